@@ -12,6 +12,7 @@
 #include "openMVG/features/image_describer.hpp"
 #include "openMVG/features/regions_factory.hpp"
 #include "openMVG/image/image_container.hpp"
+#include "openMVG/system/logger.hpp"
 
 #include <algorithm>
 #include <iostream>
@@ -131,24 +132,53 @@ public:
     return DescribeSIFT(image, mask);
   }
 
+  int Max_image_downscale() const override
+  {
+    return (_params._first_octave > 0) ? 1 << _params._first_octave : 1;
+  }
+
+  std::unique_ptr<Regions> Describe_downscaled(
+    const image::Image<unsigned char>& image,
+    const int image_downscale,
+    const image::Image<unsigned char>* mask = nullptr
+  ) override
+  {
+    return DescribeSIFT(image, mask, image_downscale);
+  }
+
   /**
   @brief Detect regions on the image and compute their attributes (description)
   @param image Image.
   @param mask 8-bit gray image for keypoint filtering (optional).
      Non-zero values depict the region of interest.
+  @param image_downscale Downscaling factor already applied to the image
+     (see Max_image_downscale).
   @return regions The detected regions and attributes (the caller must delete the allocated data)
   */
   std::unique_ptr<Regions_type> DescribeSIFT(
       const image::Image<unsigned char>& image,
-      const image::Image<unsigned char>* mask = nullptr
+      const image::Image<unsigned char>* mask = nullptr,
+      const int image_downscale = 1
   )
   {
+    if (image_downscale < 1 || Max_image_downscale() % image_downscale != 0)
+    {
+      OPENMVG_LOG_ERROR << "Invalid image downscale: " << image_downscale;
+      return nullptr;
+    }
+    // The octaves already skipped by the image downscaling
+    int skipped_octaves = 0;
+    while ((1 << skipped_octaves) < image_downscale)
+      ++skipped_octaves;
+
     const int w = image.Width(), h = image.Height();
     //Convert to float
     const image::Image<float> If(image.GetMat().cast<float>());
 
     VlSiftFilt *filt = vl_sift_new(w, h,
-      _params._num_octaves, _params._num_scales, _params._first_octave);
+      _params._num_octaves, _params._num_scales, _params._first_octave - skipped_octaves);
+    // Scale used to express the keypoints in full resolution coordinates
+    const float scale = static_cast<float>(image_downscale);
     if (_params._edge_threshold >= 0)
       vl_sift_set_edge_thresh(filt, _params._edge_threshold);
     if (_params._peak_threshold >= 0)
@@ -181,11 +211,16 @@ public:
       #endif
       for (int i = 0; i < nkeys; ++i) {
 
+        // Keypoint position in the full resolution image
+        // (a downscaled pixel is centered on its source pixel block)
+        const float
+          x = scale * keys[i].x + (scale - 1.f) / 2.f,
+          y = scale * keys[i].y + (scale - 1.f) / 2.f;
         // Feature masking
         if (mask)
         {
           const image::Image<unsigned char> & maskIma = *mask;
-          if (maskIma(keys[i].y, keys[i].x) == 0)
+          if (!maskIma.Contains(y, x) || maskIma(y, x) == 0)
             continue;
         }
 
@@ -198,8 +233,8 @@ public:
 
         for (int q=0 ; q < nangles ; ++q) {
           vl_sift_calc_keypoint_descriptor(filt, &descr[0], keys+i, angles[q]);
-          const SIOPointFeature fp(keys[i].x, keys[i].y,
-            keys[i].sigma, static_cast<float>(angles[q]));
+          const SIOPointFeature fp(x, y,
+            scale * keys[i].sigma, static_cast<float>(angles[q]));
 
           siftDescToUChar(&descr[0], descriptor, _params._root_sift);
           #ifdef OPENMVG_USE_OPENMP
@@ -111,6 +111,105 @@ struct IntrinsicBase : public Clonable<IntrinsicBase>
     return x - proj;
   }
 
+  // --
+  // Batch members (one column per point)
+  // The default implementations call the point-wise virtual functions,
+  // camera models override them to avoid a virtual call per point
+  // (and with array expressions where the model allows it).
+  // --
+
+  /**
+  * @brief Compute the projection of some 3D points into the image plane
+  * (Apply disto (if any) and Intrinsics)
+  * @param X 3D-points to project on image plane (one per column)
+  * @return Projected (2D) points on image plane
+  */
+  virtual Mat2X project_points(
+    const Mat3X & X,
+    const bool ignore_distortion = false) const
+  {
+    Mat2X x(2, X.cols());
+    for (Mat3X::Index i = 0; i < X.cols(); ++i)
+    {
+      x.col(i) = this->project(X.col(i), ignore_distortion);
+    }
+    return x;
+  }
+
+  /**
+  * @brief Compute the residuals between some 3D projected points and their image observations
+  * @param X 3d points to project on camera plane (one per column)
+  * @param x image observations (one per column)
+  * @return Relative 2d distances between projected and observed points
+  */
+  Mat2X residuals(
+    const Mat3X & X,
+    const Mat2X & x,
+    const bool ignore_distortion = false) const
+  {
+    return x - this->project_points(X, ignore_distortion);
+  }
+
+  /**
+  * @brief Add the distortion field to some points (that are in normalized camera frame)
+  * @param p Points before distortion computation (in normalized camera frame)
+  * @return points with distortion
+  */
+  virtual Mat2X add_disto_points( const Mat2X& p ) const
+  {
+    Mat2X p_d(2, p.cols());
+    for (Mat2X::Index i = 0; i < p.cols(); ++i)
+    {
+      p_d.col(i) = this->add_disto(p.col(i));
+    }
+    return p_d;
+  }
+
+  /**
+  * @brief Remove the distortion to some camera points (that are in normalized camera frame)
+  * @param p Points with distortion
+  * @return Points without distortion
+  */
+  virtual Mat2X remove_disto_points( const Mat2X& p ) const
+  {
+    Mat2X p_u(2, p.cols());
+    for (Mat2X::Index i = 0; i < p.cols(); ++i)
+    {
+      p_u.col(i) = this->remove_disto(p.col(i));
+    }
+    return p_u;
+  }
+
+  /**
+  * @brief Return the un-distorted pixels (with removed distortion)
+  * @param p Input distorted pixels
+  * @return Points without distortion
+  */
+  virtual Mat2X get_ud_pixels( const Mat2X& p ) const
+  {
+    Mat2X p_u(2, p.cols());
+    for (Mat2X::Index i = 0; i < p.cols(); ++i)
+    {
+      p_u.col(i) = this->get_ud_pixel(p.col(i));
+    }
+    return p_u;
+  }
+
+  /**
+  * @brief Return the distorted pixels (with added distortion)
+  * @param p Input pixels
+  * @return Distorted pixels
+  */
+  virtual Mat2X get_d_pixels( const Mat2X& p ) const
+  {
+    Mat2X p_d(2, p.cols());
+    for (Mat2X::Index i = 0; i < p.cols(); ++i)
+    {
+      p_d.col(i) = this->get_d_pixel(p.col(i));
+    }
+    return p_d;
+  }
+
   // --
   // Virtual members
   // --
@@ -158,6 +158,70 @@ class Pinhole_Intrinsic : public IntrinsicBase
       return ( p -  principal_point() ) / focal();
     }
 
+    /**
+    * @brief Transform some points from the camera plane to the image plane
+    * @param p Camera plane points
+    * @return Points on image plane
+    */
+    Mat2X cam2ima_points( const Mat2X& p ) const
+    {
+      return ( focal() * p ).colwise() + principal_point();
+    }
+
+    /**
+    * @brief Transform some points from the image plane to the camera plane
+    * @param p Image plane points
+    * @return camera plane points
+    */
+    Mat2X ima2cam_points( const Mat2X& p ) const
+    {
+      return ( p.colwise() - principal_point() ) / focal();
+    }
+
+    /**
+    * @brief Compute the projection of some 3D points into the image plane
+    * (Apply disto (if any) and Intrinsics)
+    * @param X 3D-points to project on image plane (one per column)
+    * @return Projected (2D) points on image plane
+    */
+    Mat2X project_points(
+      const Mat3X & X,
+      const bool ignore_distortion = false) const override
+    {
+      if ( this->have_disto() && !ignore_distortion ) // apply disto & intrinsics
+      {
+        return cam2ima_points( this->add_disto_points( X.colwise().hnormalized() ) );
+      }
+      else // apply intrinsics
+      {
+        return cam2ima_points( X.colwise().hnormalized() );
+      }
+    }
+
+    /**
+    * @brief Return the un-distorted pixels (with removed distortion)
+    * @param p Input distorted pixels
+    * @return Points without distortion
+    */
+    Mat2X get_ud_pixels( const Mat2X& p ) const override
+    {
+      if ( !this->have_disto() )
+        return p;
+      return cam2ima_points( this->remove_disto_points( ima2cam_points( p ) ) );
+    }
+
+    /**
+    * @brief Return the distorted pixels (with added distortion)
+    * @param p Input pixels
+    * @return Distorted pixels
+    */
+    Mat2X get_d_pixels( const Mat2X& p ) const override
+    {
+      if ( !this->have_disto() )
+        return p;
+      return cam2ima_points( this->add_disto_points( ima2cam_points( p ) ) );
+    }
+
     /**
     * @brief Does the camera model handle a distortion field?
     * @retval false if intrinsic does not hold distortion
@@ -109,6 +109,49 @@ class Pinhole_Intrinsic_Brown_T2 : public Pinhole_Intrinsic
       return p_u;
     }
 
+    /**
+    * @brief Add the distortion field to some points (that are in normalized camera frame)
+    * @param p Points before distortion computation (in normalized camera frame)
+    * @return points with distortion
+    */
+    Mat2X add_disto_points( const Mat2X & p ) const override
+    {
+      return ( p + distoFunction( params_, p ) );
+    }
+
+    /**
+    * @brief Remove the distortion to some camera points (that are in normalized camera frame)
+    *  The fixed point iterations of remove_disto are run on all the points at once,
+    *  a point is no longer updated once it has converged.
+    *  The points that do not converge in max_iteration are undistorted one by one.
+    * @param p Points with distortion
+    * @return Points without distortion
+    */
+    Mat2X remove_disto_points( const Mat2X & p ) const override
+    {
+      const double epsilon = 1e-10; //criteria to stop the iteration
+      const int max_iteration = 100;
+      Mat2X p_u = p;
+
+      Mat2X d = distoFunction(params_, p_u);
+      Eigen::Array<bool, 1, Eigen::Dynamic> active =
+        (p_u + d - p).array().abs().colwise().sum() > epsilon;
+      for (int iteration = 0; iteration < max_iteration && active.any(); ++iteration)
+      {
+        p_u = active.replicate(2, 1).select(p - d, p_u);
+        d = distoFunction(params_, p_u);
+        active = active && ((p_u + d - p).array().abs().colwise().sum() > epsilon);
+      }
+      for ( Mat2X::Index i = 0; i < p.cols(); ++i )
+      {
+        if ( active( i ) )
+        {
+          p_u.col( i ) = class_type::remove_disto( p.col( i ) );
+        }
+      }
+      return p_u;
+    }
+
     /**
     * @brief Data wrapper for non linear optimization (get data)
     * @return vector of parameter of this intrinsic
@@ -234,6 +277,27 @@ class Pinhole_Intrinsic_Brown_T2 : public Pinhole_Intrinsic
       const double t_y = t1 * ( r2 + 2 * p( 1 ) * p( 1 ) ) + 2 * t2 * p( 0 ) * p( 1 );
       return { p( 0 ) * k_diff + t_x, p( 1 ) * k_diff + t_y};
     }
+
+    /**
+    * @brief Functor to calculate the distortion offsets of some points at once
+    * @param params List of parameters to define a Brown camera
+    * @param p Input points
+    * @return Distortion offsets
+    */
+    static Mat2X distoFunction( const std::vector<double> & params, const Mat2X & p )
+    {
+      using RowArray = Eigen::Array<double, 1, Eigen::Dynamic>;
+      const double k1 = params[0], k2 = params[1], k3 = params[2], t1 = params[3], t2 = params[4];
+      const RowArray x = p.row( 0 ).array(), y = p.row( 1 ).array();
+      const RowArray r2 = x * x + y * y;
+      const RowArray r4 = r2 * r2;
+      const RowArray r6 = r4 * r2;
+      const RowArray k_diff = ( k1 * r2 + k2 * r4 + k3 * r6 );
+      Mat2X d( 2, p.cols() );
+      d.row( 0 ) = ( x * k_diff + t2 * ( r2 + 2 * x * x ) + 2 * t1 * x * y ).matrix();
+      d.row( 1 ) = ( y * k_diff + t1 * ( r2 + 2 * y * y ) + 2 * t2 * x * y ).matrix();
+      return d;
+    }
 };
 
 
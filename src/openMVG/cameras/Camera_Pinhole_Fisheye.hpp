@@ -135,6 +135,61 @@ class Pinhole_Intrinsic_Fisheye : public Pinhole_Intrinsic
       return p * scale;
     }
 
+    /**
+    * @brief Add the distortion field to some points (that are in normalized camera frame)
+    * @param p Points before distortion computation (in normalized camera frame)
+    * @return points with distortion
+    */
+    Mat2X add_disto_points( const Mat2X & p ) const override
+    {
+      using RowArray = Eigen::Array<double, 1, Eigen::Dynamic>;
+      const double eps = 1e-8;
+      const double k1 = params_[0], k2 = params_[1], k3 = params_[2], k4 = params_[3];
+      const RowArray r = p.colwise().norm().array();
+      const RowArray theta = r.atan();
+      const RowArray
+        theta2 = theta * theta,
+        theta3 = theta2 * theta,
+        theta4 = theta2 * theta2,
+        theta5 = theta4 * theta,
+        theta6 = theta3 * theta3,
+        theta7 = theta6 * theta,
+        theta8 = theta4 * theta4,
+        theta9 = theta8 * theta;
+      const RowArray theta_dist = theta + k1 * theta3 + k2 * theta5 + k3 * theta7 + k4 * theta9;
+      const RowArray cdist = ( r > eps ).select( theta_dist / r, 1.0 );
+      return ( p.array().rowwise() * cdist ).matrix();
+    }
+
+    /**
+    * @brief Remove the distortion to some camera points (that are in normalized camera frame)
+    *  The fixed point iterations of remove_disto are run on all the points at once.
+    * @param p Points with distortion
+    * @return Points without distortion
+    */
+    Mat2X remove_disto_points( const Mat2X & p ) const override
+    {
+      using RowArray = Eigen::Array<double, 1, Eigen::Dynamic>;
+      const double eps = 1e-8;
+      const RowArray theta_dist = p.colwise().norm().array();
+      RowArray theta = theta_dist;
+      for ( int j = 0; j < 10; ++j )
+      {
+        const RowArray
+          theta2 = theta * theta,
+          theta4 = theta2 * theta2,
+          theta6 = theta4 * theta2,
+          theta8 = theta6 * theta2;
+        theta = theta_dist /
+                ( 1 + params_[0] * theta2
+                  + params_[1] * theta4
+                  + params_[2] * theta6
+                  + params_[3] * theta8 );
+      }
+      const RowArray scale = ( theta_dist > eps ).select( theta.tan() / theta_dist, 1.0 );
+      return ( p.array().rowwise() * scale ).matrix();
+    }
+
     /**
     * @brief Data wrapper for non linear optimization (get data)
     * @return vector of parameter of this intrinsic
@@ -9,6 +9,8 @@
 #ifndef OPENMVG_CAMERAS_CAMERA_PINHOLE_RADIAL_HPP
 #define OPENMVG_CAMERAS_CAMERA_PINHOLE_RADIAL_HPP
 
+#include <cmath>
+#include <limits>
 #include <vector>
 
 #include "openMVG/cameras/Camera_Common.hpp"
@@ -69,6 +71,128 @@ double bisection_Radius_Solve(
   return .5 * ( lowerbound + upbound );
 }
 
+/**
+* @brief Solve by Newton iterations the undistorted radius r_u such that
+*  r_u * (1 + k1 r_u^2 + k2 r_u^4 + ...) = r_d
+* @param params Parameters of the radial distortion {k1, k2, ...}
+* @param r_d Distorted (target) radius
+* @param[out] r_u Undistorted radius
+* @param epsilon Error driven threshold
+* @param max_iteration Maximal number of Newton iterations
+* @return true if the iterations converged on the monotonic part of the
+*  distortion function (else a bisection must be used)
+*/
+inline bool newton_Radius_Solve(
+  const std::vector<double> & params, // radial distortion parameters
+  double r_d, // targeted radius
+  double & r_u,
+  double epsilon = 1e-10, // criteria to stop the iterations
+  int max_iteration = 20
+)
+{
+  r_u = r_d;
+  for ( int iteration = 0; iteration < max_iteration; ++iteration )
+  {
+    const double r_u2 = r_u * r_u;
+    double r_u2k = 1.;
+    double factor = 1., derivative = 1.;
+    for ( size_t k = 0; k < params.size(); ++k )
+    {
+      r_u2k *= r_u2;
+      factor += params[k] * r_u2k;
+      derivative += ( 2 * k + 3 ) * params[k] * r_u2k;
+    }
+    if ( derivative <= 0. ) // Not on the monotonic part of the distortion
+    {
+      return false;
+    }
+    const double delta = ( r_u * factor - r_d ) / derivative;
+    r_u -= delta;
+    if ( std::abs( delta ) < epsilon )
+    {
+      return r_u >= 0.;
+    }
+  }
+  return false;
+}
+
+/**
+* @brief Solve by Newton iterations the undistorted radii of some points at once
+*  (see the point-wise newton_Radius_Solve)
+* @param params Parameters of the radial distortion {k1, k2, ...}
+* @param r_d Distorted (target) radii
+* @param[out] r_u Undistorted radii
+* @param epsilon Error driven threshold
+* @param max_iteration Maximal number of Newton iterations
+* @return For each radius, true if the iterations converged on the monotonic
+*  part of the distortion function (else a bisection must be used)
+*/
+inline Eigen::Array<bool, 1, Eigen::Dynamic> newton_Radius_Solve(
+  const std::vector<double> & params, // radial distortion parameters
+  const Eigen::Array<double, 1, Eigen::Dynamic> & r_d, // targeted radii
+  Eigen::Array<double, 1, Eigen::Dynamic> & r_u,
+  double epsilon = 1e-10, // criteria to stop the iterations
+  int max_iteration = 20
+)
+{
+  using RowArray = Eigen::Array<double, 1, Eigen::Dynamic>;
+  r_u = r_d;
+  Eigen::Array<bool, 1, Eigen::Dynamic> monotonic =
+    Eigen::Array<bool, 1, Eigen::Dynamic>::Constant( r_d.size(), true );
+  RowArray delta = RowArray::Constant( r_d.size(), std::numeric_limits<double>::infinity() );
+  for ( int iteration = 0; iteration < max_iteration; ++iteration )
+  {
+    const RowArray r_u2 = r_u.square();
+    RowArray r_u2k = RowArray::Ones( r_d.size() );
+    RowArray factor = RowArray::Ones( r_d.size() ), derivative = RowArray::Ones( r_d.size() );
+    for ( size_t k = 0; k < params.size(); ++k )
+    {
+      r_u2k *= r_u2;
+      factor += params[k] * r_u2k;
+      derivative += ( 2 * k + 3 ) * params[k] * r_u2k;
+    }
+    monotonic = monotonic && ( derivative > 0. );
+    delta = ( r_u * factor - r_d ) / derivative;
+    r_u -= delta;
+    if ( ( delta.abs() < epsilon ).all() )
+    {
+      break;
+    }
+  }
+  return monotonic && ( delta.abs() < epsilon ) && ( r_u >= 0. );
+}
+
+/**
+* @brief Remove the radial distortion of some points (in normalized camera frame)
+*  with array-wise Newton iterations. The points for which the iterations fail
+*  are undistorted one by one by the given camera model.
+* @param cam Camera model (used for the point-wise fallback)
+* @param params Parameters of the radial distortion {k1, k2, ...}
+* @param p Points with distortion
+* @return Points without distortion
+*/
+template <class Camera_Radial>
+Mat2X remove_disto_points(
+  const Camera_Radial & cam,
+  const std::vector<double> & params,
+  const Mat2X & p
+)
+{
+  const Eigen::Array<double, 1, Eigen::Dynamic> r_d = p.colwise().norm().array();
+  Eigen::Array<double, 1, Eigen::Dynamic> r_u;
+  const Eigen::Array<bool, 1, Eigen::Dynamic> converged =
+    newton_Radius_Solve( params, r_d, r_u );
+  Mat2X p_u = ( p.array().rowwise() * ( r_d > 0. ).select( r_u / r_d, 1. ) ).matrix();
+  for ( Mat2X::Index i = 0; i < p.cols(); ++i )
+  {
+    if ( !converged( i ) )
+    {
+      p_u.col( i ) = cam.Camera_Radial::remove_disto( p.col( i ) );
+    }
+  }
+  return p_u;
+}
+
 } // namespace radial_distortion
 
 /**
@@ -151,10 +275,40 @@ class Pinhole_Intrinsic_Radial_K1 : public Pinhole_Intrinsic
       // Minimize disto(radius(p')^2) == actual Squared(radius(p))
 
       const double r2 = p( 0 ) * p( 0 ) + p( 1 ) * p( 1 );
-      const double radius = ( r2 == 0 ) ?
-                            1. :
-                            ::sqrt( radial_distortion::bisection_Radius_Solve( params_, r2, distoFunctor ) / r2 );
-      return radius * p;
+      if ( r2 == 0 )
+      {
+        return p;
+      }
+      // Newton iterations on the radius (fallback to a bisection if they fail)
+      const double r_d = ::sqrt( r2 );
+      double r_u;
+      if ( !radial_distortion::newton_Radius_Solve( params_, r_d, r_u ) )
+      {
+        r_u = ::sqrt( radial_distortion::bisection_Radius_Solve( params_, r2, distoFunctor ) );
+      }
+      return ( r_u / r_d ) * p;
+    }
+
+    /**
+    * @brief Add the distortion field to some points (that are in normalized camera frame)
+    * @param p Points before distortion computation (in normalized camera frame)
+    * @return points with distortion
+    */
+    Mat2X add_disto_points( const Mat2X & p ) const override
+    {
+      const double k1 = params_[0];
+      const Eigen::Array<double, 1, Eigen::Dynamic> r2 = p.colwise().squaredNorm().array();
+      return ( p.array().rowwise() * ( 1. + k1 * r2 ) ).matrix();
+    }
+
+    /**
+    * @brief Remove the distortion to some camera points (that are in normalized camera frame)
+    * @param p Points with distortion
+    * @return Points without distortion
+    */
+    Mat2X remove_disto_points( const Mat2X & p ) const override
+    {
+      return radial_distortion::remove_disto_points( *this, params_, p );
     }
 
     /**
@@ -360,10 +514,40 @@ class Pinhole_Intrinsic_Radial_K3 : public Pinhole_Intrinsic
       // Minimize disto(radius(p')^2) == actual Squared(radius(p))
 
       const double r2 = p( 0 ) * p( 0 ) + p( 1 ) * p( 1 );
-      const double radius = ( r2 == 0 ) ? //1. : ::sqrt(bisectionSolve(_params, r2) / r2);
-                            1. :
-                            ::sqrt( radial_distortion::bisection_Radius_Solve( params_, r2, distoFunctor ) / r2 );
-      return radius * p;
+      if ( r2 == 0 )
+      {
+        return p;
+      }
+      // Newton iterations on the radius (fallback to a bisection if they fail)
+      const double r_d = ::sqrt( r2 );
+      double r_u;
+      if ( !radial_distortion::newton_Radius_Solve( params_, r_d, r_u ) )
+      {
+        r_u = ::sqrt( radial_distortion::bisection_Radius_Solve( params_, r2, distoFunctor ) );
+      }
+      return ( r_u / r_d ) * p;
+    }
+
+    /**
+    * @brief Add the distortion field to some points (that are in normalized camera frame)
+    * @param p Points before distortion computation (in normalized camera frame)
+    * @return points with distortion
+    */
+    Mat2X add_disto_points( const Mat2X & p ) const override
+    {
+      const double k1 = params_[0], k2 = params_[1], k3 = params_[2];
+      const Eigen::Array<double, 1, Eigen::Dynamic> r2 = p.colwise().squaredNorm().array();
+      return ( p.array().rowwise() * ( 1. + r2 * ( k1 + r2 * ( k2 + r2 * k3 ) ) ) ).matrix();
+    }
+
+    /**
+    * @brief Remove the distortion to some camera points (that are in normalized camera frame)
+    * @param p Points with distortion
+    * @return Points without distortion
+    */
+    Mat2X remove_disto_points( const Mat2X & p ) const override
+    {
+      return radial_distortion::remove_disto_points( *this, params_, p );
     }
 
     /**
@@ -7,12 +7,15 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "openMVG/cameras/Camera_Pinhole_Radial.hpp"
+#include "openMVG/numeric/numeric.h"
 using namespace openMVG;
 using namespace openMVG::cameras;
 
 #include "testing/testing.h"
 #include "openMVG/cameras/Camera_Unit_Test.inl"
 
+#include <random>
+
 TEST(Cameras_Radial, disto_undisto_K1) {
 
   const Pinhole_Intrinsic_Radial_K1 cam(1000, 1000, 1000, 500, 500,
@@ -31,6 +34,62 @@ TEST(Cameras_Radial, disto_undisto_K3) {
   Test_camera(cam);
 }
 
+// Check that the Newton undistortion matches the bisection based one
+// and that the array-wise undistortion matches the point-wise one
+TEST(Cameras_Radial, undisto_newton_vs_bisection) {
+
+  const Pinhole_Intrinsic_Radial_K3 cam(1000, 1000, 1000, 500, 500,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  const std::vector<double> params = {-0.245539, 0.255195, 0.163773};
+  const auto distoFunctor = [](const std::vector<double> & params, double r2)
+  {
+    const double k1 = params[0], k2 = params[1], k3 = params[2];
+    return r2 * Square( 1. + r2 * ( k1 + r2 * ( k2 + r2 * k3 ) ) );
+  };
+
+  Mat2X pts(2, 10000);
+  std::default_random_engine gen;
+  std::uniform_real_distribution<> rand_coord(0, 1000);
+  for (Mat2X::Index i = 0; i < pts.cols(); ++i)
+    pts.col(i) << rand_coord(gen), rand_coord(gen);
+
+  // Newton vs bisection radius
+  for (Mat2X::Index i = 0; i < pts.cols(); i += 100)
+  {
+    const double r2 = cam.ima2cam(pts.col(i)).squaredNorm();
+    double r_u;
+    if (radial_distortion::newton_Radius_Solve(params, std::sqrt(r2), r_u))
+    {
+      EXPECT_NEAR(
+        std::sqrt(radial_distortion::bisection_Radius_Solve(params, r2, distoFunctor)),
+        r_u, 1e-6);
+    }
+  }
+
+  // Point-wise vs array-wise undistortion
+  Mat2X ud_pixels(2, pts.cols());
+  for (Mat2X::Index i = 0; i < pts.cols(); ++i)
+    ud_pixels.col(i) = cam.get_ud_pixel(pts.col(i));
+  EXPECT_MATRIX_NEAR(ud_pixels, cam.get_ud_pixels(pts), 1e-8);
+
+  // Some points beyond the monotonic part of the distortion function:
+  //  the array-wise Newton iterations fall back to the point-wise solver
+  const Pinhole_Intrinsic_Radial_K1 cam_k1(1000, 1000, 1000, 500, 500, -0.5);
+  const Mat2X cam_pts = (Mat2X(2, 4) << 0, 0.1, 0.3, 0.6,
+                                        0, 0.1, 0.3, 0.6).finished();
+  Eigen::Array<double, 1, Eigen::Dynamic> r_u_array;
+  const Eigen::Array<bool, 1, Eigen::Dynamic> converged =
+    radial_distortion::newton_Radius_Solve({-0.5},
+      cam_pts.colwise().norm().array(), r_u_array);
+  EXPECT_TRUE(converged(0) && converged(1) && converged(2));
+  EXPECT_FALSE(converged(3));
+  const Mat2X ud_cam_pts = cam_k1.remove_disto_points(cam_pts);
+  for (Mat2X::Index i = 0; i < cam_pts.cols(); ++i)
+    EXPECT_MATRIX_NEAR(cam_k1.remove_disto(cam_pts.col(i)), ud_cam_pts.col(i), 1e-8);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
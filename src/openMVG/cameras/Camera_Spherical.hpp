@@ -181,6 +181,20 @@ using class_type = Intrinsic_Spherical;
   */
   virtual Vec2 get_d_pixel(const Vec2 &p) const override { return p; }
 
+  /**
+   * @brief Return the un-distorted pixels (with removed distortion)
+   * @param p Input distorted pixels
+   * @return Points without distortion
+   */
+  Mat2X get_ud_pixels(const Mat2X &p) const override { return p; }
+
+  /**
+   * @brief Return the distorted pixels (with added distortion)
+   * @param p Input pixels
+   * @return Distorted pixels
+   */
+  Mat2X get_d_pixels(const Mat2X &p) const override { return p; }
+
   /**
   * @brief Normalize a given unit pixel error to the camera plane
   * @param value Error in image plane
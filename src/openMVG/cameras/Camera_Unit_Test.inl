@@ -15,6 +15,7 @@
 //   - Check bijection between transformation between camera and image domain
 //   - Check bijection of the distortion function
 //   - Check bijection of the bearing vector and its projection
+// - Check that the batch members match the point-wise ones
 #define Test_camera(cam) \
 { \
  \
@@ -54,4 +55,20 @@
     EXPECT_TRUE(CheiralityTest(cam(ptImage), geometry::Pose3{}, cam(ptImage)));\
     EXPECT_FALSE(CheiralityTest(cam(ptImage), geometry::Pose3{}, -cam(ptImage)));\
   } \
+ \
+  /* Check that the batch members match the point-wise ones */ \
+  Mat2X ptsImage(2, 100); \
+  for (Mat2X::Index i = 0; i < ptsImage.cols(); ++i) \
+    ptsImage.col(i) << rand_x(gen), rand_y(gen); \
+  const Mat3X bearings = cam(ptsImage); \
+  const Mat2X \
+    projected = cam.project_points(bearings), \
+    ud_pixels = cam.get_ud_pixels(ptsImage), \
+    d_pixels = cam.get_d_pixels(ptsImage); \
+  for (Mat2X::Index i = 0; i < ptsImage.cols(); ++i) \
+  { \
+    EXPECT_MATRIX_NEAR(cam.project(bearings.col(i)), projected.col(i), epsilon); \
+    EXPECT_MATRIX_NEAR(cam.get_ud_pixel(ptsImage.col(i)), ud_pixels.col(i), epsilon); \
+    EXPECT_MATRIX_NEAR(cam.get_d_pixel(ptsImage.col(i)), d_pixels.col(i), epsilon); \
+  } \
 }
@@ -9,13 +9,33 @@
 #ifndef OPENMVG_CAMERAS_CAMERA_UNDISTORT_IMAGE_HPP
 #define OPENMVG_CAMERAS_CAMERA_UNDISTORT_IMAGE_HPP
 
-#include <limits>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/image/image_container.hpp"
+#include "openMVG/image/pixel_types.hpp"
 #include "openMVG/image/sample.hpp"
 
+// The AVX2 remap is compiled for a specific target and selected at runtime
+#if defined(__AVX2__) || defined(_MSC_VER)
+  #define OPENMVG_CAMERA_REMAP_AVX2
+  #define OPENMVG_CAMERA_REMAP_AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #define OPENMVG_CAMERA_REMAP_AVX2
+  #define OPENMVG_CAMERA_REMAP_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#if defined(OPENMVG_CAMERA_REMAP_AVX2)
+  #include <immintrin.h>
+  #include "openMVG/system/cpu_instruction_set.hpp"
+#endif
+
 namespace openMVG
 {
 namespace cameras
@@ -144,6 +164,441 @@ void UndistortImageResized(
   }
 }
 
+/**
+* @brief Number of interleaved 8-bit channels of the pixel types supported
+*  by the UndistortionMap remapping (0 for unsupported types)
+*/
+template <typename T>
+struct RemapChannels { static const int value = 0; };
+template <>
+struct RemapChannels<unsigned char> { static const int value = 1; };
+template <>
+struct RemapChannels<image::RGBColor> { static const int value = 3; };
+
+/**
+* @brief Precomputed remap table of an image undistortion.
+*
+* For each pixel of the undistorted image, the table stores the position of
+* its source pixel in the distorted image as a top-left pixel index and a
+* fixed point sub-pixel offset. The table depends only on the intrinsic, so
+* it is computed once and reused for every image sharing the same intrinsic
+* (and can be persisted to disk).
+* Remapping a gray or RGB image is then a pure integer bilinear
+* interpolation (AVX2 if the CPU supports it) that gives the same
+* result as UndistortImage up to the rounding of the sampling position.
+*/
+class UndistortionMap
+{
+public:
+  /// Number of bits of the fractional part of the sampling positions
+  static const int kFractionBits = 7;
+
+  UndistortionMap() = default;
+
+  /**
+  * @brief Compute the remap table of a camera
+  * @param cam Intrinsic parameter used to undistort the images
+  */
+  explicit UndistortionMap( const IntrinsicBase * cam )
+  {
+    Build( cam );
+  }
+
+  /**
+  * @brief Compute the remap table of a camera
+  * @param cam Intrinsic parameter used to undistort the images
+  * @return false if the camera image is too small to be interpolated
+  */
+  bool Build( const IntrinsicBase * cam )
+  {
+    width_ = static_cast<int>( cam->w() );
+    height_ = static_cast<int>( cam->h() );
+    intrinsic_hash_ = cam->hashValue();
+    if ( width_ < 2 || height_ < 2 )
+    {
+      width_ = height_ = 0;
+      offsets_.clear(); weights_x_.clear(); weights_y_.clear();
+      return false;
+    }
+    const std::size_t nb_pixels = static_cast<std::size_t>( width_ ) * height_;
+    offsets_.resize( nb_pixels );
+    weights_x_.resize( nb_pixels );
+    weights_y_.resize( nb_pixels );
+
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for ( int j = 0; j < height_; ++j )
+    {
+      // compute the coordinates with distortion of a whole row at once
+      Mat2X undisto_pix( 2, width_ );
+      for ( int i = 0; i < width_; ++i )
+      {
+        undisto_pix.col( i ) << i, j;
+      }
+      const Mat2X disto_pix = cam->get_d_pixels( undisto_pix );
+      for ( int i = 0; i < width_; ++i )
+      {
+        const std::size_t index = static_cast<std::size_t>( j ) * width_ + i;
+        SetSamplingPosition( index, disto_pix( 0, i ), disto_pix( 1, i ) );
+      }
+    }
+    return true;
+  }
+
+  /**
+  * @brief Undistort an image
+  * @param imageIn Input (distorted) image (gray or RGB)
+  * @param[out] image_ud Output undistorted image
+  * @param fillcolor color used to fill pixels where no input pixel is found
+  * @return false if the image size does not match the map
+  */
+  template <typename Image>
+  bool Remap(
+    const Image & imageIn,
+    Image & image_ud,
+    typename Image::Tpixel fillcolor = typename Image::Tpixel( 0 ) ) const
+  {
+    static const int channels = RemapChannels<typename Image::Tpixel>::value;
+    static_assert( channels > 0, "Remap supports only 8-bit gray and RGB images" );
+
+    if ( offsets_.empty() || imageIn.Width() != width_ || imageIn.Height() != height_ )
+    {
+      return false;
+    }
+    image_ud.resize( width_, height_, false );
+    Remap_Bilinear<channels>(
+      reinterpret_cast<const uint8_t *>( imageIn.data() ),
+      reinterpret_cast<uint8_t *>( image_ud.data() ),
+      reinterpret_cast<const uint8_t *>( &fillcolor ) );
+    return true;
+  }
+
+  /**
+  * @brief Save the map to a binary file
+  * @param filename Output file name
+  * @return true if the file has been written
+  */
+  bool Save( const std::string & filename ) const
+  {
+    std::ofstream stream( filename, std::ios::out | std::ios::binary );
+    if ( !stream )
+    {
+      return false;
+    }
+    const uint64_t hash = intrinsic_hash_;
+    const int32_t size[2] = {width_, height_};
+    stream.write( Magic(), kMagicSize );
+    stream.write( reinterpret_cast<const char *>( &hash ), sizeof( hash ) );
+    stream.write( reinterpret_cast<const char *>( size ), sizeof( size ) );
+    stream.write( reinterpret_cast<const char *>( offsets_.data() ), offsets_.size() * sizeof( int32_t ) );
+    stream.write( reinterpret_cast<const char *>( weights_x_.data() ), weights_x_.size() );
+    stream.write( reinterpret_cast<const char *>( weights_y_.data() ), weights_y_.size() );
+    return stream.good();
+  }
+
+  /**
+  * @brief Load a map from a binary file
+  * @param filename Input file name
+  * @param intrinsic_hash Expected intrinsic hash (0 to accept any map)
+  * @return true if a valid map (for the expected intrinsic) has been read
+  * @note The map size is checked against the file length before any
+  *  allocation, and the sampling positions are checked to lie in the image
+  *  (the map is left unchanged if the file is invalid).
+  */
+  bool Load( const std::string & filename, const std::size_t intrinsic_hash = 0 )
+  {
+    std::ifstream stream( filename, std::ios::in | std::ios::binary );
+    if ( !stream )
+    {
+      return false;
+    }
+    stream.seekg( 0, std::ios::end );
+    const std::streamoff file_length = stream.tellg();
+    stream.seekg( 0, std::ios::beg );
+
+    char magic[kMagicSize];
+    uint64_t hash;
+    int32_t size[2];
+    stream.read( magic, sizeof( magic ) );
+    stream.read( reinterpret_cast<char *>( &hash ), sizeof( hash ) );
+    stream.read( reinterpret_cast<char *>( size ), sizeof( size ) );
+    if ( !stream || !std::equal( magic, magic + kMagicSize, Magic() )
+         || ( intrinsic_hash != 0 && hash != static_cast<uint64_t>( intrinsic_hash ) )
+         || size[0] < 2 || size[1] < 2 )
+    {
+      return false;
+    }
+    // Each pixel stores an offset and two weights
+    const uint64_t header_length = kMagicSize + sizeof( hash ) + sizeof( size );
+    const uint64_t nb_pixels = static_cast<uint64_t>( size[0] ) * static_cast<uint64_t>( size[1] );
+    if ( file_length < 0 || nb_pixels > std::numeric_limits<int32_t>::max()
+         || header_length + nb_pixels * ( sizeof( int32_t ) + 2 ) != static_cast<uint64_t>( file_length ) )
+    {
+      return false;
+    }
+    std::vector<int32_t> offsets( nb_pixels );
+    std::vector<uint8_t> weights_x( nb_pixels ), weights_y( nb_pixels );
+    stream.read( reinterpret_cast<char *>( offsets.data() ), nb_pixels * sizeof( int32_t ) );
+    stream.read( reinterpret_cast<char *>( weights_x.data() ), nb_pixels );
+    stream.read( reinterpret_cast<char *>( weights_y.data() ), nb_pixels );
+    if ( !stream )
+    {
+      return false;
+    }
+    // The 2x2 sampling neighborhoods must lie in the image
+    static const int one = 1 << kFractionBits;
+    const int32_t width = size[0], height = size[1];
+    for ( std::size_t index = 0; index < nb_pixels; ++index )
+    {
+      const int32_t offset = offsets[index];
+      if ( offset == -1 )
+      {
+        continue;
+      }
+      if ( offset < 0 || offset >= ( height - 1 ) * width || offset % width == width - 1
+           || weights_x[index] > one || weights_y[index] > one )
+      {
+        return false;
+      }
+    }
+    intrinsic_hash_ = hash;
+    width_ = width;
+    height_ = height;
+    offsets_ = std::move( offsets );
+    weights_x_ = std::move( weights_x );
+    weights_y_ = std::move( weights_y );
+    return true;
+  }
+
+  int Width() const { return width_; }
+  int Height() const { return height_; }
+  std::size_t IntrinsicHash() const { return intrinsic_hash_; }
+
+private:
+
+  /// File signature of the saved maps
+  static const char * Magic() { return "OMVGUDM1"; }
+  static const std::size_t kMagicSize = 8;
+
+  /// Store the sampling position (x,y) of a pixel (or mark it as invalid)
+  void SetSamplingPosition( const std::size_t index, const double x, const double y )
+  {
+    static const int one = 1 << kFractionBits;
+    // pick pixel if it is in the image domain (same test as UndistortImage)
+    if ( !std::isfinite( x ) || !std::isfinite( y ) || x <= -1. || y <= -1. || x >= width_ || y >= height_ )
+    {
+      offsets_[index] = -1;
+      weights_x_[index] = weights_y_[index] = 0;
+      return;
+    }
+    int x0 = static_cast<int>( std::floor( x ) ), y0 = static_cast<int>( std::floor( y ) );
+    int fx = static_cast<int>( std::lround( ( x - x0 ) * one ) );
+    int fy = static_cast<int>( std::lround( ( y - y0 ) * one ) );
+    // Keep the 2x2 neighborhood inside the image: the weight of the
+    // outside pixels is moved to the border ones.
+    if ( x0 < 0 ) { x0 = 0; fx = 0; }
+    if ( y0 < 0 ) { y0 = 0; fy = 0; }
+    if ( x0 >= width_ - 1 ) { x0 = width_ - 2; fx = one; }
+    if ( y0 >= height_ - 1 ) { y0 = height_ - 2; fy = one; }
+    offsets_[index] = y0 * width_ + x0;
+    weights_x_[index] = static_cast<uint8_t>( fx );
+    weights_y_[index] = static_cast<uint8_t>( fy );
+  }
+
+  /// Bilinear interpolation of the pixel #index (all the channels)
+  template <int Channels>
+  inline void Remap_Pixel(
+    const uint8_t * src,
+    uint8_t * dst,
+    const uint8_t * fillcolor,
+    const std::size_t index ) const
+  {
+    static const int one = 1 << kFractionBits;
+    static const int shift = 2 * kFractionBits;
+    const int32_t offset = offsets_[index];
+    if ( offset < 0 )
+    {
+      std::copy( fillcolor, fillcolor + Channels, dst + index * Channels );
+      return;
+    }
+    const int fx = weights_x_[index], fy = weights_y_[index];
+    const int
+      w00 = ( one - fx ) * ( one - fy ), w01 = fx * ( one - fy ),
+      w10 = ( one - fx ) * fy, w11 = fx * fy;
+    const uint8_t * row0 = src + static_cast<std::size_t>( offset ) * Channels;
+    const uint8_t * row1 = row0 + static_cast<std::size_t>( width_ ) * Channels;
+    for ( int c = 0; c < Channels; ++c )
+    {
+      dst[index * Channels + c] = static_cast<uint8_t>(
+        ( w00 * row0[c] + w01 * row0[Channels + c] +
+          w10 * row1[c] + w11 * row1[Channels + c] + ( 1 << ( shift - 1 ) ) ) >> shift );
+    }
+  }
+
+  /// Bilinear remap of an image with interleaved 8-bit channels
+  template <int Channels>
+  void Remap_Bilinear(
+    const uint8_t * src,
+    uint8_t * dst,
+    const uint8_t * fillcolor ) const
+  {
+#if defined(OPENMVG_CAMERA_REMAP_AVX2)
+    static const bool avx2 = system::CpuInstructionSet().supportAVX2();
+#endif
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for ( int j = 0; j < height_; ++j )
+    {
+      const std::size_t row_begin = static_cast<std::size_t>( j ) * width_;
+      int i = 0;
+#if defined(OPENMVG_CAMERA_REMAP_AVX2)
+      if ( avx2 )
+      {
+        i = Remap_Bilinear_AVX2<Channels>( src, dst, fillcolor, row_begin );
+      }
+#endif
+      for ( ; i < width_; ++i )
+      {
+        Remap_Pixel<Channels>( src, dst, fillcolor, row_begin + i );
+      }
+    }
+  }
+
+#if defined(OPENMVG_CAMERA_REMAP_AVX2)
+  /**
+  * @brief Remap a row by blocks of 8 pixels.
+  * Blocks with invalid pixels (or whose gathers could read past the end of
+  * the source image) are left to the scalar path.
+  * @return the index of the first pixel of the row that has not been processed
+  */
+  template <int Channels>
+  OPENMVG_CAMERA_REMAP_AVX2_TARGET int Remap_Bilinear_AVX2(
+    const uint8_t * src,
+    uint8_t * dst,
+    const uint8_t * fillcolor,
+    const std::size_t row_begin ) const
+  {
+    static const int one = 1 << kFractionBits;
+    static const int shift = 2 * kFractionBits;
+    // A gather reads 4 bytes: max offset such that the reads stay in the image
+    const int64_t max_safe_offset =
+      ( static_cast<int64_t>( Channels ) * width_ * height_ - Channels - 3 ) / Channels - width_;
+    const __m256i safe_limit = _mm256_set1_epi32(
+      static_cast<int32_t>( std::min<int64_t>( max_safe_offset, std::numeric_limits<int32_t>::max() ) ) );
+    const __m256i minus_one = _mm256_set1_epi32( -1 );
+    const __m256i v_one = _mm256_set1_epi32( one );
+    const __m256i v_round = _mm256_set1_epi32( 1 << ( shift - 1 ) );
+    const __m256i byte_mask = _mm256_set1_epi32( 0xFF );
+    const __m256i row_stride = _mm256_set1_epi32( width_ * Channels );
+    const __m256i channels = _mm256_set1_epi32( Channels );
+    alignas( 32 ) int32_t values[Channels][8];
+
+    int i = 0;
+    for ( ; i + 8 <= width_; i += 8 )
+    {
+      const std::size_t index = row_begin + i;
+      const __m256i offsets = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>( offsets_.data() + index ) );
+      const __m256i outside = _mm256_or_si256(
+        _mm256_cmpgt_epi32( offsets, safe_limit ),
+        _mm256_cmpeq_epi32( offsets, minus_one ) );
+      if ( !_mm256_testz_si256( outside, outside ) )
+      {
+        // Scalar path for this block
+        for ( int k = 0; k < 8; ++k )
+        {
+          Remap_Pixel<Channels>( src, dst, fillcolor, index + k );
+        }
+        continue;
+      }
+      // Fixed point bilinear weights
+      const __m256i fx = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64( reinterpret_cast<const __m128i *>( weights_x_.data() + index ) ) );
+      const __m256i fy = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64( reinterpret_cast<const __m128i *>( weights_y_.data() + index ) ) );
+      const __m256i ifx = _mm256_sub_epi32( v_one, fx ), ify = _mm256_sub_epi32( v_one, fy );
+      const __m256i
+        w00 = _mm256_mullo_epi32( ifx, ify ), w01 = _mm256_mullo_epi32( fx, ify ),
+        w10 = _mm256_mullo_epi32( ifx, fy ), w11 = _mm256_mullo_epi32( fx, fy );
+
+      // Gather the 2x2 neighborhoods (all the channels at once):
+      // - a: the bytes of the top-left pixel (and following),
+      // - b: the bytes of the top-right pixel (shifted by one byte)
+      const __m256i base = _mm256_mullo_epi32( offsets, channels );
+      const __m256i base_b = _mm256_add_epi32( base, _mm256_set1_epi32( Channels - 1 ) );
+      const int * src_int = reinterpret_cast<const int *>( src );
+      const __m256i
+        row0_a = _mm256_i32gather_epi32( src_int, base, 1 ),
+        row0_b = ( Channels == 1 ) ? row0_a : _mm256_i32gather_epi32( src_int, base_b, 1 ),
+        row1_a = _mm256_i32gather_epi32( src_int, _mm256_add_epi32( base, row_stride ), 1 ),
+        row1_b = ( Channels == 1 ) ? row1_a :
+          _mm256_i32gather_epi32( src_int, _mm256_add_epi32( base_b, row_stride ), 1 );
+
+      for ( int c = 0; c < Channels; ++c )
+      {
+        const __m128i shift_a = _mm_cvtsi32_si128( 8 * c );
+        const __m128i shift_b = _mm_cvtsi32_si128( 8 * ( c + 1 ) );
+        const __m256i
+          p00 = _mm256_and_si256( _mm256_srl_epi32( row0_a, shift_a ), byte_mask ),
+          p01 = _mm256_and_si256( _mm256_srl_epi32( row0_b, shift_b ), byte_mask ),
+          p10 = _mm256_and_si256( _mm256_srl_epi32( row1_a, shift_a ), byte_mask ),
+          p11 = _mm256_and_si256( _mm256_srl_epi32( row1_b, shift_b ), byte_mask );
+        __m256i acc = _mm256_add_epi32(
+          _mm256_add_epi32( _mm256_mullo_epi32( w00, p00 ), _mm256_mullo_epi32( w01, p01 ) ),
+          _mm256_add_epi32( _mm256_mullo_epi32( w10, p10 ), _mm256_mullo_epi32( w11, p11 ) ) );
+        acc = _mm256_srli_epi32( _mm256_add_epi32( acc, v_round ), shift );
+        _mm256_store_si256( reinterpret_cast<__m256i *>( values[c] ), acc );
+      }
+      uint8_t * dst_pixels = dst + index * Channels;
+      for ( int k = 0; k < 8; ++k )
+      {
+        for ( int c = 0; c < Channels; ++c )
+        {
+          dst_pixels[k * Channels + c] = static_cast<uint8_t>( values[c][k] );
+        }
+      }
+    }
+    return i;
+  }
+#endif
+
+  int width_ = 0;
+  int height_ = 0;
+  std::size_t intrinsic_hash_ = 0;
+  /// Index of the top-left pixel of the sampling neighborhood (-1 if invalid)
+  std::vector<int32_t> offsets_;
+  /// Fixed point sub-pixel sampling position (in [0, 1 << kFractionBits])
+  std::vector<uint8_t> weights_x_, weights_y_;
+};
+
+/**
+* @brief  Undistort an image according a precomputed undistortion map
+* @param imageIn Input image
+* @param cam Input intrinsic parameter used to undistort image
+* @param map Undistortion map of the intrinsic
+* @param[out] image_ud Output undistorted image
+* @param fillcolor color used to fill pixels where no input pixel is found
+* @note Fallback to the generic UndistortImage if the map cannot be used
+*/
+template <typename Image>
+void UndistortImage(
+  const Image& imageIn,
+  const IntrinsicBase * cam,
+  const UndistortionMap & map,
+  Image & image_ud,
+  typename Image::Tpixel fillcolor = typename Image::Tpixel( 0 ) )
+{
+  if ( !cam->have_disto() ) // no distortion, perform a direct copy
+  {
+    image_ud = imageIn;
+  }
+  else if ( !map.Remap( imageIn, image_ud, fillcolor ) )
+  {
+    UndistortImage( imageIn, cam, image_ud, fillcolor );
+  }
+}
 
 } // namespace cameras
 } // namespace openMVG
@@ -0,0 +1,167 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole_Radial.hpp"
+#include "openMVG/cameras/Camera_undistort_image.hpp"
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::image;
+
+// Maximal absolute difference between two images
+template <typename T>
+int MaxDifference(const Image<T> & a, const Image<T> & b)
+{
+  int max_difference = 0;
+  const uint8_t
+    * a_data = reinterpret_cast<const uint8_t *>(a.data()),
+    * b_data = reinterpret_cast<const uint8_t *>(b.data());
+  for (int i = 0; i < a.Width() * a.Height() * static_cast<int>(sizeof(T)); ++i)
+    max_difference = std::max(max_difference, std::abs(a_data[i] - b_data[i]));
+  return max_difference;
+}
+
+// A smooth random image (the interpolation rounding stays small)
+Image<RGBColor> SmoothImage(const int width, const int height)
+{
+  Image<RGBColor> image(width, height);
+  std::default_random_engine gen;
+  std::uniform_real_distribution<> rand_phase(0, 3);
+  const double phase_r = rand_phase(gen), phase_g = rand_phase(gen), phase_b = rand_phase(gen);
+  for (int j = 0; j < height; ++j)
+    for (int i = 0; i < width; ++i)
+      image(j, i) = RGBColor(
+        static_cast<uint8_t>(127.5 + 127 * std::sin(i * 0.05 + phase_r)),
+        static_cast<uint8_t>(127.5 + 127 * std::cos(j * 0.07 + phase_g)),
+        static_cast<uint8_t>(127.5 + 127 * std::sin((i + j) * 0.03 + phase_b)));
+  return image;
+}
+
+TEST(UndistortionMap, remap_vs_sampler) {
+
+  const Pinhole_Intrinsic_Radial_K3 cam(641, 479, 600, 320, 240,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  const UndistortionMap map(&cam);
+  EXPECT_EQ(641, map.Width());
+  EXPECT_EQ(479, map.Height());
+
+  // RGB image
+  const Image<RGBColor> image = SmoothImage(cam.w(), cam.h());
+  Image<RGBColor> image_ud, image_ud_map;
+  UndistortImage(image, &cam, image_ud, BLACK);
+  UndistortImage(image, &cam, map, image_ud_map, BLACK);
+  EXPECT_TRUE(MaxDifference(image_ud, image_ud_map) <= 2);
+
+  // Gray image
+  Image<uint8_t> image_gray(cam.w(), cam.h()), image_gray_ud, image_gray_ud_map;
+  for (int j = 0; j < image.Height(); ++j)
+    for (int i = 0; i < image.Width(); ++i)
+      image_gray(j, i) = image(j, i).r();
+  UndistortImage(image_gray, &cam, image_gray_ud, uint8_t(0));
+  UndistortImage(image_gray, &cam, map, image_gray_ud_map, uint8_t(0));
+  EXPECT_TRUE(MaxDifference(image_gray_ud, image_gray_ud_map) <= 2);
+
+  // An image that does not match the map size is rejected
+  Image<uint8_t> image_small(10, 10);
+  EXPECT_FALSE(map.Remap(image_small, image_gray_ud_map));
+}
+
+TEST(UndistortionMap, save_load) {
+
+  const Pinhole_Intrinsic_Radial_K1 cam(200, 100, 150, 100, 50, 0.1);
+  const UndistortionMap map(&cam);
+
+  const std::string filename = "undistortion_map_test.bin";
+  EXPECT_TRUE(map.Save(filename));
+
+  UndistortionMap map_loaded;
+  // The map of another intrinsic is rejected
+  EXPECT_FALSE(map_loaded.Load(filename, cam.hashValue() + 1));
+  EXPECT_TRUE(map_loaded.Load(filename, cam.hashValue()));
+  EXPECT_EQ(map.Width(), map_loaded.Width());
+  EXPECT_EQ(map.Height(), map_loaded.Height());
+  EXPECT_EQ(map.IntrinsicHash(), map_loaded.IntrinsicHash());
+
+  Image<uint8_t> image(cam.w(), cam.h()), image_ud, image_ud_loaded;
+  for (int j = 0; j < image.Height(); ++j)
+    for (int i = 0; i < image.Width(); ++i)
+      image(j, i) = static_cast<uint8_t>((i * 7 + j * 3) % 256);
+  EXPECT_TRUE(map.Remap(image, image_ud));
+  EXPECT_TRUE(map_loaded.Remap(image, image_ud_loaded));
+  EXPECT_EQ(0, MaxDifference(image_ud, image_ud_loaded));
+
+  std::remove(filename.c_str());
+}
+
+// Corrupted map files are rejected without allocating the size they read
+TEST(UndistortionMap, load_corrupted) {
+
+  const Pinhole_Intrinsic_Radial_K1 cam(200, 100, 150, 100, 50, 0.1);
+  const UndistortionMap map(&cam);
+
+  const std::string filename = "undistortion_map_corrupted.bin";
+  EXPECT_TRUE(map.Save(filename));
+  std::string content;
+  {
+    std::ifstream file(filename, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  }
+  const auto write_content = [&](const std::string & bytes)
+  {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(bytes.data(), bytes.size());
+  };
+  // The header is magic[8], hash[8], width[4], height[4]
+  const std::size_t size_offset = 16, offsets_offset = 24;
+
+  UndistortionMap map_loaded;
+
+  // Truncated table
+  write_content(content.substr(0, content.size() - 1));
+  EXPECT_FALSE(map_loaded.Load(filename));
+
+  // Huge image size
+  std::string corrupted = content;
+  const int32_t huge_size[2] = {1 << 20, 1 << 20};
+  corrupted.replace(size_offset, sizeof(huge_size),
+    reinterpret_cast<const char *>(huge_size), sizeof(huge_size));
+  write_content(corrupted);
+  EXPECT_FALSE(map_loaded.Load(filename));
+
+  // Sampling positions outside of the image
+  for (const int32_t offset : {-2, 200 * 100, 200 * 99, 199})
+  {
+    corrupted = content;
+    corrupted.replace(offsets_offset, sizeof(offset),
+      reinterpret_cast<const char *>(&offset), sizeof(offset));
+    write_content(corrupted);
+    EXPECT_FALSE(map_loaded.Load(filename));
+  }
+  EXPECT_EQ(0, map_loaded.Width());
+
+  write_content(content);
+  EXPECT_TRUE(map_loaded.Load(filename));
+  EXPECT_EQ(200, map_loaded.Width());
+
+  std::remove(filename.c_str());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
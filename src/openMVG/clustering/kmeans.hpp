@@ -13,8 +13,11 @@
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 #include "openMVG/system/loggerprogress.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <random>
+#include <type_traits>
 #include <vector>
 #include <iostream>
 
@@ -32,6 +35,16 @@ enum class KMeansInitType
   KMEANS_INIT_PP,     /* Kmeans++ initialization */
 };
 
+/**
+* @brief Kind of kmeans solver
+*/
+enum class KMeansSolverType
+{
+  KMEANS_LLOYD,      /* Standard Llyod iterations */
+  KMEANS_HAMERLY,    /* Llyod iterations accelerated with Hamerly triangle inequality bounds (exact) */
+  KMEANS_MINI_BATCH, /* Mini-batch kmeans (approximate) */
+};
+
 /**
 * @brief Compute minimum distance to any center
 * @param pts Input points
@@ -87,20 +100,59 @@ uint32_t NearestCenterID( const DataType & pt,
   return nearest_center;
 }
 
+/**
+* @brief Compute the two nearest centers of a given point
+* @param pt Query point
+* @param centers list of test centers
+* @param[out] nearest_dist (square) distance to the nearest center
+* @param[out] second_nearest_dist (square) distance to the second nearest center
+* @return id of the nearest center (0-based)
+*/
+template< typename DataType >
+uint32_t NearestCenterIDs( const DataType & pt,
+                           const std::vector< DataType > & centers,
+                           typename KMeansVectorDataTrait<DataType>::scalar_type & nearest_dist,
+                           typename KMeansVectorDataTrait<DataType>::scalar_type & second_nearest_dist )
+{
+  using trait = KMeansVectorDataTrait<DataType>;
+  const uint32_t nb_cluster = static_cast<uint32_t>( centers.size() );
+
+  nearest_dist = std::numeric_limits<typename trait::scalar_type>::max();
+  second_nearest_dist = std::numeric_limits<typename trait::scalar_type>::max();
+  uint32_t nearest_center = nb_cluster;
+
+  for( uint32_t cur_center = 0; cur_center < nb_cluster; ++cur_center )
+  {
+    const typename trait::scalar_type cur_dist = trait::L2( pt, centers[ cur_center ] );
+    if( cur_dist < nearest_dist )
+    {
+      second_nearest_dist = nearest_dist;
+      nearest_dist = cur_dist;
+      nearest_center = cur_center;
+    }
+    else if( cur_dist < second_nearest_dist )
+    {
+      second_nearest_dist = cur_dist;
+    }
+  }
+  return nearest_center;
+}
+
 /**
 * @brief Compute center of mass of a set a points
 * @param pts List of points
 * @param assigned_center Id of the center to be affected to a given point
-* @param nb_center Number of center of mass in the result
+* @param previous_centers Current centers (kept for the clusters without any point)
 * @return New centers of mass
 */
 template< typename DataType >
 std::vector< DataType > ComputeCenterOfMass( const std::vector< DataType > & pts,
     const std::vector< uint32_t > & assigned_center,
-    const uint32_t nb_center )
+    const std::vector< DataType > & previous_centers )
 {
   using trait = KMeansVectorDataTrait<DataType>;
 
+  const uint32_t nb_center = static_cast<uint32_t>( previous_centers.size() );
   std::vector< DataType > new_centers( nb_center, trait::null( pts[0] ) );
   std::vector< uint32_t > nb_per_center( nb_center, 0 );
 
@@ -116,46 +168,37 @@ std::vector< DataType > ComputeCenterOfMass( const std::vector< DataType > & pts
   #pragma omp parallel for
   for( int id_center = 0; id_center < static_cast<int>(nb_center); ++id_center )
   {
-    trait::divide( new_centers[id_center], nb_per_center[id_center] );
+    if( nb_per_center[id_center] == 0 )
+    {
+      new_centers[id_center] = previous_centers[id_center];
+    }
+    else
+    {
+      trait::divide( new_centers[id_center], nb_per_center[id_center] );
+    }
   }
 
   return new_centers;
 }
 
 /**
-* @brief Compute simple kmeans clustering on specified data
+* @brief Initialize the kmeans centers
 * @param source_data Input data
-* @param[out] cluster_assignment index for each point in the input set to a specified cluster
-* @param[out] centers Centers of the clusters
-* @param nb_cluster requested number of cluster in the output
-* @param max_nb_iteration maximum number of iteration to do for clustering
-* @note This is the standard llyod algorithm
+* @param[out] centers Initial centers of the clusters
+* @param nb_cluster requested number of cluster
+* @param init_type kind of initialization
+* @param rng A c++11 random generator
+* @return false if the initialization type is invalid
 */
-template< typename DataType >
-void KMeans( const std::vector< DataType > & source_data,
-             std::vector< uint32_t > & cluster_assignment,
-             std::vector< DataType > & centers,
-             const uint32_t nb_cluster,
-             const uint32_t max_nb_iteration = std::numeric_limits<uint32_t>::max(),
-             const KMeansInitType init_type = KMeansInitType::KMEANS_INIT_PP,
-             system::ProgressInterface * my_progress_bar = nullptr)
+template< typename DataType, typename RngType >
+bool InitializeCenters( const std::vector< DataType > & source_data,
+                        std::vector< DataType > & centers,
+                        const uint32_t nb_cluster,
+                        const KMeansInitType init_type,
+                        RngType & rng )
 {
-  if( source_data.size() == 0 )
-  {
-    return;
-  }
-
-  if (!my_progress_bar)
-    my_progress_bar = &system::ProgressInterface::dummy();
-
-  my_progress_bar->Restart(max_nb_iteration, "- KMeans iterations ---");
-
   using trait = KMeansVectorDataTrait<DataType>;
 
-  std::mt19937_64 rng(std::mt19937_64::default_seed);
-
-
-  // 1 - init center of mass
   if( init_type == KMeansInitType::KMEANS_INIT_PP )
   {
     // Kmeans++ init:
@@ -193,8 +236,28 @@ void KMeans( const std::vector< DataType > & source_data,
   }
   else // Invalid Kmeans initialization type
   {
-    return;
+    return false;
   }
+  return true;
+}
+
+/**
+* @brief Standard Llyod kmeans iterations
+* @param source_data Input data
+* @param[out] cluster_assignment index for each point in the input set to a specified cluster
+* @param[in,out] centers Centers of the clusters
+* @param max_nb_iteration maximum number of iteration to do for clustering
+* @param my_progress_bar progress interface (one increment per iteration)
+* @note Each point is compared to every center on every iteration
+*/
+template< typename DataType >
+void LloydIterations( const std::vector< DataType > & source_data,
+                      std::vector< uint32_t > & cluster_assignment,
+                      std::vector< DataType > & centers,
+                      const uint32_t max_nb_iteration,
+                      system::ProgressInterface * my_progress_bar )
+{
+  const uint32_t nb_cluster = static_cast<uint32_t>( centers.size() );
 
   // Assign all element to the first center
   cluster_assignment.resize( source_data.size(), nb_cluster );
@@ -202,12 +265,11 @@ void KMeans( const std::vector< DataType > & source_data,
   bool changed;
   uint32_t id_iteration = 0;
 
-  // 2 - Perform kmeans
   do
   {
     changed = false;
 
-    // 2.1 affect center to each points
+    // 1 affect center to each points
     #pragma omp parallel for shared(changed)
     for( int id_pt = 0; id_pt < static_cast<int>(source_data.size()); ++id_pt )
     {
@@ -221,8 +283,152 @@ void KMeans( const std::vector< DataType > & source_data,
       }
     }
 
-    // 2.2 Compute new centers of mass
-    centers = ComputeCenterOfMass( source_data, cluster_assignment, nb_cluster );
+    // 2 Compute new centers of mass (empty clusters keep their previous center)
+    centers = ComputeCenterOfMass( source_data, cluster_assignment, centers );
+
+    ++id_iteration;
+    ++(*my_progress_bar);
+  }
+  while( changed && id_iteration < max_nb_iteration );
+}
+
+/**
+* @brief Llyod kmeans iterations accelerated with the Hamerly bounds
+* @param source_data Input data
+* @param[out] cluster_assignment index for each point in the input set to a specified cluster
+* @param[in,out] centers Centers of the clusters
+* @param max_nb_iteration maximum number of iteration to do for clustering
+* @param my_progress_bar progress interface (one increment per iteration)
+* @note It computes the same clustering as LloydIterations, but an upper bound
+*  of the distance to the assigned center and a lower bound of the distance
+*  to the second nearest center are maintained for each point thanks to the
+*  triangle inequality. The distances to the centers are only computed for
+*  the points for which those bounds overlap.
+* @ref "Making k-means even faster", G. Hamerly, SDM 2010.
+*/
+template< typename DataType >
+void HamerlyIterations( const std::vector< DataType > & source_data,
+                        std::vector< uint32_t > & cluster_assignment,
+                        std::vector< DataType > & centers,
+                        const uint32_t max_nb_iteration,
+                        system::ProgressInterface * my_progress_bar )
+{
+  using trait = KMeansVectorDataTrait<DataType>;
+  using scalar_type = typename trait::scalar_type;
+
+  const uint32_t nb_cluster = static_cast<uint32_t>( centers.size() );
+  const int nb_pts = static_cast<int>( source_data.size() );
+
+  // The bounds are (non square) distances, kept in double to not truncate
+  // nor underflow them for the integer scalar types
+  const auto distance = []( const scalar_type square_distance )
+  {
+    return std::sqrt( static_cast<double>( square_distance ) );
+  };
+
+  // Upper bound of the distance of each point to its assigned center
+  std::vector< double > upper_bound( nb_pts );
+  // Lower bound of the distance of each point to its second nearest center
+  std::vector< double > lower_bound( nb_pts );
+  // Half of the distance of each center to its nearest other center
+  std::vector< double > half_center_gap( nb_cluster );
+  // Distance moved by each center during the last update
+  std::vector< double > center_shift( nb_cluster );
+
+  cluster_assignment.resize( source_data.size(), nb_cluster );
+
+  bool changed;
+  uint32_t id_iteration = 0;
+
+  do
+  {
+    changed = false;
+
+    // 1 affect center to each points
+    if( id_iteration == 0 )
+    {
+      // Initialize the bounds with an exhaustive search
+      changed = true;
+      #pragma omp parallel for
+      for( int id_pt = 0; id_pt < nb_pts; ++id_pt )
+      {
+        scalar_type nearest_dist, second_nearest_dist;
+        cluster_assignment[id_pt] =
+          NearestCenterIDs( source_data[id_pt], centers, nearest_dist, second_nearest_dist );
+        upper_bound[id_pt] = distance( nearest_dist );
+        lower_bound[id_pt] = distance( second_nearest_dist );
+      }
+    }
+    else
+    {
+      #pragma omp parallel for
+      for( int id_center = 0; id_center < static_cast<int>( nb_cluster ); ++id_center )
+      {
+        scalar_type min_dist = std::numeric_limits<scalar_type>::max();
+        for( uint32_t id_other = 0; id_other < nb_cluster; ++id_other )
+        {
+          if( id_other != static_cast<uint32_t>( id_center ) )
+            min_dist = std::min( min_dist, trait::L2( centers[id_center], centers[id_other] ) );
+        }
+        half_center_gap[id_center] = distance( min_dist ) / 2.0;
+      }
+
+      #pragma omp parallel for shared(changed)
+      for( int id_pt = 0; id_pt < nb_pts; ++id_pt )
+      {
+        const uint32_t assigned_center = cluster_assignment[id_pt];
+        const double bound = std::max( half_center_gap[assigned_center], lower_bound[id_pt] );
+        if( upper_bound[id_pt] <= bound )
+          continue;
+        // Tighten the upper bound and test again
+        const DataType & cur_pt = source_data[id_pt];
+        upper_bound[id_pt] = distance( trait::L2( cur_pt, centers[assigned_center] ) );
+        if( upper_bound[id_pt] <= bound )
+          continue;
+        // The bounds overlap, an exhaustive search is required
+        scalar_type nearest_dist, second_nearest_dist;
+        const uint32_t nearest_center =
+          NearestCenterIDs( cur_pt, centers, nearest_dist, second_nearest_dist );
+        upper_bound[id_pt] = distance( nearest_dist );
+        lower_bound[id_pt] = distance( second_nearest_dist );
+        if( nearest_center != assigned_center )
+        {
+          cluster_assignment[id_pt] = nearest_center;
+          changed = true;
+        }
+      }
+    }
+
+    // 2 Compute new centers of mass (empty clusters keep their previous center)
+    std::vector< DataType > new_centers =
+      ComputeCenterOfMass( source_data, cluster_assignment, centers );
+
+    // 3 Update the bounds according to the center motions
+    uint32_t id_max_shift = 0;
+    double max_shift = 0.0, second_max_shift = 0.0;
+    for( uint32_t id_center = 0; id_center < nb_cluster; ++id_center )
+    {
+      center_shift[id_center] = distance( trait::L2( centers[id_center], new_centers[id_center] ) );
+      if( center_shift[id_center] > max_shift )
+      {
+        second_max_shift = max_shift;
+        max_shift = center_shift[id_center];
+        id_max_shift = id_center;
+      }
+      else if( center_shift[id_center] > second_max_shift )
+      {
+        second_max_shift = center_shift[id_center];
+      }
+    }
+    centers = std::move( new_centers );
+
+    #pragma omp parallel for
+    for( int id_pt = 0; id_pt < nb_pts; ++id_pt )
+    {
+      const uint32_t assigned_center = cluster_assignment[id_pt];
+      upper_bound[id_pt] += center_shift[assigned_center];
+      lower_bound[id_pt] -= ( assigned_center == id_max_shift ) ? second_max_shift : max_shift;
+    }
 
     ++id_iteration;
     ++(*my_progress_bar);
@@ -230,6 +436,221 @@ void KMeans( const std::vector< DataType > & source_data,
   while( changed && id_iteration < max_nb_iteration );
 }
 
+/**
+* @brief Mini-batch kmeans iterations
+* @param source_data Input data
+* @param[out] cluster_assignment index for each point in the input set to a specified cluster
+* @param[in,out] centers Centers of the clusters
+* @param max_nb_iteration maximum number of epochs (one epoch process as many
+*  points as the input set size)
+* @param batch_size number of points randomly sampled in each mini-batch
+* @param rng A c++11 random generator
+* @param my_progress_bar progress interface (one increment per epoch)
+* @note Each mini-batch moves the centers toward the mean of the points
+*  assigned to them with a per center learning rate (1 / number of points
+*  assigned so far). The centers are updated incrementally in double
+*  precision, so that integer data types neither overflow nor get truncated
+*  along the iterations. The iterations stop when the smoothed mini-batch
+*  inertia has not improved for several consecutive mini-batches.
+* @ref "Web-scale k-means clustering", D. Sculley, WWW 2010.
+*/
+template< typename DataType, typename RngType >
+void MiniBatchIterations( const std::vector< DataType > & source_data,
+                          std::vector< uint32_t > & cluster_assignment,
+                          std::vector< DataType > & centers,
+                          const uint32_t max_nb_iteration,
+                          const uint32_t batch_size,
+                          RngType & rng,
+                          system::ProgressInterface * my_progress_bar )
+{
+  using trait = KMeansVectorDataTrait<DataType>;
+  using scalar_type = typename trait::scalar_type;
+
+  const uint32_t nb_cluster = static_cast<uint32_t>( centers.size() );
+  const size_t nb_pts = source_data.size();
+  const int nb_batch_pts = static_cast<int>( std::min<size_t>( batch_size, nb_pts ) );
+
+  // Number of mini-batches (saturated to avoid overflow)
+  const uint64_t nb_batch_per_epoch = ( nb_pts + nb_batch_pts - 1 ) / nb_batch_pts;
+  const uint64_t max_nb_batch =
+    ( max_nb_iteration == std::numeric_limits<uint32_t>::max() ) ?
+      std::numeric_limits<uint64_t>::max() :
+      static_cast<uint64_t>( max_nb_iteration ) * nb_batch_per_epoch;
+
+  // Early stop once the smoothed inertia does not improve anymore
+  const uint32_t max_no_improvement = 10;
+  const double inertia_smoothing = std::min( 1.0, 2.0 * nb_batch_pts / ( nb_pts + 1.0 ) );
+  double smoothed_inertia = 0.0;
+  double best_smoothed_inertia = std::numeric_limits<double>::max();
+  uint32_t no_improvement_count = 0;
+
+  // Floating point copy of the centers (the running means)
+  const size_t dimension = static_cast<size_t>( source_data[0].size() );
+  std::vector< std::vector< double > > center_means( nb_cluster, std::vector< double >( dimension ) );
+  for( uint32_t id_center = 0; id_center < nb_cluster; ++id_center )
+  {
+    for( size_t id_dim = 0; id_dim < dimension; ++id_dim )
+    {
+      center_means[id_center][id_dim] = static_cast<double>( centers[id_center][id_dim] );
+    }
+  }
+
+  // Reused mini-batch buffers
+  std::vector< size_t > nb_per_center( nb_cluster, 0 );
+  std::vector< size_t > batch_ids( nb_batch_pts );
+  std::vector< uint32_t > batch_assignment( nb_batch_pts );
+  std::vector< scalar_type > batch_dists( nb_batch_pts );
+  std::vector< std::vector< double > > batch_sums( nb_cluster, std::vector< double >( dimension ) );
+  std::vector< uint32_t > batch_nb_per_center( nb_cluster );
+
+  std::uniform_int_distribution<size_t> distrib( 0, nb_pts - 1 );
+
+  for( uint64_t id_batch = 0; id_batch < max_nb_batch; ++id_batch )
+  {
+    // 1 Sample a mini-batch and find the nearest center of its points
+    for( auto & id_pt : batch_ids )
+    {
+      id_pt = distrib( rng );
+    }
+
+    #pragma omp parallel for
+    for( int id_batch_pt = 0; id_batch_pt < nb_batch_pts; ++id_batch_pt )
+    {
+      const DataType & cur_pt = source_data[batch_ids[id_batch_pt]];
+      batch_assignment[id_batch_pt] = NearestCenterID( cur_pt, centers );
+      batch_dists[id_batch_pt] = trait::L2( cur_pt, centers[batch_assignment[id_batch_pt]] );
+    }
+
+    // 2 Move the centers to the running mean of their assigned points
+    std::fill( batch_nb_per_center.begin(), batch_nb_per_center.end(), 0 );
+    double batch_inertia = 0.0;
+    for( int id_batch_pt = 0; id_batch_pt < nb_batch_pts; ++id_batch_pt )
+    {
+      const uint32_t id_center = batch_assignment[id_batch_pt];
+      if( batch_nb_per_center[id_center] == 0 )
+      {
+        std::fill( batch_sums[id_center].begin(), batch_sums[id_center].end(), 0.0 );
+      }
+      const DataType & cur_pt = source_data[batch_ids[id_batch_pt]];
+      for( size_t id_dim = 0; id_dim < dimension; ++id_dim )
+      {
+        batch_sums[id_center][id_dim] += static_cast<double>( cur_pt[id_dim] );
+      }
+      ++batch_nb_per_center[id_center];
+      batch_inertia += batch_dists[id_batch_pt];
+    }
+    batch_inertia /= nb_batch_pts;
+
+    for( uint32_t id_center = 0; id_center < nb_cluster; ++id_center )
+    {
+      if( batch_nb_per_center[id_center] == 0 )
+        continue;
+      // c += (batch_sum - n_b * c) / n_total
+      nb_per_center[id_center] += batch_nb_per_center[id_center];
+      const double nb_batch_center_pts = batch_nb_per_center[id_center];
+      const double nb_center_pts = nb_per_center[id_center];
+      std::vector< double > & cur_mean = center_means[id_center];
+      DataType & cur_center = centers[id_center];
+      for( size_t id_dim = 0; id_dim < dimension; ++id_dim )
+      {
+        cur_mean[id_dim] +=
+          ( batch_sums[id_center][id_dim] - nb_batch_center_pts * cur_mean[id_dim] ) / nb_center_pts;
+        cur_center[id_dim] = static_cast<scalar_type>(
+          std::is_integral<scalar_type>::value ? std::round( cur_mean[id_dim] ) : cur_mean[id_dim] );
+      }
+    }
+
+    if( ( id_batch + 1 ) % nb_batch_per_epoch == 0 )
+    {
+      ++(*my_progress_bar);
+    }
+
+    // 3 Convergence test
+    smoothed_inertia = ( id_batch == 0 ) ?
+      batch_inertia :
+      smoothed_inertia * ( 1.0 - inertia_smoothing ) + batch_inertia * inertia_smoothing;
+    if( smoothed_inertia < best_smoothed_inertia )
+    {
+      best_smoothed_inertia = smoothed_inertia;
+      no_improvement_count = 0;
+    }
+    else if( ++no_improvement_count >= max_no_improvement )
+    {
+      break;
+    }
+  }
+
+  // Final assignment of the whole input set
+  cluster_assignment.resize( nb_pts );
+  #pragma omp parallel for
+  for( int id_pt = 0; id_pt < static_cast<int>( nb_pts ); ++id_pt )
+  {
+    cluster_assignment[id_pt] = NearestCenterID( source_data[id_pt], centers );
+  }
+}
+
+/**
+* @brief Compute simple kmeans clustering on specified data
+* @param source_data Input data
+* @param[out] cluster_assignment index for each point in the input set to a specified cluster
+* @param[out] centers Centers of the clusters
+* @param nb_cluster requested number of cluster in the output
+* @param max_nb_iteration maximum number of iteration to do for clustering
+* @param init_type kind of initialization of the centers
+* @param my_progress_bar progress interface
+* @param solver_type kind of kmeans iterations
+* @note The default solver is the standard llyod algorithm.
+*  KMEANS_HAMERLY computes the same clustering faster (mainly for large number of clusters).
+*  KMEANS_MINI_BATCH approximates the clustering using mini-batches of
+*  max(1024, 8 * nb_cluster) points, for this solver an iteration is an epoch.
+*/
+template< typename DataType >
+void KMeans( const std::vector< DataType > & source_data,
+             std::vector< uint32_t > & cluster_assignment,
+             std::vector< DataType > & centers,
+             const uint32_t nb_cluster,
+             const uint32_t max_nb_iteration = std::numeric_limits<uint32_t>::max(),
+             const KMeansInitType init_type = KMeansInitType::KMEANS_INIT_PP,
+             system::ProgressInterface * my_progress_bar = nullptr,
+             const KMeansSolverType solver_type = KMeansSolverType::KMEANS_LLOYD )
+{
+  if( source_data.size() == 0 )
+  {
+    return;
+  }
+
+  if (!my_progress_bar)
+    my_progress_bar = &system::ProgressInterface::dummy();
+
+  my_progress_bar->Restart(max_nb_iteration, "- KMeans iterations ---");
+
+  std::mt19937_64 rng(std::mt19937_64::default_seed);
+
+  // 1 - init center of mass
+  if( !InitializeCenters( source_data, centers, nb_cluster, init_type, rng ) )
+  {
+    return;
+  }
+
+  // 2 - Perform kmeans
+  switch( solver_type )
+  {
+    case KMeansSolverType::KMEANS_LLOYD:
+      LloydIterations( source_data, cluster_assignment, centers,
+                       max_nb_iteration, my_progress_bar );
+      break;
+    case KMeansSolverType::KMEANS_HAMERLY:
+      HamerlyIterations( source_data, cluster_assignment, centers,
+                         max_nb_iteration, my_progress_bar );
+      break;
+    case KMeansSolverType::KMEANS_MINI_BATCH:
+      MiniBatchIterations( source_data, cluster_assignment, centers,
+                           max_nb_iteration, std::max<uint32_t>( 1024, 8 * nb_cluster ),
+                           rng, my_progress_bar );
+      break;
+  }
+}
+
 } // namespace clustering
 } // namespace openMVG
 
@@ -10,6 +10,7 @@
 
 #include "testing/testing.h"
 
+#include <algorithm>
 #include <random>
 #include <vector>
 
@@ -23,6 +24,9 @@ static const std::array<int, 3> POINTS_PER_CLUSTER =
   {NB_POINT, NB_POINT, NB_POINT};
 static const std::array<KMeansInitType, 2> KMEAN_INIT_TYPES =
   {KMeansInitType::KMEANS_INIT_RANDOM, KMeansInitType::KMEANS_INIT_PP};
+static const std::array<KMeansSolverType, 3> KMEAN_SOLVER_TYPES =
+  {KMeansSolverType::KMEANS_LLOYD, KMeansSolverType::KMEANS_HAMERLY,
+   KMeansSolverType::KMEANS_MINI_BATCH};
 
 // Initialize NB_CLUSTER centers and POINTS_PER_CLUSTER[i] points around each centroid
 // Note: Clusters and points are column based
@@ -80,7 +84,8 @@ void KMeanTesting
   std::vector< typename ContainerType::value_type > & centers,
   const int dimension,
   const KMeansInitType k_mean_init_type,
-  const uint32_t k_mean_centers = 3
+  const uint32_t k_mean_centers = 3,
+  const KMeansSolverType k_mean_solver_type = KMeansSolverType::KMEANS_LLOYD
 )
 {
   // Data initialization (centers and data_points)
@@ -92,7 +97,8 @@ void KMeanTesting
 
   // K-Means clustering:
   KMeans(pts, ids, centers, k_mean_centers,
-         std::numeric_limits<uint32_t>::max(), k_mean_init_type );
+         std::numeric_limits<uint32_t>::max(), k_mean_init_type,
+         nullptr, k_mean_solver_type );
 }
 
 // Check the result of the KMean Ids classification
@@ -359,6 +365,139 @@ TEST( clustering, threeClustersEigenVecf )
   }
 }
 
+TEST( clustering, threeClustersSolvers )
+{
+  const int dimension = 6;
+  using DataPointType = Vecf;
+  using ContainerType = std::vector<DataPointType>;
+
+  for (const auto kmean_solver_type : KMEAN_SOLVER_TYPES)
+  {
+    for (const auto kmean_init_type : KMEAN_INIT_TYPES)
+    {
+      std::vector<uint32_t> ids;
+      std::vector<DataPointType> centers;
+      KMeanTesting<ContainerType>
+      (
+        ids,
+        centers,
+        dimension,
+        kmean_init_type,
+        NB_CLUSTER,
+        kmean_solver_type
+      );
+
+      KMEANS_CHECK_VALIDITY(NB_CLUSTER, ids);
+    }
+  }
+}
+
+// Run every kmeans solver with the same seed on some points sampled around
+// some random modes (SIFT like range)
+template< typename DataType >
+void RunSolvers
+(
+  const int dimension,
+  const int nb_point,
+  const uint32_t nb_cluster,
+  std::vector<std::vector<uint32_t>> & ids_per_solver,
+  std::vector<double> & inertia_per_solver
+)
+{
+  using trait = KMeansVectorDataTrait<DataType>;
+  using scalar_type = typename trait::scalar_type;
+  const uint32_t max_nb_iteration = 25;
+
+  std::mt19937_64 rng(std::mt19937_64::default_seed);
+  std::uniform_real_distribution<float> distrib(0.f, 255.f);
+  std::normal_distribution<float> noise(0.f, 50.f);
+  std::vector<std::vector<float>> modes(2 * nb_cluster, std::vector<float>(dimension));
+  for (auto & mode : modes)
+    for (int i = 0; i < dimension; ++i)
+      mode[i] = distrib(rng);
+  std::vector<DataType> pts(nb_point);
+  for (int id_pt = 0; id_pt < nb_point; ++id_pt)
+  {
+    pts[id_pt] = DataType(dimension);
+    for (int i = 0; i < dimension; ++i)
+      pts[id_pt][i] = static_cast<scalar_type>(
+        std::max(0.f, modes[id_pt % modes.size()][i] + noise(rng)));
+  }
+
+  ids_per_solver.clear();
+  inertia_per_solver.clear();
+  for (const auto kmean_solver_type : KMEAN_SOLVER_TYPES)
+  {
+    std::vector<uint32_t> ids;
+    std::vector<DataType> centers;
+    KMeans(pts, ids, centers, nb_cluster, max_nb_iteration,
+           KMeansInitType::KMEANS_INIT_RANDOM, nullptr, kmean_solver_type);
+    double inertia = 0.0;
+    for (size_t i = 0; i < ids.size(); ++i)
+      inertia += static_cast<double>(trait::L2(pts[i], centers[ids[i]]));
+    ids_per_solver.push_back(ids);
+    inertia_per_solver.push_back(inertia / nb_point);
+  }
+}
+
+// Compare the accelerated solvers to the standard Llyod iterations
+// (inertia and assignment agreement) for a floating point and an integer
+// data type
+TEST( clustering, solversComparison )
+{
+  const int dimension = 16;
+  const int nb_point = 4000;
+  const uint32_t nb_cluster = 16;
+
+  for (const bool integer_data : {false, true})
+  {
+    std::vector<std::vector<uint32_t>> ids_per_solver;
+    std::vector<double> inertia_per_solver;
+    if (integer_data)
+      RunSolvers<std::vector<int>>(dimension, nb_point, nb_cluster,
+                                   ids_per_solver, inertia_per_solver);
+    else
+      RunSolvers<Vecf>(dimension, nb_point, nb_cluster,
+                       ids_per_solver, inertia_per_solver);
+
+    for (const auto & ids : ids_per_solver)
+      EXPECT_EQ(nb_point, ids.size());
+
+    const auto & lloyd_ids = ids_per_solver[0];
+    const double lloyd_inertia = inertia_per_solver[0];
+    // Exact solver: same clustering as the Llyod iterations
+    EXPECT_TRUE(lloyd_ids == ids_per_solver[1]);
+    EXPECT_NEAR(lloyd_inertia, inertia_per_solver[1], 1e-6 * lloyd_inertia);
+    // Approximated solver
+    EXPECT_TRUE(inertia_per_solver[2] < 1.05 * lloyd_inertia);
+  }
+}
+
+// A cluster that gets no point keeps its previous center with both the
+// Llyod and the Hamerly iterations
+TEST( clustering, emptyCluster )
+{
+  const std::vector<Vec2> pts = {{0, 0}, {1, 0}, {10, 0}, {11, 0}};
+  const std::vector<Vec2> init_centers = {{0, 0}, {10, 0}, {100, 0}};
+
+  std::vector<uint32_t> lloyd_ids, hamerly_ids;
+  std::vector<Vec2> lloyd_centers = init_centers, hamerly_centers = init_centers;
+  LloydIterations(pts, lloyd_ids, lloyd_centers, 10,
+                  &system::ProgressInterface::dummy());
+  HamerlyIterations(pts, hamerly_ids, hamerly_centers, 10,
+                    &system::ProgressInterface::dummy());
+
+  EXPECT_TRUE((std::vector<uint32_t>{0, 0, 1, 1}) == lloyd_ids);
+  EXPECT_TRUE(lloyd_ids == hamerly_ids);
+  for (const auto & centers : {lloyd_centers, hamerly_centers})
+  {
+    EXPECT_EQ(3, centers.size());
+    EXPECT_MATRIX_NEAR(Vec2(0.5, 0), centers[0], 1e-8);
+    EXPECT_MATRIX_NEAR(Vec2(10.5, 0), centers[1], 1e-8);
+    EXPECT_MATRIX_NEAR(Vec2(100, 0), centers[2], 1e-8);
+  }
+}
+
 /* ************************************************************************* */
 int main()
 {
@@ -91,6 +91,14 @@ class KMeansVectorDataTrait
     * @note this perform self /= data (component-wise)
     */
     static void divide( type & self, const size_t val );
+
+    /**
+    * @brief Scalar multiplication
+    * @param self Vector to multiply
+    * @param val scalar multiplier
+    * @note this perform self *= val (component-wise)
+    */
+    static void multiply( type & self, const size_t val );
 };
 
 /**
@@ -216,6 +224,18 @@ class KMeansVectorDataTrait<std::array<T, N>>
       map_self /= static_cast<scalar_type>( val );
     }
 
+    /**
+    * @brief Scalar multiplication
+    * @param self Vector to multiply
+    * @param val scalar multiplier
+    * @note this perform self *= val (component-wise)
+    */
+    static void multiply( type & self, const size_t val )
+    {
+      VecTypeMap map_self(self.data(), self.size());
+      map_self *= static_cast<scalar_type>( val );
+    }
+
 };
 
 /**
@@ -338,6 +358,18 @@ class KMeansVectorDataTrait<std::vector<T>>
       VecTypeMap map_self(self.data(), self.size());
       map_self /= static_cast<scalar_type>( val );
     }
+
+    /**
+    * @brief Scalar multiplication
+    * @param self Vector to multiply
+    * @param val scalar multiplier
+    * @note this perform self *= val (component-wise)
+    */
+    static void multiply( type & self, const size_t val )
+    {
+      VecTypeMap map_self(self.data(), self.size());
+      map_self *= static_cast<scalar_type>( val );
+    }
 };
 
 /*
@@ -447,6 +479,17 @@ class KMeansVectorDataTrait<Eigen::Matrix<T, N, 1>>
     {
       self /= static_cast<scalar_type>( val );
     }
+
+    /**
+    * @brief Scalar multiplication
+    * @param self Vector to multiply
+    * @param val scalar multiplier
+    * @note this perform self *= val (component-wise)
+    */
+    static void multiply( type & self, const size_t val )
+    {
+      self *= static_cast<scalar_type>( val );
+    }
 };
 
 /**
@@ -534,7 +577,7 @@ class KMeansVectorDataTrait<Vec>
     */
     static type null( const type & dummy )
     {
-      static type res( dummy.size() );
+      type res( dummy.size() );
       res.fill( scalar_type( 0 ) );
       return res;
     }
@@ -560,6 +603,17 @@ class KMeansVectorDataTrait<Vec>
     {
       self /= static_cast<scalar_type>( val );
     }
+
+    /**
+    * @brief Scalar multiplication
+    * @param self Vector to multiply
+    * @param val scalar multiplier
+    * @note this perform self *= val (component-wise)
+    */
+    static void multiply( type & self, const size_t val )
+    {
+      self *= static_cast<scalar_type>( val );
+    }
 };
 
 /**
@@ -647,7 +701,7 @@ class KMeansVectorDataTrait<Vecf>
     */
     static type null( const type & dummy )
     {
-      static type res( dummy.size() );
+      type res( dummy.size() );
       res.fill( scalar_type( 0 ) );
       return res;
     }
@@ -673,6 +727,17 @@ class KMeansVectorDataTrait<Vecf>
     {
       self /= static_cast<scalar_type>( val );
     }
+
+    /**
+    * @brief Scalar multiplication
+    * @param self Vector to multiply
+    * @param val scalar multiplier
+    * @note this perform self *= val (component-wise)
+    */
+    static void multiply( type & self, const size_t val )
+    {
+      self *= static_cast<scalar_type>( val );
+    }
 };
 
 } // namespace clustering
@@ -8,6 +8,8 @@
 
 #include "openMVG/exif/exif_IO_EasyExif.hpp"
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <limits>
 #include <sstream>
@@ -59,27 +61,97 @@ Exif_IO_EasyExif::Exif_IO_EasyExif( const std::string & sFileName ):
   open( sFileName );
 }
 
+/**
+* Walk the JPEG header markers and read the APP1 "Exif" segment (if any).
+* Only the segment headers and the EXIF segment are read from the file,
+* the walk stops at the first scan (SOS) marker.
+* @param fp file opened in binary mode
+* @param[out] segment the EXIF segment content (starting with "Exif\0\0")
+* @retval true if an EXIF segment has been found
+*/
+static bool ReadJpegExifSegment( FILE * fp, std::vector<unsigned char> & segment )
+{
+  unsigned char soi[2];
+  if ( fread( soi, 1, 2, fp ) != 2 || soi[0] != 0xFF || soi[1] != 0xD8 )
+  {
+    return false; // Not a JPEG file
+  }
+
+  while ( true )
+  {
+    int marker = fgetc( fp );
+    if ( marker != 0xFF )
+    {
+      return false; // Corrupted marker structure
+    }
+    // Skip the fill bytes
+    while ( marker == 0xFF )
+    {
+      marker = fgetc( fp );
+    }
+    if ( marker == EOF || marker == 0xDA || marker == 0xD9 )
+    {
+      return false; // Reached the image data (SOS) or the end of the image (EOI)
+    }
+    // Standalone markers (TEM, RSTn, SOI) have no payload
+    if ( marker == 0x01 || ( marker >= 0xD0 && marker <= 0xD8 ) )
+    {
+      continue;
+    }
+
+    unsigned char length_bytes[2];
+    if ( fread( length_bytes, 1, 2, fp ) != 2 )
+    {
+      return false;
+    }
+    // The marker length is stored in Motorola byte order and counts itself
+    const unsigned int length = ( length_bytes[0] << 8 ) | length_bytes[1];
+    if ( length < 2 )
+    {
+      return false;
+    }
+    const unsigned int payload_length = length - 2;
+
+    // APP1 segment: it must contain at least the "Exif\0\0" string and the TIFF header
+    if ( marker == 0xE1 && payload_length >= 14 )
+    {
+      segment.resize( payload_length );
+      if ( fread( segment.data(), 1, payload_length, fp ) != payload_length )
+      {
+        return false;
+      }
+      static const unsigned char exif_header[6] = {'E', 'x', 'i', 'f', 0, 0};
+      if ( std::equal( exif_header, exif_header + 6, segment.begin() ) )
+      {
+        return true;
+      }
+      // Another APP1 segment (i.e XMP metadata), keep searching
+    }
+    else if ( fseek( fp, payload_length, SEEK_CUR ) != 0 )
+    {
+      return false;
+    }
+  }
+}
+
 bool Exif_IO_EasyExif::open( const std::string & sFileName )
 {
-  // Read the file into a buffer
+  (*pimpl_).get().clear();
+  bHaveExifInfo_ = false;
+
   FILE *fp = fopen( sFileName.c_str(), "rb" );
   if ( !fp )
   {
     return false;
   }
-  fseek( fp, 0, SEEK_END );
-  unsigned long fsize = ftell( fp );
-  rewind( fp );
-  std::vector<unsigned char> buf( fsize );
-  if ( fread( &buf[0], 1, fsize, fp ) != fsize )
-  {
-    fclose( fp );
-    return false;
-  }
+  // Read only the EXIF segment rather than the whole image file
+  std::vector<unsigned char> segment;
+  const bool bHaveExifSegment = ReadJpegExifSegment( fp, segment );
   fclose( fp );
 
   // Parse EXIF
-  bHaveExifInfo_ = ( (*pimpl_).get().parseFrom( &buf[0], fsize ) == PARSE_EXIF_SUCCESS );
+  bHaveExifInfo_ = bHaveExifSegment &&
+    ( (*pimpl_).get().parseFromEXIFSegment( segment.data(), static_cast<unsigned>( segment.size() ) ) == PARSE_EXIF_SUCCESS );
 
   return bHaveExifInfo_;
 }
@@ -11,8 +11,10 @@
 #include "testing/testing.h"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 using namespace std;
 using namespace openMVG;
@@ -53,6 +55,42 @@ TEST(Matching, Exif_IO_easyexif_ReadData)
   EXPECT_FALSE(exif_io->GPSAltitude(&val));
 }
 
+TEST(Matching, Exif_IO_easyexif_ReadData_headerOnly)
+{
+  // Keep only the beginning of the image file (the JPEG header segments):
+  // the EXIF data must be read without the image data
+  std::ifstream in( sImg, std::ios::binary );
+  std::vector<char> header( 64 * 1024 );
+  in.read( header.data(), header.size() );
+  EXPECT_EQ( header.size(), in.gcount() );
+
+  const std::string sTruncatedImg = "truncated_exif.jpg";
+  {
+    std::ofstream out( sTruncatedImg, std::ios::binary );
+    out.write( header.data(), header.size() );
+  }
+  std::unique_ptr<Exif_IO> exif_io ( new Exif_IO_EasyExif( sTruncatedImg ) );
+  stlplus::file_delete( sTruncatedImg );
+
+  EXPECT_TRUE( exif_io->doesHaveExifInfo());
+  EXPECT_EQ( "KODAK Z612 ZOOM DIGITAL CAMERA", exif_io->getModel());
+  EXPECT_NEAR( 5.85, exif_io->getFocal(), 1e-2);
+}
+
+TEST(Matching, Exif_IO_easyexif_ReadData_notJpeg)
+{
+  const std::string sNotJpeg = "not_a_jpeg.jpg";
+  {
+    std::ofstream out( sNotJpeg );
+    out << "Exif data are only read from JPEG files";
+  }
+  std::unique_ptr<Exif_IO> exif_io ( new Exif_IO_EasyExif( sNotJpeg ) );
+  stlplus::file_delete( sNotJpeg );
+
+  EXPECT_FALSE( exif_io->doesHaveExifInfo());
+  EXPECT_EQ( "", exif_io->getModel());
+}
+
 TEST(Matching, Exif_IO_easyexif_Read_GPS_Data)
 {
   const std::string sImg_gps = std::string(THIS_SOURCE_DIR) + "/image_data/gps_tag.jpg";
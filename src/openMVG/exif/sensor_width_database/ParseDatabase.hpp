@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <fstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "openMVG/exif/sensor_width_database/datasheet.hpp"
@@ -76,4 +77,52 @@ bool getInfo
   return existInDatabase;
 }
 
+// Index of the database entries (ids in the database vector) by camera maker
+using DatasheetIndex = std::unordered_map<std::string, std::vector<std::size_t>>;
+
+// Build the camera maker index of the database, used to avoid scanning
+//  the whole database for each query
+inline void buildDatabaseIndex
+(
+  const std::vector<Datasheet>& vec_database,
+  DatasheetIndex& database_index
+)
+{
+  database_index.clear();
+  for (std::size_t i = 0; i < vec_database.size(); ++i)
+  {
+    database_index[datasheetMaker(vec_database[i].model_)].push_back(i);
+  }
+}
+
+// Retrieve camera 'Datasheet' information for the given camera model model name
+//  iff it is found in the database.
+// Only the database entries sharing the camera maker are tested, in database order,
+//  so the result is the same as the linear search.
+inline bool getInfo
+(
+  const std::string & sModel,
+  const std::vector<Datasheet>& vec_database,
+  const DatasheetIndex& database_index,
+  Datasheet& datasheetContent
+)
+{
+  const auto maker_entries = database_index.find(datasheetMaker(sModel));
+  if ( maker_entries == database_index.end() )
+  {
+    return false;
+  }
+
+  const Datasheet refDatasheet( sModel, -1. );
+  for (const std::size_t id : maker_entries->second)
+  {
+    if ( vec_database[id] == refDatasheet )
+    {
+      datasheetContent = vec_database[id];
+      return true;
+    }
+  }
+  return false;
+}
+
 #endif // OPENMVG_EXIF_SENSOR_WIDTH_PARSE_DATABASE_HPP
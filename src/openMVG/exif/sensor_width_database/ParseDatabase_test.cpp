@@ -129,6 +129,38 @@ TEST(Matching, ParseDatabaseCanon_EOS_M)
   EXPECT_EQ( 22.3, datasheet.sensorSize_ );
 }
 
+TEST(Matching, ParseDatabaseIndex)
+{
+  std::vector<Datasheet> vec_database;
+  const std::string sfileDatabase = stlplus::create_filespec( std::string(THIS_SOURCE_DIR), sDatabase );
+  EXPECT_TRUE( parseDatabase( sfileDatabase, vec_database ) );
+
+  DatasheetIndex database_index;
+  buildDatabaseIndex( vec_database, database_index );
+  EXPECT_TRUE( !database_index.empty() );
+
+  // The indexed search must give the same result as the linear search
+  std::vector<std::string> models = {
+    "Canon PowerShot SD900", "Canon EOS 5D Mark II", "Canon EOS M",
+    "canon eos 550d", "KODAK Z612 ZOOM DIGITAL CAMERA", "NotExistModel", ""};
+  for (const Datasheet & datasheet : vec_database)
+  {
+    models.push_back( datasheet.model_ );
+  }
+  for (const std::string & sModel : models)
+  {
+    Datasheet datasheet_linear, datasheet_indexed;
+    const bool found_linear = getInfo( sModel, vec_database, datasheet_linear );
+    const bool found_indexed = getInfo( sModel, vec_database, database_index, datasheet_indexed );
+    EXPECT_EQ( found_linear, found_indexed );
+    if ( found_linear && found_indexed )
+    {
+      EXPECT_EQ( datasheet_linear.model_, datasheet_indexed.model_ );
+      EXPECT_EQ( datasheet_linear.sensorSize_, datasheet_indexed.sensorSize_ );
+    }
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
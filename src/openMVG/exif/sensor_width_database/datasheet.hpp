@@ -15,6 +15,15 @@
 
 #include "openMVG/stl/split.hpp"
 
+// Return the camera maker of a camera model string ("MAKER MODELNAME"),
+//  in lower case. Two Datasheet can only be equal if they share the same maker.
+inline std::string datasheetMaker( const std::string & model )
+{
+  std::string maker = model.substr( 0, model.find( ' ' ) );
+  std::transform(maker.begin(), maker.end(), maker.begin(), ::tolower);
+  return maker;
+}
+
 // Database structure to store camera model and sensor size
 struct Datasheet
 {
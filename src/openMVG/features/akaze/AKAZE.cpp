@@ -107,87 +107,80 @@ float AKAZE::ComputeAutomaticContrastFactor( const Image<float> & src , const fl
 
 const float fderivative_factor = 1.5f;      // Factor for the multiscale derivatives
 
-void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const int q , const int nbSlice ,
+void AKAZE::ComputeAKAZESliceDiffusion( const Image<float> & src , const int p , const int q , const int nbSlice ,
                         const float sigma0 , // first octave initial scale
                         const float contrast_factor ,
-                        Image<float> & Li , // Diffusion image
-                        Image<float> & Lx , // X derivatives
-                        Image<float> & Ly , // Y derivatives
-                        Image<float> & Lhess ) // Det(Hessian)
+                        Image<float> & Li ) // Diffusion image
 {
-  const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
-  const float ratio = 1 << p; //pow(2,p);
-  const int sigma_scale = std::round(sigma_cur * fderivative_factor / ratio);
-
-  Image<float> smoothed;
   if (p == 0 && q == 0 )
   {
     // Compute new image
     ImageGaussianFilter( src , sigma0 , Li, 0, 0);
+    return;
   }
-  else
-  {
-    // general case
-    Image<float> in;
-    if (q == 0 )  {
-      ImageHalfSample( src , in );
-    }
-    else {
-      in = src;
-    }
 
-    const float sigma_prev = ( q == 0 ) ? Sigma( sigma0 , p - 1 , nbSlice - 1 , nbSlice ) : Sigma( sigma0 , p , q - 1 , nbSlice );
+  // general case
+  Image<float> & in = Li;
+  if (q == 0 )  {
+    ImageHalfSample( src , in );
+  }
+  else {
+    in = src;
+  }
 
-    // Compute non linear timing between two consecutive slices
-    const float t_prev = 0.5f * ( sigma_prev * sigma_prev );
-    const float t_cur  = 0.5f * ( sigma_cur * sigma_cur );
-    const float total_cycle_time = t_cur - t_prev;
+  const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
+  const float sigma_prev = ( q == 0 ) ? Sigma( sigma0 , p - 1 , nbSlice - 1 , nbSlice ) : Sigma( sigma0 , p , q - 1 , nbSlice );
 
-    // Compute first derivatives (Scharr scale 1, non normalized) for diffusion coef
-    ImageGaussianFilter( in , 1.f , smoothed, 0, 0 );
+  // Compute non linear timing between two consecutive slices
+  const float t_prev = 0.5f * ( sigma_prev * sigma_prev );
+  const float t_cur  = 0.5f * ( sigma_cur * sigma_cur );
+  const float total_cycle_time = t_cur - t_prev;
 
-    ImageScharrXDerivative( smoothed , Lx , false );
-    ImageScharrYDerivative( smoothed , Ly , false );
+  // Compute first derivatives (Scharr scale 1, non normalized) for diffusion coef
+  Image<float> smoothed, Lx, Ly;
+  ImageGaussianFilter( in , 1.f , smoothed, 0, 0 );
 
-    // Compute diffusion coefficient
-    Image<float> & diff = smoothed; // diffusivity image (reuse existing memory)
-    ImagePeronaMalikG2DiffusionCoef( Lx , Ly , contrast_factor , diff );
+  ImageScharrXDerivative( smoothed , Lx , false );
+  ImageScharrYDerivative( smoothed , Ly , false );
 
-    // Compute FED cycles
-    std::vector<float> tau;
-    FEDCycleTimings( total_cycle_time , 0.25f , tau );
-    ImageFEDCycle( in , diff , tau );
-    Li = in; // evolution image
-  }
+  // Compute diffusion coefficient
+  Image<float> & diff = smoothed; // diffusivity image (reuse existing memory)
+  ImagePeronaMalikG2DiffusionCoef( Lx , Ly , contrast_factor , diff );
+
+  // Compute FED cycles
+  std::vector<float> tau;
+  FEDCycleTimings( total_cycle_time , 0.25f , tau );
+  ImageFEDCycle( in , diff , tau ); // in is the evolution image
+}
+
+void AKAZE::ComputeAKAZESliceResponse( const Image<float> & Li , const int p , const int q , const int nbSlice ,
+                        const float sigma0 , // first octave initial scale
+                        Image<float> & Lx , // X derivatives
+                        Image<float> & Ly , // Y derivatives
+                        Image<float> & Lhess ) // Det(Hessian)
+{
+  const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
+  const float ratio = 1 << p; //pow(2,p);
+  const int sigma_scale = std::round(sigma_cur * fderivative_factor / ratio);
 
   // Compute Hessian response
-  if (p == 0 && q == 0 )
-  {
-    smoothed = Li;
-  }
-  else
+  Image<float> smoothed;
+  if (p != 0 || q != 0 )
   {
     // Add a little smooth to image (for robustness of Scharr derivatives)
     ImageGaussianFilter( Li , 1.f , smoothed, 0, 0 );
   }
 
   // Compute true first derivatives
-  ImageScaledScharrXDerivative( smoothed , Lx , sigma_scale );
-  ImageScaledScharrYDerivative( smoothed , Ly , sigma_scale );
+  ImageScaledScharrDerivatives( (p == 0 && q == 0) ? Li : smoothed , Lx , Ly , sigma_scale );
 
-  // Second order spatial derivatives
-  Image<float> Lxx, Lyy, Lxy;
-  ImageScaledScharrXDerivative( Lx , Lxx , sigma_scale );
-  ImageScaledScharrYDerivative( Lx , Lxy , sigma_scale );
-  ImageScaledScharrYDerivative( Ly , Lyy , sigma_scale );
+  // Compute the Determinant of the Hessian
+  //  (the second order spatial derivatives are computed on the fly)
+  const float sigma_size_quad = Square(sigma_scale) * Square(sigma_scale);
+  ImageScaledScharrHessianDeterminant( Lx , Ly , Lhess , sigma_scale , sigma_size_quad );
 
   Lx *= static_cast<float>( sigma_scale );
   Ly *= static_cast<float>( sigma_scale );
-
-  // Compute Determinant of the Hessian
-  Lhess.resize(Li.Width(), Li.Height());
-  const float sigma_size_quad = Square(sigma_scale) * Square(sigma_scale);
-  Lhess.array() = (Lxx.array()*Lyy.array()-Lxy.array().square())*sigma_size_quad;
 }
 
 template <typename Image>
@@ -224,35 +217,52 @@ void AKAZE::Compute_AKAZEScaleSpace()
 
   float contrast_factor = ComputeAutomaticContrastFactor( in_, 0.7f );
 
-  Image<float> input = in_;
+  // Allocate all the slices upfront
+  evolution_.resize( options_.iNbOctave * options_.iNbSlicePerOctave );
 
-  // Octave computation
+  // Non linear diffusion: each slice is computed from the previous one
+  //  (each diffusion step is run in parallel over the image rows)
   for (int p = 0; p < options_.iNbOctave; ++p )
   {
     contrast_factor *= (p == 0) ? 1.f : 0.75f;
 
     for (int q = 0; q < options_.iNbSlicePerOctave; ++q )
     {
-      evolution_.emplace_back(TEvolution());
-      TEvolution & evo = evolution_.back();
+      const int slice_id = p * options_.iNbSlicePerOctave + q;
       // Compute Slice at (p,q) index
-      ComputeAKAZESlice( input , p , q , options_.iNbSlicePerOctave , options_.fSigma0 , contrast_factor,
-        evo.cur , evo.Lx , evo.Ly , evo.Lhess );
+      ComputeAKAZESliceDiffusion(
+        (slice_id == 0) ? in_ : evolution_[slice_id - 1].cur,
+        p , q , options_.iNbSlicePerOctave , options_.fSigma0 , contrast_factor,
+        evolution_[slice_id].cur );
+    }
+  }
 
-      // Prepare inputs for next slice
-      input = evo.cur;
+  // Derivatives and Hessian response: the slices are independent
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int slice_id = 0; slice_id < static_cast<int>(evolution_.size()); ++slice_id)
+  {
+    const int p = slice_id / options_.iNbSlicePerOctave;
+    const int q = slice_id % options_.iNbSlicePerOctave;
+    TEvolution & evo = evolution_[slice_id];
+    ComputeAKAZESliceResponse( evo.cur , p , q , options_.iNbSlicePerOctave , options_.fSigma0 ,
+      evo.Lx , evo.Ly , evo.Lhess );
+  }
 
-      // DEBUG octave image
+  // DEBUG octave image
 #if DEBUG_OCTAVE
-      std::stringstream str;
-      str << "./" << "_oct_" << p << "_" << q << ".png";
-      Image<float> tmp = evo.cur;
-      convert_scale(tmp);
-      Image<unsigned char> tmp2 ((tmp*255).cast<unsigned char>());
-      WriteImage( str.str().c_str() , tmp2 );
-#endif // DEBUG_OCTAVE
-    }
+  for (int slice_id = 0; slice_id < static_cast<int>(evolution_.size()); ++slice_id)
+  {
+    std::stringstream str;
+    str << "./" << "_oct_" << slice_id / options_.iNbSlicePerOctave
+      << "_" << slice_id % options_.iNbSlicePerOctave << ".png";
+    Image<float> tmp = evolution_[slice_id].cur;
+    convert_scale(tmp);
+    Image<unsigned char> tmp2 ((tmp*255).cast<unsigned char>());
+    WriteImage( str.str().c_str() , tmp2 );
   }
+#endif // DEBUG_OCTAVE
 }
 
 void detectDuplicates(
@@ -133,16 +133,26 @@ public:
 
 private:
 
-  /// Compute an AKAZE slice
+  /// Compute the non linear diffusion image of an AKAZE slice
   static
-  void ComputeAKAZESlice(
-    const image::Image<float> & src, // Input image for the given octave
+  void ComputeAKAZESliceDiffusion(
+    const image::Image<float> & src, // Previous slice diffusion image (or input image for the first slice)
     const int p , // octave index
     const int q , // slice index
     const int nbSlice , // slices per octave
     const float sigma0 , // first octave initial scale
     const float contrast_factor ,
-    image::Image<float> & Li, // Diffusion image
+    image::Image<float> & Li // Diffusion image
+    );
+
+  /// Compute the derivatives and the Hessian response of an AKAZE slice
+  static
+  void ComputeAKAZESliceResponse(
+    const image::Image<float> & Li, // Diffusion image
+    const int p , // octave index
+    const int q , // slice index
+    const int nbSlice , // slices per octave
+    const float sigma0 , // first octave initial scale
     image::Image<float> & Lx, // X derivatives
     image::Image<float> & Ly, // Y derivatives
     image::Image<float> & Lhess // Det(Hessian)
@@ -38,6 +38,31 @@ TEST( AKAZE , AkazeImageDescriberSurf )
   EXPECT_TRUE(extractor.Describe(image_in)->RegionCount() > 0);
 }
 
+TEST( AKAZE , AkazeImageDescriberSurfQuantized )
+{
+  Image<unsigned char> image_in;
+  EXPECT_TRUE( ReadImage( png_filename.c_str(), &image_in ) );
+
+  AKAZE_Image_describer_SURF_Quantized extractor;
+  EXPECT_TRUE(extractor.Describe(Image<unsigned char>{})->RegionCount() == 0);
+  const auto quantized_regions = extractor.Describe_AKAZE_SURF_Quantized(image_in);
+  EXPECT_TRUE(quantized_regions->RegionCount() > 0);
+
+  // The quantized descriptors distances are proportional to the float ones
+  //  (up to the rounding and the clamping of the few large values)
+  AKAZE_Image_describer_SURF float_extractor;
+  const auto regions = float_extractor.Describe_AKAZE_SURF(image_in);
+  EXPECT_EQ(regions->RegionCount(), quantized_regions->RegionCount());
+  const double scale = Square(255.0);
+  for (size_t i = 1; i < regions->RegionCount(); ++i)
+  {
+    EXPECT_NEAR(
+      std::sqrt(regions->SquaredDescriptorDistance(i, regions.get(), i - 1)),
+      std::sqrt(quantized_regions->SquaredDescriptorDistance(i, quantized_regions.get(), i - 1) / scale),
+      0.05);
+  }
+}
+
 TEST( AKAZE , AkazeImageDescriberLiop )
 {
   Image<unsigned char> image_in;
@@ -25,6 +25,10 @@ AKAZE_Image_describer_SURF::Describe_AKAZE_SURF
   if (image.size() == 0)
     return regions;
 
+  // A fully masked image has no region: the scale space is not computed
+  if (mask && (mask->size() == 0 || !(mask->GetMat().array() != 0).any()))
+    return regions;
+
   params_.options_.fDesc_factor = GetfDescFactor();
 
   AKAZE akaze(image, params_.options_);
@@ -34,12 +38,12 @@ AKAZE_Image_describer_SURF::Describe_AKAZE_SURF
   akaze.Feature_Detection(kpts);
   akaze.Do_Subpixel_Refinement(kpts);
 
-  // Feature masking (remove keypoints if they are masked)
+  // Feature masking (remove keypoints if they are masked) before the description
   kpts.erase(std::remove_if(kpts.begin(),
                             kpts.end(),
                             [&](const AKAZEKeypoint & pt)
                             {
-                              if (mask) return (*mask)(pt.y, pt.x) == 0;
+                              if (mask) return !mask->Contains(pt.y, pt.x) || (*mask)(pt.y, pt.x) == 0;
                               else return false;
                             }),
              kpts.end());
@@ -70,6 +74,22 @@ AKAZE_Image_describer_SURF::Describe_AKAZE_SURF
   return regions;
 }
 
+std::unique_ptr<AKAZE_Image_describer_SURF_Quantized::Regions_type>
+AKAZE_Image_describer_SURF_Quantized::Describe_AKAZE_SURF_Quantized
+(
+  const image::Image<unsigned char>& image,
+  const image::Image<unsigned char>* mask
+)
+{
+  auto regions = std::unique_ptr<Regions_type>(new Regions_type);
+  const auto float_regions = Describe_AKAZE_SURF(image, mask);
+
+  // The MSURF descriptors are unit vectors, their values lie in [-0.5, 0.5]
+  //  (very few values are clamped).
+  QuantizeRegions(*float_regions, -0.5f, 0.5f, *regions);
+  return regions;
+}
+
 std::unique_ptr<AKAZE_Image_describer_LIOP::Regions_type>
 AKAZE_Image_describer_LIOP::Describe_AKAZE_LIOP
 (
@@ -82,6 +102,10 @@ AKAZE_Image_describer_LIOP::Describe_AKAZE_LIOP
   if (image.size() == 0)
     return regions;
 
+  // A fully masked image has no region: the scale space is not computed
+  if (mask && (mask->size() == 0 || !(mask->GetMat().array() != 0).any()))
+    return regions;
+
   params_.options_.fDesc_factor = GetfDescFactor();
 
   AKAZE akaze(image, params_.options_);
@@ -91,12 +115,12 @@ AKAZE_Image_describer_LIOP::Describe_AKAZE_LIOP
   akaze.Feature_Detection(kpts);
   akaze.Do_Subpixel_Refinement(kpts);
 
-  // Feature masking (remove keypoints if they are masked)
+  // Feature masking (remove keypoints if they are masked) before the description
   kpts.erase(std::remove_if(kpts.begin(),
                             kpts.end(),
                             [&](const AKAZEKeypoint & pt)
                             {
-                              if (mask) return (*mask)(pt.y, pt.x) == 0;
+                              if (mask) return !mask->Contains(pt.y, pt.x) || (*mask)(pt.y, pt.x) == 0;
                               else return false;
                             }),
              kpts.end());
@@ -150,6 +174,10 @@ AKAZE_Image_describer_MLDB::Describe_AKAZE_MLDB
   if (image.size() == 0)
     return regions;
 
+  // A fully masked image has no region: the scale space is not computed
+  if (mask && (mask->size() == 0 || !(mask->GetMat().array() != 0).any()))
+    return regions;
+
   params_.options_.fDesc_factor = GetfDescFactor();
 
   AKAZE akaze(image, params_.options_);
@@ -159,12 +187,12 @@ AKAZE_Image_describer_MLDB::Describe_AKAZE_MLDB
   akaze.Feature_Detection(kpts);
   akaze.Do_Subpixel_Refinement(kpts);
 
-  // Feature masking (remove keypoints if they are masked)
+  // Feature masking (remove keypoints if they are masked) before the description
   kpts.erase(std::remove_if(kpts.begin(),
                             kpts.end(),
                             [&](const AKAZEKeypoint & pt)
                             {
-                              if (mask) return (*mask)(pt.y, pt.x) == 0;
+                              if (mask) return !mask->Contains(pt.y, pt.x) || (*mask)(pt.y, pt.x) == 0;
                               else return false;
                             }),
              kpts.end());
@@ -225,6 +253,9 @@ std::unique_ptr<AKAZE_Image_describer> AKAZE_Image_describer::create
   case AKAZE_MLDB:
     return std::unique_ptr<AKAZE_Image_describer>
         (new AKAZE_Image_describer_MLDB(params, orientation));
+  case AKAZE_MSURF_QUANTIZED:
+    return std::unique_ptr<AKAZE_Image_describer>
+        (new AKAZE_Image_describer_SURF_Quantized(params, orientation));
   default:
     return {};
   }
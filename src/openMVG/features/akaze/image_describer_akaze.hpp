@@ -23,7 +23,8 @@ enum EAKAZE_DESCRIPTOR
 {
   AKAZE_MSURF,
   AKAZE_LIOP,
-  AKAZE_MLDB
+  AKAZE_MLDB,
+  AKAZE_MSURF_QUANTIZED
 };
 
 class AKAZE_Image_describer : public Image_describer
@@ -116,6 +117,38 @@ public:
   );
 };
 
+// AKAZE MSURF descriptor stored as unsigned char values (4x less memory)
+class AKAZE_Image_describer_SURF_Quantized : public AKAZE_Image_describer_SURF
+{
+public:
+
+  using Regions_type = AKAZE_Quantized_Float_Regions;
+
+  AKAZE_Image_describer_SURF_Quantized(
+    const Params& params = Params(),
+    bool bOrientation = true
+  )
+    :AKAZE_Image_describer_SURF(params, bOrientation) { }
+
+  std::unique_ptr<Regions> Describe(
+      const image::Image<unsigned char>& image,
+      const image::Image<unsigned char>* mask = nullptr
+  ) override
+  {
+    return Describe_AKAZE_SURF_Quantized(image, mask);
+  }
+
+  std::unique_ptr<Regions> Allocate() const override
+  {
+    return std::unique_ptr<Regions_type>(new Regions_type);
+  }
+
+  std::unique_ptr<Regions_type> Describe_AKAZE_SURF_Quantized(
+    const image::Image<unsigned char>& image,
+    const image::Image<unsigned char>* mask = nullptr
+  );
+};
+
 class AKAZE_Image_describer_LIOP : public AKAZE_Image_describer {
 public:
   using Regions_type = AKAZE_Liop_Regions;
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <iterator>
 #include <fstream>
 #include <string>
@@ -138,6 +139,30 @@ std::istream& Descriptor<T,N>::read(std::istream& in)
   return readT<T>(in, (T*) this->data(), N);
 }
 
+/**
+ * Quantize a floating point descriptor to an unsigned char descriptor:
+ *  q = clamp(round(255 * (x - min_value) / (max_value - min_value)), 0, 255)
+ * The same [min_value, max_value] range is used for all the dimensions,
+ *  so the L2 distances between quantized descriptors stay proportional
+ *  to the floating point ones (distance ratio are preserved).
+ */
+template <uint32_t N>
+inline void QuantizeDescriptor
+(
+  const Descriptor<float, N> & desc,
+  const float min_value,
+  const float max_value,
+  Descriptor<unsigned char, N> & quantized_desc
+)
+{
+  const float scale = 255.f / (max_value - min_value);
+  for (uint32_t i = 0; i < N; ++i)
+  {
+    const float value = std::round((desc[i] - min_value) * scale);
+    quantized_desc[i] = static_cast<unsigned char>(std::min(255.f, std::max(0.f, value)));
+  }
+}
+
 /// Read descriptors from file
 template<typename DescriptorsT >
 inline bool loadDescsFromFile(
@@ -129,6 +129,18 @@ TEST(descriptorIO, BINARY) {
   }
 }
 
+TEST(descriptor, Quantization) {
+  Descriptor<float, 4> desc;
+  desc << -1.f, -0.5f, 0.25f, 1.f;
+
+  Descriptor<unsigned char, 4> quantized_desc;
+  QuantizeDescriptor(desc, -0.5f, 0.5f, quantized_desc);
+  EXPECT_EQ(0, quantized_desc[0]);   // clamped
+  EXPECT_EQ(0, quantized_desc[1]);
+  EXPECT_EQ(191, quantized_desc[2]); // round(0.75 * 255)
+  EXPECT_EQ(255, quantized_desc[3]); // clamped
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
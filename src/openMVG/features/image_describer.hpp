@@ -72,6 +72,36 @@ public:
     const image::Image<unsigned char> & image,
     const image::Image<unsigned char> * mask = nullptr) = 0;
 
+  /**
+  @brief Maximal factor by which the input image can be downscaled before its
+     description (see Describe_downscaled). It lets the caller decode the image
+     directly at a reduced resolution.
+  @return The maximal downscaling factor (1 if the full resolution is required)
+  */
+  virtual int Max_image_downscale() const
+  {
+    return 1;
+  }
+
+  /**
+  @brief Detect regions on a downscaled image and compute their attributes (description)
+  @param image Image downscaled by image_downscale (each pixel being the mean
+     of an image_downscale x image_downscale block of the full resolution image).
+  @param image_downscale The downscaling factor (must divide Max_image_downscale()).
+  @param mask 8-bit gray image for keypoint filtering (optional, full resolution).
+     Non-zero values depict the region of interest.
+  @return The detected regions (in full resolution coordinates) and attributes
+  */
+  virtual std::unique_ptr<Regions> Describe_downscaled(
+    const image::Image<unsigned char> & image,
+    const int image_downscale,
+    const image::Image<unsigned char> * mask = nullptr)
+  {
+    if (image_downscale != 1)
+      return nullptr;
+    return Describe(image, mask);
+  }
+
   /// Allocate regions depending of the Image_describer
   virtual std::unique_ptr<Regions> Allocate() const = 0;
 
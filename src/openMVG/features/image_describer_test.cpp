@@ -81,6 +81,15 @@ TEST(Image_describer_akaze_surf, IO)
   EXPECT_TRUE(SaveAndLoad(image_describer));
 }
 
+TEST(Image_describer_akaze_surf_quantized, IO)
+{
+  std::unique_ptr<Image_describer> image_describer = AKAZE_Image_describer::create
+    (AKAZE_Image_describer::Params(AKAZE::Params(), AKAZE_MSURF_QUANTIZED));
+
+  EXPECT_TRUE(SaveAndLoad(image_describer));
+  EXPECT_TRUE(dynamic_cast<AKAZE_Image_describer_SURF_Quantized*>(image_describer.get()) != nullptr);
+}
+
 TEST(Image_describer_akaze_mldb, IO)
 {
   std::unique_ptr<Image_describer> image_describer = AKAZE_Image_describer::create
@@ -20,6 +20,8 @@ using SIFT_Regions = Scalar_Regions<SIOPointFeature, unsigned char, 128>;
 
 /// Define the AKAZE Keypoint (with a float descriptor)
 using AKAZE_Float_Regions = Scalar_Regions<SIOPointFeature, float, 64>;
+/// Define the AKAZE Keypoint (with a float descriptor quantized to uchar)
+using AKAZE_Quantized_Float_Regions = Scalar_Regions<SIOPointFeature, unsigned char, 64>;
 /// Define the AKAZE Keypoint (with a LIOP descriptor)
 using AKAZE_Liop_Regions = Scalar_Regions<SIOPointFeature, unsigned char, 144>;
 /// Define the AKAZE Keypoint (with a binary descriptor saved in an uchar array)
@@ -30,6 +32,7 @@ using AKAZE_Binary_Regions = Binary_Regions<SIOPointFeature, 64>;
 
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::SIFT_Regions)
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Float_Regions)
+EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Quantized_Float_Regions)
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Liop_Regions)
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Binary_Regions)
 
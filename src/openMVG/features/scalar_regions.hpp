@@ -135,6 +135,27 @@ private:
   DescsT vec_descs_; // region descriptions
 };
 
+/// Quantize floating point regions descriptors to unsigned char (4x less memory).
+/// The quantized regions can be matched directly with the unsigned char metrics.
+/// See QuantizeDescriptor for the [min_value, max_value] range.
+template<typename FeatT, size_t L>
+void QuantizeRegions
+(
+  const Scalar_Regions<FeatT, float, L> & regions,
+  const float min_value,
+  const float max_value,
+  Scalar_Regions<FeatT, unsigned char, L> & quantized_regions
+)
+{
+  quantized_regions.Features() = regions.Features();
+  quantized_regions.Descriptors().resize(regions.RegionCount());
+  for (size_t i = 0; i < regions.RegionCount(); ++i)
+  {
+    QuantizeDescriptor(regions.Descriptors()[i], min_value, max_value,
+      quantized_regions.Descriptors()[i]);
+  }
+}
+
 } // namespace features
 } // namespace openMVG
 
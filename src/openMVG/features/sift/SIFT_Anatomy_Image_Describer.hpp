@@ -18,13 +18,16 @@ Changes are:
 - The hierarchical scale space code can be run on its own,
 - Keypoint detection and description is split in two separate modules,
 - the code can run per Octave (less memory consuming),
-- some computation can be run in parallel.
+- some computation can be run in parallel (the results do not depend on the
+  number of threads).
 
 */
 
 #ifndef OPENMVG_FEATURES_SIFT_SIFT_ANATOMY_IMAGE_DESCRIBER_HPP
 #define OPENMVG_FEATURES_SIFT_SIFT_ANATOMY_IMAGE_DESCRIBER_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <vector>
 
@@ -68,7 +71,8 @@ public:
     inline void serialize( Archive & ar );
 
     // Parameters
-    int first_octave_;      // Use original image, or perform an upscale if == -1
+    int first_octave_;      // Use original image, perform an upscale if == -1
+                            //  or a 2^first_octave_ downscale if > 0
     int num_octaves_;       // Max octaves count
     int num_scales_;        // Scales per octave
     float edge_threshold_;  // Max ratio of Hessian eigenvalues
@@ -106,25 +110,60 @@ public:
     return true;
   }
 
+  int Max_image_downscale() const override
+  {
+    return (params_.first_octave_ > 0) ? 1 << params_.first_octave_ : 1;
+  }
+
   /**
   @brief Detect regions on the image and compute their attributes (description)
   @param image Image.
   @param mask 8-bit gray image for keypoint filtering (optional).
      Non-zero values depict the region of interest.
+  @param image_downscale Downscaling factor already applied to the image
+     (see Max_image_downscale).
   @return regions The detected regions and attributes (the caller must delete the allocated data)
   */
   std::unique_ptr<Regions_type> Describe_SIFT_Anatomy(
     const image::Image<unsigned char>& image,
-    const image::Image<unsigned char>* mask = nullptr
+    const image::Image<unsigned char>* mask = nullptr,
+    const int image_downscale = 1
   )
   {
+    const int max_image_downscale = Max_image_downscale();
+    if (image_downscale < 1 || max_image_downscale % image_downscale != 0)
+    {
+      OPENMVG_LOG_ERROR << "Invalid image downscale: " << image_downscale;
+      return nullptr;
+    }
+
     auto regions = std::unique_ptr<Regions_type>(new Regions_type);
 
     if (image.size() == 0)
       return regions;
 
+    // A fully masked image has no region: the scale space is not computed
+    if (mask && (mask->size() == 0 || !(mask->GetMat().array() != 0).any()))
+      return regions;
+
     // Convert to float in range [0;1]
-    const image::Image<float> If(image.GetMat().cast<float>()/255.0f);
+    image::Image<float> If(image.GetMat().cast<float>()/255.0f);
+
+    // Perform the remaining downscaling (2x2 mean) requested by first_octave_
+    for (int downscale = image_downscale; downscale < max_image_downscale; downscale *= 2)
+    {
+      image::Image<float> half(If.Width() / 2, If.Height() / 2);
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
+      for (int j = 0; j < half.Height(); ++j)
+        for (int i = 0; i < half.Width(); ++i)
+          half(j, i) = 0.25f * (If(2 * j, 2 * i) + If(2 * j, 2 * i + 1)
+                                + If(2 * j + 1, 2 * i) + If(2 * j + 1, 2 * i + 1));
+      If = std::move(half);
+    }
+    // Scale used to express the keypoints in full resolution coordinates
+    const float scale = static_cast<float>(max_image_downscale);
 
     // compute sift keypoints
     {
@@ -141,17 +180,62 @@ public:
         : GaussianScaleSpaceParams(1.6f, 1.0f, 0.5f, supplementary_images));
       octave_gen.SetImage( If );
 
+      // Keypoint position in the full resolution image
+      // (a downscaled pixel is centered on its source pixel block)
+      const auto full_resolution_position = [scale](const sift::Keypoint & k)
+      {
+        return Vec2f(scale * k.x + (scale - 1.f) / 2.f,
+                     scale * k.y + (scale - 1.f) / 2.f);
+      };
+
       std::vector<sift::Keypoint> keypoints;
       keypoints.reserve(5000);
       Octave octave;
+      image::Image<unsigned char> octave_mask;
       while ( octave_gen.NextOctave( octave ) )
       {
+        if (mask)
+        {
+          // Resample the mask to the octave sampling in order to skip the
+          // extrema detection far away from the region of interest
+          const image::Image<unsigned char> & maskIma = *mask;
+          const int w = octave.slices[0].Width(), h = octave.slices[0].Height();
+          const float step = scale * octave.delta;
+          octave_mask.resize(w, h, true, 0);
+          for (int y = 0; y < maskIma.Height(); ++y)
+          {
+            const int j = std::round((y - (scale - 1.f) / 2.f) / step);
+            if (j < 0 || j >= h)
+              continue;
+            for (int x = 0; x < maskIma.Width(); ++x)
+            {
+              if (maskIma(y, x) == 0)
+                continue;
+              const int i = std::round((x - (scale - 1.f) / 2.f) / step);
+              if (i >= 0 && i < w)
+                octave_mask(j, i) = 255;
+            }
+          }
+        }
+
         std::vector<sift::Keypoint> keys;
         // Find Keypoints
         sift::SIFT_KeypointExtractor keypointDetector(
           params_.peak_threshold_ / octave_gen.NbSlice(),
           params_.edge_threshold_);
-        keypointDetector(octave, keys);
+        keypointDetector(octave, mask ? &octave_mask : nullptr, keys);
+        // Feature masking (before the orientation and description computation)
+        if (mask)
+        {
+          const image::Image<unsigned char> & maskIma = *mask;
+          keys.erase(std::remove_if(keys.begin(), keys.end(),
+            [&](const sift::Keypoint & k)
+            {
+              const Vec2f pos = full_resolution_position(k);
+              return !maskIma.Contains(pos.y(), pos.x()) || maskIma(pos.y(), pos.x()) == 0;
+            }),
+            keys.end());
+        }
         // Find Keypoints orientation and compute their description
         sift::Sift_DescriptorExtractor descriptorExtractor;
         descriptorExtractor(octave, keys);
@@ -159,20 +243,14 @@ public:
         // Concatenate the found keypoints
         std::move(keys.begin(), keys.end(), std::back_inserter(keypoints));
       }
+      regions->Descriptors().reserve(keypoints.size());
+      regions->Features().reserve(keypoints.size());
       for (const auto & k : keypoints)
       {
-        // Feature masking
-        if (mask)
-        {
-          const image::Image<unsigned char> & maskIma = *mask;
-          if (maskIma(k.y, k.x) == 0)
-            continue;
-        }
         // Create the SIFT region
-        {
-          regions->Descriptors().emplace_back(k.descr.cast<unsigned char>());
-          regions->Features().emplace_back(k.x, k.y, k.sigma, k.theta);
-        }
+        const Vec2f pos = full_resolution_position(k);
+        regions->Descriptors().emplace_back(k.descr.cast<unsigned char>());
+        regions->Features().emplace_back(pos.x(), pos.y(), scale * k.sigma, k.theta);
       }
     }
     return regions;
@@ -194,6 +272,15 @@ public:
     return Describe_SIFT_Anatomy(image, mask);
   }
 
+  std::unique_ptr<Regions> Describe_downscaled(
+    const image::Image<unsigned char>& image,
+    const int image_downscale,
+    const image::Image<unsigned char>* mask = nullptr
+  ) override
+  {
+    return Describe_SIFT_Anatomy(image, mask, image_downscale);
+  }
+
  private:
   Params params_;
 };
@@ -116,6 +116,9 @@ protected:
     m_ygradient.delta = octave.delta;
     m_xgradient.octave_level = octave.octave_level;
     m_ygradient.octave_level = octave.octave_level;
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
     for (int s = 1; s < nSca-1; ++s)
     {
       // only in range [1; n-1] (since first and last images were only used for non max suppression)
@@ -289,6 +292,8 @@ protected:
 
   /**
   * @brief Compute the orientations of a list of Keypoints
+  * The oriented keypoints are listed in the input keypoint order
+  *  (whatever the number of threads).
   * @param[in,out] keypoints The list of found Keypoints
   */
   void Keypoints_orientations
@@ -296,12 +301,12 @@ protected:
     std::vector<Keypoint> & keypoints
   ) const
   {
-    std::vector<Keypoint> kps;
-    kps.reserve(keypoints.size());
+    // Principal orientation(s) of each keypoint
+    std::vector<std::vector<float>> keypoints_orientations(keypoints.size());
 #ifdef OPENMVG_USE_OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
-    for (int i_key = 0; i_key < keypoints.size(); ++i_key)
+    for (int i_key = 0; i_key < static_cast<int>(keypoints.size()); ++i_key)
     {
       const Keypoint & key = keypoints[i_key];
 
@@ -309,17 +314,24 @@ protected:
       Keypoint_orientation_histogram(key, orientation_histogram);
 
       // Compute principal orientation(s)
-      std::vector<float> principal_orientations(m_nb_orientation_histogram_bin);
+      std::vector<float> & principal_orientations = keypoints_orientations[i_key];
+      principal_orientations.resize(m_nb_orientation_histogram_bin);
       const int n_prOri = Extract_principal_orientations(orientation_histogram, principal_orientations);
+      principal_orientations.resize(n_prOri);
+    }
 
-      // Updating keypoints and save it in the new list
-#ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
-#endif
-      for (int n = 0; n < n_prOri; ++n)
+    // Updating keypoints and save them in the new list
+    size_t nb_oriented_keypoints = 0;
+    for (const auto & orientations : keypoints_orientations)
+      nb_oriented_keypoints += orientations.size();
+    std::vector<Keypoint> kps;
+    kps.reserve(nb_oriented_keypoints);
+    for (size_t i_key = 0; i_key < keypoints.size(); ++i_key)
+    {
+      for (const float orientation : keypoints_orientations[i_key])
       {
-        Keypoint kp = key;
-        kp.theta = principal_orientations[n];
+        Keypoint kp = keypoints[i_key];
+        kp.theta = orientation;
         kps.emplace_back(kp);
       }
     }
@@ -468,7 +480,7 @@ protected:
 #ifdef OPENMVG_USE_OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
-    for (int i_key = 0; i_key < keypoints.size(); ++i_key)
+    for (int i_key = 0; i_key < static_cast<int>(keypoints.size()); ++i_key)
     {
       Keypoint & key = keypoints[i_key];
       // Compute the SIFT descriptor
@@ -18,6 +18,9 @@ The implementation is based on
         http://www.ipol.im/pub/algo/rd_anatomy_sift/
 */
 
+#include <algorithm>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 #include "openMVG/features/feature.hpp"
@@ -55,10 +58,28 @@ struct SIFT_KeypointExtractor
   * @param[out] keypoints The found Scale Invariant keypoint
   */
   void operator()( const Octave & octave , std::vector<Keypoint> & keypoints )
+  {
+    (*this)(octave, nullptr, keypoints);
+  }
+
+  /**
+  * @brief Detect Scale Invariant points using Difference of Gaussians in a region of interest
+  * @param octave A Gaussian octave
+  * @param mask Region of interest expressed in the octave sampling (optional).
+  *  Non-zero values depict the region of interest. Extrema are not searched
+  *  where they cannot be refined into the region of interest.
+  * @param[out] keypoints The found Scale Invariant keypoint
+  */
+  void operator()
+  (
+    const Octave & octave,
+    const image::Image<unsigned char> * mask,
+    std::vector<Keypoint> & keypoints
+  )
   {
     if (!ComputeDogs(octave))
       return;
-    Find_3d_discrete_extrema(keypoints, 0.8f);
+    Find_3d_discrete_extrema(keypoints, 0.8f, mask);
     Keypoints_refine_position(keypoints);
   }
 
@@ -79,6 +100,9 @@ protected:
     m_Dogs.octave_level = octave.octave_level;
     m_Dogs.delta = octave.delta;
     m_Dogs.sigmas = octave.sigmas;
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
     for (int s = 0; s < m_Dogs.slices.size(); ++s)
     {
       const image::Image<float> &P = octave.slices[s+1];
@@ -168,13 +192,19 @@ protected:
 
   /**
   * @brief Find discrete extrema position (position, scale) in the Dog domain
+  * The Dog domain is split in row tiles that are processed in parallel.
+  * Tiles results are concatenated in the slice/row/col scan order,
+  *  so the found keypoints do not depend on the number of threads.
   * @param[out] keypoints The list of found extrema as Keypoints
   * @param percent Percentage applied on of the internal Edge threshold value
+  * @param mask Region of interest in the octave sampling (optional).
+  *  Tiles too far away from the region of interest are skipped.
   */
   void Find_3d_discrete_extrema
   (
     std::vector<Keypoint> & keypoints,
-    float percent = 1.0f
+    float percent = 1.0f,
+    const image::Image<unsigned char> * mask = nullptr
   ) const
   {
     const int ns = m_Dogs.slices.size();
@@ -182,12 +212,63 @@ protected:
     const int h = m_Dogs.slices[0].Height();
     const int w = m_Dogs.slices[0].Width();
 
-    // Loop through the slices of the image stack (one octave)
-    for (int s = 1; s < ns-1; ++s)
+    if (ns < 3 || h < 3)
+      return;
+
+    // Row tiles of the (1 -> h-2) row range for each inner slice (1 -> ns-2)
+    const int tile_height = 32;
+    const int nb_tile_per_slice = (h - 2 + tile_height - 1) / tile_height;
+    const int nb_tile = (ns - 2) * nb_tile_per_slice;
+    std::vector<std::vector<Keypoint>> tile_keypoints(nb_tile);
+
+    // Column range of the region of interest for each row ([w;-1] if the row is masked)
+    std::vector<std::pair<int, int>> roi_cols;
+    if (mask)
     {
-      for (int id_row = 1; id_row < h-1; ++id_row )
+      roi_cols.assign(h, {w, -1});
+      for (int id_row = 0; id_row < std::min(h, mask->Height()); ++id_row)
       {
-        for (int id_col = 1; id_col < w-1; ++id_col )
+        for (int id_col = 0; id_col < std::min(w, mask->Width()); ++id_col)
+        {
+          if ((*mask)(id_row, id_col) != 0)
+          {
+            roi_cols[id_row].first = std::min(roi_cols[id_row].first, id_col);
+            roi_cols[id_row].second = id_col;
+          }
+        }
+      }
+    }
+    // Maximal displacement of a discrete extrema during the position refinement
+    // (one pixel per refinement step + the sub-pixel offset),
+    // + 2 pixels to absorb the mask resampling to the octave sampling
+    const int roi_margin = m_nb_refinement_step + 3;
+
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int id_tile = 0; id_tile < nb_tile; ++id_tile)
+    {
+      const int s = 1 + id_tile / nb_tile_per_slice;
+      const int row_begin = 1 + (id_tile % nb_tile_per_slice) * tile_height;
+      const int row_end = std::min(row_begin + tile_height, h-1);
+      int col_begin = 1, col_end = w-1;
+      if (mask)
+      {
+        // Restrict the search to the columns that are close to the region of interest
+        int roi_col_min = w, roi_col_max = -1;
+        for (int id_row = std::max(0, row_begin - roi_margin);
+             id_row < std::min(h, row_end + roi_margin); ++id_row)
+        {
+          roi_col_min = std::min(roi_col_min, roi_cols[id_row].first);
+          roi_col_max = std::max(roi_col_max, roi_cols[id_row].second);
+        }
+        col_begin = std::max(col_begin, roi_col_min - roi_margin);
+        col_end = std::min(col_end, roi_col_max + roi_margin + 1);
+      }
+      std::vector<Keypoint> & keys = tile_keypoints[id_tile];
+      for (int id_row = row_begin; id_row < row_end; ++id_row )
+      {
+        for (int id_col = col_begin; id_col < col_end; ++id_col )
         {
           const float pix_val = m_Dogs.slices[s](id_row, id_col);
           if (std::abs(pix_val) > m_peak_threshold * percent)
@@ -203,12 +284,19 @@ protected:
             key.y = delta * id_row;
             key.sigma = m_Dogs.sigmas[s];
             key.val = pix_val;
-            keypoints.emplace_back(key);
+            keys.emplace_back(key);
           }
         }
       }
     }
-    keypoints.shrink_to_fit();
+
+    // Concatenate the tiles keypoints in scan order
+    size_t nb_keypoints = keypoints.size();
+    for (const auto & keys : tile_keypoints)
+      nb_keypoints += keys.size();
+    keypoints.reserve(nb_keypoints);
+    for (auto & keys : tile_keypoints)
+      std::move(keys.begin(), keys.end(), std::back_inserter(keypoints));
   }
 
 
@@ -316,8 +404,10 @@ protected:
     std::vector<Keypoint> & keypoints
   ) const
   {
-    std::vector<Keypoint> kps;
-    kps.reserve(keypoints.size());
+    // Refined keypoints are stored by index and compacted afterward
+    //  in order to keep the input order whatever the number of threads.
+    std::vector<Keypoint> refined_keypoints(keypoints.size());
+    std::vector<unsigned char> is_valid(keypoints.size(), 0);
 
     const float ofstMax = 0.6f;
 
@@ -330,8 +420,12 @@ protected:
     const int h = octave.slices[0].Height();
     const float delta  = octave.delta;
 
-    for (const auto & key : keypoints)
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i_key = 0; i_key < static_cast<int>(keypoints.size()); ++i_key)
     {
+      const Keypoint & key = keypoints[i_key];
       float val = key.val;
 
       int ic = key.i; // current discrete value of x coordinate - at each interpolation
@@ -392,12 +486,20 @@ protected:
             // Border check
             if (Border_Check(kp, w, h))
             {
-              kps.emplace_back(kp);
+              refined_keypoints[i_key] = std::move(kp);
+              is_valid[i_key] = 1;
             }
           }
         }
       }
     }
+    std::vector<Keypoint> kps;
+    kps.reserve(std::count(is_valid.cbegin(), is_valid.cend(), 1));
+    for (size_t i_key = 0; i_key < refined_keypoints.size(); ++i_key)
+    {
+      if (is_valid[i_key])
+        kps.emplace_back(std::move(refined_keypoints[i_key]));
+    }
     keypoints = std::move(kps);
     keypoints.shrink_to_fit();
   }
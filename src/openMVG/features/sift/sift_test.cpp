@@ -14,6 +14,11 @@
 
 #include "testing/testing.h"
 
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
 #include <sstream>
 
 using namespace openMVG;
@@ -124,6 +129,130 @@ TEST( Sift , EmptyImage )
   EXPECT_TRUE(extractor.Describe(image_in)->RegionCount() == 0);
 }
 
+TEST( Sift , DownscaledImage )
+{
+  Image<unsigned char> in;
+  const std::string png_filename = std::string( THIS_SOURCE_DIR )
+    + "/../../../openMVG_Samples/imageData/StanfordMobileVisualSearch/Ace_0.png";
+  EXPECT_TRUE( ReadImage( png_filename.c_str(), &in ) );
+
+  // first_octave = 1 => the describer works on a half resolution image
+  SIFT_Anatomy_Image_describer extractor(SIFT_Anatomy_Image_describer::Params(1));
+  EXPECT_EQ(2, extractor.Max_image_downscale());
+
+  // Describe the full resolution image (the describer performs the downscaling)
+  const auto regions = extractor.Describe(in);
+  EXPECT_TRUE(regions->RegionCount() > 0);
+
+  // Describe an already downscaled image (2x2 mean)
+  Image<unsigned char> half(in.Width() / 2, in.Height() / 2);
+  for (int j = 0; j < half.Height(); ++j)
+    for (int i = 0; i < half.Width(); ++i)
+      half(j, i) = static_cast<unsigned char>(
+        (in(2 * j, 2 * i) + in(2 * j, 2 * i + 1) + in(2 * j + 1, 2 * i) + in(2 * j + 1, 2 * i + 1) + 2) / 4);
+  const auto regions_downscaled = extractor.Describe_downscaled(half, 2);
+  EXPECT_TRUE(regions_downscaled->RegionCount() > 0);
+  EXPECT_NEAR(regions->RegionCount(), regions_downscaled->RegionCount(), regions->RegionCount() * 0.1);
+
+  // Keypoints are expressed in full resolution coordinates
+  for (size_t i = 0; i < regions_downscaled->RegionCount(); ++i)
+  {
+    const Vec2 pos = regions_downscaled->GetRegionPosition(i);
+    EXPECT_TRUE(pos.x() >= 0 && pos.x() < in.Width() && pos.y() >= 0 && pos.y() < in.Height());
+  }
+
+  // A downscale that is not supported by the describer is rejected
+  EXPECT_TRUE(extractor.Describe_downscaled(half, 4) == nullptr);
+}
+
+TEST( Sift , ParallelDeterminism )
+{
+  Image<unsigned char> in;
+  const std::string png_filename = std::string( THIS_SOURCE_DIR )
+    + "/../../../openMVG_Samples/imageData/StanfordMobileVisualSearch/Ace_0.png";
+  EXPECT_TRUE( ReadImage( png_filename.c_str(), &in ) );
+
+  SIFT_Anatomy_Image_describer extractor;
+
+  // Serial run
+#ifdef OPENMVG_USE_OPENMP
+  const int nb_thread = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  const auto regions_serial = extractor.Describe_SIFT_Anatomy(in);
+#ifdef OPENMVG_USE_OPENMP
+  omp_set_num_threads(std::max(4, nb_thread));
+#endif
+  // Parallel runs must give the exact same regions, in the same order
+  for (int i = 0; i < 2; ++i)
+  {
+    const auto regions_parallel = extractor.Describe_SIFT_Anatomy(in);
+    EXPECT_EQ(regions_serial->RegionCount(), regions_parallel->RegionCount());
+    if (regions_serial->RegionCount() != regions_parallel->RegionCount())
+      continue;
+    const auto & features_serial = regions_serial->Features();
+    const auto & features_parallel = regions_parallel->Features();
+    for (size_t j = 0; j < regions_serial->RegionCount(); ++j)
+    {
+      EXPECT_EQ(features_serial[j].x(), features_parallel[j].x());
+      EXPECT_EQ(features_serial[j].y(), features_parallel[j].y());
+      EXPECT_EQ(features_serial[j].scale(), features_parallel[j].scale());
+      EXPECT_EQ(features_serial[j].orientation(), features_parallel[j].orientation());
+      EXPECT_TRUE(regions_serial->Descriptors()[j] == regions_parallel->Descriptors()[j]);
+    }
+  }
+#ifdef OPENMVG_USE_OPENMP
+  omp_set_num_threads(nb_thread);
+#endif
+}
+
+TEST( Sift , MaskedImage )
+{
+  Image<unsigned char> in;
+  const std::string png_filename = std::string( THIS_SOURCE_DIR )
+    + "/../../../openMVG_Samples/imageData/StanfordMobileVisualSearch/Ace_0.png";
+  EXPECT_TRUE( ReadImage( png_filename.c_str(), &in ) );
+
+  // Mask out the top band and the left part of the image
+  Image<unsigned char> mask(in.Width(), in.Height(), true, 255);
+  mask.block(0, 0, in.Height() / 3, in.Width()).fill(0);
+  mask.block(0, 0, in.Height(), in.Width() / 2).fill(0);
+
+  for (const int first_octave : {-1, 0, 1})
+  {
+    SIFT_Anatomy_Image_describer extractor{SIFT_Anatomy_Image_describer::Params(first_octave)};
+    // Masking before the description must give the regions of an unmasked
+    // description that lie in the region of interest
+    const auto regions = extractor.Describe_SIFT_Anatomy(in);
+    const auto regions_masked = extractor.Describe_SIFT_Anatomy(in, &mask);
+    std::vector<size_t> roi_region_ids;
+    for (size_t i = 0; i < regions->RegionCount(); ++i)
+    {
+      const auto & feature = regions->Features()[i];
+      if (mask(feature.y(), feature.x()) != 0)
+        roi_region_ids.push_back(i);
+    }
+    EXPECT_TRUE(regions_masked->RegionCount() > 0);
+    EXPECT_EQ(roi_region_ids.size(), regions_masked->RegionCount());
+    if (roi_region_ids.size() != regions_masked->RegionCount())
+      continue;
+    for (size_t i = 0; i < roi_region_ids.size(); ++i)
+    {
+      const auto & feature = regions->Features()[roi_region_ids[i]];
+      const auto & feature_masked = regions_masked->Features()[i];
+      EXPECT_EQ(feature.coords(), feature_masked.coords());
+      EXPECT_EQ(feature.scale(), feature_masked.scale());
+      EXPECT_EQ(feature.orientation(), feature_masked.orientation());
+      EXPECT_TRUE(regions->Descriptors()[roi_region_ids[i]] == regions_masked->Descriptors()[i]);
+    }
+  }
+
+  // A fully masked image has no region
+  mask.fill(0);
+  SIFT_Anatomy_Image_describer extractor;
+  EXPECT_EQ(0, extractor.Describe(in, &mask)->RegionCount());
+}
+
 /* ************************************************************************* */
 int main()
 {
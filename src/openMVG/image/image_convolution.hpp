@@ -9,11 +9,13 @@
 #ifndef OPENMVG_IMAGE_IMAGE_CONVOLUTION_HPP
 #define OPENMVG_IMAGE_IMAGE_CONVOLUTION_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
 #include "openMVG/image/image_container.hpp"
 #include "openMVG/image/image_convolution_base.hpp"
+#include "openMVG/image/image_convolution_simd.hpp"
 #include "openMVG/numeric/accumulator_trait.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
@@ -94,33 +96,43 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
   const int kernel_width = kernel.size();
   const int half_kernel_width = kernel_width / 2;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t>> line( cols + kernel_width );
-
-  for (int row = 0; row < rows; ++row )
+#if defined(OPENMVG_USE_OPENMP)
+  #pragma omp parallel
+#endif
   {
-    // Copy line
-    const pix_t start_pix = img.coeffRef( row , 0 );
-    for (int k = 0; k < half_kernel_width; ++k ) // pad before
-    {
-      line[ k ] = start_pix;
-    }
-    std::memcpy( &line[0] + half_kernel_width, img.data() + row * cols, sizeof( pix_t ) * cols );
-    const pix_t end_pix = img.coeffRef( row , cols - 1 );
-    for (int k = 0; k < half_kernel_width; ++k ) // pad after
+    std::vector<pix_t, Eigen::aligned_allocator<pix_t>> line( cols + kernel_width );
+
+#if defined(OPENMVG_USE_OPENMP)
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int row = 0; row < rows; ++row )
     {
-      line[ k + half_kernel_width + cols ] = end_pix;
-    }
+      // Copy line
+      const pix_t start_pix = img.coeffRef( row , 0 );
+      for (int k = 0; k < half_kernel_width; ++k ) // pad before
+      {
+        line[ k ] = start_pix;
+      }
+      std::memcpy( &line[0] + half_kernel_width, img.data() + row * cols, sizeof( pix_t ) * cols );
+      const pix_t end_pix = img.coeffRef( row , cols - 1 );
+      for (int k = 0; k < half_kernel_width; ++k ) // pad after
+      {
+        line[ k + half_kernel_width + cols ] = end_pix;
+      }
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
+      // Apply convolution
+      conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
 
-    std::memcpy( out.data() + row * cols, &line[0], sizeof( pix_t ) * cols );
+      std::memcpy( out.data() + row * cols, &line[0], sizeof( pix_t ) * cols );
+    }
   }
 }
 
 /**
  ** Vertical (1d) convolution
  ** assume kernel has odd size
+ ** The image is processed row by row (the kernel taps are accumulated on whole
+ **  rows) in order to keep a sequential memory access.
  ** @param img Input image
  ** @param kernel convolution kernel
  ** @param out Output image
@@ -129,6 +141,7 @@ template<typename ImageTypeIn, typename ImageTypeOut, typename Kernel>
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out )
 {
   using pix_t = typename ImageTypeIn::Tpixel;
+  using kernel_t = typename Kernel::Scalar;
 
   const int kernel_width = kernel.size();
   const int half_kernel_width = kernel_width / 2;
@@ -138,30 +151,32 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
 
   out.resize( cols , rows );
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t>> line( rows + kernel_width );
-
-  for (int col = 0; col < cols; ++col )
+#if defined(OPENMVG_USE_OPENMP)
+  #pragma omp parallel
+#endif
   {
-    // Copy column
-    for (int k = 0; k < half_kernel_width; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col );
-    }
-    for (int k = 0; k < rows; ++k )
-    {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col );
-    }
-    for (int k = 0; k < half_kernel_width; ++k )
-    {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col );
-    }
-
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
-
+    std::vector<kernel_t> sums( cols );
+#if defined(OPENMVG_USE_OPENMP)
+    #pragma omp for schedule(dynamic)
+#endif
     for (int row = 0; row < rows; ++row )
     {
-      out.coeffRef( row , col ) = line[row];
+      std::fill( sums.begin(), sums.end(), kernel_t( 0 ) );
+      for (int k = 0; k < kernel_width; ++k )
+      {
+        // Border pixels are copied
+        const int src_row = std::min( std::max( row + k - half_kernel_width, 0 ), rows - 1 );
+        const pix_t * src = img.data() + src_row * cols;
+        const kernel_t weight = kernel.data()[k];
+        for (int col = 0; col < cols; ++col )
+        {
+          sums[ col ] += src[ col ] * weight;
+        }
+      }
+      for (int col = 0; col < cols; ++col )
+      {
+        out.coeffRef( row , col ) = static_cast<pix_t>( sums[ col ] );
+      }
     }
   }
 }
@@ -193,81 +208,138 @@ void ImageSeparableConvolution( const ImageType & img ,
 
 using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 
-/// Specialization for Float based image (for arbitrary sized kernel)
-inline void SeparableConvolution2d( const RowMatrixXf& image,
-                                    const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
-                                    const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
-                                    RowMatrixXf* out )
+/**
+ ** @brief Mirror an index in the [0;n[ range (without repeating the border value)
+ ** i.e. for n = 5: -2 -> 2, -1 -> 1, 5 -> 3, 6 -> 2
+ **/
+inline int MirrorIndex( int i , const int n )
 {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
+  if ( n == 1 )
+    return 0;
+  while ( i < 0 || i >= n )
+  {
+    i = ( i < 0 ) ? -i : 2 * n - 2 - i;
+  }
+  return i;
+}
 
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
-#if defined(OPENMVG_USE_OPENMP)
-  #pragma omp parallel for schedule(dynamic)
-#endif
-  for ( int i = 0; i < half_sigma_y; i++ )
+/**
+ ** Work buffers used to compute a separable convolution row by row
+ **/
+struct SeparableConvolutionRowBuffer
+{
+  std::vector<const float*> kernel_rows; // input rows used by the vertical pass
+  std::vector<float> line; // vertical pass result extended by mirrored values on each side
+};
+
+/**
+ ** Separable convolution of an image row (vertical pass then horizontal pass)
+ ** Borders are mirrored.
+ ** @param image Input image
+ ** @param kernel_x horizontal kernel
+ ** @param kernel_y vertical kernel
+ ** @param row the row to compute
+ ** @param[out] out_row Output row (image.cols() elements)
+ ** @param buffer Work buffers (can be reused from one call to another)
+ ** @param instruction_set Instruction set used by the row convolutions
+ **/
+inline void SeparableConvolutionRow( const RowMatrixXf& image,
+                                     const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                                     const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                                     const int row,
+                                     float * out_row,
+                                     SeparableConvolutionRowBuffer & buffer,
+                                     const EConvolutionInstructionSet instruction_set =
+                                       BestConvolutionInstructionSet() )
+{
+  const int rows = static_cast<int>( image.rows() );
+  const int cols = static_cast<int>( image.cols() );
+  const int ksize_x = static_cast<int>( kernel_x.cols() );
+  const int ksize_y = static_cast<int>( kernel_y.cols() );
+  const int half_ksize_x = ksize_x / 2;
+  const int half_ksize_y = ksize_y / 2;
+
+  buffer.kernel_rows.resize( ksize_y );
+  buffer.line.resize( cols + 2 * half_ksize_x );
+
+  // Vertical pass
+  for ( int k = 0; k < ksize_y; ++k )
   {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row( i ) = kernel_y.tail( forward_size ) *
-                    image.block( 0, 0, forward_size, image.cols() ) +
-                    reverse_kernel_y.tail( reverse_size ) *
-                    image.block( 1, 0, reverse_size, image.cols() );
-
-    // Apply the same technique for the end rows.
-    out->row( image.rows() - i - 1 ) =
-      kernel_y.head( forward_size ) *
-      image.block( image.rows() - forward_size, 0, forward_size, image.cols() )
-      +
-      reverse_kernel_y.head( reverse_size ) *
-      image.block( image.rows() - reverse_size - 1, 0, reverse_size, image.cols() );
+    buffer.kernel_rows[k] = image.data() + MirrorIndex( row + k - half_ksize_y, rows ) * cols;
   }
+  float * row_begin = buffer.line.data() + half_ksize_x;
+  ConvolveRowsVertical( buffer.kernel_rows.data(), kernel_y.data(), ksize_y, cols,
+                        row_begin, instruction_set );
 
-  // Applying the rest of the y filter.
-#if defined(OPENMVG_USE_OPENMP)
-  #pragma omp parallel for schedule(dynamic)
-#endif
-  for ( int row = half_sigma_y; row < image.rows() - half_sigma_y; row++ )
+  // Mirror the borders
+  for ( int k = 1; k <= half_ksize_x; ++k )
   {
-    out->row( row ) =  kernel_y * image.block( row - half_sigma_y, 0, sigma_y, out->cols() );
+    row_begin[-k] = row_begin[MirrorIndex( -k, cols )];
+    row_begin[cols - 1 + k] = row_begin[MirrorIndex( cols - 1 + k, cols )];
   }
 
-  const int sigma_x = static_cast<int>( kernel_x.cols() );
-  const int half_sigma_x = static_cast<int>( kernel_x.cols() / 2 );
+  // Horizontal pass
+  ConvolveRowHorizontal( buffer.line.data(), kernel_x.data(), ksize_x, cols,
+                         out_row, instruction_set );
+}
+
+/**
+ ** Specialization for Float based image (for arbitrary sized kernel)
+ ** The two 1D passes are fused and run row by row (see SeparableConvolutionRow):
+ **  the intermediate row stays in cache. Borders are mirrored.
+ ** A decimation step can be used to compute only one pixel over step
+ **  (i.e. a fused blur + decimation for pyramid construction).
+ ** @param image Input image
+ ** @param kernel_x horizontal kernel
+ ** @param kernel_y vertical kernel
+ ** @param[out] out Output image of size (image.rows() / step, image.cols() / step)
+ ** @param step decimation step (1 for no decimation)
+ ** @param instruction_set Instruction set used by the row convolutions
+ **/
+inline void SeparableConvolution2d( const RowMatrixXf& image,
+                                    const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                                    const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                                    RowMatrixXf* out,
+                                    const int step = 1,
+                                    const EConvolutionInstructionSet instruction_set =
+                                      BestConvolutionInstructionSet() )
+{
+  assert( step >= 1 );
+  const int out_rows = static_cast<int>( image.rows() ) / step;
+  const int out_cols = static_cast<int>( image.cols() ) / step;
+  out->resize( out_rows, out_cols );
+  if ( out_rows == 0 || out_cols == 0 )
+    return;
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row( image.cols() + sigma_x - 1 );
 #if defined(OPENMVG_USE_OPENMP)
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
+  #pragma omp parallel
 #endif
-  for ( int row = 0; row < out->rows(); row++ )
   {
-    temp_row.head( half_sigma_x ) =
-      out->row( row ).segment( 1, half_sigma_x ).reverse();
-    temp_row.segment( half_sigma_x, image.cols() ) = out->row( row );
-    temp_row.tail( half_sigma_x ) =
-      out->row( row )
-      .segment( image.cols() - 2 - half_sigma_x, half_sigma_x )
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row( row ) = kernel_x( 0 ) * temp_row.head( image.cols() );
-    for ( int i = 1; i < sigma_x; i++ )
+    SeparableConvolutionRowBuffer buffer;
+    std::vector<float> decimated_row( step > 1 ? image.cols() : 0 );
+#if defined(OPENMVG_USE_OPENMP)
+    #pragma omp for schedule(dynamic)
+#endif
+    for ( int out_row = 0; out_row < out_rows; ++out_row )
     {
-      out->row( row ) += kernel_x( i ) * temp_row.segment( i, image.cols() );
+      if ( step == 1 )
+      {
+        SeparableConvolutionRow( image, kernel_x, kernel_y, out_row,
+                                 out->data() + out_row * out_cols, buffer, instruction_set );
+      }
+      else
+      {
+        SeparableConvolutionRow( image, kernel_x, kernel_y, out_row * step,
+                                 decimated_row.data(), buffer, instruction_set );
+        for ( int out_col = 0; out_col < out_cols; ++out_col )
+        {
+          out->coeffRef( out_row, out_col ) = decimated_row[out_col * step];
+        }
+      }
     }
   }
 }
 
-
 /**
 * @brief Specialization for Image<float> in order to use SeparableConvolution2d
 * @param img Input image
@@ -291,6 +363,30 @@ void ImageSeparableConvolution( const Image<float> & img ,
   SeparableConvolution2d( img.GetMat(), horiz_k_cast, vert_k_cast, &out );
 }
 
+/**
+* @brief Separable convolution followed by a decimation (one pixel over two is kept)
+*  Only the kept rows are filtered (faster than a convolution followed by ImageDecimate).
+* @param img Input image
+* @param horiz_k Kernel used for horizontal convolution
+* @param vert_k Kernl used for vertical convolution
+* @param[out] out Convolved and decimated image (of size (img.Width() / 2, img.Height() / 2))
+*/
+template<typename Kernel>
+void ImageSeparableConvolutionDecimate( const Image<float> & img ,
+                                        const Kernel & horiz_k ,
+                                        const Kernel & vert_k ,
+                                        Image<float> & out )
+{
+  // Cast the Kernel to the appropriate type
+  using pix_t = Image<float>::Tpixel;
+  using VecKernel = Eigen::Matrix<typename openMVG::Accumulator<pix_t>::Type, Eigen::Dynamic, 1>;
+  const VecKernel horiz_k_cast = horiz_k.template cast< typename openMVG::Accumulator<pix_t>::Type >();
+  const VecKernel vert_k_cast = vert_k.template cast< typename openMVG::Accumulator<pix_t>::Type >();
+
+  out.resize( img.Width() / 2, img.Height() / 2 );
+  SeparableConvolution2d( img.GetMat(), horiz_k_cast, vert_k_cast, &out, 2 );
+}
+
 } // namespace image
 } // namespace openMVG
 
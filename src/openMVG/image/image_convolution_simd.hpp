@@ -0,0 +1,278 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre Moulon.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_IMAGE_IMAGE_CONVOLUTION_SIMD_HPP
+#define OPENMVG_IMAGE_IMAGE_CONVOLUTION_SIMD_HPP
+
+/**
+ ** @file Float row convolution kernels used by the separable convolution:
+ ** - vertical: out[c] = sum_k kernel[k] * rows[k][c]
+ ** - horizontal: out[c] = sum_k kernel[k] * line[c + k]
+ **
+ ** The kernels exist in scalar, SSE2 and AVX2 flavors.
+ ** The AVX2 flavor is selected at runtime if the CPU supports it.
+ ** All the flavors accumulate the kernel taps in the same order (without FMA),
+ ** so they give the same results.
+ **/
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define OPENMVG_IMAGE_CONVOLUTION_SSE2
+  #include <emmintrin.h>
+  #if defined(__AVX2__)
+    #define OPENMVG_IMAGE_CONVOLUTION_AVX2
+    #define OPENMVG_IMAGE_CONVOLUTION_AVX2_TARGET
+  #elif defined(__GNUC__) || defined(__clang__)
+    // AVX2 code path compiled for a specific target and selected at runtime
+    #define OPENMVG_IMAGE_CONVOLUTION_AVX2
+    #define OPENMVG_IMAGE_CONVOLUTION_AVX2_TARGET __attribute__((target("avx2")))
+  #elif defined(_MSC_VER)
+    #define OPENMVG_IMAGE_CONVOLUTION_AVX2
+    #define OPENMVG_IMAGE_CONVOLUTION_AVX2_TARGET
+  #endif
+  #if defined(OPENMVG_IMAGE_CONVOLUTION_AVX2)
+    #include <immintrin.h>
+    #include "openMVG/system/cpu_instruction_set.hpp"
+  #endif
+#endif
+
+namespace openMVG
+{
+namespace image
+{
+
+/// Instruction set used by the float row convolution kernels
+enum class EConvolutionInstructionSet
+{
+  SCALAR,
+  SSE2,
+  AVX2
+};
+
+/**
+ ** @brief Return the best instruction set supported by the binary and the CPU
+ **/
+inline EConvolutionInstructionSet BestConvolutionInstructionSet()
+{
+#if defined(OPENMVG_IMAGE_CONVOLUTION_AVX2)
+  static const bool avx2 = system::CpuInstructionSet().supportAVX2();
+  if (avx2)
+    return EConvolutionInstructionSet::AVX2;
+#endif
+#if defined(OPENMVG_IMAGE_CONVOLUTION_SSE2)
+  return EConvolutionInstructionSet::SSE2;
+#else
+  return EConvolutionInstructionSet::SCALAR;
+#endif
+}
+
+/**
+ ** @brief Tell if an instruction set can be used on this CPU
+ **/
+inline bool IsSupported(const EConvolutionInstructionSet instruction_set)
+{
+  switch (instruction_set)
+  {
+    case EConvolutionInstructionSet::AVX2:
+      return BestConvolutionInstructionSet() == EConvolutionInstructionSet::AVX2;
+    case EConvolutionInstructionSet::SSE2:
+#if defined(OPENMVG_IMAGE_CONVOLUTION_SSE2)
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return true;
+  }
+}
+
+namespace internal
+{
+
+// Scalar kernels (also used for the tail of the SIMD kernels)
+
+inline void ConvolveRowsVertical_Scalar
+(
+  const float * const * rows, const float * kernel, const int ksize,
+  const int begin, const int end, float * out
+)
+{
+  for (int c = begin; c < end; ++c)
+  {
+    float sum = kernel[0] * rows[0][c];
+    for (int k = 1; k < ksize; ++k)
+      sum += kernel[k] * rows[k][c];
+    out[c] = sum;
+  }
+}
+
+inline void ConvolveRowHorizontal_Scalar
+(
+  const float * line, const float * kernel, const int ksize,
+  const int begin, const int end, float * out
+)
+{
+  for (int c = begin; c < end; ++c)
+  {
+    float sum = kernel[0] * line[c];
+    for (int k = 1; k < ksize; ++k)
+      sum += kernel[k] * line[c + k];
+    out[c] = sum;
+  }
+}
+
+#if defined(OPENMVG_IMAGE_CONVOLUTION_SSE2)
+
+inline void ConvolveRowsVertical_SSE2
+(
+  const float * const * rows, const float * kernel, const int ksize,
+  const int width, float * out
+)
+{
+  int c = 0;
+  for (; c + 4 <= width; c += 4)
+  {
+    __m128 sum = _mm_mul_ps(_mm_set1_ps(kernel[0]), _mm_loadu_ps(rows[0] + c));
+    for (int k = 1; k < ksize; ++k)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[k]), _mm_loadu_ps(rows[k] + c)));
+    _mm_storeu_ps(out + c, sum);
+  }
+  ConvolveRowsVertical_Scalar(rows, kernel, ksize, c, width, out);
+}
+
+inline void ConvolveRowHorizontal_SSE2
+(
+  const float * line, const float * kernel, const int ksize,
+  const int width, float * out
+)
+{
+  int c = 0;
+  for (; c + 4 <= width; c += 4)
+  {
+    __m128 sum = _mm_mul_ps(_mm_set1_ps(kernel[0]), _mm_loadu_ps(line + c));
+    for (int k = 1; k < ksize; ++k)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[k]), _mm_loadu_ps(line + c + k)));
+    _mm_storeu_ps(out + c, sum);
+  }
+  ConvolveRowHorizontal_Scalar(line, kernel, ksize, c, width, out);
+}
+
+#endif // OPENMVG_IMAGE_CONVOLUTION_SSE2
+
+#if defined(OPENMVG_IMAGE_CONVOLUTION_AVX2)
+
+OPENMVG_IMAGE_CONVOLUTION_AVX2_TARGET
+inline void ConvolveRowsVertical_AVX2
+(
+  const float * const * rows, const float * kernel, const int ksize,
+  const int width, float * out
+)
+{
+  int c = 0;
+  for (; c + 8 <= width; c += 8)
+  {
+    __m256 sum = _mm256_mul_ps(_mm256_set1_ps(kernel[0]), _mm256_loadu_ps(rows[0] + c));
+    for (int k = 1; k < ksize; ++k)
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel[k]), _mm256_loadu_ps(rows[k] + c)));
+    _mm256_storeu_ps(out + c, sum);
+  }
+  ConvolveRowsVertical_Scalar(rows, kernel, ksize, c, width, out);
+}
+
+OPENMVG_IMAGE_CONVOLUTION_AVX2_TARGET
+inline void ConvolveRowHorizontal_AVX2
+(
+  const float * line, const float * kernel, const int ksize,
+  const int width, float * out
+)
+{
+  int c = 0;
+  for (; c + 8 <= width; c += 8)
+  {
+    __m256 sum = _mm256_mul_ps(_mm256_set1_ps(kernel[0]), _mm256_loadu_ps(line + c));
+    for (int k = 1; k < ksize; ++k)
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel[k]), _mm256_loadu_ps(line + c + k)));
+    _mm256_storeu_ps(out + c, sum);
+  }
+  ConvolveRowHorizontal_Scalar(line, kernel, ksize, c, width, out);
+}
+
+#endif // OPENMVG_IMAGE_CONVOLUTION_AVX2
+
+} // namespace internal
+
+/**
+ ** Vertical convolution of a set of rows: out[c] = sum_k kernel[k] * rows[k][c]
+ ** @param rows the ksize input rows (of width elements)
+ ** @param kernel kernel array
+ ** @param ksize kernel length
+ ** @param width row length
+ ** @param out output row
+ ** @param instruction_set the instruction set to use
+ **/
+inline void ConvolveRowsVertical
+(
+  const float * const * rows, const float * kernel, const int ksize,
+  const int width, float * out,
+  const EConvolutionInstructionSet instruction_set = BestConvolutionInstructionSet()
+)
+{
+  switch (instruction_set)
+  {
+#if defined(OPENMVG_IMAGE_CONVOLUTION_AVX2)
+    case EConvolutionInstructionSet::AVX2:
+      internal::ConvolveRowsVertical_AVX2(rows, kernel, ksize, width, out);
+      return;
+#endif
+#if defined(OPENMVG_IMAGE_CONVOLUTION_SSE2)
+    case EConvolutionInstructionSet::SSE2:
+      internal::ConvolveRowsVertical_SSE2(rows, kernel, ksize, width, out);
+      return;
+#endif
+    default:
+      internal::ConvolveRowsVertical_Scalar(rows, kernel, ksize, 0, width, out);
+  }
+}
+
+/**
+ ** Horizontal convolution of an extended row [ksize/2][row][ksize/2]:
+ **  out[c] = sum_k kernel[k] * line[c + k]
+ ** @param line the extended row (of width + ksize - 1 elements)
+ ** @param kernel kernel array
+ ** @param ksize kernel length
+ ** @param width output row length
+ ** @param out output row
+ ** @param instruction_set the instruction set to use
+ **/
+inline void ConvolveRowHorizontal
+(
+  const float * line, const float * kernel, const int ksize,
+  const int width, float * out,
+  const EConvolutionInstructionSet instruction_set = BestConvolutionInstructionSet()
+)
+{
+  switch (instruction_set)
+  {
+#if defined(OPENMVG_IMAGE_CONVOLUTION_AVX2)
+    case EConvolutionInstructionSet::AVX2:
+      internal::ConvolveRowHorizontal_AVX2(line, kernel, ksize, width, out);
+      return;
+#endif
+#if defined(OPENMVG_IMAGE_CONVOLUTION_SSE2)
+    case EConvolutionInstructionSet::SSE2:
+      internal::ConvolveRowHorizontal_SSE2(line, kernel, ksize, width, out);
+      return;
+#endif
+    default:
+      internal::ConvolveRowHorizontal_Scalar(line, kernel, ksize, 0, width, out);
+  }
+}
+
+} // namespace image
+} // namespace openMVG
+
+#endif // OPENMVG_IMAGE_IMAGE_CONVOLUTION_SIMD_HPP
@@ -51,59 +51,61 @@ void ImagePeronaMalikG2DiffusionCoef( const Image & Lx , const Image & Ly , cons
   out.array() = ( static_cast<Real>( 1.f ) + ( Lx.array().square() + Ly.array().square() ) / ( k * k ) ).inverse();
 }
 
+namespace internal
+{
+
 /**
 ** Apply Fast Explicit Diffusion to an Image (on central part)
+** The pixels are processed along contiguous rows (vectorizable loop).
 ** @param src input image
 ** @param diff diffusion coefficient image
 ** @param half_t Half diffusion time
-** @param out Output image
+** @param out Output image (FED step value, or src + FED step value if ADD_SRC)
 ** @param row_start Row range beginning (range is [row_start; row_end [ )
 ** @param row_end Row range end (range is [row_start; row_end [ )
 **/
-template<typename Image>
+template<bool ADD_SRC, typename Image>
 void ImageFEDCentral( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out ,
                       const int row_start , const int row_end )
 {
   using Real = typename Image::Tpixel;
   const int width = src.Width();
-  Real n_diff[4];
-  Real n_src[4];
   // Compute FED step on general range
   for (int i = row_start; i < row_end; ++i)
   {
+    const Real * src_up = src.data() + ( i - 1 ) * width;
+    const Real * src_cur = src_up + width;
+    const Real * src_down = src_cur + width;
+    const Real * diff_up = diff.data() + ( i - 1 ) * width;
+    const Real * diff_cur = diff_up + width;
+    const Real * diff_down = diff_cur + width;
+    Real * out_cur = out.data() + i * width;
+#if defined(OPENMVG_USE_OPENMP)
+    #pragma omp simd
+#endif
     for (int j = 1; j < width - 1; ++j)
     {
-      // Retrieve neighbors : TODO check if we need a cache efficient version ?
-      n_diff[0] = diff( i , j + 1 );
-      n_diff[1] = diff( i - 1 , j );
-      n_diff[2] = diff( i , j - 1 );
-      n_diff[3] = diff( i + 1 , j );
-      n_src[0] = src( i , j + 1 );
-      n_src[1] = src( i - 1 , j );
-      n_src[2] = src( i , j - 1 );
-      n_src[3] = src( i + 1 , j );
-
       // Compute diffusion factor for given pixel
-      const Real cur_src = src( i , j );
-      const Real cur_diff = diff( i , j );
-      const Real a = ( cur_diff + n_diff[0] ) * ( n_src[0] - cur_src );
-      const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] );
-      const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] );
-      const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src );
+      const Real cur_src = src_cur[ j ];
+      const Real cur_diff = diff_cur[ j ];
+      const Real a = ( cur_diff + diff_cur[ j + 1 ] ) * ( src_cur[ j + 1 ] - cur_src );
+      const Real b = ( cur_diff + diff_up[ j ] ) * ( cur_src - src_up[ j ] );
+      const Real c = ( cur_diff + diff_cur[ j - 1 ] ) * ( cur_src - src_cur[ j - 1 ] );
+      const Real d = ( cur_diff + diff_down[ j ] ) * ( src_down[ j ] - cur_src );
       const Real value = half_t * ( a - c + d - b );
-      out( i , j ) = value;
+      out_cur[ j ] = ADD_SRC ? cur_src + value : value;
     }
   }
 }
 
 /**
-** Apply Fast Explicit Diffusion to an Image (on central part)
+** Apply Fast Explicit Diffusion to an Image (on central part) using multiple threads
 ** @param src input image
 ** @param diff diffusion coefficient image
 ** @param half_t Half diffusion time
-** @param out Output image
+** @param out Output image (FED step value, or src + FED step value if ADD_SRC)
 **/
-template<typename Image>
+template<bool ADD_SRC, typename Image>
 void ImageFEDCentralCPPThread( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out )
 {
 #ifdef OPENMVG_USE_OPENMP
@@ -121,7 +123,7 @@ void ImageFEDCentralCPPThread( const Image & src , const Image & diff , const ty
 #endif
   for (int i = 1; i < static_cast<int>( range.size() ); ++i)
   {
-    ImageFEDCentral( src, diff, half_t, out, range[i - 1] , range[i] );
+    ImageFEDCentral<ADD_SRC>( src, diff, half_t, out, range[i - 1] , range[i] );
   }
 }
 
@@ -130,9 +132,9 @@ void ImageFEDCentralCPPThread( const Image & src , const Image & diff , const ty
 ** @param src input image
 ** @param diff diffusion coefficient image
 ** @param t diffusion time
-** @param out output image
+** @param out output image (FED step value, or src + FED step value if ADD_SRC)
 **/
-template<typename Image>
+template<bool ADD_SRC, typename Image>
 void ImageFED( const Image & src , const Image & diff , const typename Image::Tpixel t , Image & out )
 {
   using Real = typename Image::Tpixel;
@@ -147,7 +149,7 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
   Real n_src[4];
 
   // Take care of the central part
-  ImageFEDCentralCPPThread( src , diff , half_t , out );
+  ImageFEDCentralCPPThread<ADD_SRC>( src , diff , half_t , out );
 
   // Take care of the border
   // - first/last row
@@ -170,7 +172,7 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
     const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] );
     const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src );
     const Real value = half_t * ( a - c + d );
-    out( 0 , j ) = value;
+    out( 0 , j ) = ADD_SRC ? cur_src + value : value;
   }
 
   // Compute FED step on last row
@@ -190,7 +192,7 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
     const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] );
     const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] );
     const Real value = half_t * ( a - c - b );
-    out( height - 1 , j ) = value;
+    out( height - 1 , j ) = ADD_SRC ? cur_src + value : value;
   }
 
   // Compute FED step on first col
@@ -210,7 +212,7 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
     const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] );
     const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src );
     const Real value = half_t * ( a + d - b );
-    out( i , 0 ) = value;
+    out( i , 0 ) = ADD_SRC ? cur_src + value : value;
   }
 
   // Compute FED step on last col
@@ -230,12 +232,67 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
     const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] );
     const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src );
     const Real value = half_t * ( - c + d - b );
-    out( i , width - 1 ) = value;
+    out( i , width - 1 ) = ADD_SRC ? cur_src + value : value;
+  }
+
+  // The corners are not diffused
+  if (ADD_SRC)
+  {
+    out( 0 , 0 ) = src( 0 , 0 );
+    out( 0 , width - 1 ) = src( 0 , width - 1 );
+    out( height - 1 , 0 ) = src( height - 1 , 0 );
+    out( height - 1 , width - 1 ) = src( height - 1 , width - 1 );
   }
 }
 
+} // namespace internal
+
+/**
+** Apply Fast Explicit Diffusion to an Image (on central part)
+** @param src input image
+** @param diff diffusion coefficient image
+** @param half_t Half diffusion time
+** @param out Output image
+** @param row_start Row range beginning (range is [row_start; row_end [ )
+** @param row_end Row range end (range is [row_start; row_end [ )
+**/
+template<typename Image>
+void ImageFEDCentral( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out ,
+                      const int row_start , const int row_end )
+{
+  internal::ImageFEDCentral<false>( src , diff , half_t , out , row_start , row_end );
+}
+
+/**
+** Apply Fast Explicit Diffusion to an Image (on central part)
+** @param src input image
+** @param diff diffusion coefficient image
+** @param half_t Half diffusion time
+** @param out Output image
+**/
+template<typename Image>
+void ImageFEDCentralCPPThread( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out )
+{
+  internal::ImageFEDCentralCPPThread<false>( src , diff , half_t , out );
+}
+
+/**
+** Apply Fast Explicit Diffusion of an Image
+** @param src input image
+** @param diff diffusion coefficient image
+** @param t diffusion time
+** @param out output image
+**/
+template<typename Image>
+void ImageFED( const Image & src , const Image & diff , const typename Image::Tpixel t , Image & out )
+{
+  internal::ImageFED<false>( src , diff , t , out );
+}
+
 /**
  ** Compute Fast Explicit Diffusion cycle
+ ** Each FED step writes src + step value in a second buffer (no extra
+ **  accumulation pass), the two buffers are then swapped.
  ** @param self input/output image
  ** @param diff diffusion coefficient
  ** @param tau cycle timing vector
@@ -243,11 +300,11 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
 template<typename Image>
 void ImageFEDCycle( Image & self , const Image & diff , const std::vector<typename Image::Tpixel > & tau )
 {
-  Image tmp;
+  Image tmp( self.Width() , self.Height() );
   for (int i = 0; i < tau.size(); ++i)
   {
-    ImageFED( self , diff , tau[i] , tmp );
-    self.array() += tmp.array();
+    internal::ImageFED<true>( self , diff , tau[i] , tmp );
+    self.swap( tmp );
   }
 }
 
@@ -178,49 +178,60 @@ void ImageScharrYDerivative( const Image & img , Image & out , const bool normal
 
 
 /**
- ** Compute X-derivative using scaled Scharr filter
- ** @param img Input image
- ** @param out Output image
+ ** Compute the 1D kernels of the scaled Scharr filter
  ** @param scale scale of filter (1 -> 3x3 filter; 2 -> 5x5, ...)
  ** @param bNormalize true if kernel must be normalized
+ ** @param[out] kernel_derivative Kernel applied along the derivative direction
+ ** @param[out] kernel_smoothing Kernel applied along the orthogonal direction
  **/
-template<typename Image>
-void ImageScaledScharrXDerivative( const Image & img , Image & out , const int scale , const bool bNormalize = true )
+inline void ComputeScaledScharrKernels( const int scale , const bool bNormalize ,
+                                        Vec & kernel_derivative , Vec & kernel_smoothing )
 {
-  const int kernel_size = 3 + 2 * ( scale - 1 );
-
-  Vec kernel_vert( kernel_size );
-  Vec kernel_horiz( kernel_size );
-
   /*
   General X-derivative function
                               | -1   0   1 |
   D = 1 / ( 2 h * ( w + 2 ) ) | -w   0   w |
                               | -1   0   1 |
   */
+  const int kernel_size = 3 + 2 * ( scale - 1 );
+
+  kernel_derivative.resize( kernel_size );
+  kernel_smoothing.resize( kernel_size );
 
-  kernel_horiz.fill( 0.0 );
-  kernel_horiz( 0 )               = -1.0;
-  // kernel_horiz( kernel_size / 2 ) = 0.0;
-  kernel_horiz( kernel_size - 1 ) = 1.0;
+  kernel_derivative.fill( 0.0 );
+  kernel_derivative( 0 )               = -1.0;
+  // kernel_derivative( kernel_size / 2 ) = 0.0;
+  kernel_derivative( kernel_size - 1 ) = 1.0;
 
   // Scharr parameter for derivative
   const double w = 10.0 / 3.0;
 
-  kernel_vert.fill( 0.0 );
-  kernel_vert( 0 )               = 1.0;
-  kernel_vert( kernel_size / 2 ) = w;
-  kernel_vert( kernel_size - 1 ) = 1.0;
+  kernel_smoothing.fill( 0.0 );
+  kernel_smoothing( 0 )               = 1.0;
+  kernel_smoothing( kernel_size / 2 ) = w;
+  kernel_smoothing( kernel_size - 1 ) = 1.0;
 
   if (bNormalize )
   {
-    kernel_vert *= 1.0 / ( 2.0 * scale * ( w + 2.0 ) );
+    kernel_smoothing *= 1.0 / ( 2.0 * scale * ( w + 2.0 ) );
   }
-
-  ImageSeparableConvolution( img , kernel_horiz , kernel_vert , out );
 }
 
+/**
+ ** Compute X-derivative using scaled Scharr filter
+ ** @param img Input image
+ ** @param out Output image
+ ** @param scale scale of filter (1 -> 3x3 filter; 2 -> 5x5, ...)
+ ** @param bNormalize true if kernel must be normalized
+ **/
+template<typename Image>
+void ImageScaledScharrXDerivative( const Image & img , Image & out , const int scale , const bool bNormalize = true )
+{
+  Vec kernel_horiz, kernel_vert;
+  ComputeScaledScharrKernels( scale , bNormalize , kernel_horiz , kernel_vert );
 
+  ImageSeparableConvolution( img , kernel_horiz , kernel_vert , out );
+}
 
 /**
  ** Compute Y-derivative using scaled Scharr filter
@@ -239,33 +250,97 @@ void ImageScaledScharrYDerivative( const Image & img , Image & out , const int s
                               |  1   w   1 |
 
   */
-  const int kernel_size = 3 + 2 * ( scale - 1 );
-
-  Vec kernel_vert( kernel_size );
-  Vec kernel_horiz( kernel_size );
-
-  // Scharr parameter for derivative
-  const double w = 10.0 / 3.0;
-
+  Vec kernel_horiz, kernel_vert;
+  ComputeScaledScharrKernels( scale , bNormalize , kernel_vert , kernel_horiz );
 
-  kernel_horiz.fill( 0.0 );
-  kernel_horiz( 0 )               = 1.0;
-  kernel_horiz( kernel_size / 2 ) = w;
-  kernel_horiz( kernel_size - 1 ) = 1.0;
+  ImageSeparableConvolution( img , kernel_horiz , kernel_vert , out );
+}
 
-  if (bNormalize )
+/**
+ ** Compute X and Y derivatives using scaled Scharr filter in a single pass over the image
+ ** (same result as ImageScaledScharrXDerivative and ImageScaledScharrYDerivative)
+ ** @param img Input image
+ ** @param[out] Lx X-derivative
+ ** @param[out] Ly Y-derivative
+ ** @param scale scale of filter (1 -> 3x3 filter; 2 -> 5x5, ...)
+ ** @param bNormalize true if kernel must be normalized
+ **/
+inline void ImageScaledScharrDerivatives( const Image<float> & img , Image<float> & Lx , Image<float> & Ly ,
+                                          const int scale , const bool bNormalize = true )
+{
+  Vec kernel_derivative, kernel_smoothing;
+  ComputeScaledScharrKernels( scale , bNormalize , kernel_derivative , kernel_smoothing );
+  const Eigen::Matrix<float, 1, Eigen::Dynamic>
+    kernel_d = kernel_derivative.cast<float>(),
+    kernel_s = kernel_smoothing.cast<float>();
+
+  Lx.resize( img.Width() , img.Height() );
+  Ly.resize( img.Width() , img.Height() );
+
+#if defined(OPENMVG_USE_OPENMP)
+  #pragma omp parallel
+#endif
   {
-    kernel_horiz *= 1.0 / ( 2.0 * scale * ( w + 2.0 ) );
+    SeparableConvolutionRowBuffer buffer;
+#if defined(OPENMVG_USE_OPENMP)
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int row = 0; row < img.Height(); ++row )
+    {
+      SeparableConvolutionRow( img.GetMat() , kernel_d , kernel_s , row , Lx.data() + row * Lx.Width() , buffer );
+      SeparableConvolutionRow( img.GetMat() , kernel_s , kernel_d , row , Ly.data() + row * Ly.Width() , buffer );
+    }
   }
-
-  kernel_vert.fill( 0.0 );
-  kernel_vert( 0 ) = - 1.0;
-  // kernel_vert( kernel_size / 2 ) = 0.0;
-  kernel_vert( kernel_size - 1 ) = 1.0;
-
-  ImageSeparableConvolution( img , kernel_horiz , kernel_vert , out );
 }
 
+/**
+ ** Compute the determinant of the Hessian from the first derivatives using scaled Scharr filter
+ **  out = ( Lxx * Lyy - Lxy * Lxy ) * factor
+ ** The second derivatives (Lxx = d(Lx)/dx, Lxy = d(Lx)/dy, Lyy = d(Ly)/dy) are computed
+ **  row by row and are not stored (same result as computing them with
+ **  ImageScaledScharrXDerivative and ImageScaledScharrYDerivative).
+ ** @param Lx X-derivative
+ ** @param Ly Y-derivative
+ ** @param[out] out Determinant of the Hessian
+ ** @param scale scale of filter (1 -> 3x3 filter; 2 -> 5x5, ...)
+ ** @param factor Scaling applied to the determinant
+ ** @param bNormalize true if kernel must be normalized
+ **/
+inline void ImageScaledScharrHessianDeterminant( const Image<float> & Lx , const Image<float> & Ly ,
+                                                 Image<float> & out , const int scale , const float factor ,
+                                                 const bool bNormalize = true )
+{
+  Vec kernel_derivative, kernel_smoothing;
+  ComputeScaledScharrKernels( scale , bNormalize , kernel_derivative , kernel_smoothing );
+  const Eigen::Matrix<float, 1, Eigen::Dynamic>
+    kernel_d = kernel_derivative.cast<float>(),
+    kernel_s = kernel_smoothing.cast<float>();
+
+  const int width = Lx.Width();
+  out.resize( width , Lx.Height() );
+
+#if defined(OPENMVG_USE_OPENMP)
+  #pragma omp parallel
+#endif
+  {
+    SeparableConvolutionRowBuffer buffer;
+    std::vector<float> Lxx( width ), Lxy( width ), Lyy( width );
+#if defined(OPENMVG_USE_OPENMP)
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int row = 0; row < Lx.Height(); ++row )
+    {
+      SeparableConvolutionRow( Lx.GetMat() , kernel_d , kernel_s , row , Lxx.data() , buffer );
+      SeparableConvolutionRow( Lx.GetMat() , kernel_s , kernel_d , row , Lxy.data() , buffer );
+      SeparableConvolutionRow( Ly.GetMat() , kernel_s , kernel_d , row , Lyy.data() , buffer );
+      float * out_row = out.data() + row * width;
+      for (int col = 0; col < width; ++col )
+      {
+        out_row[ col ] = ( Lxx[ col ] * Lyy[ col ] - Lxy[ col ] * Lxy[ col ] ) * factor;
+      }
+    }
+  }
+}
 
 /**
  ** Compute (isotropic) gaussian filtering of an image using filter width of k * sigma
@@ -367,6 +442,25 @@ void ImageGaussianFilter( const Image & img , const double sigma , Image & out ,
   ImageSeparableConvolution( img , kernel_horiz , kernel_vert , out );
 }
 
+/**
+ ** Compute (isotropic) gaussian filtering of an image followed by a decimation
+ **  (one pixel over two is kept, as ImageDecimate). Blur and decimation are fused:
+ **  only the kept pixels are filtered.
+ ** @param img Input image
+ ** @param sigma standard deviation of kernel
+ ** @param out Output image of size (img.Width() / 2, img.Height() / 2)
+ ** @param kernel_size Size of the kernel (must be an odd number or 0 for automatic computation)
+ **/
+inline void ImageGaussianFilterDecimate( const Image<float> & img , const double sigma , Image<float> & out ,
+                                         const size_t kernel_size = 0 )
+{
+  assert( kernel_size % 2 == 1 || kernel_size == 0 );
+
+  const Vec kernel = ComputeGaussianKernel( kernel_size , sigma );
+
+  ImageSeparableConvolutionDecimate( img , kernel , kernel , out );
+}
+
 } // namespace image
 } // namespace openMVG
 
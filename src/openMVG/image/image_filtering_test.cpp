@@ -7,11 +7,14 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "openMVG/image/image_io.hpp"
+#include "openMVG/image/image_diffusion.hpp"
 #include "openMVG/image/image_filtering.hpp"
+#include "openMVG/image/image_resampling.hpp"
 
 #include "testing/testing.h"
 
 #include <iostream>
+#include <random>
 
 using namespace openMVG;
 using namespace openMVG::image;
@@ -131,6 +134,167 @@ TEST(Image, Convolution_Sobel_X_Y)
   EXPECT_TRUE(WriteImage("out_SobelY.png", Image<unsigned char>(outFiltered.cast<unsigned char>())));
 }
 
+// Reference separable convolution with mirrored borders (double accumulation)
+static Image<float> ReferenceSeparableConvolution
+(
+  const Image<float> & in,
+  const Vec & kernel_x,
+  const Vec & kernel_y
+)
+{
+  const int half_x = kernel_x.size() / 2, half_y = kernel_y.size() / 2;
+  Image<float> tmp(in.Width(), in.Height()), out(in.Width(), in.Height());
+  for (int row = 0; row < in.Height(); ++row)
+    for (int col = 0; col < in.Width(); ++col)
+    {
+      double sum = 0;
+      for (int k = 0; k < kernel_y.size(); ++k)
+        sum += kernel_y(k) * in(MirrorIndex(row + k - half_y, in.Height()), col);
+      tmp(row, col) = sum;
+    }
+  for (int row = 0; row < in.Height(); ++row)
+    for (int col = 0; col < in.Width(); ++col)
+    {
+      double sum = 0;
+      for (int k = 0; k < kernel_x.size(); ++k)
+        sum += kernel_x(k) * tmp(row, MirrorIndex(col + k - half_x, in.Width()));
+      out(row, col) = sum;
+    }
+  return out;
+}
+
+static Image<float> RandomImage(const int width, const int height)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+  Image<float> image(width, height);
+  for (int i = 0; i < image.size(); ++i)
+    image.data()[i] = distribution(random_generator);
+  return image;
+}
+
+static const std::vector<EConvolutionInstructionSet> instruction_sets =
+{
+  EConvolutionInstructionSet::SCALAR,
+  EConvolutionInstructionSet::SSE2,
+  EConvolutionInstructionSet::AVX2
+};
+
+TEST(Image, Convolution_Float_SIMD)
+{
+  // Odd sizes to test the SIMD loop tails
+  const Image<float> in = RandomImage(37, 29);
+  for (const double sigma : {0.5, 1.6, 4.0})
+  {
+    const Vec kernel = ComputeGaussianKernel(0, sigma);
+    const Vec kernel_y = ComputeGaussianKernel(3, sigma);
+    const Image<float> reference = ReferenceSeparableConvolution(in, kernel, kernel_y);
+
+    const Eigen::Matrix<float, 1, Eigen::Dynamic>
+      kernel_f = kernel.cast<float>(), kernel_y_f = kernel_y.cast<float>();
+    RowMatrixXf scalar_out;
+    SeparableConvolution2d(in.GetMat(), kernel_f, kernel_y_f, &scalar_out, 1,
+                           EConvolutionInstructionSet::SCALAR);
+    for (const auto instruction_set : instruction_sets)
+    {
+      if (!IsSupported(instruction_set))
+        continue;
+      RowMatrixXf out;
+      SeparableConvolution2d(in.GetMat(), kernel_f, kernel_y_f, &out, 1, instruction_set);
+      EXPECT_EQ(in.Height(), out.rows());
+      EXPECT_EQ(in.Width(), out.cols());
+      EXPECT_NEAR(0.0, (out - reference.GetMat()).cwiseAbs().maxCoeff(), 1e-5);
+      // All the instruction sets accumulate the taps in the same order
+      EXPECT_NEAR(0.0, (out - scalar_out).cwiseAbs().maxCoeff(), 1e-6);
+    }
+  }
+
+  // Image<float> interface
+  Image<float> out;
+  ImageGaussianFilter(in, 1.6, out);
+  EXPECT_EQ(in.Width(), out.Width());
+  EXPECT_EQ(in.Height(), out.Height());
+}
+
+TEST(Image, Convolution_Vertical_RowOrder)
+{
+  // The vertical convolution copies the border pixels
+  const Image<float> in = RandomImage(23, 31);
+  const Vec kernel = ComputeGaussianKernel(9, 2.0);
+  Image<float> out;
+  ImageVerticalConvolution(in, kernel, out);
+  for (int row = 0; row < in.Height(); ++row)
+    for (int col = 0; col < in.Width(); ++col)
+    {
+      double sum = 0;
+      for (int k = 0; k < kernel.size(); ++k)
+        sum += kernel(k) * in(std::min(std::max(row + k - 4, 0), in.Height() - 1), col);
+      EXPECT_NEAR(sum, out(row, col), 1e-5);
+    }
+}
+
+TEST(Image, GaussianFilterDecimate)
+{
+  for (const auto & size : {std::make_pair(64, 48), std::make_pair(37, 29)})
+  {
+    const Image<float> in = RandomImage(size.first, size.second);
+    // The fused version gives the same result as a blur followed by a decimation
+    Image<float> blurred, decimated, fused;
+    ImageGaussianFilter(in, 1.6, blurred, 0, 0);
+    ImageDecimate(blurred, decimated);
+    ImageGaussianFilterDecimate(in, 1.6, fused);
+    EXPECT_EQ(decimated.Width(), fused.Width());
+    EXPECT_EQ(decimated.Height(), fused.Height());
+    EXPECT_EQ(0.f, (decimated.GetMat() - fused.GetMat()).cwiseAbs().maxCoeff());
+  }
+}
+
+TEST(Image, ScaledScharr_Fused)
+{
+  const Image<float> in = RandomImage(41, 33);
+  for (const int scale : {1, 2, 4})
+  {
+    // Fused first derivatives
+    Image<float> Lx, Ly, Lx_fused, Ly_fused;
+    ImageScaledScharrXDerivative(in, Lx, scale);
+    ImageScaledScharrYDerivative(in, Ly, scale);
+    ImageScaledScharrDerivatives(in, Lx_fused, Ly_fused, scale);
+    EXPECT_EQ(0.f, (Lx.GetMat() - Lx_fused.GetMat()).cwiseAbs().maxCoeff());
+    EXPECT_EQ(0.f, (Ly.GetMat() - Ly_fused.GetMat()).cwiseAbs().maxCoeff());
+
+    // Fused Hessian determinant
+    Image<float> Lxx, Lxy, Lyy, Lhess;
+    ImageScaledScharrXDerivative(Lx, Lxx, scale);
+    ImageScaledScharrYDerivative(Lx, Lxy, scale);
+    ImageScaledScharrYDerivative(Ly, Lyy, scale);
+    const float factor = Square(scale) * Square(scale);
+    ImageScaledScharrHessianDeterminant(Lx, Ly, Lhess, scale, factor);
+    const Mat hessian_determinant =
+      ((Lxx.array() * Lyy.array() - Lxy.array().square()) * factor).cast<double>();
+    EXPECT_EQ(0.0, (hessian_determinant - Lhess.GetMat().cast<double>()).cwiseAbs().maxCoeff());
+  }
+}
+
+TEST(Image, FEDCycle)
+{
+  const Image<float> in = RandomImage(31, 27);
+  Image<float> diff = RandomImage(31, 27);
+  std::vector<float> tau;
+  FEDCycleTimings(2.f, 0.25f, tau);
+
+  // Reference: FED step values accumulated on the image
+  Image<float> reference = in, step;
+  for (const float t : tau)
+  {
+    ImageFED(reference, diff, t, step);
+    reference.array() += step.array();
+  }
+
+  Image<float> evolution = in;
+  ImageFEDCycle(evolution, diff, tau);
+  EXPECT_EQ(0.f, (evolution.GetMat() - reference.GetMat()).cwiseAbs().maxCoeff());
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -133,6 +133,16 @@ int ReadJpgStream(FILE * file,
                   int * w,
                   int * h,
                   int * depth) {
+  return ReadJpgStream(file, ptr, w, h, depth, 1, false);
+}
+
+int ReadJpgStream(FILE * file,
+                  std::vector<unsigned char> * ptr,
+                  int * w,
+                  int * h,
+                  int * depth,
+                  int scale_denom,
+                  bool grayscale) {
   jpeg_decompress_struct cinfo;
   struct my_error_mgr jerr;
   cinfo.err = jpeg_std_error(&jerr.pub);
@@ -147,6 +157,13 @@ int ReadJpgStream(FILE * file,
   jpeg_create_decompress(&cinfo);
   jpeg_stdio_src(&cinfo, file);
   jpeg_read_header(&cinfo, TRUE);
+  // Let the decoder perform the downscaling (in the DCT domain)
+  // and the gray conversion (by keeping only the luminance channel)
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = scale_denom;
+  if (grayscale &&
+      (cinfo.jpeg_color_space == JCS_YCbCr || cinfo.jpeg_color_space == JCS_GRAYSCALE))
+    cinfo.out_color_space = JCS_GRAYSCALE;
   jpeg_start_decompress(&cinfo);
 
   const int row_stride = cinfo.output_width * cinfo.output_components;
@@ -650,6 +667,134 @@ bool ReadImageHeader(const char * filename, ImageHeader * imgheader)
   };
 }
 
+// Decode a JPEG file at the largest supported downscaling factor
+//  that does not exceed max_downscale
+static int ReadJpgDownscaled(const char * filename,
+                             int max_downscale,
+                             bool grayscale,
+                             std::vector<unsigned char> * ptr,
+                             int * w,
+                             int * h,
+                             int * depth,
+                             int * downscale,
+                             ImageHeader * full_resolution_header)
+{
+  if (full_resolution_header && !Read_JPG_ImageHeader(filename, full_resolution_header))
+    return 0;
+
+  // libjpeg supports the 1/2, 1/4 and 1/8 scaling factors
+  int scale_denom = 1;
+  while (scale_denom < 8 && 2 * scale_denom <= max_downscale)
+    scale_denom *= 2;
+
+  FILE *file = fopen(filename, "rb");
+  if (!file) {
+    OPENMVG_LOG_ERROR << "Couldn't open " << filename << " fopen returned 0";
+    return 0;
+  }
+  const int res = ReadJpgStream(file, ptr, w, h, depth, scale_denom, grayscale);
+  fclose(file);
+  if (res != 1)
+    return 0;
+  *downscale = scale_denom;
+  return 1;
+}
+
+int ReadImageDownscaled(const char * filename,
+                        int max_downscale,
+                        Image<unsigned char> * im,
+                        int * downscale,
+                        ImageHeader * full_resolution_header)
+{
+  if (GetFormat(filename) != Jpg)
+  {
+    *downscale = 1;
+    const int res = ReadImage(filename, im);
+    if (res && full_resolution_header)
+    {
+      full_resolution_header->width = im->Width();
+      full_resolution_header->height = im->Height();
+    }
+    return res;
+  }
+
+  std::vector<unsigned char> ptr;
+  int w, h, depth;
+  if (!ReadJpgDownscaled(filename, max_downscale, true, &ptr, &w, &h, &depth,
+                         downscale, full_resolution_header))
+    return 0;
+
+  if (depth == 1)
+  {
+    //convert raw array to Image
+    ( *im ) = Eigen::Map<Image<unsigned char>::Base>( &ptr[0], h, w );
+  }
+  else if (depth == 3)
+  {
+    //-- Must convert RGB to gray
+    RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
+    Image<RGBColor> rgbColIm;
+    rgbColIm = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
+    ConvertPixelType( rgbColIm, im );
+  }
+  else
+  {
+    return 0;
+  }
+  return 1;
+}
+
+int ReadImageDownscaled(const char * filename,
+                        int max_downscale,
+                        Image<RGBColor> * im,
+                        int * downscale,
+                        ImageHeader * full_resolution_header)
+{
+  if (GetFormat(filename) != Jpg)
+  {
+    *downscale = 1;
+    int res = ReadImage(filename, im);
+    if (!res) //try Gray level
+    {
+      Image<unsigned char> image_gray;
+      res = ReadImage(filename, &image_gray);
+      if (res)
+        ConvertPixelType( image_gray, im );
+    }
+    if (res && full_resolution_header)
+    {
+      full_resolution_header->width = im->Width();
+      full_resolution_header->height = im->Height();
+    }
+    return res;
+  }
+
+  std::vector<unsigned char> ptr;
+  int w, h, depth;
+  if (!ReadJpgDownscaled(filename, max_downscale, false, &ptr, &w, &h, &depth,
+                         downscale, full_resolution_header))
+    return 0;
+
+  if (depth == 3)
+  {
+    RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
+    //convert raw array to Image
+    ( *im ) = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
+  }
+  else if (depth == 1)
+  {
+    //-- Must convert gray to RGB
+    Image<unsigned char> grayIm;
+    grayIm = Eigen::Map<Image<unsigned char>::Base>( &ptr[0], h, w );
+    ConvertPixelType( grayIm, im );
+  }
+  else
+  {
+    return 0;
+  }
+  return 1;
+}
+
 bool Read_PNG_ImageHeader(const char * filename, ImageHeader * imgheader)
 {
   bool bStatus = false;
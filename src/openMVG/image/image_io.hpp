@@ -175,6 +175,24 @@ int ReadJpg( const char * path , std::vector<unsigned char> * array, int * w, in
 */
 int ReadJpgStream( FILE * stream , std::vector<unsigned char> * array, int * w, int * h, int * depth );
 
+/**
+* @brief Read JPEG image from stream at a reduced resolution
+* The image is downscaled during the decoding (libjpeg DCT scaling):
+*  the output size is ceil(width / scale_denom) x ceil(height / scale_denom)
+* @param[in] stream Input data stream
+* @param[out] array Output image data
+* @param[out] w Image width (of the downscaled image)
+* @param[out] h Image height (of the downscaled image)
+* @param[out] depth Depth of image
+* @param[in] scale_denom Downscaling factor (1, 2, 4 or 8)
+* @param[in] grayscale Decode directly to a gray image (if the image color
+*  space allows it, else depth is the native one)
+* @retval 0 if there is an error during read operation
+* @return non nul value if read operation is valid
+*/
+int ReadJpgStream( FILE * stream , std::vector<unsigned char> * array, int * w, int * h, int * depth,
+                   int scale_denom, bool grayscale );
+
 /**
 * @brief Write JPEG file
 * @param path Output image path
@@ -355,6 +373,39 @@ bool Read_PNM_ImageHeader( const char * path , ImageHeader * hdr );
 */
 bool Read_TIFF_ImageHeader( const char * path , ImageHeader * hdr );
 
+/**
+* @brief Read a gray image at a reduced resolution
+* JPEG images are decoded directly to gray at the largest downscaling factor
+*  (1, 2, 4 or 8) that does not exceed max_downscale.
+* Other formats are read at full resolution (downscale = 1).
+* @param[in] path Input image path
+* @param[in] max_downscale Maximal accepted downscaling factor
+* @param[out] im Output (downscaled) gray image
+* @param[out] downscale Applied downscaling factor
+* @param[out] full_resolution_header Size of the full resolution image (optional)
+* @retval 0 if there was an error during read operation
+* @retval 1 if read is correct
+*/
+int ReadImageDownscaled( const char * path, int max_downscale, Image<unsigned char> * im,
+                         int * downscale, ImageHeader * full_resolution_header = nullptr );
+
+/**
+* @brief Read a color image at a reduced resolution
+* JPEG images are decoded at the largest downscaling factor
+*  (1, 2, 4 or 8) that does not exceed max_downscale.
+* Other formats are read at full resolution (downscale = 1).
+* Gray level images are converted to RGB.
+* @param[in] path Input image path
+* @param[in] max_downscale Maximal accepted downscaling factor
+* @param[out] im Output (downscaled) color image
+* @param[out] downscale Applied downscaling factor
+* @param[out] full_resolution_header Size of the full resolution image (optional)
+* @retval 0 if there was an error during read operation
+* @retval 1 if read is correct
+*/
+int ReadImageDownscaled( const char * path, int max_downscale, Image<RGBColor> * im,
+                         int * downscale, ImageHeader * full_resolution_header = nullptr );
+
 
 /**
 * @brief Generic Image read from file
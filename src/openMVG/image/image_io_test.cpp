@@ -126,6 +126,53 @@ TEST(ImageIOTest, Jpg) {
   remove(filename.c_str());
 }
 
+TEST(ImageIOTest, Jpg_Downscaled) {
+  Image<RGBColor> image(64, 48);
+  for (int j = 0; j < image.Height(); ++j)
+    for (int i = 0; i < image.Width(); ++i)
+      image(j, i) = RGBColor(i * 4, j * 5, 128);
+  const std::string filename = ("test_write_jpg_downscaled.jpg");
+  EXPECT_TRUE(WriteJpg(filename.c_str(), image, 100));
+
+  Image<unsigned char> read_image;
+  int downscale = 0;
+  ImageHeader header;
+  EXPECT_TRUE(ReadImageDownscaled(filename.c_str(), 4, &read_image, &downscale, &header));
+  EXPECT_EQ(4, downscale);
+  EXPECT_EQ(16, read_image.Width());
+  EXPECT_EQ(12, read_image.Height());
+  EXPECT_EQ(64, header.width);
+  EXPECT_EQ(48, header.height);
+
+  // The downscaling factor is a power of two (up to 8)
+  EXPECT_TRUE(ReadImageDownscaled(filename.c_str(), 3, &read_image, &downscale));
+  EXPECT_EQ(2, downscale);
+  EXPECT_EQ(32, read_image.Width());
+  EXPECT_TRUE(ReadImageDownscaled(filename.c_str(), 100, &read_image, &downscale));
+  EXPECT_EQ(8, downscale);
+  EXPECT_EQ(8, read_image.Width());
+  EXPECT_EQ(6, read_image.Height());
+
+  // Same as the full resolution decoding if no downscale is allowed
+  Image<unsigned char> full_image;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &full_image));
+  EXPECT_TRUE(ReadImageDownscaled(filename.c_str(), 1, &read_image, &downscale));
+  EXPECT_EQ(1, downscale);
+  EXPECT_EQ(full_image.Width(), read_image.Width());
+  EXPECT_EQ(full_image.Height(), read_image.Height());
+
+  // Color decoding
+  Image<RGBColor> read_color_image, full_color_image;
+  EXPECT_TRUE(ReadImageDownscaled(filename.c_str(), 2, &read_color_image, &downscale));
+  EXPECT_EQ(2, downscale);
+  EXPECT_EQ(32, read_color_image.Width());
+  EXPECT_EQ(24, read_color_image.Height());
+  EXPECT_TRUE(ReadImage(filename.c_str(), &full_color_image));
+  EXPECT_TRUE(ReadImageDownscaled(filename.c_str(), 1, &read_color_image, &downscale));
+  EXPECT_TRUE(read_color_image == full_color_image);
+  remove(filename.c_str());
+}
+
 TEST(ReadPnm, Pgm) {
   Image<unsigned char> image;
   const std::string pgm_filename = string(THIS_SOURCE_DIR) + "/image_test/two_pixels.pgm";
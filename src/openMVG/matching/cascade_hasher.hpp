@@ -61,7 +61,10 @@
 // Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
 
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <random>
 #include <utility>
 #include <vector>
@@ -69,29 +72,72 @@
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/matching/metric.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
-#include "openMVG/stl/dynamic_bitset.hpp"
 
 namespace openMVG {
 namespace matching {
 
-struct HashedDescription {
-  // Hash code generated by the primary hashing function.
-  stl::dynamic_bitset hash_code;
+struct HashedDescriptions{
+  // Number of 64 bit blocks used to store a hash code.
+  int nb_hash_code_blocks = 0;
+  // Number of bucket groups.
+  int nb_bucket_groups = 0;
+
+  // Hash codes generated by the primary hashing function
+  // (packed, nb_hash_code_blocks blocks per description).
+  std::vector<uint64_t> hash_codes;
 
-  // Each bucket_ids[x] = y means the descriptor belongs to bucket y in bucket
-  // group x.
+  // bucket_ids[i * nb_bucket_groups + x] = y means the description i belongs
+  // to bucket y in bucket group x.
   std::vector<uint16_t> bucket_ids;
-};
 
-struct HashedDescriptions{
-  // The hash information.
-  std::vector<HashedDescription> hashed_desc;
+  // Buckets of each bucket group, stored contiguously:
+  // the description ids of the bucket y of the group x are
+  //  bucket_descriptions[x][bucket_offsets[x][y] .. bucket_offsets[x][y+1]-1]
+  std::vector<std::vector<uint32_t>> bucket_offsets;
+  std::vector<std::vector<uint32_t>> bucket_descriptions;
+
+  size_t size() const
+  {
+    return nb_bucket_groups == 0 ? 0 : bucket_ids.size() / nb_bucket_groups;
+  }
 
-  using Bucket = std::vector<int>;
-  // buckets[bucket_group][bucket_id] = bucket (container of description ids).
-  std::vector<std::vector<Bucket>> buckets;
+  const uint64_t * HashCode(const size_t i) const
+  {
+    return hash_codes.data() + i * nb_hash_code_blocks;
+  }
 };
 
+// Hamming distance between two packed hash codes.
+// The common 64 and 128 bit hash codes use an unrolled implementation (NB_BLOCKS = 1, 2),
+// NB_BLOCKS = 0 handles any code length.
+template <int NB_BLOCKS>
+inline int HashCodeHammingDistance
+(
+  const uint64_t * a,
+  const uint64_t * b,
+  const int /*nb_blocks*/
+)
+{
+  int distance = 0;
+  for (int i = 0; i < NB_BLOCKS; ++i)
+    distance += PopCount64(a[i] ^ b[i]);
+  return distance;
+}
+
+template <>
+inline int HashCodeHammingDistance<0>
+(
+  const uint64_t * a,
+  const uint64_t * b,
+  const int nb_blocks
+)
+{
+  int distance = 0;
+  for (int i = 0; i < nb_blocks; ++i)
+    distance += PopCount64(a[i] ^ b[i]);
+  return distance;
+}
+
 // This hasher will hash descriptors with a two-step hashing system:
 // 1. it generates a hash code,
 // 2. it determines which buckets the descriptors belong to.
@@ -114,6 +160,12 @@ private:
   // The number of buckets in each group.
   int nb_buckets_per_group_;
 
+  // Number of L2 distance computed per query (the best hash code candidates)
+  static const int kNumTopCandidates = 10;
+
+  // Number of descriptions hashed together (batched projections)
+  static const int kHashingBatchSize = 512;
+
 public:
   CascadeHasher() = default;
 
@@ -147,15 +199,15 @@ public:
     }
 
     // Initialize secondary hash projection.
-    secondary_hash_projection_.resize(nb_bucket_groups);
+    // The projections of all the bucket groups are stacked
+    // (rows [i * nb_bits_per_bucket, (i+1) * nb_bits_per_bucket[ for the group i).
+    secondary_hash_projection_.resize(nb_bucket_groups * nb_bits_per_bucket_, nb_hash_code);
     for (int i = 0; i < nb_bucket_groups; ++i)
     {
-      secondary_hash_projection_[i].resize(nb_bits_per_bucket_,
-        nb_hash_code);
       for (int j = 0; j < nb_bits_per_bucket_; ++j)
       {
         for (int k = 0; k < nb_hash_code; ++k)
-          secondary_hash_projection_[i](j, k) = d(gen);
+          secondary_hash_projection_(i * nb_bits_per_bucket_ + j, k) = d(gen);
       }
     }
     return true;
@@ -191,55 +243,76 @@ public:
       return hashed_descriptions;
     }
 
+    const Eigen::Index nbDescriptions = descriptions.rows();
+    hashed_descriptions.nb_hash_code_blocks = (nb_hash_code_ + 63) / 64;
+    hashed_descriptions.nb_bucket_groups = nb_bucket_groups_;
+    hashed_descriptions.hash_codes.assign(
+      nbDescriptions * hashed_descriptions.nb_hash_code_blocks, 0);
+    hashed_descriptions.bucket_ids.resize(nbDescriptions * nb_bucket_groups_);
+
     // Create hash codes for each description.
+    // The projections are computed by batch of descriptions (matrix products).
     {
-      // Allocate space for hash codes.
-      const typename MatrixT::Index nbDescriptions = descriptions.rows();
-      hashed_descriptions.hashed_desc.resize(nbDescriptions);
-      Eigen::VectorXf descriptor(descriptions.cols());
-      for (int i = 0; i < nbDescriptions; ++i)
+      using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+      RowMatrixXf centered_descriptions, primary_projections, secondary_projections;
+      for (Eigen::Index first = 0; first < nbDescriptions; first += kHashingBatchSize)
       {
-        // Allocate space for each bucket id.
-        hashed_descriptions.hashed_desc[i].bucket_ids.resize(nb_bucket_groups_);
-
-        // Compute hash code.
-        auto& hash_code = hashed_descriptions.hashed_desc[i].hash_code;
-        hash_code = stl::dynamic_bitset(descriptions.cols());
-        descriptor = descriptions.row(i).template cast<float>();
-        descriptor -= zero_mean_descriptor;
-        const Eigen::VectorXf primary_projection = primary_hash_projection_ * descriptor;
-        for (int j = 0; j < nb_hash_code_; ++j)
+        const Eigen::Index nb = std::min<Eigen::Index>(kHashingBatchSize, nbDescriptions - first);
+        centered_descriptions = descriptions.middleRows(first, nb).template cast<float>();
+        centered_descriptions.rowwise() -= zero_mean_descriptor.transpose();
+        primary_projections.noalias() =
+          centered_descriptions * primary_hash_projection_.transpose();
+        secondary_projections.noalias() =
+          centered_descriptions * secondary_hash_projection_.transpose();
+
+        for (Eigen::Index i = 0; i < nb; ++i)
         {
-          hash_code[j] = primary_projection(j) > 0;
-        }
-
-        // Determine the bucket index for each group.
-        Eigen::VectorXf secondary_projection;
-        for (int j = 0; j < nb_bucket_groups_; ++j)
-        {
-          uint16_t bucket_id = 0;
-          secondary_projection = secondary_hash_projection_[j] * descriptor;
+          // Compute hash code.
+          uint64_t * hash_code = hashed_descriptions.hash_codes.data()
+            + (first + i) * hashed_descriptions.nb_hash_code_blocks;
+          for (int j = 0; j < nb_hash_code_; ++j)
+          {
+            if (primary_projections(i, j) > 0)
+              hash_code[j / 64] |= uint64_t(1) << (j % 64);
+          }
 
-          for (int k = 0; k < nb_bits_per_bucket_; ++k)
+          // Determine the bucket index for each group.
+          uint16_t * bucket_ids = hashed_descriptions.bucket_ids.data()
+            + (first + i) * nb_bucket_groups_;
+          for (int j = 0; j < nb_bucket_groups_; ++j)
           {
-            bucket_id = (bucket_id << 1) + (secondary_projection(k) > 0 ? 1 : 0);
+            uint16_t bucket_id = 0;
+            for (int k = 0; k < nb_bits_per_bucket_; ++k)
+            {
+              bucket_id = (bucket_id << 1) +
+                (secondary_projections(i, j * nb_bits_per_bucket_ + k) > 0 ? 1 : 0);
+            }
+            bucket_ids[j] = bucket_id;
           }
-          hashed_descriptions.hashed_desc[i].bucket_ids[j] = bucket_id;
         }
       }
     }
-    // Build the Buckets
+    // Build the Buckets (description ids sorted by bucket, in increasing order)
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
+      hashed_descriptions.bucket_offsets.resize(nb_bucket_groups_);
+      hashed_descriptions.bucket_descriptions.resize(nb_bucket_groups_);
       for (int i = 0; i < nb_bucket_groups_; ++i)
       {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+        std::vector<uint32_t> & offsets = hashed_descriptions.bucket_offsets[i];
+        offsets.assign(nb_buckets_per_group_ + 1, 0);
+        for (Eigen::Index j = 0; j < nbDescriptions; ++j)
+          ++offsets[hashed_descriptions.bucket_ids[j * nb_bucket_groups_ + i] + 1];
+        for (int j = 0; j < nb_buckets_per_group_; ++j)
+          offsets[j + 1] += offsets[j];
 
         // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+        std::vector<uint32_t> & bucket_descriptions = hashed_descriptions.bucket_descriptions[i];
+        bucket_descriptions.resize(nbDescriptions);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (Eigen::Index j = 0; j < nbDescriptions; ++j)
         {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
+          const uint16_t bucket_id = hashed_descriptions.bucket_ids[j * nb_bucket_groups_ + i];
+          bucket_descriptions[fill[bucket_id]++] = static_cast<uint32_t>(j);
         }
       }
     }
@@ -248,6 +321,7 @@ public:
 
   // Matches two collection of hashed descriptions with a fast matching scheme
   // based on the hash codes previously generated.
+  // The descriptions matrices must be stored in row major order.
   template <typename MatrixT, typename DistanceType>
   void Match_HashedDescriptions
   (
@@ -260,104 +334,163 @@ public:
     const int NN = 2
   ) const
   {
-    using MetricT = L2<typename MatrixT::Scalar>;
-    MetricT metric;
-
-    static const int kNumTopCandidates = 10;
-
-    // Preallocate the candidate descriptors container.
-    std::vector<int> candidate_descriptors;
-    candidate_descriptors.reserve(hashed_descriptions2.hashed_desc.size());
-
-    // Preallocated hamming distances. Each column indicates the hamming distance
-    // and the rows collect the descriptor ids with that
-    // distance. num_descriptors_with_hamming_distance keeps track of how many
-    // descriptors have that distance.
-    Eigen::MatrixXi candidate_hamming_distances(
-      hashed_descriptions2.hashed_desc.size(), nb_hash_code_ + 1);
-    Eigen::VectorXi num_descriptors_with_hamming_distance(nb_hash_code_ + 1);
+    switch (hashed_descriptions1.nb_hash_code_blocks)
+    {
+      case 1:
+        Match_HashedDescriptions_Impl<1>(
+          hashed_descriptions1, descriptions1, hashed_descriptions2, descriptions2,
+          pvec_indices, pvec_distances, NN);
+      break;
+      case 2:
+        Match_HashedDescriptions_Impl<2>(
+          hashed_descriptions1, descriptions1, hashed_descriptions2, descriptions2,
+          pvec_indices, pvec_distances, NN);
+      break;
+      default:
+        Match_HashedDescriptions_Impl<0>(
+          hashed_descriptions1, descriptions1, hashed_descriptions2, descriptions2,
+          pvec_indices, pvec_distances, NN);
+    }
+  }
 
-    // Preallocate the container for keeping euclidean distances.
-    std::vector<std::pair<DistanceType, int>> candidate_euclidean_distances;
-    candidate_euclidean_distances.reserve(kNumTopCandidates);
+  private:
 
-    // A preallocated vector to determine if we have already used a particular
-    // feature for matching (i.e., prevents duplicates).
-    std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
+  // Buffers used to match one collection of hashed descriptions.
+  // They are kept per thread and reused from a matching call to another.
+  struct MatchingWorkspace
+  {
+    // Candidates of the current query (each candidate is stored once)
+    std::vector<uint32_t> candidates;
+    // Hamming distance of each candidate to the query
+    std::vector<uint16_t> candidate_hamming_distances;
+    // Tell if a database description is already a candidate of the current query
+    std::vector<uint8_t> used_descriptor;
+    // Number of candidates with a given hamming distance
+    std::vector<int> num_descriptors_with_hamming_distance;
+  };
+
+  template <int NB_BLOCKS, typename MatrixT, typename DistanceType>
+  void Match_HashedDescriptions_Impl
+  (
+    const HashedDescriptions& hashed_descriptions1,
+    const MatrixT & descriptions1,
+    const HashedDescriptions& hashed_descriptions2,
+    const MatrixT & descriptions2,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    const int NN
+  ) const
+  {
+    using MetricT = L2<typename MatrixT::Scalar>;
+    MetricT metric;
 
-    using HammingMetricType = matching::Hamming<stl::dynamic_bitset::BlockType>;
-    static const HammingMetricType metricH = {};
-    for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
+    if (hashed_descriptions1.size() == 0 || hashed_descriptions2.size() == 0)
+      return;
+
+    static thread_local MatchingWorkspace workspace;
+    if (workspace.used_descriptor.size() < hashed_descriptions2.size())
+      workspace.used_descriptor.resize(hashed_descriptions2.size(), 0);
+    workspace.num_descriptors_with_hamming_distance.resize(nb_hash_code_ + 1);
+    std::vector<uint32_t> & candidate_descriptors = workspace.candidates;
+    std::vector<uint16_t> & candidate_hamming_distances = workspace.candidate_hamming_distances;
+    std::vector<uint8_t> & used_descriptor = workspace.used_descriptor;
+    std::vector<int> & num_descriptors_with_hamming_distance =
+      workspace.num_descriptors_with_hamming_distance;
+
+    // The euclidean distances of the best hamming distance candidates
+    std::array<std::pair<DistanceType, int>, kNumTopCandidates> candidate_euclidean_distances;
+
+    const int nb_blocks = hashed_descriptions1.nb_hash_code_blocks;
+    const Eigen::Index dimension = descriptions1.cols();
+    for (int i = 0; i < static_cast<int>(hashed_descriptions1.size()); ++i)
     {
       candidate_descriptors.clear();
-      num_descriptors_with_hamming_distance.setZero();
-      candidate_euclidean_distances.clear();
-
-      const auto& hashed_desc = hashed_descriptions1.hashed_desc[i];
+      const uint16_t * bucket_ids =
+        hashed_descriptions1.bucket_ids.data() + i * nb_bucket_groups_;
 
       // Accumulate all descriptors in each bucket group that are in the same
-      // bucket id as the query descriptor.
+      // bucket id as the query descriptor (avoid selecting the same candidate
+      // multiple times).
+      size_t nb_retrieved_descriptors = 0;
       for (int j = 0; j < nb_bucket_groups_; ++j)
       {
-        const uint16_t bucket_id = hashed_desc.bucket_ids[j];
-        for (const auto& feature_id : hashed_descriptions2.buckets[j][bucket_id])
+        const std::vector<uint32_t> & offsets = hashed_descriptions2.bucket_offsets[j];
+        const uint32_t * bucket = hashed_descriptions2.bucket_descriptions[j].data();
+        for (uint32_t k = offsets[bucket_ids[j]]; k < offsets[bucket_ids[j] + 1]; ++k)
         {
-          candidate_descriptors.emplace_back(feature_id);
-          used_descriptor[feature_id] = false;
+          const uint32_t feature_id = bucket[k];
+          if (!used_descriptor[feature_id])
+          {
+            used_descriptor[feature_id] = 1;
+            candidate_descriptors.push_back(feature_id);
+          }
         }
+        nb_retrieved_descriptors += offsets[bucket_ids[j] + 1] - offsets[bucket_ids[j]];
       }
+      for (const uint32_t candidate_id : candidate_descriptors)
+        used_descriptor[candidate_id] = 0;
 
       // Skip matching this descriptor if there are not at least NN candidates.
-      if (candidate_descriptors.size() <= NN)
+      if (nb_retrieved_descriptors <= static_cast<size_t>(NN))
       {
         continue;
       }
 
       // Compute the hamming distance of all candidates based on the comp hash
-      // code. Put the descriptors into buckets corresponding to their hamming
-      // distance.
-      for (const int candidate_id : candidate_descriptors)
+      // code and count the candidates per hamming distance.
+      std::fill(num_descriptors_with_hamming_distance.begin(),
+        num_descriptors_with_hamming_distance.end(), 0);
+      candidate_hamming_distances.resize(candidate_descriptors.size());
+      const uint64_t * hash_code = hashed_descriptions1.HashCode(i);
+      for (size_t k = 0; k < candidate_descriptors.size(); ++k)
       {
-        if (!used_descriptor[candidate_id]) // avoid selecting the same candidate multiple times
-        {
-          used_descriptor[candidate_id] = true;
-
-          const HammingMetricType::ResultType hamming_distance = metricH(
-            hashed_desc.hash_code.data(),
-            hashed_descriptions2.hashed_desc[candidate_id].hash_code.data(),
-            hashed_desc.hash_code.num_blocks());
-          candidate_hamming_distances(
-              num_descriptors_with_hamming_distance(hamming_distance)++,
-              hamming_distance) = candidate_id;
-        }
+        const int hamming_distance = HashCodeHammingDistance<NB_BLOCKS>(
+          hash_code,
+          hashed_descriptions2.HashCode(candidate_descriptors[k]),
+          nb_blocks);
+        candidate_hamming_distances[k] = static_cast<uint16_t>(hamming_distance);
+        ++num_descriptors_with_hamming_distance[hamming_distance];
       }
 
-      // Compute the euclidean distance of the k descriptors with the best hamming
-      // distance.
-      candidate_euclidean_distances.reserve(kNumTopCandidates);
-      for (int j = 0; j < candidate_hamming_distances.cols() &&
-        (candidate_euclidean_distances.size() < kNumTopCandidates); ++j)
+      // Select the kNumTopCandidates descriptors with the best hamming distance:
+      // - all the candidates with a distance lower than max_hamming_distance,
+      // - the first candidates with the max_hamming_distance.
+      int max_hamming_distance = 0;
+      int nb_selected = 0;
+      for (; max_hamming_distance < nb_hash_code_; ++max_hamming_distance)
       {
-        for (int k = 0; k < num_descriptors_with_hamming_distance(j) &&
-          (candidate_euclidean_distances.size() < kNumTopCandidates); ++k)
-        {
-          const int candidate_id = candidate_hamming_distances(k, j);
-          const DistanceType distance = metric(
-            descriptions2.row(candidate_id).data(),
-            descriptions1.row(i).data(),
-            descriptions1.cols());
+        if (nb_selected + num_descriptors_with_hamming_distance[max_hamming_distance]
+            >= kNumTopCandidates)
+          break;
+        nb_selected += num_descriptors_with_hamming_distance[max_hamming_distance];
+      }
+      int nb_selected_at_max_distance = kNumTopCandidates - nb_selected;
 
-          candidate_euclidean_distances.emplace_back(distance, candidate_id);
-        }
+      // Compute the euclidean distance of the k descriptors with the best hamming
+      // distance (the descriptors are read in place).
+      const typename MatrixT::Scalar * query = descriptions1.data() + i * dimension;
+      int nb_candidate_euclidean_distances = 0;
+      for (size_t k = 0; k < candidate_descriptors.size(); ++k)
+      {
+        const int hamming_distance = candidate_hamming_distances[k];
+        if (hamming_distance > max_hamming_distance ||
+            (hamming_distance == max_hamming_distance && nb_selected_at_max_distance-- <= 0))
+          continue;
+        const int candidate_id = candidate_descriptors[k];
+        const DistanceType distance = metric(
+          descriptions2.data() + candidate_id * dimension,
+          query,
+          dimension);
+        candidate_euclidean_distances[nb_candidate_euclidean_distances++] = {distance, candidate_id};
       }
 
       // Assert that each query is having at least NN retrieved neighbors
-      if (candidate_euclidean_distances.size() >= NN)
+      if (nb_candidate_euclidean_distances >= NN)
       {
         // Find the top NN candidates based on euclidean distance.
         std::partial_sort(candidate_euclidean_distances.begin(),
           candidate_euclidean_distances.begin() + NN,
-          candidate_euclidean_distances.end());
+          candidate_euclidean_distances.begin() + nb_candidate_euclidean_distances);
         // save resulting neighbors
         for (int l = 0; l < NN; ++l)
         {
@@ -369,12 +502,11 @@ public:
     }
   }
 
-  private:
   // Primary hashing function.
   Eigen::MatrixXf primary_hash_projection_;
 
-  // Secondary hashing function.
-  std::vector<Eigen::MatrixXf> secondary_hash_projection_;
+  // Secondary hashing function (the projections of the bucket groups are stacked).
+  Eigen::MatrixXf secondary_hash_projection_;
 };
 
 }  // namespace matching
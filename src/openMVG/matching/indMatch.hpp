@@ -9,8 +9,11 @@
 #ifndef OPENMVG_MATCHING_IND_MATCH_HPP
 #define OPENMVG_MATCHING_IND_MATCH_HPP
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <numeric>
 #include <set>
 #include <utility>
 #include <vector>
@@ -22,9 +25,21 @@ namespace matching {
 
 /// Structure in order to save pairwise indexed references.
 /// A sort operator exist in order to remove duplicates of IndMatch series.
+/// An optional quality score can be attached to the match
+///  (i.e. the nearest neighbor distance ratio, the lower the better).
+/// The score does not take part in the match comparison.
+/// Note: the score is stored in the match (12 bytes instead of 8) since it
+///  must follow the match through the deduplication, the sorting, the
+///  filtering and the file IO. A score array beside the matches would have to
+///  be permuted in lockstep at each of those steps.
 struct IndMatch
 {
-  IndMatch(const IndexT i = 0, const IndexT j = 0) : i_(i), j_(j)  {}
+  IndMatch
+  (
+    const IndexT i = 0,
+    const IndexT j = 0,
+    const float score = 0.f
+  ) : i_(i), j_(j), score_(score)  {}
 
   /// Remove duplicates ((i_, j_) that appears multiple times)
   static bool getDeduplicated(std::vector<IndMatch> & vec_match)  {
@@ -40,6 +55,7 @@ struct IndMatch
   void serialize( Archive & ar );
 
   IndexT i_, j_;  // Left, right index
+  float score_;   // Match quality score (0 if unknown)
 };
 
 inline bool operator==(const IndMatch& m1, const IndMatch& m2)  {
@@ -59,12 +75,58 @@ inline std::ostream& operator<<(std::ostream & out, const IndMatch & obj) {
   return out << obj.i_ << " " << obj.j_;
 }
 
+// Read a "i j [score]" line
 inline std::istream& operator>>(std::istream & in, IndMatch & obj) {
-  return in >> obj.i_ >> obj.j_;
+  obj.score_ = 0.f;
+  if (!(in >> obj.i_ >> obj.j_))
+    return in;
+  // Look for an optional score on the same line
+  while (in.peek() == ' ' || in.peek() == '\t' || in.peek() == '\r')
+    in.get();
+  if (in.peek() != '\n' && in.peek() != std::char_traits<char>::eof())
+    in >> obj.score_;
+  return in;
 }
 
 using IndMatches = std::vector<matching::IndMatch>;
 
+/**
+ * @brief Match quality score from a nearest neighbor distance ratio.
+ * An exact match (null distance ratio) is clamped to the smallest score
+ *  so that it is not confused with an unknown score.
+ */
+inline float DistanceRatioScore(const float distance_ratio)
+{
+  return std::max(distance_ratio, std::numeric_limits<float>::epsilon());
+}
+
+/**
+ * @brief Rank the matches by quality (increasing score: best matches first).
+ * Ties keep the match order.
+ *
+ * @param[in] matches The matches to rank
+ * @param[out] ranking The match indices sorted by quality
+ * @return false if the matches do not have a score
+ */
+inline bool RankByScore
+(
+  const IndMatches & matches,
+  std::vector<uint32_t> & ranking
+)
+{
+  ranking.clear();
+  if (std::none_of(matches.cbegin(), matches.cend(),
+    [](const IndMatch & match) { return match.score_ != 0.f; }))
+    return false;
+
+  ranking.resize(matches.size());
+  std::iota(ranking.begin(), ranking.end(), 0);
+  std::stable_sort(ranking.begin(), ranking.end(),
+    [&matches](const uint32_t a, const uint32_t b)
+    { return matches[a].score_ < matches[b].score_; });
+  return true;
+}
+
 /// Pairwise matches (indexed matches for a pair <I,J>)
 /// The interface used to store corresponding point indexes per images pairs
 class PairWiseMatchesContainer
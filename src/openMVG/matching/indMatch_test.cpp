@@ -12,6 +12,10 @@
 
 #include "testing/testing.h"
 
+#include <algorithm>
+#include <fstream>
+#include <string>
+
 using namespace openMVG;
 using namespace matching;
 
@@ -53,6 +57,93 @@ TEST(IndMatch, IO)
   EXPECT_EQ(3, matches.at({1,2}).size());
 }
 
+TEST(IndMatch, IO_Score)
+{
+  PairWiseMatches matches;
+  matches[{0,1}] = {{0,0,0.5f},{1,1,0.25f}};
+  matches[{1,2}] = {{0,0},{1,1}, {2,2}}; // matches without score
+
+  for (const std::string filename : {"matches.txt", "matches.bin"})
+  {
+    PairWiseMatches loaded_matches;
+    EXPECT_TRUE(Save(matches, filename, true));
+    EXPECT_TRUE(Load(loaded_matches, filename));
+    EXPECT_EQ(2, loaded_matches.size());
+    EXPECT_EQ(2, loaded_matches.at({0,1}).size());
+    EXPECT_EQ(3, loaded_matches.at({1,2}).size());
+    EXPECT_EQ(0.5f, loaded_matches.at({0,1})[0].score_);
+    EXPECT_EQ(0.25f, loaded_matches.at({0,1})[1].score_);
+    for (const auto & match : loaded_matches.at({1,2}))
+      EXPECT_EQ(0.f, match.score_);
+  }
+}
+
+// The scores are not saved by default: the files keep the historical format
+TEST(IndMatch, IO_NoScore)
+{
+  PairWiseMatches matches;
+  matches[{0,1}] = {{0,0,0.5f},{1,1,0.25f}};
+  matches[{1,2}] = {{0,0},{1,1}, {2,2}};
+
+  for (const std::string filename : {"matches.txt", "matches.bin"})
+  {
+    PairWiseMatches loaded_matches;
+    EXPECT_TRUE(Save(matches, filename));
+    EXPECT_TRUE(Load(loaded_matches, filename));
+    EXPECT_EQ(2, loaded_matches.size());
+    EXPECT_TRUE(matches.at({0,1}) == loaded_matches.at({0,1}));
+    EXPECT_TRUE(matches.at({1,2}) == loaded_matches.at({1,2}));
+    for (const auto & pair_matches : loaded_matches)
+      for (const auto & match : pair_matches.second)
+        EXPECT_EQ(0.f, match.score_);
+  }
+
+  // The text file keeps the "i j" lines
+  std::ifstream stream("matches.txt");
+  std::string line;
+  while (std::getline(stream, line))
+    EXPECT_TRUE(std::count(line.cbegin(), line.cend(), ' ') <= 1);
+}
+
+TEST(IndMatch, DistanceRatioScore)
+{
+  // An exact match keeps a known score...
+  EXPECT_TRUE(DistanceRatioScore(0.f) > 0.f);
+  EXPECT_EQ(0.5f, DistanceRatioScore(0.5f));
+
+  // ... it is ranked first and survives the match files
+  const IndMatches matches =
+    {{0,0,DistanceRatioScore(0.5f)},{1,1,DistanceRatioScore(0.f)}};
+  std::vector<uint32_t> ranking;
+  EXPECT_TRUE(RankByScore(matches, ranking));
+  EXPECT_EQ(1, ranking[0]);
+
+  for (const std::string filename : {"matches.txt", "matches.bin"})
+  {
+    PairWiseMatches saved_matches, loaded_matches;
+    saved_matches[{0,1}] = matches;
+    EXPECT_TRUE(Save(saved_matches, filename, true));
+    EXPECT_TRUE(Load(loaded_matches, filename));
+    EXPECT_EQ(2, loaded_matches.at({0,1}).size());
+    EXPECT_TRUE(loaded_matches.at({0,1})[1].score_ > 0.f);
+    EXPECT_TRUE(RankByScore(loaded_matches.at({0,1}), ranking));
+    EXPECT_EQ(1, ranking[0]);
+  }
+}
+
+TEST(IndMatch, RankByScore)
+{
+  std::vector<uint32_t> ranking;
+  // Matches without score cannot be ranked
+  EXPECT_FALSE(RankByScore({{0,0},{1,1}}, ranking));
+  EXPECT_TRUE(ranking.empty());
+
+  const IndMatches matches = {{0,0,0.8f},{1,1,0.2f},{2,2,0.5f},{3,3,0.2f}};
+  EXPECT_TRUE(RankByScore(matches, ranking));
+  // Best score first, ties keep the match order
+  EXPECT_TRUE((std::vector<uint32_t>{1,3,2,0}) == ranking);
+}
+
 TEST(IndMatch, DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch = {
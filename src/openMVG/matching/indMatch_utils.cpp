@@ -28,6 +28,21 @@
 namespace openMVG {
 namespace matching {
 
+// The binary match file stores the match indices (IndMatch::serialize).
+// If the scores are requested (and some matches have a score), the scores are
+//  appended after them (it keeps the file readable by the previous releases).
+using PairWiseScores = std::map<Pair, std::vector<float>>;
+
+static bool HasScores(const PairWiseMatches & matches)
+{
+  return std::any_of(matches.cbegin(), matches.cend(),
+    [](const PairWiseMatches::value_type & pair_matches)
+    {
+      return std::any_of(pair_matches.second.cbegin(), pair_matches.second.cend(),
+        [](const IndMatch & match) { return match.score_ != 0.f; });
+    });
+}
+
 bool Load
 (
   PairWiseMatches & matches,
@@ -66,6 +81,22 @@ bool Load
     {
       cereal::PortableBinaryInputArchive archive(stream);
       archive(matches);
+      // Read the optional match scores
+      if (stream.peek() != std::ifstream::traits_type::eof())
+      {
+        PairWiseScores scores;
+        archive(scores);
+        for (const auto & pair_scores : scores)
+        {
+          auto pair_matches = matches.find(pair_scores.first);
+          if (pair_matches == matches.end() ||
+              pair_matches->second.size() != pair_scores.second.size())
+            continue;
+          for (size_t i = 0; i < pair_scores.second.size(); ++i)
+            pair_matches->second[i].score_ = pair_scores.second[i];
+        }
+      }
+      stream.clear(); // the eof may have been reached by peek
       stream.close();
     }
   }
@@ -85,7 +116,8 @@ bool Load
 bool Save
 (
   const PairWiseMatches & matches,
-  const std::string & filename
+  const std::string & filename,
+  const bool b_save_scores
 )
 {
   const std::string ext = stlplus::extension_part(filename);
@@ -102,8 +134,16 @@ bool Save
 
         const std::vector<IndMatch> & pair_matches = cur_match.second;
         stream << I << " " << J << '\n' << pair_matches.size() << '\n';
-        copy(pair_matches.cbegin(), pair_matches.cend(),
-             std::ostream_iterator<IndMatch>(stream, "\n"));
+        if (b_save_scores)
+        {
+          for (const IndMatch & match : pair_matches)
+            stream << match << " " << match.score_ << '\n';
+        }
+        else
+        {
+          copy(pair_matches.cbegin(), pair_matches.cend(),
+               std::ostream_iterator<IndMatch>(stream, "\n"));
+        }
       }
       stream.close();
     }
@@ -115,6 +155,18 @@ bool Save
     {
       cereal::PortableBinaryOutputArchive archive(stream);
       archive(matches);
+      if (b_save_scores && HasScores(matches))
+      {
+        PairWiseScores scores;
+        for (const auto & pair_matches : matches)
+        {
+          std::vector<float> & pair_scores = scores[pair_matches.first];
+          pair_scores.reserve(pair_matches.second.size());
+          for (const IndMatch & match : pair_matches.second)
+            pair_scores.push_back(match.score_);
+        }
+        archive(scores);
+      }
       stream.close();
     }
   }
@@ -22,10 +22,20 @@ bool Load
   const std::string & filename
 );
 
+/**
+ * @brief Save some matches to a txt or a bin file
+ * @param matches The matches to save
+ * @param filename Output file name (.txt or .bin)
+ * @param b_save_scores Save the match scores too ("i j score" lines in the
+ *  txt files, a score section after the matches in the bin files).
+ *  Off by default to keep the usual "i j" format.
+ * @return true if the file has been written
+ */
 bool Save
 (
   const PairWiseMatches & matches,
-  const std::string & filename
+  const std::string & filename,
+  const bool b_save_scores = false
 );
 
 }  // namespace matching
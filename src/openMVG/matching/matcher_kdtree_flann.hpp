@@ -9,7 +9,9 @@
 #ifndef OPENMVG_MATCHING_MATCHER_KDTREE_FLANN_HPP
 #define OPENMVG_MATCHING_MATCHER_KDTREE_FLANN_HPP
 
+#include <fstream>
 #include <memory>
+#include <string>
 #include <vector>
 
 #ifdef OPENMVG_USE_OPENMP
@@ -74,6 +76,74 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
     return false;
   }
 
+  /**
+   * Save the FLANN index to a file.
+   * Note that the dataset is not saved along the index.
+   *
+   * \param[in] filename The file where the index will be saved.
+   *
+   * \return True if success.
+   */
+  bool SaveIndex
+  (
+    const std::string & filename
+  ) const override
+  {
+    if (index_.get() == nullptr)
+      return false;
+    try
+    {
+      index_->save(filename);
+    }
+    catch (const flann::FLANNException &)
+    {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Load a FLANN index saved with SaveIndex (avoid the index building).
+   *
+   * \param[in] dataset   Input data (the one used to build the saved index).
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the each
+   *  row of the dataset.
+   * \param[in] filename  The file where the index was saved.
+   *
+   * \return True if success.
+   */
+  bool LoadIndex
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension,
+    const std::string & filename
+  ) override
+  {
+    // FLANN returns an invalid index (no exception) if the file is not readable
+    if (nbRows <= 0 || !std::ifstream(filename.c_str()).good())
+      return false;
+    try
+    {
+      std::unique_ptr<flann::Matrix<Scalar>> datasetM(
+          new flann::Matrix<Scalar>((Scalar*)dataset, nbRows, dimension));
+      std::unique_ptr<flann::Index<Metric>> index(
+          new flann::Index<Metric> (*datasetM, flann::SavedIndexParams(filename)));
+      if (index->size() != static_cast<size_t>(nbRows) ||
+          index->veclen() != static_cast<size_t>(dimension))
+        return false;
+      dimension_ = dimension;
+      datasetM_ = std::move(datasetM);
+      index_ = std::move(index);
+    }
+    catch (const flann::FLANNException &)
+    {
+      return false;
+    }
+    return true;
+  }
+
   /**
    * Search the nearest Neighbor of the scalar array query.
    *
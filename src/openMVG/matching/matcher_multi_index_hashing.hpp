@@ -0,0 +1,389 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_MATCHER_MULTI_INDEX_HASHING_HPP
+#define OPENMVG_MATCHING_MATCHER_MULTI_INDEX_HASHING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "openMVG/matching/matching_interface.hpp"
+#include "openMVG/matching/metric.hpp"
+
+//------------------
+//-- Bibliography --
+//------------------
+//- [1] "Fast Search in Hamming Space with Multi-Index Hashing"
+//- Authors: Mohammad Norouzi, Ali Punjani, David J. Fleet.
+//- Date: 2012.
+//- Conference: CVPR.
+//
+// Exact K nearest neighbor search of binary codes under the Hamming distance.
+// The B bits codes are split in m disjoint substrings, each one indexed in its
+//  own hash table. If two codes are at Hamming distance < m * s, at least one
+//  of their substrings are at distance < s (pigeonhole principle).
+// The search probes the tables with increasing radius s and verifies the
+//  candidates with a popcount Hamming distance. It stops as soon as the K-th
+//  best distance is < m * s: the result is then the same as a linear scan.
+
+namespace openMVG {
+namespace matching {
+
+// Implement ArrayMatcher as a Multi-Index Hashing matcher (for binary descriptors).
+// The template Metric parameter is ignored (Hamming distance is always used).
+template < typename Scalar = unsigned char, typename Metric = Hamming<unsigned char>>
+class ArrayMatcherMultiIndexHashing : public ArrayMatcher<Scalar, Metric>
+{
+  public:
+  using DistanceType = typename Metric::ResultType;
+
+  ArrayMatcherMultiIndexHashing() = default;
+  virtual ~ArrayMatcherMultiIndexHashing()= default;
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension
+  ) override
+  {
+    nb_codes_ = 0;
+    if (nbRows < 1 || dimension < 1)
+      return false;
+
+    // Copy the codes to 64 bit blocks (zero padded)
+    dimension_ = dimension;
+    nb_bytes_ = dimension * sizeof(Scalar);
+    nb_blocks_ = (nb_bytes_ + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    nb_codes_ = nbRows;
+    codes_.assign(nb_codes_ * nb_blocks_, 0);
+    for (int i = 0; i < nbRows; ++i)
+    {
+      std::memcpy(&codes_[i * nb_blocks_], dataset + i * dimension, nb_bytes_);
+    }
+
+    // Substring length: log2(N) bits gives ~1 code per bucket [1]
+    const int nb_bits = static_cast<int>(nb_bytes_ * 8);
+    const int substring_target_length = std::max(kMinSubstringLength, std::min(kMaxSubstringLength,
+      static_cast<int>(std::lround(std::log2(static_cast<double>(nbRows))))));
+    const int nb_substrings = (nb_bits + substring_target_length - 1) / substring_target_length;
+
+    // Balanced split of the bits in nb_substrings substrings
+    substring_first_bit_.resize(nb_substrings);
+    substring_length_.resize(nb_substrings);
+    int first_bit = 0;
+    for (int i = 0; i < nb_substrings; ++i)
+    {
+      substring_first_bit_[i] = first_bit;
+      substring_length_[i] = nb_bits / nb_substrings + (i < nb_bits % nb_substrings ? 1 : 0);
+      first_bit += substring_length_[i];
+    }
+
+    // Build a bucket table per substring: the code ids are stored sorted per key
+    bucket_offsets_.resize(nb_substrings);
+    bucket_ids_.resize(nb_substrings);
+    std::vector<uint32_t> keys(nb_codes_);
+    for (int i = 0; i < nb_substrings; ++i)
+    {
+      std::vector<uint32_t> & offsets = bucket_offsets_[i];
+      std::vector<uint32_t> & ids = bucket_ids_[i];
+      offsets.assign((size_t(1) << substring_length_[i]) + 1, 0);
+      for (size_t j = 0; j < nb_codes_; ++j)
+      {
+        keys[j] = Substring(&codes_[j * nb_blocks_], i);
+        ++offsets[keys[j] + 1];
+      }
+      for (size_t k = 1; k < offsets.size(); ++k)
+        offsets[k] += offsets[k - 1];
+      ids.resize(nb_codes_);
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for (size_t j = 0; j < nb_codes_; ++j)
+        ids[fill[keys[j]]++] = static_cast<uint32_t>(j);
+    }
+
+    // Number of table probes of each search radius
+    nb_probes_at_radius_.assign(substring_target_length + 1, 0.);
+    for (int radius = 0; radius <= substring_target_length; ++radius)
+      for (int i = 0; i < nb_substrings; ++i)
+        nb_probes_at_radius_[radius] += NbKeysAtRadius(substring_length_[i], radius);
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array.
+   * \param[out]  indice    The indice of array in the dataset that.
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour
+  (
+    const Scalar * query,
+    int * indice,
+    DistanceType * distance
+  ) override
+  {
+    IndMatches vec_index;
+    std::vector<DistanceType> vec_distance;
+    if (!SearchNeighbours(query, 1, &vec_index, &vec_distance, 1))
+      return false;
+    indice[0] = vec_index[0].j_;
+    distance[0] = vec_distance[0];
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array.
+   * \param[in]   nbQuery   The number of query rows.
+   * \param[out]  indices   The corresponding (query, neighbor) indices.
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[in]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  ) override
+  {
+    if (nb_codes_ == 0 ||
+        NN > nb_codes_ ||
+        nbQuery < 1)
+    {
+      return false;
+    }
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    // Each query uses its own (thread local) workspace
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int query_index = 0; query_index < nbQuery; ++query_index)
+    {
+      SearchNeighbours_func(query + query_index * dimension_, query_index, NN,
+        pvec_indices->data() + query_index * NN,
+        pvec_distances->data() + query_index * NN);
+    }
+    return true;
+  };
+
+private:
+  // Substring length bounds (the tables have 2^length buckets)
+  static const int kMinSubstringLength = 4;
+  static const int kMaxSubstringLength = 16;
+
+  // Reusable per thread search buffers
+  struct SearchWorkspace
+  {
+    std::vector<uint64_t> query_code;
+    std::vector<uint32_t> query_substrings;
+    std::vector<std::pair<DistanceType, uint32_t>> best; // sorted (distance, id)
+    std::vector<uint32_t> visit_stamps; // verified codes are marked with the query stamp
+    uint32_t stamp = 0;
+  };
+
+  // Extract the i-th substring of a code
+  uint32_t Substring(const uint64_t * code, const int i) const
+  {
+    const int first_bit = substring_first_bit_[i];
+    const int length = substring_length_[i];
+    const int block = first_bit / 64;
+    const int shift = first_bit % 64;
+    uint64_t value = code[block] >> shift;
+    if (shift + length > 64)
+      value |= code[block + 1] << (64 - shift);
+    return static_cast<uint32_t>(value & ((uint64_t(1) << length) - 1));
+  }
+
+  // Number of keys at Hamming distance radius of a length bits key
+  static double NbKeysAtRadius(const int length, const int radius)
+  {
+    if (radius > length)
+      return 0.;
+    double count = 1.;
+    for (int i = 0; i < radius; ++i)
+      count = count * (length - i) / (i + 1);
+    return count;
+  }
+
+  // Insert a candidate in the sorted NN best list and return the distance
+  //  that a new candidate must not exceed to enter the list
+  static DistanceType InsertCandidate
+  (
+    const DistanceType distance,
+    const uint32_t id,
+    const size_t NN,
+    std::vector<std::pair<DistanceType, uint32_t>> & best
+  )
+  {
+    const std::pair<DistanceType, uint32_t> candidate(distance, id);
+    if (best.size() == NN)
+    {
+      if (!(candidate < best.back()))
+        return best.back().first;
+      best.pop_back();
+    }
+    best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+    return (best.size() == NN) ? best.back().first : std::numeric_limits<DistanceType>::max();
+  }
+
+  void SearchNeighbours_func
+  (
+    const Scalar * query,
+    const int query_index,
+    const size_t NN,
+    IndMatch * indices,
+    DistanceType * distances
+  ) const
+  {
+    static thread_local SearchWorkspace workspace;
+    workspace.query_code.assign(nb_blocks_, 0);
+    std::memcpy(workspace.query_code.data(), query, nb_bytes_);
+    const uint64_t * query_code = workspace.query_code.data();
+
+    const int nb_substrings = static_cast<int>(substring_length_.size());
+    workspace.query_substrings.resize(nb_substrings);
+    for (int i = 0; i < nb_substrings; ++i)
+      workspace.query_substrings[i] = Substring(query_code, i);
+
+    if (workspace.visit_stamps.size() < nb_codes_ || workspace.stamp == std::numeric_limits<uint32_t>::max())
+    {
+      workspace.visit_stamps.assign(std::max(workspace.visit_stamps.size(), nb_codes_), 0);
+      workspace.stamp = 0;
+    }
+    const uint32_t stamp = ++workspace.stamp;
+    uint32_t * visit_stamps = workspace.visit_stamps.data();
+    std::vector<std::pair<DistanceType, uint32_t>> & best = workspace.best;
+    best.clear();
+    // Distance of the NN-th best candidate (a code farther than it is rejected)
+    DistanceType worst_distance = std::numeric_limits<DistanceType>::max();
+    size_t nb_verified = 0;
+
+    // Compute the distance to a code and keep it if it is one of the NN best
+    const auto verify = [&](const uint32_t id)
+    {
+      if (visit_stamps[id] == stamp)
+        return;
+      visit_stamps[id] = stamp;
+      ++nb_verified;
+      const DistanceType distance =
+        HammingDistance64(query_code, &codes_[id * nb_blocks_], nb_blocks_);
+      if (distance <= worst_distance)
+        worst_distance = InsertCandidate(distance, id, NN, best);
+    };
+
+    const int max_radius = static_cast<int>(nb_probes_at_radius_.size()) - 1;
+    for (int radius = 0; ; ++radius)
+    {
+      // All the codes at distance < nb_substrings * radius have been verified
+      if (best.size() == NN && worst_distance < static_cast<DistanceType>(nb_substrings * radius))
+        break;
+      if (nb_verified == nb_codes_)
+        break;
+
+      // Radius at which the search would stop with the current NN-th distance
+      //  (only the current radius is known to be searched if there is no NN-th code yet).
+      // If probing the tables up to this radius costs more than a linear scan
+      //  (a bucket holds ~1 code), scan all the codes (from scratch, so the
+      //  loop does not need the visit marks).
+      const int stop_radius = (best.size() == NN)
+        ? static_cast<int>(worst_distance / nb_substrings) + 1
+        : radius + 1;
+      double nb_probes = (stop_radius > max_radius + 1) ? static_cast<double>(nb_codes_) : 0.;
+      for (int r = radius; r < std::min(stop_radius, max_radius + 1); ++r)
+        nb_probes += nb_probes_at_radius_[r];
+      if (radius > max_radius || nb_probes > nb_codes_ - nb_verified)
+      {
+        best.clear();
+        worst_distance = std::numeric_limits<DistanceType>::max();
+        for (size_t id = 0; id < nb_codes_; ++id)
+        {
+          const DistanceType distance =
+            HammingDistance64(query_code, &codes_[id * nb_blocks_], nb_blocks_);
+          if (distance <= worst_distance)
+            worst_distance = InsertCandidate(distance, static_cast<uint32_t>(id), NN, best);
+        }
+        break;
+      }
+
+      // Probe the buckets at Hamming distance radius of the query substrings
+      // (the bit masks with radius bits set are enumerated with Gosper's hack)
+      for (int i = 0; i < nb_substrings; ++i)
+      {
+        const int length = substring_length_[i];
+        if (radius > length)
+          continue;
+        const uint32_t * offsets = bucket_offsets_[i].data();
+        const uint32_t * ids = bucket_ids_[i].data();
+        const uint32_t key_limit = uint32_t(1) << length;
+        uint32_t mask = (uint32_t(1) << radius) - 1;
+        while (mask < key_limit)
+        {
+          const uint32_t key = workspace.query_substrings[i] ^ mask;
+          for (uint32_t k = offsets[key]; k < offsets[key + 1]; ++k)
+            verify(ids[k]);
+          if (mask == 0)
+            break;
+          const uint32_t lowest_bit = mask & (~mask + 1);
+          const uint32_t ripple = mask + lowest_bit;
+          mask = (((ripple ^ mask) >> 2) / lowest_bit) | ripple;
+        }
+      }
+    }
+
+    for (size_t k = 0; k < NN; ++k)
+    {
+      distances[k] = best[k].first;
+      indices[k] = IndMatch(query_index, best[k].second);
+    }
+  }
+
+  int dimension_ = 0;
+  size_t nb_bytes_ = 0;
+  size_t nb_blocks_ = 0;
+  size_t nb_codes_ = 0;
+  // Codes stored as zero padded 64 bit blocks
+  std::vector<uint64_t> codes_;
+  // Substrings definition (first bit, bit count)
+  std::vector<int> substring_first_bit_;
+  std::vector<int> substring_length_;
+  std::vector<double> nb_probes_at_radius_;
+  // Per substring table: the ids of the codes of key k are
+  //  bucket_ids_[i][bucket_offsets_[i][k] .. bucket_offsets_[i][k+1]]
+  std::vector<std::vector<uint32_t>> bucket_offsets_;
+  std::vector<std::vector<uint32_t>> bucket_ids_;
+};
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_MATCHER_MULTI_INDEX_HASHING_HPP
@@ -20,7 +20,8 @@ enum EMatcherType : unsigned char
   HNSW_L2,
   HNSW_L1,
   BRUTE_FORCE_HAMMING,
-  HNSW_HAMMING
+  HNSW_HAMMING,
+  MULTI_INDEX_HASHING_HAMMING
 };
 
 } // namespace matching
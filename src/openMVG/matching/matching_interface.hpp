@@ -9,6 +9,7 @@
 #ifndef OPENMVG_MATCHING_MATCHING_INTERFACE_HPP
 #define OPENMVG_MATCHING_MATCHING_INTERFACE_HPP
 
+#include <string>
 #include <vector>
 
 #include "openMVG/matching/indMatch.hpp"
@@ -68,6 +69,41 @@ class ArrayMatcher
                                   IndMatches * indices,
                                   std::vector<DistanceType> * distances,
                                   size_t NN)=0;
+
+  /**
+   * Save the matching structure to a file (if supported by the matcher).
+   *
+   * \param[in] filename The file where the matching structure will be saved.
+   *
+   * \return True if success.
+   */
+  virtual bool SaveIndex(const std::string & /*filename*/) const
+  {
+    return false;
+  }
+
+  /**
+   * Load a matching structure previously saved with SaveIndex
+   *  (if supported by the matcher).
+   * The dataset must be the one that was used to build the saved structure.
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   * \param[in] filename  The file where the matching structure was saved.
+   *
+   * \return True if success.
+   */
+  virtual bool LoadIndex
+  (
+    const Scalar * /*dataset*/,
+    int /*nbRows*/,
+    int /*dimension*/,
+    const std::string & /*filename*/
+  )
+  {
+    return false;
+  }
 };
 
 }  // namespace matching
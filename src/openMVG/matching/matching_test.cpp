@@ -12,6 +12,9 @@
 #include "openMVG/matching/matcher_cascade_hashing.hpp"
 #include "openMVG/matching/matcher_kdtree_flann.hpp"
 #include "openMVG/matching/matcher_hnsw.hpp"
+#include "openMVG/matching/matcher_multi_index_hashing.hpp"
+#include "openMVG/matching/regions_matcher.hpp"
+#include "openMVG/features/regions_factory.hpp"
 
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
@@ -19,6 +22,7 @@
 #include "testing/testing.h"
 
 #include <iostream>
+#include <random>
 using namespace std;
 
 using namespace openMVG;
@@ -119,6 +123,66 @@ TEST(Matching, ArrayMatcher_Kdtree_Flann_Simple__NN)
   EXPECT_EQ(IndMatch(0,4), vec_nIndice[4]);
 }
 
+TEST(Matching, ArrayMatcher_Kdtree_Flann_SaveLoadIndex)
+{
+  const float array[] = {0, 1, 2, 5, 6};
+
+  ArrayMatcher_Kdtree_Flann<float> matcher;
+  EXPECT_FALSE( matcher.SaveIndex("kdtree_flann_index.bin") );
+  EXPECT_TRUE( matcher.Build(array, 5, 1) );
+  EXPECT_TRUE( matcher.SaveIndex("kdtree_flann_index.bin") );
+
+  ArrayMatcher_Kdtree_Flann<float> loaded_matcher;
+  EXPECT_FALSE( loaded_matcher.LoadIndex(array, 5, 1, "kdtree_flann_not_existing.bin") );
+  // The index must be related to a dataset of the same size
+  EXPECT_FALSE( loaded_matcher.LoadIndex(array, 4, 1, "kdtree_flann_index.bin") );
+  EXPECT_TRUE( loaded_matcher.LoadIndex(array, 5, 1, "kdtree_flann_index.bin") );
+
+  const float query[] = {4.8f};
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  EXPECT_TRUE( loaded_matcher.SearchNeighbour(query, &nIndice, &fDistance) );
+  EXPECT_EQ( 3, nIndice);
+  EXPECT_NEAR( Square(5.0f-4.8f), fDistance, 1e-6);
+}
+
+TEST(Matching, RegionsMatcher_Kdtree_Flann_SubsetDistanceRatio)
+{
+  // Random database descriptors, queried with copies of themselves
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  const int count = 200;
+  features::SIFT_Regions database;
+  for (int i = 0; i < count; ++i)
+  {
+    database.Features().emplace_back(i, i);
+    features::SIFT_Regions::DescriptorT descriptor;
+    for (int k = 0; k < descriptor.size(); ++k)
+      descriptor[k] = static_cast<unsigned char>(distribution(random_generator));
+    database.Descriptors().push_back(descriptor);
+  }
+
+  RegionsMatcherT<ArrayMatcher_Kdtree_Flann<unsigned char>> matcher(database, true);
+
+  // Only the even database descriptors can be matched
+  std::vector<bool> subset(count);
+  for (int i = 0; i < count; ++i)
+    subset[i] = (i % 2 == 0);
+
+  IndMatches matches;
+  EXPECT_TRUE(matcher.MatchDistanceRatio(0.8f, database, subset, 16, matches));
+  // The even queries find their copy, the odd ones do not pass the ratio test
+  EXPECT_EQ(count / 2, matches.size());
+  for (const auto & match : matches)
+  {
+    EXPECT_EQ(match.i_, match.j_);
+    EXPECT_EQ(0, match.i_ % 2);
+  }
+
+  // The subset must be defined for each database descriptor
+  EXPECT_FALSE(matcher.MatchDistanceRatio(0.8f, database, std::vector<bool>(count - 1, true), 16, matches));
+}
+
 TEST(Matching, ArrayMatcher_Hnsw_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -151,6 +215,118 @@ TEST(Matching, ArrayMatcher_Hnsw_Simple__NN)
   EXPECT_EQ(IndMatch(0,4), vec_nIndice[4]);
 }
 
+TEST(Matching, ArrayMatcher_Cascade_Hashing_NN)
+{
+  // SIFT like descriptors and a noisy copy of them as queries
+  const int nb_descriptors = 1000, dimension = 128;
+  using BaseMat = Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  BaseMat dataset(nb_descriptors, dimension), queries(nb_descriptors, dimension);
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> descriptor_value(0, 255);
+  std::uniform_int_distribution<int> noise(-4, 4);
+  for (int i = 0; i < nb_descriptors; ++i)
+  {
+    for (int j = 0; j < dimension; ++j)
+    {
+      dataset(i, j) = descriptor_value(random_generator);
+      queries(i, j) = std::max(0, std::min(255, dataset(i, j) + noise(random_generator)));
+    }
+  }
+
+  ArrayMatcherCascadeHashing<unsigned char> matcher;
+  EXPECT_TRUE( matcher.Build(dataset.data(), nb_descriptors, dimension) );
+
+  IndMatches vec_nIndice;
+  vector<int> vec_Distance;
+  const int NN = 2;
+  EXPECT_TRUE( matcher.SearchNeighbours(queries.data(), nb_descriptors, &vec_nIndice, &vec_Distance, NN) );
+  EXPECT_EQ(vec_nIndice.size(), vec_Distance.size());
+
+  // The distances are sorted and the nearest neighbor is the original descriptor
+  //  (if the query was hashed near to it)
+  const L2<unsigned char> metric;
+  int nb_found = 0;
+  for (size_t k = 0; k < vec_nIndice.size(); k += NN)
+  {
+    const IndMatch & nearest = vec_nIndice[k];
+    EXPECT_TRUE( vec_Distance[k] <= vec_Distance[k + 1] );
+    EXPECT_EQ( metric(dataset.row(nearest.j_).data(), queries.row(nearest.i_).data(), dimension),
+      vec_Distance[k] );
+    nb_found += (nearest.i_ == nearest.j_);
+  }
+  EXPECT_TRUE( nb_found > 0.95 * nb_descriptors );
+}
+
+TEST(Matching, ArrayMatcher_Multi_Index_Hashing_NN)
+{
+  // Random binary codes (with a size that is not a multiple of 8 bytes)
+  //  and queries that are near duplicates of some codes.
+  // The exact search must give the brute force distances.
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> byte_value(0, 255);
+  for (const int dimension : {32, 61})
+  {
+    const int nb_descriptors = 2000, nb_queries = 300;
+    using BaseMat = Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    BaseMat dataset(nb_descriptors, dimension), queries(nb_queries, dimension);
+    for (int i = 0; i < nb_descriptors; ++i)
+      for (int j = 0; j < dimension; ++j)
+        dataset(i, j) = byte_value(random_generator);
+    std::uniform_int_distribution<int> bit_index(0, dimension * 8 - 1);
+    for (int i = 0; i < nb_queries; ++i)
+    {
+      if (i % 2 == 0)
+      {
+        // Flip up to 40 bits of a dataset code
+        queries.row(i) = dataset.row(i * 3);
+        for (int k = 0; k < (i / 2) % 41; ++k)
+        {
+          const int bit = bit_index(random_generator);
+          queries(i, bit / 8) ^= (1 << (bit % 8));
+        }
+      }
+      else
+      {
+        for (int j = 0; j < dimension; ++j)
+          queries(i, j) = byte_value(random_generator);
+      }
+    }
+
+    using MetricT = Hamming<unsigned char>;
+    ArrayMatcherMultiIndexHashing<unsigned char, MetricT> matcher;
+    ArrayMatcherBruteForce<unsigned char, MetricT> matcher_reference;
+    EXPECT_TRUE( matcher.Build(dataset.data(), nb_descriptors, dimension) );
+    EXPECT_TRUE( matcher_reference.Build(dataset.data(), nb_descriptors, dimension) );
+
+    const int NN = 3;
+    IndMatches vec_nIndice, vec_nIndice_reference;
+    vector<MetricT::ResultType> vec_Distance, vec_Distance_reference;
+    EXPECT_TRUE( matcher.SearchNeighbours(queries.data(), nb_queries, &vec_nIndice, &vec_Distance, NN) );
+    EXPECT_TRUE( matcher_reference.SearchNeighbours(queries.data(), nb_queries,
+      &vec_nIndice_reference, &vec_Distance_reference, NN) );
+    CHECK_EQUAL(nb_queries * NN, vec_nIndice.size());
+    CHECK_EQUAL(nb_queries * NN, vec_Distance.size());
+
+    const MetricT metric;
+    for (size_t k = 0; k < vec_nIndice.size(); ++k)
+    {
+      EXPECT_EQ( vec_Distance_reference[k], vec_Distance[k] );
+      EXPECT_EQ( k / NN, vec_nIndice[k].i_ );
+      EXPECT_EQ( metric(dataset.row(vec_nIndice[k].j_).data(), queries.row(vec_nIndice[k].i_).data(), dimension),
+        vec_Distance[k] );
+    }
+    // The near duplicates are found
+    for (int i = 0; i < nb_queries; i += 2)
+      EXPECT_EQ( i * 3, vec_nIndice[i * NN].j_ );
+
+    int nIndice = -1;
+    MetricT::ResultType distance = 0;
+    EXPECT_TRUE( matcher.SearchNeighbour(dataset.row(10).data(), &nIndice, &distance) );
+    EXPECT_EQ( 10, nIndice );
+    EXPECT_EQ( 0, distance );
+  }
+}
+
 //-- Test LIMIT case (empty arrays)
 
 TEST(Matching, ArrayMatcherBruteForce_Simple_EmptyArrays)
@@ -183,6 +359,16 @@ TEST(Matching, Cascade_Hashing_Simple_EmptyArrays)
   EXPECT_FALSE( matcher.SearchNeighbour(nullptr, &nIndice, &fDistance) );
 }
 
+TEST(Matching, Multi_Index_Hashing_Simple_EmptyArrays)
+{
+  ArrayMatcherMultiIndexHashing<unsigned char> matcher;
+  EXPECT_FALSE( matcher.Build(nullptr, 0, 32) );
+
+  int nIndice = -1;
+  unsigned int distance = 0;
+  EXPECT_FALSE( matcher.SearchNeighbour(nullptr, &nIndice, &distance) );
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
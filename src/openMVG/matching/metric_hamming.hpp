@@ -10,6 +10,7 @@
 #define OPENMVG_MATCHING_METRIC_HAMMING_HPP
 
 #include "openMVG/matching/metric.hpp"
+#include "openMVG/matching/metric_simd.hpp"
 
 #include <bitset>
 #include <cstdint>
@@ -114,6 +115,41 @@ struct Hamming
   }
 };
 
+/// Count the bits set in a 64 bit block (use the POPCNT instruction if available)
+inline int PopCount64(const uint64_t block)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(block);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_WIN64))
+  return static_cast<int>(_mm_popcnt_u64(block));
+#else
+  return static_cast<int>(std::bitset<64>(block).count());
+#endif
+}
+
+/// Hamming distance between two arrays of 64 bit blocks
+inline unsigned int HammingDistance64
+(
+  const uint64_t * a,
+  const uint64_t * b,
+  size_t nb_blocks
+)
+{
+#ifdef OPENMVG_USE_AVX2
+  if (nb_blocks % 4 == 0)
+  {
+    return Hamming_AVX2(
+      reinterpret_cast<const uint8_t*>(a),
+      reinterpret_cast<const uint8_t*>(b),
+      nb_blocks * sizeof(uint64_t));
+  }
+#endif
+  unsigned int distance = 0;
+  for (size_t i = 0; i < nb_blocks; ++i)
+    distance += PopCount64(a[i] ^ b[i]);
+  return distance;
+}
+
 }  // namespace matching
 }  // namespace openMVG
 
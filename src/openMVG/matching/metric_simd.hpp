@@ -65,6 +65,38 @@ inline int L2_AVX2
   __m128i r = _mm_hadd_epi32(_mm_add_epi32(h, l), _mm_setzero_si128());
   return _mm_extract_epi32(r, 0) + _mm_extract_epi32(r, 1);
 }
+
+// Hamming distance of two binary arrays (size must be a multiple of 32 bytes)
+// Bits are counted with a 4 bit lookup table (pshufb) and summed with psadbw.
+inline unsigned int Hamming_AVX2
+(
+  const uint8_t * a,
+  const uint8_t * b,
+  size_t size
+)
+{
+  const __m256i lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  // Accumulator
+  __m256i acc (_mm256_setzero_si256());
+  for (size_t i = 0; i < size; i += 32)
+  {
+    const __m256i v = _mm256_xor_si256(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i count = _mm256_add_epi8(
+      _mm256_shuffle_epi8(lookup, lo),
+      _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+  }
+  uint64_t ALIGNED32 acc_count[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(acc_count), acc);
+  return static_cast<unsigned int>(acc_count[0] + acc_count[1] + acc_count[2] + acc_count[3]);
+}
 #endif // OPENMVG_USE_AVX2
 
 #ifdef OPENMVG_USE_AVX
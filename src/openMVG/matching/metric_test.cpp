@@ -162,6 +162,18 @@ TEST(Metric, L2DIM128)
   }
 }
 
+TEST(Metric, L2_FLOAT_ANY_DIM)
+{
+  // The SIMD code paths must handle descriptor length that are not a multiple of the register size
+  const L2<float> metricL2{};
+  for (int dimension = 1; dimension <= 40; ++dimension)
+  {
+    const Eigen::VectorXf a = Eigen::VectorXf::Random(dimension);
+    const Eigen::VectorXf b = Eigen::VectorXf::Random(dimension);
+    EXPECT_NEAR((a-b).squaredNorm(), metricL2(a.data(), b.data(), dimension), 1e-4);
+  }
+}
+
 TEST(Metric, L1DIM128) {
     using VecUC128 = Eigen::Matrix<uint8_t, 128, 1>;
     const VecUC128 a = VecUC128::Random();
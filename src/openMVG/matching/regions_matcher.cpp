@@ -11,6 +11,7 @@
 #include "openMVG/matching/matcher_cascade_hashing.hpp"
 #include "openMVG/matching/matcher_kdtree_flann.hpp"
 #include "openMVG/matching/matcher_hnsw.hpp"
+#include "openMVG/matching/matcher_multi_index_hashing.hpp"
 #include "openMVG/matching/metric.hpp"
 #include "openMVG/matching/metric_hamming.hpp"
 #include "openMVG/system/logger.hpp"
@@ -54,13 +55,18 @@ void DistanceRatioMatch
 std::unique_ptr<RegionsMatcher> RegionMatcherFactory
 (
   matching::EMatcherType eMatcherType,
-  const features::Regions & regions
+  const features::Regions & regions,
+  const std::string & index_filename
 )
 {
   // Handle invalid request
-  if (regions.IsScalar() && (eMatcherType == BRUTE_FORCE_HAMMING && eMatcherType == HNSW_HAMMING) )
+  const bool is_hamming_matcher =
+    eMatcherType == BRUTE_FORCE_HAMMING ||
+    eMatcherType == HNSW_HAMMING ||
+    eMatcherType == MULTI_INDEX_HASHING_HAMMING;
+  if (regions.IsScalar() && is_hamming_matcher)
     return {};
-  if (regions.IsBinary() && (eMatcherType != BRUTE_FORCE_HAMMING && eMatcherType != HNSW_HAMMING) )
+  if (regions.IsBinary() && !is_hamming_matcher)
     return {};
 
   std::unique_ptr<RegionsMatcher> region_matcher;
@@ -76,35 +82,35 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
         {
           using MetricT = L2<unsigned char>;
           using MatcherT = ArrayMatcherBruteForce<unsigned char, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case ANN_L2:
         {
           using MetricT = flann::L2<unsigned char>;
           using MatcherT = ArrayMatcher_Kdtree_Flann<unsigned char, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case HNSW_L2: 
         {
           using MetricT = L2<unsigned char>;
           using MatcherT = HNSWMatcher<unsigned char, MetricT, HNSWMETRIC::L2_HNSW>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case HNSW_L1: 
         {
           using MetricT = L1<unsigned char>;
           using MatcherT = HNSWMatcher<unsigned char, MetricT, HNSWMETRIC::L1_HNSW>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false, index_filename));
         }
         break;
         case CASCADE_HASHING_L2:
         {
           using MetricT = L2<unsigned char>;
           using MatcherT = ArrayMatcherCascadeHashing<unsigned char, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         default:
@@ -120,28 +126,28 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
         {
           using MetricT = L2<float>;
           using MatcherT = ArrayMatcherBruteForce<float, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case ANN_L2:
         {
           using MetricT = flann::L2<float>;
           using MatcherT = ArrayMatcher_Kdtree_Flann<float, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case HNSW_L2: 
         {
           using MetricT = L2<float>;
           using MatcherT = HNSWMatcher<float, MetricT, HNSWMETRIC::L2_HNSW>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case CASCADE_HASHING_L2:
         {
           using MetricT = L2<float>;
           using MatcherT = ArrayMatcherCascadeHashing<float, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         default:
@@ -157,14 +163,14 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
         {
           using MetricT = L2<double>;
           using MatcherT = ArrayMatcherBruteForce<double, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case ANN_L2:
         {
           using MetricT = flann::L2<double>;
           using MatcherT = ArrayMatcher_Kdtree_Flann<double, MetricT>;
-          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true, index_filename));
         }
         break;
         case CASCADE_HASHING_L2:
@@ -185,14 +191,21 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
       {
         using MetricT = Hamming<unsigned char>;
         using MatcherT = ArrayMatcherBruteForce<unsigned char, MetricT>;
-        region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false));
+        region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false, index_filename));
       }
       break;
       case HNSW_HAMMING:
       {
         using MetricT = Hamming<unsigned char>;
         using MatcherT = HNSWMatcher<unsigned char, MetricT, HNSWMETRIC::HAMMING_HNSW>;
-        region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false));
+        region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false, index_filename));
+      }
+      break;
+      case MULTI_INDEX_HASHING_HAMMING:
+      {
+        using MetricT = Hamming<unsigned char>;
+        using MatcherT = ArrayMatcherMultiIndexHashing<unsigned char, MetricT>;
+        region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, false, index_filename));
       }
       break;
       default:
@@ -9,6 +9,9 @@
 #ifndef OPENMVG_MATCHING_REGION_MATCHER_HPP
 #define OPENMVG_MATCHING_REGION_MATCHER_HPP
 
+#include <algorithm>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "openMVG/features/regions.hpp"
@@ -81,19 +84,56 @@ class RegionsMatcher
     const features::Regions & query_regions,
     matching::IndMatches & vec_putative_matches
   ) = 0;
+
+  /**
+   * @brief Match some regions to a subset of the database
+   * Look for each query to the number_neighbor nearest neighbors of the whole
+   * database and keep the 2 closest ones that belong to the subset. The match
+   * is kept if it pass the distance ratio test. If a single neighbor belongs to
+   * the subset, the farthest neighbor distance is used as second distance.
+   * @param[in] dist_ratio The distance ratio value.
+   * @param[in] query_regions The query regions.
+   * @param[in] database_subset Tell for each database region if it can be matched.
+   * @param[in] number_neighbor The number of nearest neighbors searched for each query.
+   * @param[out] vec_putative_matches The computed correspondences indices.
+   */
+  virtual bool MatchDistanceRatio
+  (
+    const float dist_ratio,
+    const features::Regions & query_regions,
+    const std::vector<bool> & database_subset,
+    const size_t number_neighbor,
+    matching::IndMatches & vec_putative_matches
+  ) = 0;
+
+  /**
+   * @brief Save the matcher search structure to a file (if the underlying
+   * matcher supports it, i.e. ANN_L2). See RegionMatcherFactory to reload it.
+   */
+  virtual bool SaveIndex
+  (
+    const std::string & index_filename
+  ) const
+  {
+    return false;
+  }
 };
 
 /**
  * @brief Create a region matcher according a matcher type and the regions type.
  * @param[in] matcher_type The Matcher type.
  * @param[in] regions The database regions.
+ * @param[in] index_filename Optional search structure saved by
+ * RegionsMatcher::SaveIndex for those regions. If it cannot be loaded, the
+ * search structure is built from the regions.
  * @return The created RegionsMatcher or an empty smart pointer if the a matcher
  * for the region type asked matcher type cannot be created.
  */
 std::unique_ptr<RegionsMatcher> RegionMatcherFactory
 (
   matching::EMatcherType matcher_type,
-  const features::Regions & regions
+  const features::Regions & regions,
+  const std::string & index_filename = ""
 );
 
 /**
@@ -115,11 +155,13 @@ public:
 
   /**
    * @brief Init the matcher with some reference regions.
+   * If index_filename is provided, try first to load the saved search structure.
    */
   RegionsMatcherT
   (
     const features::Regions & regions,
-    bool b_squared_metric = false
+    bool b_squared_metric = false,
+    const std::string & index_filename = ""
   ):
     regions_(&regions),
     b_squared_metric_(b_squared_metric)
@@ -128,7 +170,20 @@ public:
       return;
 
     const Scalar * tab = reinterpret_cast<const Scalar *>(regions_->DescriptorRawData());
-    matcher_.Build(tab, regions_->RegionCount(), regions_->DescriptorLength());
+    if (index_filename.empty() ||
+        !matcher_.LoadIndex(tab, regions_->RegionCount(),
+                            regions_->DescriptorLength(), index_filename))
+    {
+      matcher_.Build(tab, regions_->RegionCount(), regions_->DescriptorLength());
+    }
+  }
+
+  bool SaveIndex
+  (
+    const std::string & index_filename
+  ) const override
+  {
+    return regions_ && matcher_.SaveIndex(index_filename);
   }
 
   bool Match
@@ -199,8 +254,75 @@ public:
     matches.reserve(nn_ratio_indexes.size());
     for (const auto & index : nn_ratio_indexes)
     {
+      // Use the distance ratio as the match quality score
+      const float score =
+        static_cast<float>(nn_distances[index * number_neighbor])
+        / static_cast<float>(nn_distances[index * number_neighbor + 1]);
       matches.emplace_back(nn_matches[index * number_neighbor].j_,
-                           nn_matches[index * number_neighbor].i_);
+                           nn_matches[index * number_neighbor].i_,
+                           DistanceRatioScore(b_squared_metric_ ? std::sqrt(score) : score));
+    }
+
+    return (!matches.empty());
+  }
+
+  /**
+   * @brief Match some regions to a subset of the database of internal regions.
+   */
+  bool MatchDistanceRatio
+  (
+    const float distance_ratio,
+    const features::Regions & query_regions,
+    const std::vector<bool> & database_subset,
+    const size_t number_neighbor,
+    matching::IndMatches & matches
+  ) override
+  {
+    if (!regions_ || database_subset.size() != regions_->RegionCount())
+      return false;
+
+    const Scalar * queries = reinterpret_cast<const Scalar *>(query_regions.DescriptorRawData());
+
+    const size_t nb_neighbor = std::min(number_neighbor, regions_->RegionCount());
+    if (nb_neighbor < 2)
+      return false;
+    matching::IndMatches nn_matches;
+    std::vector<DistanceType> nn_distances;
+
+    // Search the closest neighbours of the whole database for each query descriptor
+    if (!matcher_.SearchNeighbours(queries,
+                                   query_regions.RegionCount(),
+                                   &nn_matches,
+                                   &nn_distances,
+                                   nb_neighbor))
+      return false;
+
+    const double ratio = b_squared_metric_ ? Square(distance_ratio) : distance_ratio;
+    matches.clear();
+    for (size_t query_index = 0; query_index < query_regions.RegionCount(); ++query_index)
+    {
+      // Find the 2 closest neighbours that belong to the subset
+      const size_t first = query_index * nb_neighbor, last = first + nb_neighbor;
+      size_t subset_neighbors[2], subset_count = 0;
+      for (size_t k = first; k < last && subset_count < 2; ++k)
+      {
+        const IndexT database_index = nn_matches[k].j_;
+        if (database_index < database_subset.size() && database_subset[database_index])
+          subset_neighbors[subset_count++] = k;
+      }
+      if (subset_count == 0)
+        continue;
+      const double first_distance = nn_distances[subset_neighbors[0]];
+      const double second_distance =
+        nn_distances[subset_count == 2 ? subset_neighbors[1] : last - 1];
+      if (first_distance < ratio * second_distance)
+      {
+        // Use the distance ratio as the match quality score
+        const float score = static_cast<float>(first_distance / second_distance);
+        matches.emplace_back(nn_matches[subset_neighbors[0]].j_,
+                             nn_matches[subset_neighbors[0]].i_,
+                             DistanceRatioScore(b_squared_metric_ ? std::sqrt(score) : score));
+      }
     }
 
     return (!matches.empty());
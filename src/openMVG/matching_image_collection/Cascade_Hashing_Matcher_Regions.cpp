@@ -17,6 +17,8 @@
 #include "openMVG/system/progressinterface.hpp"
 #include "openMVG/types.hpp"
 
+#include <cmath>
+
 
 namespace openMVG {
 namespace matching_image_collection {
@@ -173,9 +175,10 @@ void Match
       pvec_indices.reserve(regionsJ->RegionCount() * 2);
 
       // Match the query descriptors to the database
-      cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
-        hashed_base_[J], mat_J,
-        hashed_base_[I], mat_I,
+      // (the descriptors are used in place through their Eigen::Map)
+      cascade_hasher.Match_HashedDescriptions(
+        hashed_base_.at(J), mat_J,
+        hashed_base_.at(I), mat_I,
         &pvec_indices, &pvec_distances);
 
       std::vector<int> vec_nn_ratio_idx;
@@ -195,7 +198,11 @@ void Match
       for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
       {
         const size_t index = vec_nn_ratio_idx[k];
-        vec_putative_matches.emplace_back(pvec_indices[index*2].j_, pvec_indices[index*2].i_);
+        // Use the distance ratio as the match quality score
+        const float score = std::sqrt(
+          static_cast<float>(pvec_distances[index*2]) / static_cast<float>(pvec_distances[index*2+1]));
+        vec_putative_matches.emplace_back(pvec_indices[index*2].j_, pvec_indices[index*2].i_,
+                                          matching::DistanceRatioScore(score));
       }
 
       // Remove duplicates
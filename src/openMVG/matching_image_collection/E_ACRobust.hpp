@@ -16,6 +16,7 @@
 #include "openMVG/cameras/Camera_Pinhole.hpp"
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/matching_image_collection/Geometric_Filter_utils.hpp"
+#include "openMVG/multiview/solver_essential_eight_point.hpp"
 #include "openMVG/multiview/solver_essential_five_point.hpp"
 #include "openMVG/multiview/solver_essential_kernel.hpp"
 #include "openMVG/multiview/essential.hpp"
@@ -41,10 +42,12 @@ struct GeometricFilter_EMatrix_AC
   GeometricFilter_EMatrix_AC
   (
     double dPrecision = std::numeric_limits<double>::infinity(),
-    uint32_t iteration = 1024
+    uint32_t iteration = 1024,
+    const GeometricFilter_RobustOptions & robust_options = GeometricFilter_RobustOptions()
   ):
     m_dPrecision(dPrecision),
     m_stIteration(iteration),
+    m_robust_options(robust_options),
     m_E(Mat3::Identity()),
     m_dPrecision_robust(std::numeric_limits<double>::infinity())
   {
@@ -113,7 +116,8 @@ struct GeometricFilter_EMatrix_AC
       openMVG::robust::ACKernelAdaptorEssential<
         openMVG::essential::kernel::FivePointSolver,
         openMVG::fundamental::kernel::EpipolarDistanceError,
-        Mat3>;
+        Mat3,
+        openMVG::EightPointRelativePoseSolver>; // Local optimization solver
 
     const cameras::Pinhole_Intrinsic
       * ptrPinhole_I = dynamic_cast<const cameras::Pinhole_Intrinsic*>(cam_I),
@@ -128,9 +132,11 @@ struct GeometricFilter_EMatrix_AC
 
     // Robustly estimate the Essential matrix with A Contrario ransac
     const double upper_bound_precision = Square(m_dPrecision);
+    std::vector<uint32_t> ranking;
     std::vector<uint32_t> vec_inliers;
     const auto ACRansacOut =
-      openMVG::robust::ACRANSAC(kernel, vec_inliers, m_stIteration, &m_E, upper_bound_precision);
+      openMVG::robust::ACRANSAC(kernel, vec_inliers, m_stIteration, &m_E, upper_bound_precision,
+        ACRANSAC_Options_For_Pair(m_robust_options, vec_PutativeMatches, ranking));
 
     if (vec_inliers.size() > KernelType::MINIMUM_SAMPLES *2.5)
     {
@@ -215,6 +221,7 @@ struct GeometricFilter_EMatrix_AC
 
   double m_dPrecision;    // upper_bound precision used for robust estimation
   uint32_t m_stIteration; // maximal number of iteration for robust estimation
+  GeometricFilter_RobustOptions m_robust_options; // optional AC-RANSAC refinements
   //
   //-- Stored data
   Mat3 m_E;
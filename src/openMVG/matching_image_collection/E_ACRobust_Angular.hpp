@@ -21,13 +21,13 @@
 #include "openMVG/multiview/motion_from_essential.hpp"
 #include "openMVG/multiview/solver_essential_eight_point.hpp"
 #include "openMVG/multiview/solver_essential_three_point.hpp"
+#include "openMVG/robust_estimation/guided_matching.hpp"
 #include "openMVG/robust_estimation/robust_estimator_ACRansac.hpp"
 #include "openMVG/robust_estimation/robust_estimator_ACRansacKernelAdaptator.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/system/logger.hpp"
 
-namespace openMVG { namespace sfm { struct Regions_Provider; } }
-
 namespace openMVG {
 namespace matching_image_collection {
 
@@ -37,9 +37,11 @@ struct GeometricFilter_ESphericalMatrix_AC_Angular
 {
   GeometricFilter_ESphericalMatrix_AC_Angular(
     const double precision_upper_bound,
-    const size_t iteration)
+    const size_t iteration,
+    const GeometricFilter_RobustOptions & robust_options = GeometricFilter_RobustOptions())
     : m_precision_upper_bound(precision_upper_bound),
       m_stIteration(iteration),
+      m_robust_options(robust_options),
       m_E(Mat3::Identity()),
       m_precision_upper_bound_robust(std::numeric_limits<double>::infinity())
   {
@@ -118,9 +120,11 @@ struct GeometricFilter_ESphericalMatrix_AC_Angular
     const double upper_bound_precision =
      (m_precision_upper_bound != std::numeric_limits<double>::infinity())?
         D2R(m_precision_upper_bound) : std::numeric_limits<double>::infinity();
+    std::vector<uint32_t> ranking;
     std::vector<uint32_t> vec_inliers;
     const auto ac_ransac_output =
-      ACRANSAC(kernel, vec_inliers, m_stIteration, &m_E, upper_bound_precision);
+      ACRANSAC(kernel, vec_inliers, m_stIteration, &m_E, upper_bound_precision,
+        ACRANSAC_Options_For_Pair(m_robust_options, vec_PutativeMatches, ranking));
 
     const double & threshold = ac_ransac_output.first;
 
@@ -169,14 +173,65 @@ struct GeometricFilter_ESphericalMatrix_AC_Angular
     matching::IndMatches & matches
   )
   {
-    OPENMVG_LOG_ERROR << "Not yet implemented";
-    return false;
+    if (m_precision_upper_bound_robust != std::numeric_limits<double>::infinity())
+    {
+      // Get back corresponding view index
+      const IndexT iIndex = pairIndex.first;
+      const IndexT jIndex = pairIndex.second;
+
+      const sfm::View * view_I = sfm_data->views.at(iIndex).get();
+      const sfm::View * view_J = sfm_data->views.at(jIndex).get();
+
+      // Retrieve corresponding pair camera intrinsic
+      const cameras::IntrinsicBase * cam_I =
+        sfm_data->GetIntrinsics().count(view_I->id_intrinsic) ?
+          sfm_data->GetIntrinsics().at(view_I->id_intrinsic).get() : nullptr;
+      const cameras::IntrinsicBase * cam_J =
+        sfm_data->GetIntrinsics().count(view_J->id_intrinsic) ?
+          sfm_data->GetIntrinsics().at(view_J->id_intrinsic).get() : nullptr;
+
+      if (!cam_I || !cam_J)
+      {
+        OPENMVG_LOG_WARNING << "Skip this pair. No intrinsic information: "
+          << '(' << iIndex << ',' << jIndex << ')';
+        return false;
+      }
+
+      const std::shared_ptr<features::Regions>
+        regionsI = regions_provider->get(iIndex),
+        regionsJ = regions_provider->get(jIndex);
+
+      // Compute the bearing vectors of all the regions
+      //  (from the undistorted positions, as for the robust estimation)
+      Mat2X xI(2, regionsI->RegionCount()), xJ(2, regionsJ->RegionCount());
+      for (size_t i = 0; i < regionsI->RegionCount(); ++i)
+        xI.col(i) = cam_I->get_ud_pixel(regionsI->GetRegionPosition(i));
+      for (size_t j = 0; j < regionsJ->RegionCount(); ++j)
+        xJ.col(j) = cam_J->get_ud_pixel(regionsJ->GetRegionPosition(j));
+      const Mat
+        xI_bearing_vector = (*cam_I)(xI),
+        xJ_bearing_vector = (*cam_J)(xJ);
+
+      // Check the features correspondences that agree in the geometric and photometric domain
+      //  (the angular error threshold is expressed in radian)
+      geometry_aware::GuidedMatching<
+        Mat3,
+        openMVG::AngularError>(
+          m_E,
+          xI_bearing_vector, *regionsI,
+          xJ_bearing_vector, *regionsJ,
+          m_precision_upper_bound_robust, Square(dDistanceRatio),
+          matches);
+    }
+    return matches.size() != 0;
   }
 
   // upper_bound precision used for robust estimation
   double m_precision_upper_bound = std::numeric_limits<double>::infinity();
   // maximal number of iteration for robust estimation
   size_t m_stIteration = 1024;
+  // optional AC-RANSAC refinements
+  GeometricFilter_RobustOptions m_robust_options;
 
   //
   //-- Stored data
@@ -37,10 +37,12 @@ struct GeometricFilter_EOMatrix_RA
     GeometricFilter_EOMatrix_RA
     (
       double dPrecision = std::numeric_limits<double>::infinity(),
-      uint32_t iteration = 1024
+      uint32_t iteration = 1024,
+      const GeometricFilter_RobustOptions & robust_options = GeometricFilter_RobustOptions()
     ):
       m_dPrecision(dPrecision),
       m_stIteration(iteration),
+      m_robust_options(robust_options),
       m_E(Mat3::Identity())
     {
     }
@@ -121,10 +123,12 @@ struct GeometricFilter_EOMatrix_RA
       );
 
       // Robustly estimate the model with AC-RANSAC
+      std::vector<uint32_t> ranking;
       std::vector<uint32_t> vec_inliers;
 
       const auto ACRansacOut = ACRANSAC(
-        kernel, vec_inliers, m_stIteration, &m_E, m_dPrecision);
+        kernel, vec_inliers, m_stIteration, &m_E, m_dPrecision,
+        ACRANSAC_Options_For_Pair(m_robust_options, vec_PutativeMatches, ranking));
 
       if (vec_inliers.size() > KernelType::MINIMUM_SAMPLES * 2.5)
       {
@@ -157,6 +161,7 @@ struct GeometricFilter_EOMatrix_RA
 
   uint32_t m_stIteration; // maximal number of iteration for robust estimation
   double m_dPrecision;    // upper_bound precision used for robust estimation
+  GeometricFilter_RobustOptions m_robust_options; // optional AC-RANSAC refinements
   //
   //-- Stored data
   Mat3 m_E;
@@ -36,18 +36,14 @@ void MatchesPointsToMat
   using Scalar = typename Mat::Scalar; // Output matrix type
 
   for (size_t i=0; i < putativeMatches.size(); ++i)  {
-    const features::PointFeature & pt_I = feature_I[putativeMatches[i].i_];
-    const features::PointFeature & pt_J = feature_J[putativeMatches[i].j_];
-    if (cam_I)
-      x_I.col(i) = cam_I->get_ud_pixel(pt_I.coords().cast<Scalar>());
-    else
-      x_I.col(i) = pt_I.coords().cast<Scalar>();
-
-    if (cam_J)
-      x_J.col(i) = cam_J->get_ud_pixel(pt_J.coords().cast<Scalar>());
-    else
-      x_J.col(i) = pt_J.coords().cast<Scalar>();
+    x_I.col(i) = feature_I[putativeMatches[i].i_].coords().cast<Scalar>();
+    x_J.col(i) = feature_J[putativeMatches[i].j_].coords().cast<Scalar>();
   }
+  // Remove the distortion of all the points at once
+  if (cam_I)
+    x_I = cam_I->get_ud_pixels(x_I);
+  if (cam_J)
+    x_J = cam_J->get_ud_pixels(x_J);
 }
 
 void MatchesPairToMat
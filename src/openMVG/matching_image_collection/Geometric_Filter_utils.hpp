@@ -9,7 +9,10 @@
 #ifndef OPENMVG_MATCHING_IMAGE_COLLECTION_GEOMETRIC_FILTER_UTILS_HPP
 #define OPENMVG_MATCHING_IMAGE_COLLECTION_GEOMETRIC_FILTER_UTILS_HPP
 
+#include <vector>
+
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/robust_estimation/robust_estimator_ACRansac.hpp"
 #include <openMVG/features/feature_container.hpp>
 #include <openMVG/numeric/eigen_alias_definition.hpp>
 
@@ -23,6 +26,37 @@ namespace openMVG {
 
 namespace matching_image_collection {
 
+/// Options of the AC-RANSAC robust estimation of the geometric filters
+///  (the optional refinements are disabled by default)
+struct GeometricFilter_RobustOptions
+{
+  bool b_local_optimization = false; // LO-RANSAC refinement of the meaningful models
+  bool b_sprt = false; // SPRT early rejection of the bad model hypotheses
+  bool b_prosac = false; // PROSAC sampling of the best scored matches first
+};
+
+/**
+* @brief Get the ACRANSAC options used to filter the putative matches of a pair
+* @param[in] options Enabled refinements
+* @param[in] putativeMatches Matches of the pair
+* @param[out] ranking Storage of the match ranking (used by the PROSAC sampling)
+*/
+inline robust::ACRANSAC_Options ACRANSAC_Options_For_Pair
+(
+  const GeometricFilter_RobustOptions & options,
+  const matching::IndMatches & putativeMatches,
+  std::vector<uint32_t> & ranking
+)
+{
+  robust::ACRANSAC_Options acransac_options;
+  acransac_options.bLocalOptimization = options.b_local_optimization;
+  acransac_options.bSPRT = options.b_sprt;
+  // Sample first the matches with the best quality score (if any)
+  if (options.b_prosac && matching::RankByScore(putativeMatches, ranking))
+    acransac_options.sampling_ranking = &ranking;
+  return acransac_options;
+}
+
 /**
 * @brief Get "image perfect" features (un-distorted feature positions)
 * @param[in] putativeMatches Selected corresponding features id (match)
@@ -37,10 +37,12 @@ struct GeometricFilter_HMatrix_AC
   GeometricFilter_HMatrix_AC
   (
     double dPrecision = std::numeric_limits<double>::infinity(),
-    uint32_t iteration = 1024
+    uint32_t iteration = 1024,
+    const GeometricFilter_RobustOptions & robust_options = GeometricFilter_RobustOptions()
   ):
     m_dPrecision(dPrecision),
     m_stIteration(iteration),
+    m_robust_options(robust_options),
     m_H(Mat3::Identity()),
     m_dPrecision_robust(std::numeric_limits<double>::infinity())
   {
@@ -81,7 +83,8 @@ struct GeometricFilter_HMatrix_AC
         openMVG::homography::kernel::FourPointSolver,
         openMVG::homography::kernel::AsymmetricError,
         UnnormalizerI,
-        Mat3>;
+        Mat3,
+        openMVG::homography::kernel::FourPointSolver>; // Local optimization solver
 
     KernelType kernel(
       xI, sfm_data->GetViews().at(iIndex)->ui_width, sfm_data->GetViews().at(iIndex)->ui_height,
@@ -90,9 +93,11 @@ struct GeometricFilter_HMatrix_AC
 
     // Robustly estimate the Homography matrix with A Contrario ransac
     const double upper_bound_precision = Square(m_dPrecision);
+    std::vector<uint32_t> ranking;
     std::vector<uint32_t> vec_inliers;
     const std::pair<double,double> ACRansacOut =
-      ACRANSAC(kernel, vec_inliers, m_stIteration, &m_H, upper_bound_precision);
+      ACRANSAC(kernel, vec_inliers, m_stIteration, &m_H, upper_bound_precision,
+        ACRANSAC_Options_For_Pair(m_robust_options, vec_PutativeMatches, ranking));
 
     if (vec_inliers.size() > KernelType::MINIMUM_SAMPLES *2.5)
     {
@@ -203,6 +208,7 @@ struct GeometricFilter_HMatrix_AC
 
   double m_dPrecision;    // upper_bound precision used for robust estimation
   uint32_t m_stIteration; // maximal number of iteration for robust estimation
+  GeometricFilter_RobustOptions m_robust_options; // optional AC-RANSAC refinements
   //
   //-- Stored data
   Mat3 m_H;
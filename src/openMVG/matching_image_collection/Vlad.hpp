@@ -57,7 +57,9 @@ class VLAD : public VLADBase
   DescriptorVector BuildCodebook(
     const DescriptorVector& descriptor_array,
     const int codebook_size = 128,
-    const int max_nb_iteration = 25) override
+    const int max_nb_iteration = 25,
+    const clustering::KMeansSolverType kmeans_solver_type =
+      clustering::KMeansSolverType::KMEANS_LLOYD) override
   {
     DescriptorVector codebook;
     std::vector<uint32_t> vec_ids;
@@ -75,7 +77,8 @@ class VLAD : public VLADBase
         codebook_size,
         max_nb_iteration,
         k_mean_init_type,
-        &progress);
+        &progress,
+        kmeans_solver_type);
     return codebook;
   }
 
@@ -115,76 +118,92 @@ class VLAD : public VLADBase
     VladMatrixType mat_vlad_descriptors =
       VladMatrixType::Zero(vlad_descriptor_length, view_ids.size());
     // For each image (regions), compute its VLAD representation
-    const RegionTypeT *cast_centroid_regions =
-        dynamic_cast<RegionTypeT *>(centroid_regions.get());
-    Vec vlad_desc(vlad_descriptor_length);
     progress.Restart(
         view_ids.size(), "- VLAD Embedding... -");
-    for (const auto &view_id : view_ids) {
-      vlad_desc.setZero();
+    for (size_t view_index = 0; view_index < view_ids.size(); ++view_index) {
+      const IndexT view_id = view_ids[view_index];
       const auto &query_regions = embedding_regions_provider->get(view_id);
 
-      // Retrieve indexes (match descriptors to centroids)
-      matching::IndMatches centroid_to_descriptor_associations;
-      matching::Match(matching::EMatcherType::BRUTE_FORCE_L2, *centroid_regions,
-                      *query_regions, centroid_to_descriptor_associations);
-
-      const RegionTypeT *cast_query_regions =
-          dynamic_cast<RegionTypeT *>(query_regions.get());
-
-      // Accumulation of residual to the centroid
-      for (const auto centroid_id_and_descriptor_list :
-          centroid_to_descriptor_associations) {
-        const auto centroid_id = centroid_id_and_descriptor_list.i_;
-        const auto descriptor_id = centroid_id_and_descriptor_list.j_;
-
-        const auto residual =
-            cast_query_regions->Descriptors()[descriptor_id].template cast<double>() -
-            cast_centroid_regions->Descriptors()[centroid_id].template cast<double>();
-
-        switch (vlad_normalization_type) {
-          case VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW: {
-          const auto norm_residual = residual.normalized();
-          vlad_desc.segment(centroid_id * base_descriptor_length,
-                            base_descriptor_length) += residual;
-        }
-        break;
-        default:
-          vlad_desc.segment(centroid_id * base_descriptor_length,
-                            base_descriptor_length) += residual;
-        }
+      // Insert the vector into the matrix (column order follows view_ids)
+      mat_vlad_descriptors.col(view_index) =
+        ComputeVLADEmbedding(*query_regions, *centroid_regions,
+                             vlad_normalization_type);
+      ++progress;
+    }
+    return mat_vlad_descriptors;
+  }
+
+  VladMatrixType ComputeVLADEmbedding(
+    const features::Regions& query_regions,
+    const features::Regions& centroid_regions, // The codebook
+    const VLAD_NORMALIZATION vlad_normalization_type =
+    VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW)
+    override
+  {
+    const size_t codebook_size = centroid_regions.RegionCount();
+    const size_t base_descriptor_length = centroid_regions.DescriptorLength();
+    const size_t vlad_descriptor_length = base_descriptor_length * codebook_size;
+
+    const RegionTypeT *cast_centroid_regions =
+        dynamic_cast<const RegionTypeT *>(&centroid_regions);
+    Vec vlad_desc = Vec::Zero(vlad_descriptor_length);
+
+    // Retrieve indexes (match descriptors to centroids)
+    matching::IndMatches centroid_to_descriptor_associations;
+    matching::Match(matching::EMatcherType::BRUTE_FORCE_L2, centroid_regions,
+                    query_regions, centroid_to_descriptor_associations);
+
+    const RegionTypeT *cast_query_regions =
+        dynamic_cast<const RegionTypeT *>(&query_regions);
+
+    // Accumulation of residual to the centroid
+    for (const auto centroid_id_and_descriptor_list :
+        centroid_to_descriptor_associations) {
+      const auto centroid_id = centroid_id_and_descriptor_list.i_;
+      const auto descriptor_id = centroid_id_and_descriptor_list.j_;
+
+      const auto residual =
+          cast_query_regions->Descriptors()[descriptor_id].template cast<double>() -
+          cast_centroid_regions->Descriptors()[centroid_id].template cast<double>();
+
+      switch (vlad_normalization_type) {
+        case VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW: {
+        const auto norm_residual = residual.normalized();
+        vlad_desc.segment(centroid_id * base_descriptor_length,
+                          base_descriptor_length) += residual;
+      }
+      break;
+      default:
+        vlad_desc.segment(centroid_id * base_descriptor_length,
+                          base_descriptor_length) += residual;
       }
+    }
 
-      // per descriptor normalization
-      for (int centroid_id = 0; centroid_id < codebook_size; ++centroid_id) {
-        auto local_vlad = vlad_desc.segment(centroid_id * base_descriptor_length,
-                                            base_descriptor_length);
-        switch (vlad_normalization_type) {
-          case VLAD_NORMALIZATION::INTRA_NORMALIZATION:
-            local_vlad.normalize();
-            break;
-          case VLAD_NORMALIZATION::SIGNED_SQUARE_ROOTING:
-            local_vlad =
-                local_vlad.array().sign() * local_vlad.array().abs().sqrt();
-            break;
-          case VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW:
-            local_vlad =
-                local_vlad.array().sign() * local_vlad.array().abs().pow(0.2);
-            break;
-        }
+    // per descriptor normalization
+    for (int centroid_id = 0; centroid_id < codebook_size; ++centroid_id) {
+      auto local_vlad = vlad_desc.segment(centroid_id * base_descriptor_length,
+                                          base_descriptor_length);
+      switch (vlad_normalization_type) {
+        case VLAD_NORMALIZATION::INTRA_NORMALIZATION:
+          local_vlad.normalize();
+          break;
+        case VLAD_NORMALIZATION::SIGNED_SQUARE_ROOTING:
+          local_vlad =
+              local_vlad.array().sign() * local_vlad.array().abs().sqrt();
+          break;
+        case VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW:
+          local_vlad =
+              local_vlad.array().sign() * local_vlad.array().abs().pow(0.2);
+          break;
       }
+    }
 
-      // if(max_feats > 0) TODO(RJ): center adaptation for All About VLAD
+    // if(max_feats > 0) TODO(RJ): center adaptation for All About VLAD
 
-      // Global L2 normalization, it is used by all variants of VLAD
-      vlad_desc.normalize();
+    // Global L2 normalization, it is used by all variants of VLAD
+    vlad_desc.normalize();
 
-      // Insert the vector into the matrix
-      mat_vlad_descriptors.col(view_id) =
-          vlad_desc.cast<VladMatrixType::Scalar>();
-      ++progress;
-    }
-    return mat_vlad_descriptors;
+    return vlad_desc.cast<VladMatrixType::Scalar>();
   }
 };
 
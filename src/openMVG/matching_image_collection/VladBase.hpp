@@ -9,6 +9,7 @@
 #ifndef OPENMVG_MATCHING_IMAGE_COLLECTION_VLADBASE_HPP
 #define OPENMVG_MATCHING_IMAGE_COLLECTION_VLADBASE_HPP
 
+#include "openMVG/clustering/kmeans.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 
 namespace openMVG {
@@ -66,16 +67,28 @@ public:
   virtual DescriptorVector BuildCodebook(
     const DescriptorVector& descriptor_array,
     const int codebook_size = 128,
-    const int max_nb_iteration = 25) = 0;
+    const int max_nb_iteration = 25,
+    const clustering::KMeansSolverType kmeans_solver_type =
+      clustering::KMeansSolverType::KMEANS_LLOYD) = 0;
 
   // Compute the VLAD representation of each "image" given the codebook
   // and its associated image descriptors
+  // The i-th column of the returned matrix is the VLAD of the view_ids[i] view
   virtual VladMatrixType ComputeVLADEmbedding(
     const std::vector<IndexT>& view_ids,
     std::unique_ptr<features::Regions>& centroid_regions, // The codebook
     std::shared_ptr<sfm::Regions_Provider> embedding_regions_provider,
     const VLAD_NORMALIZATION vlad_normalization_type =
       VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW) = 0;
+
+  // Compute the VLAD representation of some regions (i.e. a query image
+  // that is not part of a Regions_Provider) given the codebook
+  // The returned matrix has a single column
+  virtual VladMatrixType ComputeVLADEmbedding(
+    const features::Regions& query_regions,
+    const features::Regions& centroid_regions, // The codebook
+    const VLAD_NORMALIZATION vlad_normalization_type =
+      VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW) = 0;
 };
 
 } // namespace openMVG
@@ -0,0 +1,227 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON, Romain JANVIER
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_IMAGE_COLLECTION_VLAD_DATABASE_HPP
+#define OPENMVG_MATCHING_IMAGE_COLLECTION_VLAD_DATABASE_HPP
+
+#include "openMVG/matching_image_collection/VladBase.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openMVG {
+
+// A persistent VLAD retrieval database.
+// It stores the learned codebook and the VLAD embedding of every indexed view,
+// so that new views can be embedded and queried later on without relearning
+// the codebook nor re-embedding the already indexed views.
+struct VLAD_Database
+{
+  VLAD_NORMALIZATION normalization =
+    VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW;
+  // The codebook (kmeans centroids)
+  VLADBase::DescriptorVector codebook;
+  // The view id related to each column of the embeddings matrix
+  std::vector<IndexT> view_ids;
+  // The VLAD embeddings (one column per view)
+  VLADBase::VladMatrixType embeddings;
+
+  // Append some new view embeddings (one column per view) to the database
+  void Append
+  (
+    const std::vector<IndexT> & new_view_ids,
+    const VLADBase::VladMatrixType & new_embeddings
+  )
+  {
+    assert(new_view_ids.size() == static_cast<size_t>(new_embeddings.cols()));
+    if (new_view_ids.empty())
+      return;
+    if (view_ids.empty())
+    {
+      embeddings = new_embeddings;
+    }
+    else
+    {
+      assert(embeddings.rows() == new_embeddings.rows());
+      const Eigen::Index previous_cols = embeddings.cols();
+      embeddings.conservativeResize(Eigen::NoChange,
+                                    previous_cols + new_embeddings.cols());
+      embeddings.rightCols(new_embeddings.cols()) = new_embeddings;
+    }
+    view_ids.insert(view_ids.end(), new_view_ids.cbegin(), new_view_ids.cend());
+  }
+};
+
+namespace internal {
+static const char VLAD_DATABASE_MAGIC[8] = {'V','L','A','D','_','D','B','\0'};
+static const uint32_t VLAD_DATABASE_VERSION = 1;
+
+// Tell if count items of item_size bytes fit in the remaining bytes of a file
+// (written to not overflow on corrupted sizes, empty items are not expected)
+inline bool FitInFile
+(
+  const uint64_t count,
+  const uint64_t item_size,
+  const uint64_t remaining_bytes
+)
+{
+  return item_size == 0 ? count == 0 : count <= remaining_bytes / item_size;
+}
+} // namespace internal
+
+/// Write a VLAD database to a file (in binary mode)
+inline bool Save
+(
+  const VLAD_Database & database,
+  const std::string & filename
+)
+{
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  using KmeanT = VLADBase::KmeanInternalType;
+  using VladT = VLADBase::VladInternalType;
+
+  file.write(internal::VLAD_DATABASE_MAGIC, sizeof(internal::VLAD_DATABASE_MAGIC));
+  file.write(reinterpret_cast<const char*>(&internal::VLAD_DATABASE_VERSION),
+    sizeof(uint32_t));
+  const uint8_t normalization = static_cast<uint8_t>(database.normalization);
+  file.write(reinterpret_cast<const char*>(&normalization), sizeof(uint8_t));
+
+  // Codebook
+  const uint64_t codebook_size = database.codebook.size();
+  const uint64_t descriptor_length =
+    database.codebook.empty() ? 0 : database.codebook[0].size();
+  file.write(reinterpret_cast<const char*>(&codebook_size), sizeof(uint64_t));
+  file.write(reinterpret_cast<const char*>(&descriptor_length), sizeof(uint64_t));
+  for (const auto & centroid : database.codebook)
+  {
+    file.write(reinterpret_cast<const char*>(centroid.data()),
+      descriptor_length * sizeof(KmeanT));
+  }
+
+  // Indexed view ids and their embeddings
+  const uint64_t view_count = database.view_ids.size();
+  const uint64_t vlad_length = database.embeddings.rows();
+  file.write(reinterpret_cast<const char*>(&view_count), sizeof(uint64_t));
+  file.write(reinterpret_cast<const char*>(&vlad_length), sizeof(uint64_t));
+  if (view_count > 0)
+  {
+    file.write(reinterpret_cast<const char*>(database.view_ids.data()),
+      view_count * sizeof(IndexT));
+    file.write(reinterpret_cast<const char*>(database.embeddings.data()),
+      view_count * vlad_length * sizeof(VladT));
+  }
+  const bool bOk = file.good();
+  file.close();
+  return bOk;
+}
+
+/// Read a VLAD database from a file (in binary mode)
+/// The read sizes are checked against the file length before any allocation,
+/// and the database is left unchanged if the file is invalid.
+inline bool Load
+(
+  VLAD_Database & database,
+  const std::string & filename
+)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  using KmeanT = VLADBase::KmeanInternalType;
+  using VladT = VLADBase::VladInternalType;
+
+  file.seekg(0, std::ios::end);
+  const std::streamoff file_length = file.tellg();
+  file.seekg(0, std::ios::beg);
+  if (!file || file_length < 0)
+    return false;
+  const auto remaining_bytes = [&]() -> uint64_t
+  {
+    const std::streamoff position = file.tellg();
+    return (position < 0 || position > file_length) ? 0 : file_length - position;
+  };
+
+  char magic[sizeof(internal::VLAD_DATABASE_MAGIC)];
+  uint32_t version = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+  if (!file || std::memcmp(magic, internal::VLAD_DATABASE_MAGIC, sizeof(magic)) != 0
+      || version != internal::VLAD_DATABASE_VERSION)
+  {
+    return false;
+  }
+  uint8_t normalization = 0;
+  file.read(reinterpret_cast<char*>(&normalization), sizeof(uint8_t));
+  if (!file || normalization >
+      static_cast<uint8_t>(VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW))
+  {
+    return false;
+  }
+
+  // Codebook
+  uint64_t codebook_size = 0, descriptor_length = 0;
+  file.read(reinterpret_cast<char*>(&codebook_size), sizeof(uint64_t));
+  file.read(reinterpret_cast<char*>(&descriptor_length), sizeof(uint64_t));
+  if (!file ||
+      !internal::FitInFile(descriptor_length, sizeof(KmeanT), remaining_bytes()) ||
+      !internal::FitInFile(codebook_size, descriptor_length * sizeof(KmeanT),
+                           remaining_bytes()))
+  {
+    return false;
+  }
+  VLADBase::DescriptorVector codebook(codebook_size,
+    VLADBase::DescriptorType(descriptor_length));
+  for (auto & centroid : codebook)
+  {
+    file.read(reinterpret_cast<char*>(centroid.data()),
+      descriptor_length * sizeof(KmeanT));
+  }
+
+  // Indexed view ids and their embeddings
+  uint64_t view_count = 0, vlad_length = 0;
+  file.read(reinterpret_cast<char*>(&view_count), sizeof(uint64_t));
+  file.read(reinterpret_cast<char*>(&vlad_length), sizeof(uint64_t));
+  if (!file ||
+      !internal::FitInFile(vlad_length, sizeof(VladT), remaining_bytes()) ||
+      !internal::FitInFile(view_count, sizeof(IndexT) + vlad_length * sizeof(VladT),
+                           remaining_bytes()))
+  {
+    return false;
+  }
+  std::vector<IndexT> view_ids(view_count);
+  VLADBase::VladMatrixType embeddings(vlad_length, view_count);
+  if (view_count > 0)
+  {
+    file.read(reinterpret_cast<char*>(view_ids.data()),
+      view_count * sizeof(IndexT));
+    file.read(reinterpret_cast<char*>(embeddings.data()),
+      view_count * vlad_length * sizeof(VladT));
+  }
+  if (file.fail())
+    return false;
+  file.close();
+
+  database.normalization = static_cast<VLAD_NORMALIZATION>(normalization);
+  database.codebook = std::move(codebook);
+  database.view_ids = std::move(view_ids);
+  database.embeddings = std::move(embeddings);
+  return true;
+}
+
+} // namespace openMVG
+
+#endif // OPENMVG_MATCHING_IMAGE_COLLECTION_VLAD_DATABASE_HPP
@@ -0,0 +1,127 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON, Romain JANVIER
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching_image_collection/Vlad_Database.hpp"
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace openMVG;
+
+TEST(VLAD_Database, Append)
+{
+  VLAD_Database database;
+  database.Append({0, 2}, VLADBase::VladMatrixType::Constant(6, 2, 1.f));
+  EXPECT_EQ(2, database.view_ids.size());
+  EXPECT_EQ(2, database.embeddings.cols());
+
+  database.Append({5}, VLADBase::VladMatrixType::Constant(6, 1, 2.f));
+  EXPECT_EQ(3, database.view_ids.size());
+  EXPECT_EQ(5, database.view_ids.back());
+  EXPECT_EQ(3, database.embeddings.cols());
+  EXPECT_EQ(1.f, database.embeddings(5, 1));
+  EXPECT_EQ(2.f, database.embeddings(0, 2));
+}
+
+TEST(VLAD_Database, IO)
+{
+  VLAD_Database database;
+  database.normalization = VLAD_NORMALIZATION::INTRA_NORMALIZATION;
+  database.codebook.assign(3, VLADBase::DescriptorType::Random(2));
+  database.Append({1, 4, 7}, VLADBase::VladMatrixType::Random(6, 3));
+
+  EXPECT_TRUE(Save(database, "vlad_database_IO.bin"));
+
+  VLAD_Database loaded_database;
+  EXPECT_TRUE(Load(loaded_database, "vlad_database_IO.bin"));
+  EXPECT_TRUE(VLAD_NORMALIZATION::INTRA_NORMALIZATION ==
+    loaded_database.normalization);
+  EXPECT_EQ(3, loaded_database.codebook.size());
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_MATRIX_NEAR(database.codebook[i], loaded_database.codebook[i], 0.0);
+  }
+  EXPECT_TRUE(database.view_ids == loaded_database.view_ids);
+  EXPECT_MATRIX_NEAR(database.embeddings, loaded_database.embeddings, 0.0);
+}
+
+TEST(VLAD_Database, IO_InvalidInput)
+{
+  VLAD_Database database;
+  EXPECT_FALSE(Load(database, "vlad_database_not_existing.bin"));
+
+  std::ofstream file("vlad_database_invalid.bin");
+  file << "invalid content";
+  file.close();
+  EXPECT_FALSE(Load(database, "vlad_database_invalid.bin"));
+}
+
+// Load must reject some truncated or corrupted files without allocating
+//  the sizes it reads, and keep the database unchanged
+TEST(VLAD_Database, IO_CorruptedInput)
+{
+  VLAD_Database database;
+  database.codebook.assign(3, VLADBase::DescriptorType::Random(2));
+  database.Append({1, 4, 7}, VLADBase::VladMatrixType::Random(6, 3));
+  EXPECT_TRUE(Save(database, "vlad_database_corrupted.bin"));
+
+  std::string content;
+  {
+    std::ifstream file("vlad_database_corrupted.bin", std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  }
+  const auto write_content = [](const std::string & bytes)
+  {
+    std::ofstream file("vlad_database_corrupted.bin", std::ios::binary);
+    file.write(bytes.data(), bytes.size());
+  };
+
+  VLAD_Database loaded_database;
+  loaded_database.Append({3}, VLADBase::VladMatrixType::Constant(6, 1, 1.f));
+
+  // Truncated embeddings
+  write_content(content.substr(0, content.size() - 1));
+  EXPECT_FALSE(Load(loaded_database, "vlad_database_corrupted.bin"));
+
+  // Huge codebook size (the header is magic[8], version[4], normalization[1])
+  std::string corrupted = content;
+  const uint64_t huge_size = uint64_t(1) << 60;
+  corrupted.replace(13, sizeof(uint64_t),
+    reinterpret_cast<const char*>(&huge_size), sizeof(uint64_t));
+  write_content(corrupted);
+  EXPECT_FALSE(Load(loaded_database, "vlad_database_corrupted.bin"));
+
+  // Huge view count
+  corrupted = content;
+  const size_t view_count_offset =
+    13 + 2 * sizeof(uint64_t) + 3 * 2 * sizeof(VLADBase::KmeanInternalType);
+  corrupted.replace(view_count_offset, sizeof(uint64_t),
+    reinterpret_cast<const char*>(&huge_size), sizeof(uint64_t));
+  write_content(corrupted);
+  EXPECT_FALSE(Load(loaded_database, "vlad_database_corrupted.bin"));
+
+  // The database is left unchanged by the failed loads
+  EXPECT_EQ(1, loaded_database.view_ids.size());
+  EXPECT_EQ(3, loaded_database.view_ids[0]);
+  EXPECT_TRUE(loaded_database.codebook.empty());
+
+  // The initial content is still valid
+  write_content(content);
+  EXPECT_TRUE(Load(loaded_database, "vlad_database_corrupted.bin"));
+  EXPECT_TRUE(database.view_ids == loaded_database.view_ids);
+
+  std::remove("vlad_database_corrupted.bin");
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
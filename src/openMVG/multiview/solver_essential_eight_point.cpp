@@ -59,4 +59,22 @@ double AngularError::Error
   return std::abs(std::asin(angleVal));
 }
 
+void AngularError::Errors
+(
+  const Mat3 & model,
+  const RMat3X & x1,
+  const RMat3X & x2,
+  std::vector<double> & errors
+)
+{
+  const auto x1_0 = x1.row(0).array(), x1_1 = x1.row(1).array(), x1_2 = x1.row(2).array();
+  const auto Em1_0 = model(0,0) * x1_0 + model(0,1) * x1_1 + model(0,2) * x1_2;
+  const auto Em1_1 = model(1,0) * x1_0 + model(1,1) * x1_1 + model(1,2) * x1_2;
+  const auto Em1_2 = model(2,0) * x1_0 + model(2,1) * x1_1 + model(2,2) * x1_2;
+  errors.resize(x1.cols());
+  Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic>>(errors.data(), errors.size()) =
+    ((x2.row(0).array() * Em1_0 + x2.row(1).array() * Em1_1 + x2.row(2).array() * Em1_2)
+     / (Em1_0.square() + Em1_1.square() + Em1_2.square()).sqrt()).asin().abs();
+}
+
 } // namespace openMVG
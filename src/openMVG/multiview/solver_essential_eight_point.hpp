@@ -9,6 +9,8 @@
 #ifndef OPENMVG_MULTIVIEW_SOLVER_ESSENTIAL_SPHERICAL_HPP
 #define OPENMVG_MULTIVIEW_SOLVER_ESSENTIAL_SPHERICAL_HPP
 
+#include <vector>
+
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
 namespace openMVG {
@@ -39,6 +41,16 @@ struct AngularError
     const Vec3 & x1,
     const Vec3 & x2
   );
+
+  // Angular errors of a set of bearing vector correspondences stored as
+  //  row major 3xN matrices (each coordinate row is contiguous)
+  static void Errors
+  (
+    const Mat3 & model,
+    const RMat3X & x1,
+    const RMat3X & x2,
+    std::vector<double> & errors
+  );
 };
 
 } // namespace openMVG
@@ -152,6 +152,17 @@ TEST(ThreePointsRelativePoseUpright, RelativePose_Kernel_IdFocal) {
   }
 }
 
+TEST(AngularError, BatchErrors) {
+  const Mat3 E = Mat3::Random();
+  const Mat3X x1 = Mat3X::Random(3, 101).colwise().normalized();
+  const Mat3X x2 = Mat3X::Random(3, 101).colwise().normalized();
+  std::vector<double> errors;
+  AngularError::Errors(E, RMat3X(x1), RMat3X(x2), errors);
+  CHECK_EQUAL(x1.cols(), errors.size());
+  for (Mat::Index i = 0; i < x1.cols(); ++i)
+    EXPECT_NEAR(AngularError::Error(E, x1.col(i), x2.col(i)), errors[i], 1e-10);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
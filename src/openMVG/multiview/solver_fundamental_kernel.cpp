@@ -47,8 +47,10 @@ void SevenPointSolver::Solve
   Vec9 f1, f2;
   // Set up the homogeneous system Af = 0 from the equations x'T*F*x = 0.
   MatX9 epipolar_constraint = MatX9::Zero((x1.cols() == 7) ? 9 : x1.cols(), 9);
-  EncodeEpipolarEquation(x1.colwise().homogeneous(),
-                         x2.colwise().homogeneous(),
+  // (the homogeneous points are evaluated once, an element access to the
+  //  homogeneous expression would evaluate it entirely)
+  EncodeEpipolarEquation(Mat3X(x1.colwise().homogeneous()),
+                         Mat3X(x2.colwise().homogeneous()),
                          &epipolar_constraint);
 
   using Mat9 = Eigen::Matrix<double, 9, 9>;
@@ -106,8 +108,10 @@ void EightPointSolver::Solve
   using Mat9 = Eigen::Matrix<double, 9, 9>;
   // Set up the homogeneous system Af = 0 from the equations x'T*F*x = 0.
   MatX9 epipolar_constraint = MatX9::Zero((x1.cols() == 8) ? 9 : x1.cols(), 9);
-  EncodeEpipolarEquation(x1.colwise().homogeneous(),
-                         x2.colwise().homogeneous(),
+  // (the homogeneous points are evaluated once, an element access to the
+  //  homogeneous expression would evaluate it entirely)
+  EncodeEpipolarEquation(Mat3X(x1.colwise().homogeneous()),
+                         Mat3X(x2.colwise().homogeneous()),
                          &epipolar_constraint);
   // Find the F matrice in the nullspace of epipolar_constraint.
   Eigen::SelfAdjointEigenSolver<Mat9> solver
@@ -165,6 +169,63 @@ double EpipolarDistanceError::Error
   return Square(F_x.dot(y.homogeneous())) /  F_x.head<2>().squaredNorm();
 }
 
+// The batch versions compute the same expressions with Eigen array
+//  expressions over the contiguous coordinate rows (vectorized evaluation).
+
+void SampsonError::Errors
+(
+  const Mat3 &F, const RMat2X &x, const RMat2X &y, std::vector<double> &errors
+)
+{
+  const auto x_0 = x.row(0).array(), x_1 = x.row(1).array();
+  const auto y_0 = y.row(0).array(), y_1 = y.row(1).array();
+  const auto F_x_0 = F(0,0) * x_0 + F(0,1) * x_1 + F(0,2);
+  const auto F_x_1 = F(1,0) * x_0 + F(1,1) * x_1 + F(1,2);
+  const auto F_x_2 = F(2,0) * x_0 + F(2,1) * x_1 + F(2,2);
+  const auto Ft_y_0 = F(0,0) * y_0 + F(1,0) * y_1 + F(2,0);
+  const auto Ft_y_1 = F(0,1) * y_0 + F(1,1) * y_1 + F(2,1);
+  errors.resize(x.cols());
+  Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic>>(errors.data(), errors.size()) =
+    (y_0 * F_x_0 + y_1 * F_x_1 + F_x_2).square()
+    / (F_x_0.square() + F_x_1.square() + Ft_y_0.square() + Ft_y_1.square());
+}
+
+void SymmetricEpipolarDistanceError::Errors
+(
+  const Mat3 &F, const RMat2X &x, const RMat2X &y, std::vector<double> &errors
+)
+{
+  const auto x_0 = x.row(0).array(), x_1 = x.row(1).array();
+  const auto y_0 = y.row(0).array(), y_1 = y.row(1).array();
+  const auto F_x_0 = F(0,0) * x_0 + F(0,1) * x_1 + F(0,2);
+  const auto F_x_1 = F(1,0) * x_0 + F(1,1) * x_1 + F(1,2);
+  const auto F_x_2 = F(2,0) * x_0 + F(2,1) * x_1 + F(2,2);
+  const auto Ft_y_0 = F(0,0) * y_0 + F(1,0) * y_1 + F(2,0);
+  const auto Ft_y_1 = F(0,1) * y_0 + F(1,1) * y_1 + F(2,1);
+  errors.resize(x.cols());
+  Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic>>(errors.data(), errors.size()) =
+    ((y_0 * F_x_0 + y_1 * F_x_1 + F_x_2).square()
+     * ((F_x_0.square() + F_x_1.square()).inverse()
+        + (Ft_y_0.square() + Ft_y_1.square()).inverse())
+     / 4.0);
+}
+
+void EpipolarDistanceError::Errors
+(
+  const Mat3 &F, const RMat2X &x, const RMat2X &y, std::vector<double> &errors
+)
+{
+  const auto x_0 = x.row(0).array(), x_1 = x.row(1).array();
+  const auto y_0 = y.row(0).array(), y_1 = y.row(1).array();
+  const auto F_x_0 = F(0,0) * x_0 + F(0,1) * x_1 + F(0,2);
+  const auto F_x_1 = F(1,0) * x_0 + F(1,1) * x_1 + F(1,2);
+  const auto F_x_2 = F(2,0) * x_0 + F(2,1) * x_1 + F(2,2);
+  errors.resize(x.cols());
+  Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic>>(errors.data(), errors.size()) =
+    ((F_x_0 * y_0 + F_x_1 * y_1 + F_x_2).square()
+     / (F_x_0.square() + F_x_1.square()));
+}
+
 }  // namespace kernel
 }  // namespace fundamental
 }  // namespace openMVG
@@ -93,16 +93,21 @@ inline void EncodeEpipolarEquation(const TMatX &x1, const TMatX &x2, TMatA *A) {
 }
 
 /// Compute SampsonError related to the Fundamental matrix and 2 correspondences
+/// The Errors function evaluates the residuals of a set of correspondences
+///  stored as row major 2xN matrices (each coordinate row is contiguous).
 struct SampsonError {
   static double Error(const Mat3 &F, const Vec2 &x, const Vec2 &y);
+  static void Errors(const Mat3 &F, const RMat2X &x, const RMat2X &y, std::vector<double> &errors);
 };
 
 struct SymmetricEpipolarDistanceError {
   static double Error(const Mat3 &F, const Vec2 &x, const Vec2 &y);
+  static void Errors(const Mat3 &F, const RMat2X &x, const RMat2X &y, std::vector<double> &errors);
 };
 
 struct EpipolarDistanceError {
   static double Error(const Mat3 &F, const Vec2 &x, const Vec2 &y);
+  static void Errors(const Mat3 &F, const RMat2X &x, const RMat2X &y, std::vector<double> &errors);
 };
 
 //-- Kernel solver for the 8pt Fundamental Matrix Estimation
@@ -34,6 +34,8 @@
 
 #include "testing/testing.h"
 
+#include <algorithm>
+#include <limits>
 #include <numeric>
 
 using namespace openMVG;
@@ -141,6 +143,36 @@ TEST(EightPointTest_Normalized, EasyCase) {
   EXPECT_TRUE(ExpectKernelProperties<Kernel>(x1, x2));
 }
 
+// Return the largest relative difference between the batch residual
+//  evaluation and the point by point residuals
+template<typename ErrorT>
+double BatchErrorsMaxDifference(const Mat3 & F, const Mat2X & x1, const Mat2X & x2)
+{
+  std::vector<double> errors;
+  ErrorT::Errors(F, RMat2X(x1), RMat2X(x2), errors);
+  if (errors.size() != static_cast<size_t>(x1.cols()))
+    return std::numeric_limits<double>::infinity();
+  double max_difference = 0.0;
+  for (Mat::Index i = 0; i < x1.cols(); ++i)
+  {
+    const double error = ErrorT::Error(F, x1.col(i), x2.col(i));
+    max_difference = std::max(max_difference,
+      std::abs(error - errors[i]) / std::max(1.0, error));
+  }
+  return max_difference;
+}
+
+TEST(Fundamental, BatchErrors) {
+  const Mat3 F = Mat3::Random();
+  const Mat2X x1 = Mat2X::Random(2, 101), x2 = Mat2X::Random(2, 101);
+  EXPECT_NEAR(0.0,
+    BatchErrorsMaxDifference<fundamental::kernel::SampsonError>(F, x1, x2), 1e-10);
+  EXPECT_NEAR(0.0,
+    BatchErrorsMaxDifference<fundamental::kernel::SymmetricEpipolarDistanceError>(F, x1, x2), 1e-10);
+  EXPECT_NEAR(0.0,
+    BatchErrorsMaxDifference<fundamental::kernel::EpipolarDistanceError>(F, x1, x2), 1e-10);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -60,6 +60,23 @@ struct AsymmetricError {
   static double Error(const Mat &H, const Vec2 &x, const Vec2 &y) {
     return (y - Vec3( H * x.homogeneous()).hnormalized() ).squaredNorm();
   }
+
+  // Evaluate the residuals of a set of correspondences stored as
+  //  row major 2xN matrices (each coordinate row is contiguous)
+  static void Errors
+  (
+    const Mat3 &H, const RMat2X &x, const RMat2X &y, std::vector<double> &errors
+  )
+  {
+    const auto x_0 = x.row(0).array(), x_1 = x.row(1).array();
+    const auto H_x_0 = H(0,0) * x_0 + H(0,1) * x_1 + H(0,2);
+    const auto H_x_1 = H(1,0) * x_0 + H(1,1) * x_1 + H(1,2);
+    const auto H_x_2 = H(2,0) * x_0 + H(2,1) * x_1 + H(2,2);
+    errors.resize(x.cols());
+    Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic>>(errors.data(), errors.size()) =
+      (y.row(0).array() - H_x_0 / H_x_2).square()
+      + (y.row(1).array() - H_x_1 / H_x_2).square();
+  }
 };
 
 // Kernel that works on original data point
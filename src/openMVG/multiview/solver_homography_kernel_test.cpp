@@ -114,6 +114,20 @@ TEST(HomographyKernelTest, Fitting_Normalized) {
   }
 }
 
+TEST(HomographyKernelTest, BatchErrors) {
+  Mat3 H = Mat3::Random();
+  H(2,2) = 5.0; // keep the points in front of the camera
+  const Mat2X x1 = Mat2X::Random(2, 101), x2 = Mat2X::Random(2, 101);
+  std::vector<double> errors;
+  homography::kernel::AsymmetricError::Errors(H, RMat2X(x1), RMat2X(x2), errors);
+  CHECK_EQUAL(x1.cols(), errors.size());
+  for (Mat::Index i = 0; i < x1.cols(); ++i)
+  {
+    const double error = homography::kernel::AsymmetricError::Error(H, x1.col(i), x2.col(i));
+    EXPECT_NEAR(error, errors[i], 1e-10 * std::max(1.0, error));
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
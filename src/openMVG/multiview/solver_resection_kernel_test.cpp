@@ -212,6 +212,22 @@ TEST(UP2PSolver_Kukelova, Multiview) {
   }
 }
 
+TEST(Resection_Kernel, BatchErrors) {
+  const NViewDataSet d = NRealisticCamerasRing(1, 101,
+    nViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+  // Perturb the projection matrix to get non null residuals
+  const Mat34 P = d.P(0) + Mat34::Constant(1e-3);
+  std::vector<double> errors;
+  resection::SquaredPixelReprojectionError::Errors(P, RMat2X(d._x[0]), RMat3X(d._X), errors);
+  CHECK_EQUAL(d._X.cols(), errors.size());
+  for (Mat::Index i = 0; i < d._X.cols(); ++i)
+  {
+    EXPECT_NEAR(
+      resection::SquaredPixelReprojectionError::Error(P, d._x[0].col(i), d._X.col(i)),
+      errors[i], 1e-10);
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -9,6 +9,10 @@
 #ifndef OPENMVG_MULTIVIEW_RESECTION_METRICS_HPP
 #define OPENMVG_MULTIVIEW_RESECTION_METRICS_HPP
 
+#include <vector>
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+
 namespace openMVG {
 namespace resection {
 
@@ -36,6 +40,26 @@ struct SquaredPixelReprojectionError {
   {
     return (x - (P * X.homogeneous()).hnormalized()).squaredNorm();
   }
+
+  // Compute the Square residuals of a set of correspondences stored as
+  //  row major matrices (each coordinate row is contiguous)
+  static inline void Errors
+  (
+    const Mat34 & P,
+    const RMat2X & x,
+    const RMat3X & X,
+    std::vector<double> & errors
+  )
+  {
+    const auto X_0 = X.row(0).array(), X_1 = X.row(1).array(), X_2 = X.row(2).array();
+    const auto P_X_0 = P(0,0) * X_0 + P(0,1) * X_1 + P(0,2) * X_2 + P(0,3);
+    const auto P_X_1 = P(1,0) * X_0 + P(1,1) * X_1 + P(1,2) * X_2 + P(1,3);
+    const auto P_X_2 = P(2,0) * X_0 + P(2,1) * X_1 + P(2,2) * X_2 + P(2,3);
+    errors.resize(x.cols());
+    Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic>>(errors.data(), errors.size()) =
+      (x.row(0).array() - P_X_0 / P_X_2).square()
+      + (x.row(1).array() - P_X_1 / P_X_2).square();
+  }
 };
 
 struct AngularReprojectionError {
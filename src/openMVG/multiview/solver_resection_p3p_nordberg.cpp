@@ -272,7 +272,7 @@ static void eigwithknown0(const Mat3 &x, Mat3 &E, Vec3 &L)
 *
 * @param[in] bearing_vectors 3x3 matrix with UNITARY feature vectors (each column is a vector)
 * @param[in] X  3x3 matrix with corresponding 3D world points (each column is a point)
-* @param[out] rotation_translation_solutions vector that will contain the solutions (up to 4 solutions)
+* @param[out] models vector where the solutions are appended as [R|t] poses (up to 4 solutions)
 *
 * @return true if at least one solution is found, false if no solution was found
 *
@@ -280,7 +280,7 @@ static void eigwithknown0(const Mat3 &x, Mat3 &E, Vec3 &L)
 bool computePosesNordberg(
     const Mat &bearing_vectors,
     const Mat &X,
-    std::vector<std::tuple<Mat3, Vec3>> &rotation_translation_solutions)
+    std::vector<Mat34> *models)
 {
   // Extraction of 3D points vectors
   const Vec3 & P1 = X.col(0);
@@ -465,7 +465,12 @@ bool computePosesNordberg(
             yd1(2), yd2(2), yd1xd2(2);
 
     const Mat3 Rs = Ymat * Xmat;
-    rotation_translation_solutions.emplace_back(Rs, ry1 - Rs * P1);
+    Mat34 P;
+    P_From_KRt(Mat3::Identity(), // intrinsics
+               Rs,               // rotation
+               ry1 - Rs * P1,    // translation
+               &P);
+    models->push_back(P);
   }
 
   return valid > 0;
@@ -479,18 +484,8 @@ void P3PSolver_Nordberg::Solve(
   assert(3 == bearing_vectors.rows());
   assert(3 == X.rows());
   assert(bearing_vectors.cols() == X.cols());
-  std::vector<std::tuple<Mat3, Vec3>> rotation_translation_solutions;
-  if (computePosesNordberg(bearing_vectors, X, rotation_translation_solutions))
-  {
-    for (const auto & rot_trans_it : rotation_translation_solutions) {
-      Mat34 P;
-      P_From_KRt(Mat3::Identity(),           // intrinsics
-                  std::get<0>(rot_trans_it), // rotation
-                  std::get<1>(rot_trans_it), // translation
-                  &P);
-      models->push_back(P);
-    }
-  }
+  // The solutions are directly appended to the caller model buffer
+  computePosesNordberg(bearing_vectors, X, models);
 };
 
 } // namespace euclidean_resection
@@ -127,6 +127,14 @@ namespace openMVG
   /// 4xN matrix using double internal format
   using Mat4X = Eigen::Matrix<double, 4, Eigen::Dynamic>;
 
+  /// 2xN matrix using double internal format with RowMajor storage
+  /// (structure of arrays: each coordinate row is contiguous)
+  using RMat2X = Eigen::Matrix<double, 2, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /// 3xN matrix using double internal format with RowMajor storage
+  /// (structure of arrays: each coordinate row is contiguous)
+  using RMat3X = Eigen::Matrix<double, 3, Eigen::Dynamic, Eigen::RowMajor>;
+
   /// Nx9 matrix using double internal format
   using MatX9 = Eigen::Matrix<double, Eigen::Dynamic, 9>;
 
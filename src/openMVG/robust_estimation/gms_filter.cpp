@@ -8,6 +8,10 @@
 
 #include <openMVG/robust_estimation/gms_filter.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 namespace openMVG {
 namespace robust {
 
@@ -52,145 +56,132 @@ static const std::array<double, 5> kScaleRatios = {
   { 1.0, 1.0 / 2.0, 1.0 / sqrt(2.0), sqrt(2.0), 2.0 }
 };
 
-GMSFilter::GMSFilter
-(
-  const std::vector<Eigen::Vector2f> & point_positions1,
-  const std::pair<int,int> & image_size1,
-  const std::vector<Eigen::Vector2f> & point_positions2,
-  const std::pair<int,int> & image_size2,
-  const matching::IndMatches & matches,
-  const int threshold_factor
-):
-  point_positions1_(point_positions1),
-  point_positions2_(point_positions2),
-  matches_indexes_(matches),
-  // Grid initialization
-  left_grid_size_(kGridSize, kGridSize),
-  left_grid_count_(left_grid_size_.first * left_grid_size_.second),
-  threshold_factor_(threshold_factor)
-{
-  // Normalize the points position to [{0,1};{0,1}]
-  NormalizePoints(image_size1, point_positions1_);
-  NormalizePoints(image_size2, point_positions2_);
+// Size of the left grid (the right grid size depends of the scale)
+static const int kGridSize = 20;
 
-  // Initialize the right grid neighbor indexes
-  left_neighbor_grid_indexes_.resize(left_grid_count_);
-  InitalizeGridNeighborhood(left_neighbor_grid_indexes_, left_grid_size_);
-};
+namespace {
 
-void GMSFilter::NormalizePoints
-(
-  const std::pair<int, int> & image_size,
-  std::vector<Eigen::Vector2f> & points
-) const
+/// A regular grid of cells over the normalized image domain
+struct Grid
 {
-  for (auto & kp : points)
+  int width, height;
+  // 3x3 neighbor indexes of each cell (-1 for the cells outside the grid)
+  std::vector<std::array<int, 9>> neighbors;
+
+  Grid(const int grid_width, const int grid_height)
+    : width(grid_width), height(grid_height), neighbors(grid_width * grid_height)
   {
-    kp.x() /= static_cast<float>(image_size.first);
-    kp.y() /= static_cast<float>(image_size.second);
+    for (int idx = 0; idx < static_cast<int>(neighbors.size()); ++idx)
+    {
+      const int idx_x = idx % width;
+      const int idx_y = idx / width;
+      for (const int yi : {-1, 0, 1})
+      {
+        const int idx_yy = idx_y + yi;
+        for (const int xi : {-1, 0, 1})
+        {
+          const int idx_xx = idx_x + xi;
+          const int index_NB9 = 4 + xi + yi * 3;
+          if (idx_xx < 0 || idx_xx >= width ||
+              idx_yy < 0 || idx_yy >= height)
+            neighbors[idx][index_NB9] = -1;
+          else
+            neighbors[idx][index_NB9] = idx_xx + idx_yy * width;
+        }
+      }
+    }
   }
-}
 
-void GMSFilter::InitalizeGridNeighborhood
-(
-  std::vector<std::array<int,9>> & neighborhood_grid_indexes,
-  const std::pair<int, int> & grid_size
-) const
-{
-  for (int i = 0; i < static_cast<int>(neighborhood_grid_indexes.size()); ++i)
+  int CellCount() const { return width * height; }
+
+  ///  @brief Compute the cell index of a normalized point position
+  ///   (-1 if the point is outside of the grid)
+  ///
+  ///  @param [in] pt         The normalized point position
+  ///  @param [in] x_offset   Grid offset (in cell unit) along x
+  ///  @param [in] y_offset   Grid offset (in cell unit) along y
+  int CellIndex
+  (
+    const Eigen::Vector2f & pt,
+    const double x_offset = 0.,
+    const double y_offset = 0.
+  ) const
   {
-    neighborhood_grid_indexes[i] = GetNB9(i, grid_size);
+    const int x = std::floor(pt.x() * width  + x_offset);
+    const int y = std::floor(pt.y() * height + y_offset);
+
+    // Be sure that the point still belong to the grid bounds
+    if (x >= width || y >= height || x < 0 || y < 0)
+    {
+      return -1;
+    }
+    return x + y * width;
   }
-}
+};
 
-void GMSFilter::InitalizeRightGridNeighborhoodWithScale
-(
-  int scale
-)
+/// The left grid and the right grids of the 5 scales.
+/// Computed once and shared by all the GMSFilter instances.
+const std::array<Grid, 6> & GMSGrids()
 {
-  // Set Scale
-  right_grid_size_.first  = left_grid_size_.first  * kScaleRatios[scale];
-  right_grid_size_.second = left_grid_size_.second * kScaleRatios[scale];
-  right_grid_count_ = right_grid_size_.first * right_grid_size_.second;
-  right_neighbor_grid_indexes_.resize(right_grid_count_);
-  InitalizeGridNeighborhood(right_neighbor_grid_indexes_, right_grid_size_);
+  static const std::array<Grid, 6> grids =
+  {{
+    Grid(kGridSize, kGridSize),
+    Grid(kGridSize * kScaleRatios[0], kGridSize * kScaleRatios[0]),
+    Grid(kGridSize * kScaleRatios[1], kGridSize * kScaleRatios[1]),
+    Grid(kGridSize * kScaleRatios[2], kGridSize * kScaleRatios[2]),
+    Grid(kGridSize * kScaleRatios[3], kGridSize * kScaleRatios[3]),
+    Grid(kGridSize * kScaleRatios[4], kGridSize * kScaleRatios[4])
+  }};
+  return grids;
 }
 
-int GMSFilter::GetGridIndexLeft
-(
-  const Eigen::Vector2f & pt,
-  int type
-) const
+} // namespace
+
+struct GMSFilter::Workspace
 {
-  // Moving the point according the asked direction
-  // (1:center, 2:East, 3:South, 4:SEst)
-  // C -> E
-  // | \
-  // S   SE
-  const double x_offset = (type == 2 || type == 4) ? 0.5 : 0;
-  const double y_offset = (type == 3 || type == 4) ? 0.5 : 0;
-
-  const int x = std::floor(pt.x() * left_grid_size_.first  + x_offset);
-  const int y = std::floor(pt.y() * left_grid_size_.second + y_offset);
-
-  // Be sure that the point still belong to the grid bounds
-  if (x >= left_grid_size_.first ||
-      y >= left_grid_size_.second ||
-      x < 0 ||
-      y < 0)
-  {
-    return -1;
-  }
+  // Number of matches from a left cell to a right cell
+  //  (index: left_cell * right_cell_count + right_cell).
+  // The array is kept to zero between two runs: only the used cells are reset.
+  std::vector<int> motion_statistics;
 
-  return x + y * left_grid_size_.first;
-}
+  // Number of point per left cell
+  std::vector<int> nb_points_per_left_cell;
 
-int GMSFilter::GetGridIndexRight
-(
-  const Eigen::Vector2f & pt
-) const
-{
-  const int x = std::floor(pt.x() * right_grid_size_.first);
-  const int y = std::floor(pt.y() * right_grid_size_.second);
-
-  // Be sure that the point is not out of bounds
-  if (x >= right_grid_size_.first ||
-      y >= right_grid_size_.second ||
-      x < 0 ||
-      y < 0)
-  {
-    return -1;
-  }
+  // Index  : grid_idx_left
+  // Value  : grid_idx_right (and its number of matches)
+  std::vector<int> cell_pairs, cell_pairs_count;
 
-  return x + y * right_grid_size_.first;
-}
+  // Every Matches has a cell-pair
+  // first  : grid_idx_left
+  // second : grid_idx_right
+  std::vector<std::pair<int, int>> match_cell_pairs;
+
+  // Inlier Mask of the current run and of the best run
+  std::vector<bool> inlier_mask, best_inlier_mask;
+};
 
-std::array<int, 9> GMSFilter::GetNB9
+GMSFilter::GMSFilter
 (
-  const int idx,
-  const std::pair<int, int> & grid_size
-) const
+  const std::vector<Eigen::Vector2f> & point_positions1,
+  const std::pair<int,int> & image_size1,
+  const std::vector<Eigen::Vector2f> & point_positions2,
+  const std::pair<int,int> & image_size2,
+  const matching::IndMatches & matches,
+  const int threshold_factor
+):
+  match_positions1_(matches.size()),
+  match_positions2_(matches.size()),
+  threshold_factor_(threshold_factor)
 {
-  std::array<int, 9> NB9;
-
-  const int idx_x = idx % grid_size.first;
-  const int idx_y = idx / grid_size.first;
-
-  for (const int yi : {-1, 0, 1})
+  // Normalize the matched points position to [{0,1};{0,1}]
+  const Eigen::Vector2f
+    size1(image_size1.first, image_size1.second),
+    size2(image_size2.first, image_size2.second);
+  for (size_t i = 0; i < matches.size(); ++i)
   {
-    const int idx_yy = idx_y + yi;
-    for (const int xi : {-1, 0, 1})
-    {
-      const int idx_xx = idx_x + xi;
-      const int index_NB9 = 4 + xi + yi * 3;
-      if (idx_xx < 0 || idx_xx >= grid_size.first ||
-          idx_yy < 0 || idx_yy >= grid_size.second)
-        NB9[index_NB9] = -1;
-      else
-        NB9[index_NB9] = idx_xx + idx_yy * grid_size.first;
-    }
+    match_positions1_[i] = point_positions1[matches[i].i_].cwiseQuotient(size1);
+    match_positions2_[i] = point_positions2[matches[i].j_].cwiseQuotient(size2);
   }
-  return NB9;
 }
 
 int GMSFilter::GetInlierMask
@@ -198,10 +189,8 @@ int GMSFilter::GetInlierMask
   std::vector<bool> & inlier_mask,
   const bool scale_invariance,
   const bool rotation_invariance
-)
+) const
 {
-  int max_inlier = 0;
-
   const std::vector<int> scales_idx = scale_invariance ?
     std::vector<int>({0, 1, 2, 3, 4}) :
     std::vector<int>({0});
@@ -210,132 +199,162 @@ int GMSFilter::GetInlierMask
     std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8}) :
     std::vector<int>({1});
 
-  for (const auto & scale_it : scales_idx)
+  // Keep the first (scale, rotation) run that has the most inliers
+  const int run_count = scales_idx.size() * rotations_idx.size();
+  int max_inlier = 0, best_run = run_count;
+  inlier_mask.assign(match_positions1_.size(), false);
+
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
   {
-    InitalizeRightGridNeighborhoodWithScale(scale_it);
-    for (const auto & rotation_it : rotations_idx)
+    // The buffers are reused by the next filters run on this thread
+    static thread_local Workspace workspace;
+    int thread_max_inlier = 0, thread_best_run = run_count;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int run = 0; run < run_count; ++run)
     {
-      const int num_inlier = Run(rotation_it, scale_it);
-      if (num_inlier > max_inlier)
+      const int num_inlier = Run(
+        rotations_idx[run % rotations_idx.size()],
+        scales_idx[run / rotations_idx.size()],
+        workspace);
+      // A thread processes its runs by increasing index
+      if (num_inlier > thread_max_inlier)
       {
-        inlier_mask = inlier_mask_;
-        max_inlier = num_inlier;
+        thread_max_inlier = num_inlier;
+        thread_best_run = run;
+        std::swap(workspace.best_inlier_mask, workspace.inlier_mask);
+      }
+    }
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    {
+      if (thread_max_inlier > max_inlier ||
+          (thread_max_inlier == max_inlier && thread_best_run < best_run))
+      {
+        max_inlier = thread_max_inlier;
+        best_run = thread_best_run;
+        if (max_inlier > 0)
+          inlier_mask = workspace.best_inlier_mask;
       }
     }
   }
   return max_inlier;
 }
 
-void GMSFilter::AssignMatchPairs(int grid_type)
+int GMSFilter::Run
+(
+  int rotation_type,
+  int scale,
+  Workspace & workspace
+) const
 {
-  for (size_t i = 0; i < matches_indexes_.size(); ++i)
-  {
-    const auto & lp = point_positions1_[matches_indexes_[i].i_];
-    const auto & rp = point_positions2_[matches_indexes_[i].j_];
-
-    const int lgidx = match_cell_pairs_[i].first = GetGridIndexLeft(lp, grid_type);
-    if (lgidx == -1) continue;
-    const int rgidx = match_cell_pairs_[i].second = GetGridIndexRight(rp);
-    if (rgidx == -1) continue;
-
-    ++motion_statistics_(lgidx,rgidx);
-    ++nb_points_per_left_cell_[lgidx];
-  }
-}
+  const Grid & left_grid = GMSGrids()[0];
+  const Grid & right_grid = GMSGrids()[1 + scale];
+  const int left_grid_count = left_grid.CellCount();
+  const int right_grid_count = right_grid.CellCount();
+  const auto & rotation_permutations = kRotationPatterns[rotation_type - 1];
+
+  const auto number_of_matches = match_positions1_.size();
+  workspace.inlier_mask.assign(number_of_matches, false);
+  workspace.match_cell_pairs.resize(number_of_matches);
+  if (workspace.motion_statistics.size() < static_cast<size_t>(left_grid_count * right_grid_count))
+    workspace.motion_statistics.resize(left_grid_count * right_grid_count, 0);
+  int * motion_statistics = workspace.motion_statistics.data();
 
-void GMSFilter::VerifyCellPairs(int rotation_type)
-{
-  for (int i = 0; i < left_grid_count_; ++i)
+  for (const int grid_type_it : {1, 2, 3, 4})
   {
-    if (motion_statistics_.row(i).sum() == 0)
+    // Initialize arrays
+    workspace.cell_pairs.assign(left_grid_count, -1);
+    workspace.cell_pairs_count.assign(left_grid_count, 0);
+    workspace.nb_points_per_left_cell.assign(left_grid_count, 0);
+
+    // Accumulate motion statistics for the match_pairs and the grid type:
+    //  The left grid is moved of half a cell according the grid type
+    //  (1:center, 2:East, 3:South, 4:South-East)
+    const double x_offset = (grid_type_it == 2 || grid_type_it == 4) ? 0.5 : 0;
+    const double y_offset = (grid_type_it == 3 || grid_type_it == 4) ? 0.5 : 0;
+    for (size_t i = 0; i < number_of_matches; ++i)
     {
-      cell_pairs_[i] = -1;
-      continue;
+      auto & cell_pair = workspace.match_cell_pairs[i];
+      cell_pair.first = left_grid.CellIndex(match_positions1_[i], x_offset, y_offset);
+      cell_pair.second = (cell_pair.first == -1) ? -1 : right_grid.CellIndex(match_positions2_[i]);
+      if (cell_pair.second == -1) continue;
+
+      ++motion_statistics[cell_pair.first * right_grid_count + cell_pair.second];
+      ++workspace.nb_points_per_left_cell[cell_pair.first];
     }
 
-    int max_number (0);
-    for (int j = 0; j < right_grid_count_; j++)
+    // Find the right cell with the most matches for each left cell
+    //  (the smallest right cell index in case of equality)
+    for (const auto & cell_pair : workspace.match_cell_pairs)
     {
-      if (motion_statistics_(i,j) > max_number)
+      if (cell_pair.second == -1) continue;
+      const int count = motion_statistics[cell_pair.first * right_grid_count + cell_pair.second];
+      int & best_count = workspace.cell_pairs_count[cell_pair.first];
+      int & best_cell = workspace.cell_pairs[cell_pair.first];
+      if (count > best_count || (count == best_count && cell_pair.second < best_cell))
       {
-        cell_pairs_[i] = j;
-        max_number     = motion_statistics_(i,j);
+        best_count = count;
+        best_cell = cell_pair.second;
       }
     }
 
-    const int idx_grid_rt = cell_pairs_[i];
-
-    const auto & NB9_lt = left_neighbor_grid_indexes_[i];
-    const auto & NB9_rt = right_neighbor_grid_indexes_[idx_grid_rt];
-
-    int score (0);
-    double thresh (0.0);
-    int numpair (0);
-
-    // Aggregate statistics for the neighborhood grids
-    for (const int j : {0, 1, 2, 3, 4, 5, 6, 7, 8})
+    // Verify Cell Pairs:
+    //  Threshold the aggregate statistics for the neighborhood grids.
+    for (int i = 0; i < left_grid_count; ++i)
     {
-      const auto & rotation_permutations = kRotationPatterns[rotation_type - 1];
-      const int ll = NB9_lt[j];
-      const int rr = NB9_rt[rotation_permutations[j] - 1];
-      if (ll == -1 || rr == -1)
+      if (workspace.cell_pairs[i] == -1)
         continue;
 
-      score += motion_statistics_(ll, rr);
-      thresh += nb_points_per_left_cell_[ll];
-      ++numpair;
-    }
-    if (numpair != 0)
-    {
-      thresh = threshold_factor_ * std::sqrt(thresh / static_cast<double>(numpair));
-    }
-
-    // Discard the match if it have a lower threshold or not computed statistics
-    if (score < thresh || numpair == 0)
-    {
-      cell_pairs_[i] = -2;
-    }
-  }
-}
-
-int GMSFilter::Run
-(
-  int rotation_type,
-  int scale
-)
-{
-  const auto number_of_matches = matches_indexes_.size();
-
-  inlier_mask_.assign(number_of_matches, false);
+      const auto & NB9_lt = left_grid.neighbors[i];
+      const auto & NB9_rt = right_grid.neighbors[workspace.cell_pairs[i]];
 
-  // Initialize motion statistics
-  match_cell_pairs_.assign(number_of_matches, {0, 0});
-  motion_statistics_ = Mati::Zero(left_grid_count_, right_grid_count_);
+      int score (0);
+      double thresh (0.0);
+      int numpair (0);
 
-  for (const int grid_type_it : {1, 2, 3, 4})
-  {
-    // Initialize arrays
-    motion_statistics_.fill(0);
-    cell_pairs_.assign(left_grid_count_, -1);
-    nb_points_per_left_cell_.assign(left_grid_count_, 0);
+      // Aggregate statistics for the neighborhood grids
+      for (const int j : {0, 1, 2, 3, 4, 5, 6, 7, 8})
+      {
+        const int ll = NB9_lt[j];
+        const int rr = NB9_rt[rotation_permutations[j] - 1];
+        if (ll == -1 || rr == -1)
+          continue;
+
+        score += motion_statistics[ll * right_grid_count + rr];
+        thresh += workspace.nb_points_per_left_cell[ll];
+        ++numpair;
+      }
+      if (numpair != 0)
+      {
+        thresh = threshold_factor_ * std::sqrt(thresh / static_cast<double>(numpair));
+      }
 
-    // Compute and verify motion statistics
-    AssignMatchPairs(grid_type_it);
-    VerifyCellPairs(rotation_type);
+      // Discard the match if it have a lower threshold or not computed statistics
+      if (score < thresh || numpair == 0)
+      {
+        workspace.cell_pairs[i] = -2;
+      }
+    }
 
-    // Mark inliers
+    // Mark inliers and reset the used motion statistics
     for (size_t i = 0; i < number_of_matches; ++i)
     {
-      if (match_cell_pairs_[i].first  >= 0 &&
-          match_cell_pairs_[i].second >= 0 &&
-          cell_pairs_[match_cell_pairs_[i].first] == match_cell_pairs_[i].second)
+      const auto & cell_pair = workspace.match_cell_pairs[i];
+      if (cell_pair.second == -1) continue;
+      if (workspace.cell_pairs[cell_pair.first] == cell_pair.second)
       {
-        inlier_mask_[i] = true;
+        workspace.inlier_mask[i] = true;
       }
+      motion_statistics[cell_pair.first * right_grid_count + cell_pair.second] = 0;
     }
   }
   // Return the number of inliers
-  return std::count(inlier_mask_.cbegin(), inlier_mask_.cend(), true);
+  return std::count(workspace.inlier_mask.cbegin(), workspace.inlier_mask.cend(), true);
 }
 
 } // namespace robust
@@ -187,6 +187,49 @@ TEST(GMSFilter, OutlierDetection)
   EXPECT_EQ(6, std::count(inlier_flags.cbegin(), inlier_flags.cbegin() + 6, false));
 }
 
+TEST(GMSFilter, RotatedScaledFlowField)
+{
+  const int kImageSize = 200;
+  const int kBorder = 20;
+  // Generate a lot of point (GMS is working only if dense motion statistic can be computed)
+  const int kNbPoints = (kImageSize * kImageSize) * 0.1;
+  std::vector<Eigen::Vector2f> vec_point_left(kNbPoints), vec_point_right(kNbPoints);
+  matching::IndMatches matches;
+  GenerateCorrespondingPoints(
+    kImageSize, kBorder, kNbPoints, vec_point_left, vec_point_right, matches);
+
+  // The right image is rotated by 90 degrees and downscaled by 2
+  const std::pair<int, int> kRightImageSize = {kImageSize / 2, kImageSize / 2};
+  for (auto & pt : vec_point_right)
+  {
+    pt = Vec2f(kImageSize - pt.y(), pt.x()) / 2.f;
+  }
+
+  robust::GMSFilter gms(
+    vec_point_left,  {kImageSize,kImageSize},
+    vec_point_right, kRightImageSize,
+    matches);
+  std::vector<bool> inlier_flags;
+  // Without the invariances the motion cannot be explained
+  const int num_inliers = gms.GetInlierMask(inlier_flags, false, false);
+  CHECK(num_inliers < .1 * kNbPoints);
+
+  // The rotation and the scale are found among the tested grids
+  std::vector<bool> invariant_inlier_flags;
+  const int num_invariant_inliers = gms.GetInlierMask(invariant_inlier_flags, true, true);
+  CHECK(num_invariant_inliers > .98 * kNbPoints);
+  EXPECT_EQ(kNbPoints, invariant_inlier_flags.size());
+
+  // Same result with a new filter (the per thread buffers are reused)
+  robust::GMSFilter gms_copy(
+    vec_point_left,  {kImageSize,kImageSize},
+    vec_point_right, kRightImageSize,
+    matches);
+  std::vector<bool> copy_inlier_flags;
+  EXPECT_EQ(num_invariant_inliers, gms_copy.GetInlierMask(copy_inlier_flags, true, true));
+  EXPECT_TRUE(invariant_inlier_flags == copy_inlier_flags);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
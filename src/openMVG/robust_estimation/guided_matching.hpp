@@ -10,17 +10,191 @@
 #define OPENMVG_ROBUST_ESTIMATION_GUIDED_MATCHING_HPP
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
+#include <numeric>
+#include <typeinfo>
 #include <vector>
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/features/regions.hpp"
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/metric.hpp"
 #include "openMVG/numeric/numeric.h"
+#include "openMVG/robust_estimation/guided_matching_grid.hpp"
 
 namespace openMVG{
+
+// Error metrics for which the guided matching search area is known
+struct AngularError;
+namespace fundamental { namespace kernel {
+struct EpipolarDistanceError;
+struct SymmetricEpipolarDistanceError;
+} }
+namespace homography { namespace kernel { struct AsymmetricError; } }
+
 namespace geometry_aware{
 
+/// Area of the right image where a left point can find its correspondences
+///  (the right points for which ErrorArg::Error(model, xL, xR) < errorTh)
+enum class EGuidedMatchingSearch
+{
+  EXHAUSTIVE,              // Unknown area: all the right points are tested
+  EPIPOLAR_LINE,           // Band around the epipolar line model * xL (squared pixel distance)
+  SYMMETRIC_EPIPOLAR_LINE, // Band around the epipolar line model * xL (symmetric squared pixel distance)
+  PREDICTED_POSITION,      // Ball around the predicted position model * xL (squared pixel distance)
+  GREAT_CIRCLE             // Band around the epipolar great circle model * xL (angular distance)
+};
+
+/// Search area of an error metric (an unknown metric uses an exhaustive search)
+template <typename ErrorArg>
+struct GuidedMatchingSearch
+{
+  static constexpr EGuidedMatchingSearch value = EGuidedMatchingSearch::EXHAUSTIVE;
+};
+
+template <>
+struct GuidedMatchingSearch<fundamental::kernel::EpipolarDistanceError>
+{
+  static constexpr EGuidedMatchingSearch value = EGuidedMatchingSearch::EPIPOLAR_LINE;
+};
+
+template <>
+struct GuidedMatchingSearch<fundamental::kernel::SymmetricEpipolarDistanceError>
+{
+  static constexpr EGuidedMatchingSearch value = EGuidedMatchingSearch::SYMMETRIC_EPIPOLAR_LINE;
+};
+
+template <>
+struct GuidedMatchingSearch<homography::kernel::AsymmetricError>
+{
+  static constexpr EGuidedMatchingSearch value = EGuidedMatchingSearch::PREDICTED_POSITION;
+};
+
+template <>
+struct GuidedMatchingSearch<AngularError>
+{
+  static constexpr EGuidedMatchingSearch value = EGuidedMatchingSearch::GREAT_CIRCLE;
+};
+
+namespace internal {
+
+/// List the right points that can be matched to a left point.
+/// The candidates are listed by increasing index, so the guided matching
+///  gives the same result as an exhaustive search.
+template <typename ModelArg, EGuidedMatchingSearch SEARCH>
+class CandidateSearch
+{
+public:
+  CandidateSearch(const ModelArg &, const Mat & xRight, const double)
+    : count_(xRight.cols())
+  {}
+
+  void Candidates(const Mat &, const Mat::Index, std::vector<uint32_t> & candidates) const
+  {
+    candidates.resize(count_);
+    std::iota(candidates.begin(), candidates.end(), 0);
+  }
+
+private:
+  const Mat::Index count_;
+};
+
+/// Right points that lie in a band of a given half width around the epipolar line
+template <typename ModelArg>
+class EpipolarLineSearch
+{
+public:
+  EpipolarLineSearch(const ModelArg & mod, const Mat & xRight, const double half_width)
+    : mod_(mod), grid_(xRight), half_width_(half_width)
+  {}
+
+  void Candidates(const Mat & xLeft, const Mat::Index i, std::vector<uint32_t> & candidates) const
+  {
+    const Vec3 line = mod_ * Vec2(xLeft.col(i)).homogeneous();
+    const double norm = line.head<2>().norm();
+    if (norm > 0.0)
+      grid_.QuerySlab(line.head<2>() / norm, line(2) / norm, half_width_, candidates);
+    else
+      candidates.clear();
+  }
+
+private:
+  const ModelArg & mod_;
+  const PointGrid<2> grid_;
+  const double half_width_;
+};
+
+// d_R^2 < errorTh, with d_R the distance to the epipolar line in the right image
+template <typename ModelArg>
+class CandidateSearch<ModelArg, EGuidedMatchingSearch::EPIPOLAR_LINE>
+  : public EpipolarLineSearch<ModelArg>
+{
+public:
+  CandidateSearch(const ModelArg & mod, const Mat & xRight, const double errorTh)
+    : EpipolarLineSearch<ModelArg>(mod, xRight, std::sqrt(errorTh))
+  {}
+};
+
+// (d_R^2 + d_L^2) / 4 < errorTh, with d_R and d_L the distances to the
+//  epipolar lines in the right and the left images: d_R < 2 * sqrt(errorTh)
+template <typename ModelArg>
+class CandidateSearch<ModelArg, EGuidedMatchingSearch::SYMMETRIC_EPIPOLAR_LINE>
+  : public EpipolarLineSearch<ModelArg>
+{
+public:
+  CandidateSearch(const ModelArg & mod, const Mat & xRight, const double errorTh)
+    : EpipolarLineSearch<ModelArg>(mod, xRight, 2.0 * std::sqrt(errorTh))
+  {}
+};
+
+template <typename ModelArg>
+class CandidateSearch<ModelArg, EGuidedMatchingSearch::PREDICTED_POSITION>
+{
+public:
+  CandidateSearch(const ModelArg & mod, const Mat & xRight, const double errorTh)
+    : mod_(mod), grid_(xRight), radius_(std::sqrt(errorTh))
+  {}
+
+  void Candidates(const Mat & xLeft, const Mat::Index i, std::vector<uint32_t> & candidates) const
+  {
+    const Vec3 x = mod_ * Vec2(xLeft.col(i)).homogeneous();
+    grid_.QueryBall(x.hnormalized(), radius_, candidates);
+  }
+
+private:
+  const ModelArg & mod_;
+  const PointGrid<2> grid_;
+  const double radius_;
+};
+
+template <typename ModelArg>
+class CandidateSearch<ModelArg, EGuidedMatchingSearch::GREAT_CIRCLE>
+{
+public:
+  // |asin(n.x)| < errorTh <=> |n.x| < sin(errorTh) (for errorTh in [0, PI/2])
+  CandidateSearch(const ModelArg & mod, const Mat & xRight, const double errorTh)
+    : mod_(mod), grid_(xRight), half_width_(std::sin(std::min(errorTh, M_PI / 2.)))
+  {}
+
+  void Candidates(const Mat & xLeft, const Mat::Index i, std::vector<uint32_t> & candidates) const
+  {
+    const Vec3 normal = mod_ * Vec3(xLeft.col(i));
+    const double norm = normal.norm();
+    if (norm > 0.0)
+      grid_.QuerySlab(normal / norm, 0.0, half_width_, candidates);
+    else
+      candidates.clear();
+  }
+
+private:
+  const ModelArg & mod_;
+  const PointGrid<3> grid_;
+  const double half_width_;
+};
+
+} // namespace internal
+
 /// Guided Matching (features only):
 ///  Use a model to find valid correspondences:
 ///   Keep the best corresponding points for the given model under the
@@ -39,28 +213,40 @@ void GuidedMatching(
 
   // Looking for the corresponding points that have
   //  the smallest distance (smaller than the provided Threshold)
-
-  #pragma omp parallel for
-  for (int i = 0; i < xLeft.cols(); ++i) {
-
-    double min = std::numeric_limits<double>::max();
-    matching::IndMatch match;
-    for (size_t j = 0; j < xRight.cols(); ++j) {
-      // Compute the geometric error: error to the model
-      const double err = ErrorArg::Error(
-        mod,  // The model
-        xLeft.col(i), xRight.col(j)); // The corresponding points
-      // if smaller error update corresponding index
-      if (err < errorTh && err < min) {
-        min = err;
-        match = matching::IndMatch(i,j);
+  const internal::CandidateSearch<ModelArg, GuidedMatchingSearch<ErrorArg>::value>
+    search(mod, xRight, errorTh);
+
+  // Best right point of each left point (-1 if none)
+  std::vector<int> best_match(xLeft.cols(), -1);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std::vector<uint32_t> candidates;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int i = 0; i < static_cast<int>(xLeft.cols()); ++i) {
+      search.Candidates(xLeft, i, candidates);
+      double min = std::numeric_limits<double>::max();
+      for (const uint32_t j : candidates) {
+        // Compute the geometric error: error to the model
+        const double err = ErrorArg::Error(
+          mod,  // The model
+          xLeft.col(i), xRight.col(j)); // The corresponding points
+        // if smaller error update corresponding index
+        if (err < errorTh && err < min) {
+          min = err;
+          best_match[i] = static_cast<int>(j);
+        }
       }
     }
-    if (min < errorTh)  {
-      // save the best corresponding index
-      #pragma omp critical
-      vec_corresponding_index.push_back(match);
-    }
+  }
+
+  // save the best corresponding indexes
+  for (size_t i = 0; i < best_match.size(); ++i) {
+    if (best_match[i] >= 0)
+      vec_corresponding_index.emplace_back(i, best_match[i]);
   }
 
   // Remove duplicates (when multiple points at same position exist)
@@ -112,6 +298,94 @@ struct distanceRatio
   }
 };
 
+namespace internal {
+
+/// Guided matching core: for each left point, keep the right point with the
+///  smallest descriptor distance among the candidates that satisfy the model
+///  if its distance ratio to the second best one is valid.
+/// The left points are processed in parallel.
+template<
+  typename ModelArg,          // The used model type
+  typename ErrorArg,          // The metric to compute distance to the model
+  typename DistT,             // The descriptor distance type
+  typename DescriptorDistance>// Functor (i, j) -> descriptor distance
+void GuidedMatching_DistanceRatio(
+  const ModelArg & mod,
+  const Mat & xLeft,
+  const Mat & xRight,
+  double errorTh,
+  double distRatio,
+  const DescriptorDistance & descriptor_distance,
+  matching::IndMatches & vec_corresponding_index)
+{
+  const CandidateSearch<ModelArg, GuidedMatchingSearch<ErrorArg>::value>
+    search(mod, xRight, errorTh);
+
+  // Best right point of each left point (-1 if none)
+  std::vector<int> best_match(xLeft.cols(), -1);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std::vector<uint32_t> candidates;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int i = 0; i < static_cast<int>(xLeft.cols()); ++i) {
+      search.Candidates(xLeft, i, candidates);
+      distanceRatio<DistT> dR;
+      for (const uint32_t j : candidates) {
+        // Compute the geometric error: error to the model
+        const double geomErr = ErrorArg::Error(
+          mod,  // The model
+          xLeft.col(i), xRight.col(j)); // The corresponding points
+        if (geomErr < errorTh) {
+          // Update the corresponding points & distance (if required)
+          dR.update(j, descriptor_distance(i, j));
+        }
+      }
+      // Add correspondence only iff the distance ratio is valid
+      if (dR.isValid(distRatio))
+        best_match[i] = static_cast<int>(dR.idx);
+    }
+  }
+
+  for (size_t i = 0; i < best_match.size(); ++i) {
+    if (best_match[i] >= 0)
+      vec_corresponding_index.emplace_back(i, best_match[i]);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+}
+
+/// Descriptor distance computed on the raw descriptor arrays of two Regions
+template <typename MetricT>
+class RawDescriptorDistance
+{
+public:
+  using ElementT = typename MetricT::ElementType;
+
+  RawDescriptorDistance(const features::Regions & lRegions, const features::Regions & rRegions)
+    : lDescriptors_(static_cast<const ElementT *>(lRegions.DescriptorRawData())),
+      rDescriptors_(static_cast<const ElementT *>(rRegions.DescriptorRawData())),
+      length_(lRegions.DescriptorLength())
+  {}
+
+  typename MetricT::ResultType operator()(const size_t i, const size_t j) const
+  {
+    return metric_(lDescriptors_ + i * length_, rDescriptors_ + j * length_, length_);
+  }
+
+private:
+  const ElementT * lDescriptors_;
+  const ElementT * rDescriptors_;
+  const size_t length_;
+  MetricT metric_;
+};
+
+} // namespace internal
+
 /// Guided Matching (features + descriptors with distance ratio):
 ///  Use a model to find valid correspondences:
 ///   Keep the best corresponding points for the given model under the
@@ -135,36 +409,97 @@ void GuidedMatching(
   assert(xLeft.cols() == lDescriptors.size());
   assert(xRight.cols() == rDescriptors.size());
 
-  MetricT metric;
-
   // Looking for the corresponding points that have to satisfy:
   //   1. a geometric distance below the provided Threshold
   //   2. a distance ratio between descriptors of valid geometric correspondencess
+  const MetricT metric;
+  internal::GuidedMatching_DistanceRatio<ModelArg, ErrorArg, typename MetricT::ResultType>(
+    mod, xLeft, xRight, errorTh, distRatio,
+    [&](const size_t i, const size_t j)
+    {
+      return metric(lDescriptors[i].data(), rDescriptors[j].data(), DescriptorT::static_size);
+    },
+    vec_corresponding_index);
+}
 
-  for (size_t i = 0; i < xLeft.cols(); ++i) {
-
-    distanceRatio<typename MetricT::ResultType > dR;
-    for (size_t j = 0; j < xRight.cols(); ++j) {
-      // Compute the geometric error: error to the model
-      const double geomErr = ErrorArg::Error(
-        mod,  // The model
-        xLeft.col(i), xRight.col(j)); // The corresponding points
-      if (geomErr < errorTh) {
-        const typename MetricT::ResultType descDist =
-          metric( lDescriptors[i].getData(), rDescriptors[j].getData(), DescriptorT::static_size );
-        // Update the corresponding points & distance (if required)
-        dR.update(j, descDist);
-      }
-    }
-    // Add correspondence only iff the distance ratio is valid
-    if (dR.isValid(distRatio))  {
-      // save the best corresponding index
-      vec_corresponding_index.push_back(matching::IndMatch(i,dR.idx));
-    }
-  }
+/// Guided Matching (features + descriptors with distance ratio):
+///  Use a model to find valid correspondences:
+///   Keep the best corresponding points for the given model under the
+///   user specified distance ratio.
+/// The points are given as matrices (i.e. undistorted positions or bearing vectors)
+///  and the descriptors are compared with the default metric of the Regions
+///  (SquaredL2 for scalar, SquaredHamming for binary descriptors).
+template<
+  typename ModelArg,  // The used model type
+  typename ErrorArg   // The metric to compute distance to the model
+  >
+void GuidedMatching(
+  const ModelArg & mod, // The model
+  const Mat & xLeft,    // The left data points
+  const features::Regions & lRegions,  // regions (descriptors of the left data points)
+  const Mat & xRight,   // The right data points
+  const features::Regions & rRegions,  // regions (descriptors of the right data points)
+  double errorTh,       // Maximal authorized error threshold
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  assert(xLeft.rows() == xRight.rows());
+  assert(xLeft.cols() == lRegions.RegionCount());
+  assert(xRight.cols() == rRegions.RegionCount());
 
-  // Remove duplicates (when multiple points at same position exist)
-  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+  if (lRegions.RegionCount() == 0 || rRegions.RegionCount() == 0)
+    return;
+
+  // Looking for the corresponding points that have to satisfy:
+  //   1. a geometric distance below the provided Threshold
+  //   2. a distance ratio between descriptors of valid geometric correspondencess
+  //
+  // The descriptor type is resolved once, in order to use the (SIMD) metrics
+  //  directly on the raw descriptor arrays.
+  const bool same_descriptor_type =
+    lRegions.Type_id() == rRegions.Type_id()
+    && lRegions.IsScalar() == rRegions.IsScalar()
+    && lRegions.DescriptorLength() == rRegions.DescriptorLength();
+
+  if (same_descriptor_type && lRegions.IsScalar()
+      && lRegions.Type_id() == typeid(unsigned char).name())
+  {
+    const internal::RawDescriptorDistance<matching::L2<unsigned char>>
+      metric(lRegions, rRegions);
+    internal::GuidedMatching_DistanceRatio<ModelArg, ErrorArg, double>(
+      mod, xLeft, xRight, errorTh, distRatio, metric, vec_corresponding_index);
+  }
+  else if (same_descriptor_type && lRegions.IsScalar()
+      && lRegions.Type_id() == typeid(float).name())
+  {
+    const internal::RawDescriptorDistance<matching::L2<float>>
+      metric(lRegions, rRegions);
+    internal::GuidedMatching_DistanceRatio<ModelArg, ErrorArg, double>(
+      mod, xLeft, xRight, errorTh, distRatio, metric, vec_corresponding_index);
+  }
+  else if (same_descriptor_type && lRegions.IsBinary()
+      && lRegions.Type_id() == typeid(unsigned char).name())
+  {
+    const internal::RawDescriptorDistance<matching::Hamming<unsigned char>>
+      metric(lRegions, rRegions);
+    internal::GuidedMatching_DistanceRatio<ModelArg, ErrorArg, double>(
+      mod, xLeft, xRight, errorTh, distRatio,
+      [&metric](const size_t i, const size_t j)
+      {
+        return Square(static_cast<double>(metric(i, j)));
+      },
+      vec_corresponding_index);
+  }
+  else
+  {
+    internal::GuidedMatching_DistanceRatio<ModelArg, ErrorArg, double>(
+      mod, xLeft, xRight, errorTh, distRatio,
+      [&lRegions, &rRegions](const size_t i, const size_t j)
+      {
+        return lRegions.SquaredDescriptorDistance(i, &rRegions, j);
+      },
+      vec_corresponding_index);
+  }
 }
 
 /// Guided Matching (features + descriptors with distance ratio):
@@ -185,45 +520,23 @@ void GuidedMatching(
   double distRatio,     // Maximal authorized distance ratio
   matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
 {
-  // Looking for the corresponding points that have to satisfy:
-  //   1. a geometric distance below the provided Threshold
-  //   2. a distance ratio between descriptors of valid geometric correspondencess
-
   // Build region positions arrays (in order to un-distord on-demand point position once)
-  std::vector<Vec2>
-    lRegionsPos(lRegions.RegionCount()),
-   rRegionsPos(rRegions.RegionCount());
+  Mat
+    lRegionsPos(2, lRegions.RegionCount()),
+    rRegionsPos(2, rRegions.RegionCount());
   for (size_t i = 0; i < lRegions.RegionCount(); ++i) {
-    lRegionsPos[i] = camL ? camL->get_ud_pixel(lRegions.GetRegionPosition(i)) : lRegions.GetRegionPosition(i);
+    lRegionsPos.col(i) = camL ? camL->get_ud_pixel(lRegions.GetRegionPosition(i)) : lRegions.GetRegionPosition(i);
   }
   for (size_t i = 0; i < rRegions.RegionCount(); ++i) {
-    rRegionsPos[i] = camR ? camR->get_ud_pixel(rRegions.GetRegionPosition(i)) : rRegions.GetRegionPosition(i);
+    rRegionsPos.col(i) = camR ? camR->get_ud_pixel(rRegions.GetRegionPosition(i)) : rRegions.GetRegionPosition(i);
   }
 
-  for (size_t i = 0; i < lRegions.RegionCount(); ++i) {
-
-    distanceRatio<double> dR;
-    for (size_t j = 0; j < rRegions.RegionCount(); ++j) {
-      // Compute the geometric error: error to the model
-      const double geomErr = ErrorArg::Error(
-        mod,  // The model
-        // The corresponding points
-        lRegionsPos[i],
-        rRegionsPos[j]);
-      if (geomErr < errorTh) {
-        // Update the corresponding points & distance (if required)
-        dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
-      }
-    }
-    // Add correspondence only iff the distance ratio is valid
-    if (dR.isValid(distRatio))  {
-      // save the best corresponding index
-      vec_corresponding_index.push_back(matching::IndMatch(i,dR.idx));
-    }
-  }
-
-  // Remove duplicates (when multiple points at same position exist)
-  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+  GuidedMatching<ModelArg, ErrorArg>(
+    mod,
+    lRegionsPos, lRegions,
+    rRegionsPos, rRegions,
+    errorTh, distRatio,
+    vec_corresponding_index);
 }
 
 /// Compute a bucket index from an epipolar point
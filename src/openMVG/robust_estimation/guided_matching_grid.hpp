@@ -0,0 +1,240 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_ROBUST_ESTIMATION_GUIDED_MATCHING_GRID_HPP
+#define OPENMVG_ROBUST_ESTIMATION_GUIDED_MATCHING_GRID_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+
+namespace openMVG{
+namespace geometry_aware{
+
+/**
+ ** Regular grid of points (2D image points or 3D bearing vectors).
+ ** Used to limit the guided matching search to the points that lie
+ **  in a given area:
+ **  - a ball (around a predicted position),
+ **  - a slab (a band around an epipolar line or a great circle).
+ ** The queries are conservative: they return all the points of the
+ **  grid cells that intersect the area.
+ **/
+template <int DIM>
+class PointGrid
+{
+public:
+  using VecT = Eigen::Matrix<double, DIM, 1>;
+
+  /**
+   ** @param points the points (one per column)
+   ** @param points_per_cell average number of points per non empty cell
+   **/
+  explicit PointGrid
+  (
+    const Mat & points,
+    const double points_per_cell = 4.0
+  )
+  {
+    assert(points.rows() == DIM);
+    const Eigen::Index n = points.cols();
+    if (n == 0)
+    {
+      min_.setZero();
+      cell_size_ = 1.0;
+      dims_.fill(1);
+      cell_offsets_.assign(2, 0);
+      return;
+    }
+    min_ = points.rowwise().minCoeff();
+    const VecT extent = points.rowwise().maxCoeff() - min_;
+
+    // Cell size: the points are assumed to be spread in the bounding box
+    //  (a surface for the bearing vectors)
+    const double max_extent = std::max(extent.maxCoeff(), std::numeric_limits<double>::epsilon());
+    const int kMaxCellsPerAxis = (DIM == 2) ? 1024 : 128;
+    const double dim_surface = (DIM == 2) ? extent.prod() : 4.0 * M_PI * (max_extent / 2.) * (max_extent / 2.);
+    cell_size_ = std::max(
+      std::pow(std::max(dim_surface, 0.0) * points_per_cell / n, 1. / 2.),
+      max_extent / kMaxCellsPerAxis);
+    size_t cell_count = 1;
+    for (int d = 0; d < DIM; ++d)
+    {
+      dims_[d] = std::max(1, std::min(kMaxCellsPerAxis,
+        static_cast<int>(std::ceil(extent(d) / cell_size_)) + 1));
+      cell_count *= dims_[d];
+    }
+
+    // Store the point indices sorted per cell (and by increasing index)
+    std::vector<uint32_t> point_cells(n);
+    cell_offsets_.assign(cell_count + 1, 0);
+    for (Eigen::Index i = 0; i < n; ++i)
+    {
+      std::array<int, DIM> cell;
+      for (int d = 0; d < DIM; ++d)
+        cell[d] = CellCoordinate((points(d, i) - min_(d)) / cell_size_, d);
+      point_cells[i] = CellIndex(cell);
+      ++cell_offsets_[point_cells[i] + 1];
+    }
+    for (size_t c = 0; c < cell_count; ++c)
+      cell_offsets_[c + 1] += cell_offsets_[c];
+    point_indices_.resize(n);
+    std::vector<uint32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (Eigen::Index i = 0; i < n; ++i)
+      point_indices_[fill[point_cells[i]]++] = static_cast<uint32_t>(i);
+  }
+
+  /**
+   ** Collect the points that can lie in the ball(center, radius)
+   ** @param[out] candidates point indices sorted in increasing order
+   **/
+  void QueryBall
+  (
+    const VecT & center,
+    const double radius,
+    std::vector<uint32_t> & candidates
+  ) const
+  {
+    candidates.clear();
+    if (!center.allFinite() || !std::isfinite(radius))
+      return;
+    std::array<int, DIM> first, last;
+    for (int d = 0; d < DIM; ++d)
+    {
+      const double lo = (center(d) - radius - min_(d)) / cell_size_;
+      const double hi = (center(d) + radius - min_(d)) / cell_size_;
+      if (hi < 0 || lo >= dims_[d])
+        return; // The ball does not intersect the grid
+      first[d] = CellCoordinate(lo, d);
+      last[d] = CellCoordinate(hi, d);
+    }
+    // Iterate over the cells of the [first, last] box
+    std::array<int, DIM> cell = first;
+    while (true)
+    {
+      AppendCell(CellIndex(cell), candidates);
+      int d = 0;
+      while (d < DIM && ++cell[d] > last[d])
+      {
+        cell[d] = first[d];
+        ++d;
+      }
+      if (d == DIM)
+        break;
+    }
+    std::sort(candidates.begin(), candidates.end());
+  }
+
+  /**
+   ** Collect the points that can lie in the slab |normal.x + offset| <= half_width
+   ** @param normal unit normal of the slab
+   ** @param[out] candidates point indices sorted in increasing order
+   **/
+  void QuerySlab
+  (
+    const VecT & normal,
+    const double offset,
+    const double half_width,
+    std::vector<uint32_t> & candidates
+  ) const
+  {
+    candidates.clear();
+    if (!normal.allFinite() || !std::isfinite(offset) || !std::isfinite(half_width))
+      return;
+    // The slab is scanned along its dominant normal axis:
+    //  for each cell column of the other axes, compute the range of the
+    //  dominant axis coordinate that intersects the slab.
+    int axis;
+    normal.cwiseAbs().maxCoeff(&axis);
+    if (normal(axis) == 0.0)
+      return;
+
+    std::array<int, DIM> cell;
+    cell.fill(0);
+    while (true)
+    {
+      // Range of the dot product of the other axes over the cell column
+      double dot_min = offset, dot_max = offset;
+      for (int d = 0; d < DIM; ++d)
+      {
+        if (d == axis)
+          continue;
+        const double lo = min_(d) + cell[d] * cell_size_;
+        const double a = normal(d) * lo, b = normal(d) * (lo + cell_size_);
+        dot_min += std::min(a, b);
+        dot_max += std::max(a, b);
+      }
+      // normal(axis) * x in [-half_width - dot_max, half_width - dot_min]
+      double lo = (-half_width - dot_max) / normal(axis);
+      double hi = (half_width - dot_min) / normal(axis);
+      if (lo > hi)
+        std::swap(lo, hi);
+      lo = (lo - min_(axis)) / cell_size_;
+      hi = (hi - min_(axis)) / cell_size_;
+      if (hi >= 0 && lo < dims_[axis])
+      {
+        const int first = CellCoordinate(lo, axis);
+        const int last = CellCoordinate(hi, axis);
+        for (cell[axis] = first; cell[axis] <= last; ++cell[axis])
+          AppendCell(CellIndex(cell), candidates);
+        cell[axis] = 0;
+      }
+      // Next cell column
+      int d = 0;
+      while (d < DIM && (d == axis || ++cell[d] >= dims_[d]))
+      {
+        if (d != axis)
+          cell[d] = 0;
+        ++d;
+      }
+      if (d == DIM)
+        break;
+    }
+    std::sort(candidates.begin(), candidates.end());
+  }
+
+private:
+
+  /// Cell coordinate of a (grid normalized) position along the axis d
+  int CellCoordinate(const double value, const int d) const
+  {
+    return static_cast<int>(std::max(0.0, std::min(dims_[d] - 1.0, std::floor(value))));
+  }
+
+  uint32_t CellIndex(const std::array<int, DIM> & cell) const
+  {
+    uint32_t index = 0;
+    for (int d = DIM - 1; d >= 0; --d)
+      index = index * dims_[d] + cell[d];
+    return index;
+  }
+
+  void AppendCell(const uint32_t cell_index, std::vector<uint32_t> & candidates) const
+  {
+    candidates.insert(candidates.end(),
+      point_indices_.begin() + cell_offsets_[cell_index],
+      point_indices_.begin() + cell_offsets_[cell_index + 1]);
+  }
+
+  VecT min_;                           // grid origin
+  double cell_size_;                   // cell side length
+  std::array<int, DIM> dims_;          // number of cells per axis
+  std::vector<uint32_t> cell_offsets_; // first point of each cell in point_indices_
+  std::vector<uint32_t> point_indices_;// point indices sorted per cell
+};
+
+} // namespace geometry_aware
+} // namespace openMVG
+
+#endif // OPENMVG_ROBUST_ESTIMATION_GUIDED_MATCHING_GRID_HPP
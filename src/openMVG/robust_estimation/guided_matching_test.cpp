@@ -0,0 +1,235 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/descriptor.hpp"
+#include "openMVG/multiview/solver_essential_eight_point.hpp"
+#include "openMVG/multiview/solver_fundamental_kernel.hpp"
+#include "openMVG/multiview/solver_homography_kernel.hpp"
+#include "openMVG/robust_estimation/guided_matching.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::geometry_aware;
+using namespace openMVG::matching;
+
+// Error metrics without a known search area (exhaustive guided matching)
+struct ExhaustiveEpipolarDistanceError : fundamental::kernel::EpipolarDistanceError {};
+struct ExhaustiveSymmetricEpipolarDistanceError : fundamental::kernel::SymmetricEpipolarDistanceError {};
+struct ExhaustiveAsymmetricError : homography::kernel::AsymmetricError {};
+struct ExhaustiveAngularError : AngularError {};
+
+// Random points in [0, size]^2
+Mat RandomImagePoints(const int count, const double size, std::mt19937 & rng)
+{
+  std::uniform_real_distribution<double> distribution(0.0, size);
+  Mat points(2, count);
+  for (int i = 0; i < count; ++i)
+    points.col(i) << distribution(rng), distribution(rng);
+  return points;
+}
+
+// Random unit bearing vectors
+Mat RandomBearingVectors(const int count, std::mt19937 & rng)
+{
+  std::normal_distribution<double> distribution;
+  Mat points(3, count);
+  for (int i = 0; i < count; ++i)
+    points.col(i) = Vec3(distribution(rng), distribution(rng), distribution(rng)).normalized();
+  return points;
+}
+
+TEST(PointGrid, QueryBall)
+{
+  std::mt19937 rng(0);
+  const Mat points = RandomImagePoints(1000, 500., rng);
+  const PointGrid<2> grid(points);
+
+  std::vector<uint32_t> candidates;
+  for (const double radius : {0.0, 3.0, 50.0, 1000.0})
+  {
+    for (const Vec2 center : {Vec2(250., 250.), Vec2(0., 0.), Vec2(-10., 600.), Vec2(2000., 2000.)})
+    {
+      grid.QueryBall(center, radius, candidates);
+      EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+      EXPECT_TRUE(std::adjacent_find(candidates.begin(), candidates.end()) == candidates.end());
+      // All the points of the ball are listed
+      for (int i = 0; i < points.cols(); ++i)
+      {
+        if ((points.col(i) - center).norm() <= radius)
+        {
+          EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(), i));
+        }
+      }
+    }
+  }
+  // The ball outside the grid is empty
+  grid.QueryBall(Vec2(2000., 2000.), 10.0, candidates);
+  EXPECT_TRUE(candidates.empty());
+}
+
+TEST(PointGrid, QuerySlab)
+{
+  std::mt19937 rng(0);
+  const Mat points2 = RandomImagePoints(1000, 500., rng);
+  const PointGrid<2> grid2(points2);
+  const Mat points3 = RandomBearingVectors(1000, rng);
+  const PointGrid<3> grid3(points3);
+
+  std::vector<uint32_t> candidates;
+  std::normal_distribution<double> distribution;
+  for (int trial = 0; trial < 20; ++trial)
+  {
+    const double half_width = (trial % 2) ? 2.0 : 0.05;
+    {
+      const Vec2 normal = Vec2(distribution(rng), distribution(rng)).normalized();
+      const double offset = -normal.dot(points2.col(trial));
+      grid2.QuerySlab(normal, offset, half_width, candidates);
+      EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+      EXPECT_TRUE(candidates.size() < static_cast<size_t>(points2.cols()));
+      for (int i = 0; i < points2.cols(); ++i)
+      {
+        if (std::abs(normal.dot(points2.col(i)) + offset) <= half_width)
+        {
+          EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(), i));
+        }
+      }
+    }
+    {
+      const Vec3 normal = Vec3(distribution(rng), distribution(rng), distribution(rng)).normalized();
+      grid3.QuerySlab(normal, 0.0, half_width / 100., candidates);
+      EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+      EXPECT_TRUE(candidates.size() < static_cast<size_t>(points3.cols()));
+      for (int i = 0; i < points3.cols(); ++i)
+      {
+        if (std::abs(normal.dot(points3.col(i))) <= half_width / 100.)
+        {
+          EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(), i));
+        }
+      }
+    }
+  }
+}
+
+// The guided matching restricted to the search area must give the same
+//  correspondences as the exhaustive search
+
+TEST(GuidedMatching, Fundamental)
+{
+  std::mt19937 rng(0);
+  const Mat xLeft = RandomImagePoints(500, 1000., rng);
+  const Mat xRight = RandomImagePoints(2000, 1000., rng);
+  // Epipole (500, -2000) in the right image
+  Mat3 F = CrossProductMatrix(Vec3(500., -2000., 1.)) * RotationAroundZ(0.1);
+  F /= F.norm();
+
+  IndMatches matches, exhaustive_matches;
+  GuidedMatching<Mat3, fundamental::kernel::EpipolarDistanceError>(
+    F, xLeft, xRight, Square(2.0), matches);
+  GuidedMatching<Mat3, ExhaustiveEpipolarDistanceError>(
+    F, xLeft, xRight, Square(2.0), exhaustive_matches);
+  EXPECT_TRUE(matches.size() > 100);
+  EXPECT_TRUE(matches == exhaustive_matches);
+
+  // Using the descriptor distance ratio
+  using DescriptorT = features::Descriptor<float, 8>;
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+  std::vector<DescriptorT> lDescriptors(xLeft.cols()), rDescriptors(xRight.cols());
+  for (auto & descriptor : lDescriptors)
+    for (int k = 0; k < 8; ++k) descriptor(k) = distribution(rng);
+  for (auto & descriptor : rDescriptors)
+    for (int k = 0; k < 8; ++k) descriptor(k) = distribution(rng);
+
+  matches.clear();
+  exhaustive_matches.clear();
+  GuidedMatching<Mat3, fundamental::kernel::EpipolarDistanceError, DescriptorT, L2<float>>(
+    F, xLeft, lDescriptors, xRight, rDescriptors, Square(4.0), Square(0.8), matches);
+  GuidedMatching<Mat3, ExhaustiveEpipolarDistanceError, DescriptorT, L2<float>>(
+    F, xLeft, lDescriptors, xRight, rDescriptors, Square(4.0), Square(0.8), exhaustive_matches);
+  EXPECT_TRUE(matches.size() > 50);
+  EXPECT_TRUE(matches == exhaustive_matches);
+}
+
+TEST(GuidedMatching, SymmetricFundamental)
+{
+  std::mt19937 rng(0);
+  const Mat xLeft = RandomImagePoints(500, 100., rng);
+  const Mat xRight = RandomImagePoints(20000, 1000., rng);
+  // The epipolar lines are the horizontal lines y = 10 * x_left(1):
+  //  |F^T.y| = 10 * |F.x|, so the symmetric error is mostly the (squared and
+  //  divided by 4) distance to the epipolar line in the right image
+  const Mat3 F = CrossProductMatrix(Vec3(1., 0., 0.)) * Vec3(1., 10., 1.).asDiagonal();
+  const double errorTh = Square(0.02);
+
+  IndMatches matches, exhaustive_matches;
+  GuidedMatching<Mat3, fundamental::kernel::SymmetricEpipolarDistanceError>(
+    F, xLeft, xRight, errorTh, matches);
+  GuidedMatching<Mat3, ExhaustiveSymmetricEpipolarDistanceError>(
+    F, xLeft, xRight, errorTh, exhaustive_matches);
+  EXPECT_TRUE(matches.size() > 100);
+  EXPECT_TRUE(matches == exhaustive_matches);
+
+  // Using the descriptor distance ratio
+  using DescriptorT = features::Descriptor<float, 8>;
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+  std::vector<DescriptorT> lDescriptors(xLeft.cols()), rDescriptors(xRight.cols());
+  for (auto & descriptor : lDescriptors)
+    for (int k = 0; k < 8; ++k) descriptor(k) = distribution(rng);
+  for (auto & descriptor : rDescriptors)
+    for (int k = 0; k < 8; ++k) descriptor(k) = distribution(rng);
+
+  matches.clear();
+  exhaustive_matches.clear();
+  GuidedMatching<Mat3, fundamental::kernel::SymmetricEpipolarDistanceError, DescriptorT, L2<float>>(
+    F, xLeft, lDescriptors, xRight, rDescriptors, errorTh, Square(0.8), matches);
+  GuidedMatching<Mat3, ExhaustiveSymmetricEpipolarDistanceError, DescriptorT, L2<float>>(
+    F, xLeft, lDescriptors, xRight, rDescriptors, errorTh, Square(0.8), exhaustive_matches);
+  EXPECT_TRUE(matches.size() > 50);
+  EXPECT_TRUE(matches == exhaustive_matches);
+}
+
+TEST(GuidedMatching, Homography)
+{
+  std::mt19937 rng(0);
+  const Mat xLeft = RandomImagePoints(1000, 1000., rng);
+  const Mat xRight = RandomImagePoints(4000, 1000., rng);
+  Mat3 H;
+  H << 1.1, 0.1, -20.,
+      -0.05, 0.9, 30.,
+       1e-4, 0., 1.;
+
+  IndMatches matches, exhaustive_matches;
+  GuidedMatching<Mat3, homography::kernel::AsymmetricError>(
+    H, xLeft, xRight, Square(10.0), matches);
+  GuidedMatching<Mat3, ExhaustiveAsymmetricError>(
+    H, xLeft, xRight, Square(10.0), exhaustive_matches);
+  EXPECT_TRUE(matches.size() > 100);
+  EXPECT_TRUE(matches == exhaustive_matches);
+}
+
+TEST(GuidedMatching, Angular)
+{
+  std::mt19937 rng(0);
+  const Mat xLeft = RandomBearingVectors(500, rng);
+  const Mat xRight = RandomBearingVectors(2000, rng);
+  const Mat3 E = CrossProductMatrix(Vec3(1., 0.2, 0.1)) * RotationAroundY(0.2);
+
+  IndMatches matches, exhaustive_matches;
+  GuidedMatching<Mat3, AngularError>(
+    E, xLeft, xRight, 0.005, matches);
+  GuidedMatching<Mat3, ExhaustiveAngularError>(
+    E, xLeft, xRight, 0.005, exhaustive_matches);
+  EXPECT_TRUE(matches.size() > 100);
+  EXPECT_TRUE(matches == exhaustive_matches);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -10,7 +10,10 @@
 #define OPENMVG_ROBUST_ESTIMATION_RAND_SAMPLING_HPP
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <random>
 #include <type_traits>
 #include <vector>
@@ -99,6 +102,102 @@ bool UniformSample
   return true;
 }
 
+/**
+* Progressive sampling (PROSAC) [1].
+* The data are assumed to be ranked by decreasing quality (i.e. the rank 0 is
+* the most likely inlier). The minimal samples are drawn from a subset of the
+* top-ranked data, that progressively grows up to the whole dataset.
+* Once the whole dataset is reached, the sampling is uniform.
+*
+* The samples are returned as ranks, the caller maps them to the data indices.
+*
+* [1] Matching with PROSAC - Progressive Sample Consensus.
+*     Ondrej Chum and Jiri Matas. CVPR 2005.
+*/
+class ProsacSampler
+{
+public:
+  /**
+  * \param[in] num_samples    The number of samples to produce (minimal sample size).
+  * \param[in] total_samples  The number of available samples.
+  * \param[in] growth_max_samples The number of draws (T_N) after which the
+  *   sampling would have reached the whole dataset in the PROSAC growth function.
+  */
+  ProsacSampler
+  (
+    const uint32_t num_samples,
+    const uint32_t total_samples,
+    const uint32_t growth_max_samples = 200000
+  ):
+    num_samples_(num_samples),
+    total_samples_(total_samples),
+    subset_size_(num_samples),
+    draw_count_(0),
+    subset_draw_count_(1.0),
+    subset_draw_limit_(1)
+  {
+    // T_m = T_N * prod_{i=0}^{m-1} (m-i)/(N-i):
+    //  average number of samples drawn from the top-m data (among T_N draws)
+    subset_draw_count_ = growth_max_samples;
+    for (uint32_t i = 0; i < num_samples_; ++i)
+    {
+      subset_draw_count_ *=
+        static_cast<double>(num_samples_ - i) / static_cast<double>(total_samples_ - i);
+    }
+  }
+
+  /// Current size of the top-ranked subset used for the sampling
+  uint32_t SubsetSize() const { return subset_size_; }
+
+  /**
+  * Draw a minimal sample of unique ranks.
+  *
+  * \param[in] random_generator The random number generator.
+  * \param[out] samples num_samples ranks in [0, SubsetSize()).
+  */
+  template <class RandomGeneratorT, typename SamplingType>
+  void Sample
+  (
+    RandomGeneratorT &random_generator,
+    std::vector<SamplingType> *samples
+  )
+  {
+    ++draw_count_;
+    // Grow the subset once it has been used for its share of draws (T'_n)
+    while (draw_count_ >= subset_draw_limit_ && subset_size_ < total_samples_)
+    {
+      const double next_subset_draw_count =
+        subset_draw_count_ * (subset_size_ + 1) / (subset_size_ + 1 - num_samples_);
+      subset_draw_limit_ +=
+        static_cast<uint64_t>(std::ceil(next_subset_draw_count - subset_draw_count_));
+      subset_draw_count_ = next_subset_draw_count;
+      ++subset_size_;
+    }
+
+    if (draw_count_ >= subset_draw_limit_)
+    {
+      // The whole dataset is reached: uniform sampling
+      UniformSample(num_samples_, subset_size_, random_generator, samples);
+    }
+    else
+    {
+      // The lowest ranked data of the subset and (m-1) data drawn from the better ones
+      if (num_samples_ > 1)
+        UniformSample(num_samples_ - 1, subset_size_ - 1, random_generator, samples);
+      else
+        samples->resize(0);
+      samples->push_back(subset_size_ - 1);
+    }
+  }
+
+private:
+  uint32_t num_samples_;   // m: minimal sample size
+  uint32_t total_samples_; // N: dataset size
+  uint32_t subset_size_;   // n: size of the top-ranked subset
+  uint64_t draw_count_;    // t: number of drawn samples
+  double subset_draw_count_; // T_n
+  uint64_t subset_draw_limit_; // T'_n
+};
 
 } // namespace robust
 } // namespace openMVG
@@ -45,6 +45,31 @@ TEST(UniformSampleTestInAVectorOfUniqueElements, NoRepetions) {
   }
 }
 
+// Assert that PROSAC draws unique samples among a growing top-ranked subset
+TEST(ProsacSampler, ProgressiveSubset) {
+
+  const uint32_t total = 100;
+  for (const uint32_t num_samples : {1, 2, 4, 7})
+  {
+    ProsacSampler sampler(num_samples, total, 1000);
+    std::vector<uint32_t> samples;
+    uint32_t previous_subset_size = sampler.SubsetSize();
+    EXPECT_EQ(num_samples, previous_subset_size);
+    for (int i = 0; i < 2000; ++i)
+    {
+      sampler.Sample(random_generator, &samples);
+      const std::set<uint32_t> myset(samples.begin(), samples.end());
+      CHECK_EQUAL(num_samples, myset.size());
+      // The samples are drawn among the current subset
+      EXPECT_TRUE(*myset.rbegin() < sampler.SubsetSize());
+      EXPECT_TRUE(previous_subset_size <= sampler.SubsetSize());
+      previous_subset_size = sampler.SubsetSize();
+    }
+    // The whole dataset is reached after the growth_max_samples draws
+    EXPECT_EQ(total, sampler.SubsetSize());
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
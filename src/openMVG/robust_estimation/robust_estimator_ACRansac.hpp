@@ -35,6 +35,18 @@
 //  Adaptive Structure from Motion with a contrario mode estimation.
 //  In 11th Asian Conference on Computer Vision (ACCV 2012)
 //--
+//  [4] Ondrej Chum and Jiri Matas.
+//  Optimal Randomized RANSAC.
+//  IEEE Transactions on Pattern Analysis and Machine Intelligence (PAMI), 2008.
+//--
+//  [5] Ondrej Chum and Jiri Matas.
+//  Matching with PROSAC - Progressive Sample Consensus.
+//  CVPR 2005.
+//--
+//  [6] Karel Lebeda, Jiri Matas and Ondrej Chum.
+//  Fixing the Locally Optimized RANSAC.
+//  BMVC 2012.
+//--
 
 #include <algorithm>
 #include <cmath>
@@ -43,6 +55,7 @@
 #include <limits>
 #include <numeric>
 #include <random>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -115,6 +128,153 @@ static void makelogcombi
   makelogcombi_k(k, n, vec_logc_k, vec_log10);
 }
 
+/// Tell if a Kernel can compute the residual error of a single sample:
+///  double Error(uint32_t sample, const Model & model) const
+template <typename Kernel>
+class HasSampleError
+{
+  template <typename K>
+  static auto test(int) -> decltype(
+    std::declval<const K &>().Error(uint32_t(0), std::declval<const typename K::Model &>()),
+    std::true_type());
+  template <typename>
+  static std::false_type test(...);
+public:
+  static constexpr bool value = decltype(test<Kernel>(0))::value;
+};
+
+/// Tell if a Kernel can fit a model to a non minimal sample:
+///  void FitNonMinimal(const std::vector<uint32_t> & samples, std::vector<Model> * models) const
+template <typename Kernel>
+class HasNonMinimalFit
+{
+  template <typename K>
+  static auto test(int) -> decltype(
+    std::declval<const K &>().FitNonMinimal(std::declval<const std::vector<uint32_t> &>(),
+      std::declval<std::vector<typename K::Model> *>()),
+    std::true_type());
+  template <typename>
+  static std::false_type test(...);
+public:
+  static constexpr bool value = decltype(test<Kernel>(0))::value;
+};
+
+template <typename Kernel>
+double SampleError
+(
+  const Kernel & kernel,
+  const typename Kernel::Model & model,
+  uint32_t sample,
+  std::true_type
+)
+{
+  return kernel.Error(sample, model);
+}
+
+template <typename Kernel>
+double SampleError
+(
+  const Kernel &,
+  const typename Kernel::Model &,
+  uint32_t,
+  std::false_type
+)
+{
+  return std::numeric_limits<double>::infinity(); // Never used (see HasSampleError)
+}
+
+/**
+ * @brief Wald's Sequential Probability Ratio Test (SPRT) [4]
+ * Decide if a model hypothesis is a "bad" one while its residuals are
+ *  evaluated one by one (in a random order).
+ * A sample is "consistent" with a model if its residual is below the threshold
+ *  of the best model found so far.
+ * - epsilon: probability that a sample is consistent with a good model
+ *   (inlier ratio of the best model found so far),
+ * - delta: probability that a sample is consistent with a bad model
+ *   (estimated from the rejected and the not better hypotheses).
+ */
+class SPRT
+{
+public:
+  /**
+   * @param[in] time_model_estimation Time of a model estimation (in residual evaluation unit)
+   * @param[in] models_per_sample Average number of models estimated from a minimal sample
+   * @param[in] delta Initial value of delta
+   */
+  SPRT
+  (
+    const double time_model_estimation = 200.0,
+    const double models_per_sample = 1.0,
+    const double delta = 0.05
+  ):
+    m_time_model_estimation(time_model_estimation),
+    m_models_per_sample(models_per_sample),
+    m_epsilon(0.0),
+    m_threshold(-1.0),
+    m_delta(delta),
+    m_consistent_count(0.0),
+    m_tested_count(0.0)
+  {
+    Update();
+  }
+
+  /// Tell if a reference model is known and if the test is discriminative
+  bool IsActive() const
+  {
+    return m_threshold >= 0.0 && m_epsilon > m_delta;
+  }
+
+  /// Residual threshold of the sample consistency
+  double threshold() const { return m_threshold; }
+
+  /// Likelihood ratio update for a consistent/inconsistent sample
+  double ratio_consistent() const { return m_ratio_consistent; }
+  double ratio_inconsistent() const { return m_ratio_inconsistent; }
+  /// Likelihood ratio threshold (the model is rejected above this value)
+  double decision_threshold() const { return m_A; }
+
+  /// Set the residual threshold and the inlier ratio of the best model found so far
+  void SetReference(const double threshold, const double epsilon)
+  {
+    m_threshold = threshold;
+    m_epsilon = epsilon;
+    Update();
+  }
+
+  /// Add the sample consistency observed on a bad model
+  void AddBadModel(const uint32_t consistent_count, const uint32_t tested_count)
+  {
+    m_consistent_count += consistent_count;
+    m_tested_count += tested_count;
+    m_delta = std::min(0.95, std::max(0.005, m_consistent_count / m_tested_count));
+    Update();
+  }
+
+private:
+
+  void Update()
+  {
+    if (!IsActive())
+      return;
+    m_ratio_consistent = m_delta / m_epsilon;
+    m_ratio_inconsistent = (1.0 - m_delta) / (1.0 - m_epsilon);
+    // Optimal decision threshold: A = A0 + log(A), with A0 = t_M * C / m_S + 1
+    const double C = (1.0 - m_delta) * log((1.0 - m_delta) / (1.0 - m_epsilon))
+      + m_delta * log(m_delta / m_epsilon);
+    const double A0 = m_time_model_estimation * C / m_models_per_sample + 1.0;
+    m_A = A0;
+    for (int i = 0; i < 10; ++i)
+      m_A = A0 + log(m_A);
+  }
+
+  const double m_time_model_estimation;
+  const double m_models_per_sample;
+  double m_epsilon, m_threshold, m_delta;
+  double m_consistent_count, m_tested_count;
+  double m_ratio_consistent = 1.0, m_ratio_inconsistent = 1.0, m_A = 1.0;
+};
+
 template <typename Kernel>
 class NFA_Interface
 {
@@ -125,26 +285,52 @@ public:
    * @param[in] dmaxThreshold Upper bound of the residual error (default infinity)
    * @param[in] bquantified_nfa_evaluation Tell if NFA evaluation is using the quantified or exhaustive evaluation method.
    *  An upper bound different from infinity must be provided to be set to true.
+   * @param[in] bSPRT Tell if the model hypotheses are verified with the SPRT
+   *  (early rejection of the bad hypotheses, the Kernel must provide Error(sample, model))
    */
   NFA_Interface
   (
     const Kernel & kernel,
     const double dmaxThreshold = std::numeric_limits<double>::infinity(),
-    const bool bquantified_nfa_evaluation = false
+    const bool bquantified_nfa_evaluation = false,
+    const bool bSPRT = false
   ):
     m_residuals(kernel.NumSamples()),
     m_kernel(kernel),
     m_bquantified_nfa_evaluation(bquantified_nfa_evaluation),
-    m_max_threshold(dmaxThreshold)
+    m_max_threshold(dmaxThreshold),
+    m_bSPRT(bSPRT && HasSampleError<Kernel>::value),
+    m_sprt(200.0, Kernel::MAX_MODELS),
+    m_sprt_random_generator(std::mt19937::default_seed),
+    m_sprt_consistent_count(0),
+    m_sprt_tested_count(0)
   {
     // Precompute log combi
     m_loge0 = log10((double)Kernel::MAX_MODELS * (kernel.NumSamples() - Kernel::MINIMUM_SAMPLES));
     makelogcombi(Kernel::MINIMUM_SAMPLES, kernel.NumSamples(), m_logc_k, m_logc_n);
+    if (m_bSPRT)
+    {
+      // Random evaluation order of the residuals
+      m_sprt_order.resize(kernel.NumSamples());
+      std::iota(m_sprt_order.begin(), m_sprt_order.end(), 0);
+      std::shuffle(m_sprt_order.begin(), m_sprt_order.end(), m_sprt_random_generator);
+    }
   };
 
   std::vector<double> & residuals()
   { return m_residuals;}
 
+  /**
+   * @brief Compute the residuals of a model hypothesis.
+   * If the SPRT is enabled and a meaningful model has already been found,
+   *  the residuals are evaluated in a random order and the evaluation stops
+   *  as soon as the test decides that the hypothesis is a bad one.
+   *
+   * @param[in] model the model hypothesis
+   * @return false if the hypothesis has been rejected (the residuals are incomplete).
+   */
+  bool ComputeResiduals(const typename Kernel::Model & model);
+
   /**
    * @brief Evaluation of the NFA (Number of False Alarm)
    *  for the given residual distribution.
@@ -169,6 +355,15 @@ public:
 
 private:
 
+  /// Update the SPRT reference model or the bad model statistics
+  ///  after the NFA evaluation of a fully verified hypothesis
+  void UpdateSPRT
+  (
+    const bool b_better_model,
+    const size_t inlier_count,
+    const std::pair<double,double> & nfa_threshold
+  );
+
   /// residual array
   std::vector<double> m_residuals;
   /// [residual,index] array -> used in the exhaustive nfa computation mode
@@ -185,8 +380,60 @@ private:
   const bool m_bquantified_nfa_evaluation;
   /// upper bound of the maximum authorized residual value
   const double m_max_threshold;
+
+  /// Randomized hypothesis verification (SPRT)
+  const bool m_bSPRT;
+  SPRT m_sprt;
+  std::mt19937 m_sprt_random_generator;
+  std::vector<uint32_t> m_sprt_order;
+  /// sample consistency of the last fully verified hypothesis
+  uint32_t m_sprt_consistent_count, m_sprt_tested_count;
 };
 
+template <typename Kernel>
+bool
+NFA_Interface<Kernel>::ComputeResiduals
+(
+  const typename Kernel::Model & model
+)
+{
+  m_sprt_tested_count = 0;
+  if (!m_bSPRT || !m_sprt.IsActive())
+  {
+    m_kernel.Errors(model, m_residuals);
+    return true;
+  }
+
+  const uint32_t n = m_kernel.NumSamples();
+  const uint32_t start = std::uniform_int_distribution<uint32_t>(0, n - 1)(m_sprt_random_generator);
+  double lambda = 1.0; // Likelihood ratio
+  uint32_t consistent_count = 0;
+  for (uint32_t k = 0; k < n; ++k)
+  {
+    const uint32_t index = m_sprt_order[(start + k) % n];
+    m_residuals[index] = SampleError(m_kernel, model, index,
+      std::integral_constant<bool, HasSampleError<Kernel>::value>());
+    if (m_residuals[index] <= m_sprt.threshold())
+    {
+      ++consistent_count;
+      lambda *= m_sprt.ratio_consistent();
+    }
+    else
+    {
+      lambda *= m_sprt.ratio_inconsistent();
+    }
+    if (lambda > m_sprt.decision_threshold())
+    {
+      // Bad model
+      m_sprt.AddBadModel(consistent_count, k + 1);
+      return false;
+    }
+  }
+  m_sprt_consistent_count = consistent_count;
+  m_sprt_tested_count = n;
+  return true;
+}
+
 template <typename Kernel>
 bool
 NFA_Interface<Kernel>::ComputeNFA_and_inliers
@@ -251,6 +498,7 @@ NFA_Interface<Kernel>::ComputeNFA_and_inliers
         if (m_residuals[index] <= nfa_threshold.second)
           inliers.push_back(index);
       }
+      UpdateSPRT(true, inliers.size(), nfa_threshold);
       return inliers.size() > Kernel::MINIMUM_SAMPLES;
     }
   }
@@ -299,13 +547,186 @@ NFA_Interface<Kernel>::ComputeNFA_and_inliers
       {
         inliers[i] = m_sorted_residuals[i].second;
       }
+      UpdateSPRT(true, inliers.size(), nfa_threshold);
       return true;
     }
   }
+  UpdateSPRT(false, 0, nfa_threshold);
   return false;
 }
+
+template <typename Kernel>
+void
+NFA_Interface<Kernel>::UpdateSPRT
+(
+  const bool b_better_model,
+  const size_t inlier_count,
+  const std::pair<double,double> & nfa_threshold
+)
+{
+  if (!m_bSPRT)
+    return;
+  if (b_better_model)
+  {
+    // Only a meaningful model is used as the reference of the test
+    if (nfa_threshold.first < 0)
+      m_sprt.SetReference(nfa_threshold.second,
+        inlier_count / static_cast<double>(m_kernel.NumSamples()));
+  }
+  else if (m_sprt_tested_count > 0)
+  {
+    m_sprt.AddBadModel(m_sprt_consistent_count, m_sprt_tested_count);
+  }
+}
+
+template <typename Kernel>
+void FitNonMinimal
+(
+  const Kernel & kernel,
+  const std::vector<uint32_t> & samples,
+  std::vector<typename Kernel::Model> * models,
+  std::true_type
+)
+{
+  kernel.FitNonMinimal(samples, models);
+}
+
+template <typename Kernel>
+void FitNonMinimal
+(
+  const Kernel &,
+  const std::vector<uint32_t> &,
+  std::vector<typename Kernel::Model> *,
+  std::false_type
+)
+{
+  // Never used (see HasNonMinimalFit)
+}
+
+/**
+ * @brief Local optimization of the so far best model [6]
+ * - Inner RANSAC: models are fitted to random non minimal subsets of the inliers,
+ * - Iterative least squares: each inner model is refitted to the data whose
+ *   residual is below a threshold that shrinks to the NFA threshold
+ *   (binary IRLS weights, since the solvers are not weighted).
+ * Every refined model is scored with the NFA.
+ *
+ * @param[in] kernel model estimator (must provide FitNonMinimal)
+ * @param[in] nfa_interface NFA evaluation interface
+ * @param[in] random_generator random number generator used by the inner sampling
+ * @param[in, out] model the so far best model (updated if a better one is found)
+ * @param[in, out] inliers inlier indices of the so far best model
+ * @param[in, out] nfa_threshold NFA and residual threshold of the so far best model
+ *
+ * @return true if a better model is found.
+ */
+template <typename Kernel, class RandomGeneratorT>
+bool LocalOptimization
+(
+  const Kernel & kernel,
+  NFA_Interface<Kernel> & nfa_interface,
+  RandomGeneratorT & random_generator,
+  typename Kernel::Model & model,
+  std::vector<uint32_t> & inliers,
+  std::pair<double,double> & nfa_threshold
+)
+{
+  const uint32_t kInnerIterations = 10;
+  const uint32_t kInnerSampleSizeFactor = 7; // Inner sample size (x MINIMUM_SAMPLES)
+  const uint32_t kLeastSquaresIterations = 4;
+  const double kThresholdMultiplier = 3.0;
+
+  using integral_fit = std::integral_constant<bool, HasNonMinimalFit<Kernel>::value>;
+
+  bool better = false;
+  // Score a model and keep it if it is better than the so far best one
+  // (the residuals of the model are available for a further refinement).
+  const auto evaluate = [&](const typename Kernel::Model & candidate) -> bool
+  {
+    if (!nfa_interface.ComputeResiduals(candidate))
+      return false;
+    const double best_nfa = nfa_threshold.first;
+    nfa_interface.ComputeNFA_and_inliers(inliers, nfa_threshold);
+    if (nfa_threshold.first < best_nfa)
+    {
+      model = candidate;
+      better = true;
+    }
+    return true;
+  };
+
+  std::vector<uint32_t> vec_index, vec_sample, vec_refit;
+  std::vector<typename Kernel::Model> vec_models, vec_refined_models;
+  for (uint32_t iter = 0; iter < kInnerIterations; ++iter)
+  {
+    // Draw a non minimal sample among the so far best inliers
+    const uint32_t inner_sample_size =
+      std::min(static_cast<uint32_t>(inliers.size()) / 2,
+               kInnerSampleSizeFactor * Kernel::MINIMUM_SAMPLES);
+    vec_index = inliers;
+    const bool b_all_inliers = inner_sample_size <= Kernel::MINIMUM_SAMPLES ||
+      !UniformSample(inner_sample_size, random_generator, &vec_index, &vec_sample);
+    if (b_all_inliers)
+      vec_sample = inliers; // Too few inliers: use all of them once
+    vec_models.clear();
+    FitNonMinimal(kernel, vec_sample, &vec_models, integral_fit());
+
+    for (const auto & inner_model : vec_models)
+    {
+      if (!evaluate(inner_model))
+        continue;
+      // Iterative least squares with a decreasing inlier threshold
+      const double error_max = nfa_threshold.second;
+      for (uint32_t step = kLeastSquaresIterations; step > 0; --step)
+      {
+        const double scale =
+          1.0 + (kThresholdMultiplier - 1.0) * (step - 1) / (kLeastSquaresIterations - 1);
+        const double threshold = error_max * scale * scale; // residuals are squared errors
+        vec_refit.clear();
+        const std::vector<double> & residuals = nfa_interface.residuals();
+        for (uint32_t i = 0; i < residuals.size(); ++i)
+        {
+          if (residuals[i] <= threshold)
+            vec_refit.push_back(i);
+        }
+        if (vec_refit.size() <= Kernel::MINIMUM_SAMPLES)
+          break;
+        vec_refined_models.clear();
+        FitNonMinimal(kernel, vec_refit, &vec_refined_models, integral_fit());
+        if (vec_refined_models.empty() || !evaluate(vec_refined_models.front()))
+          break;
+      }
+    }
+    if (b_all_inliers)
+      break;
+  }
+  return better;
+}
+
 }  // namespace acransac_nfa_internal
 
+/// Options of the ACRANSAC routine (all the refinements are disabled by default)
+struct ACRANSAC_Options
+{
+  /// Display console log
+  bool bVerbose = false;
+  /// Enable the randomized verification of the model hypotheses [4]:
+  ///  once a meaningful model is found, the evaluation of a hypothesis stops as soon as
+  ///  a sequential probability ratio test (SPRT) tells it is a bad one.
+  ///  (used only if the Kernel provides the Error(sample, model) function)
+  bool bSPRT = false;
+  /// Optional data indices sorted by decreasing quality
+  ///  (i.e. sorted by increasing matching distance ratio). If provided, the model
+  ///  hypotheses are first drawn among the top-ranked data (PROSAC sampling [5])
+  ///  until a meaningful model is found. The sampled subset grows to the whole
+  ///  dataset within num_max_iteration draws.
+  const std::vector<uint32_t> * sampling_ranking = nullptr;
+  /// Enable the local optimization of the meaningful models [6]: each time a
+  ///  better model is found, it is refined by non minimal fits on its inliers
+  ///  (used only if the Kernel provides FitNonMinimal)
+  bool bLocalOptimization = false;
+};
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  * If an upper bound of the threshold is provided:
@@ -318,7 +739,7 @@ NFA_Interface<Kernel>::ComputeNFA_and_inliers
  * @param[in] nIter maximum number of consecutive iterations
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
- * @param[in] bVerbose display console log
+ * @param[in] options verbosity and optional refinements (SPRT, PROSAC, LO-RANSAC)
  *
  * @return (errorMax, minNFA)
  */
@@ -327,10 +748,10 @@ std::pair<double, double> ACRANSAC
 (
   const Kernel &kernel,
   std::vector<uint32_t> & vec_inliers,
-  const unsigned int num_max_iteration = 1024,
-  typename Kernel::Model * model = nullptr,
-  double precision = std::numeric_limits<double>::infinity(),
-  bool bVerbose = false
+  const unsigned int num_max_iteration,
+  typename Kernel::Model * model,
+  double precision,
+  const ACRANSAC_Options & options
 )
 {
   vec_inliers.clear();
@@ -355,7 +776,7 @@ std::pair<double, double> ACRANSAC
   // Initialize the NFA computation interface
   // (quantified NFA computation is used if a valid upper bound is provided)
   acransac_nfa_internal::NFA_Interface<Kernel> nfa_interface
-    (kernel, maxThreshold, (precision != std::numeric_limits<double>::infinity()));
+    (kernel, maxThreshold, (precision != std::numeric_limits<double>::infinity()), options.bSPRT);
 
   // Output parameters
   double minNFA = std::numeric_limits<double>::infinity();
@@ -378,18 +799,39 @@ std::pair<double, double> ACRANSAC
   // Random number generation
   std::mt19937 random_generator(std::mt19937::default_seed);
 
+  //--
+  // Progressive sampling of the top-ranked data (until the local optimization)
+  const std::vector<uint32_t> * sampling_ranking = options.sampling_ranking;
+  bool bProgressiveSampling = sampling_ranking && sampling_ranking->size() == nData;
+  ProsacSampler prosac_sampler(sizeSample, nData, num_max_iteration);
+
+  //--
+  // Local optimization of the so far best model (requires a non minimal solver)
+  const bool bLocalOptimization =
+    options.bLocalOptimization && acransac_nfa_internal::HasNonMinimalFit<Kernel>::value;
+  typename Kernel::Model best_model;
+
+  // Model hypotheses buffer (reused by all the iterations)
+  std::vector<typename Kernel::Model> vec_models;
+
   //--
   // Main estimation loop.
   for (unsigned int iter = 0; iter < nIter && iter < num_max_iteration; ++iter)
   {
     // Get random samples
-    if (bACRansacMode)
+    if (bProgressiveSampling)
+    {
+      prosac_sampler.Sample(random_generator, &vec_sample);
+      for (auto & sample : vec_sample)
+        sample = (*sampling_ranking)[sample];
+    }
+    else if (bACRansacMode)
       UniformSample(sizeSample, random_generator, &vec_index, &vec_sample);
     else
       UniformSample(sizeSample, nData, random_generator, &vec_sample);
 
     // Fit model(s). Can find up to Kernel::MAX_MODELS solution(s)
-    std::vector<typename Kernel::Model> vec_models;
+    vec_models.clear();
     kernel.Fit(vec_sample, &vec_models);
 
     // Evaluate model(s)
@@ -397,7 +839,8 @@ std::pair<double, double> ACRANSAC
     for (const auto& model_it : vec_models)
     {
       // Compute residual values
-      kernel.Errors(model_it, nfa_interface.residuals());
+      if (!nfa_interface.ComputeResiduals(model_it))
+        continue; // Bad model hypothesis (rejected by the SPRT)
 
       if (!bACRansacMode)
       {
@@ -422,11 +865,17 @@ std::pair<double, double> ACRANSAC
         if (b_better_model_found)
         {
           better = true;
+          best_model = model_it;
+          if (bLocalOptimization && nfa_threshold.first < 0)
+          {
+            acransac_nfa_internal::LocalOptimization(kernel, nfa_interface,
+              random_generator, best_model, vec_inliers, nfa_threshold);
+          }
           minNFA = nfa_threshold.first;
           errorMax = nfa_threshold.second;
-          if (model) *model = model_it;
+          if (model) *model = best_model;
 
-          if (bVerbose)
+          if (options.bVerbose)
           {
             std::ostringstream os;
             os << "  nfa=" << minNFA
@@ -464,6 +913,7 @@ std::pair<double, double> ACRANSAC
       {
         // ACRANSAC optimization: draw samples among best set of inliers so far
         vec_index = vec_inliers;
+        bProgressiveSampling = false;
         if (nIterReserve) {
             // reduce the number of iteration
             // next iterations will be dedicated to local optimization
@@ -488,6 +938,34 @@ std::pair<double, double> ACRANSAC
   return {errorMax, minNFA};
 }
 
+/**
+ * @brief ACRANSAC routine (ErrorThreshold, NFA) without the optional refinements
+ *
+ * @param[in] kernel model and metric object
+ * @param[out] vec_inliers points that fit the estimated model
+ * @param[in] nIter maximum number of consecutive iterations
+ * @param[out] model returned model if found
+ * @param[in] precision upper bound of the precision (squared error)
+ * @param[in] bVerbose display console log
+ *
+ * @return (errorMax, minNFA)
+ */
+template<typename Kernel>
+std::pair<double, double> ACRANSAC
+(
+  const Kernel &kernel,
+  std::vector<uint32_t> & vec_inliers,
+  const unsigned int num_max_iteration = 1024,
+  typename Kernel::Model * model = nullptr,
+  double precision = std::numeric_limits<double>::infinity(),
+  bool bVerbose = false
+)
+{
+  ACRANSAC_Options options;
+  options.bVerbose = bVerbose;
+  return ACRANSAC(kernel, vec_inliers, num_max_iteration, model, precision, options);
+}
+
 } // namespace robust
 } // namespace openMVG
 #endif // OPENMVG_ROBUST_ESTIMATOR_ACRANSAC_HPP
@@ -25,7 +25,18 @@
 // Mainly it add correct data normalization and define the required functions
 //  by the ACRANSAC algorithm.
 //
+// The residuals of all the data are computed by a batch ErrorT::Errors function
+//  if the ErrorT provides one (selected at compile time), else point by point.
+//  The batch functions work on row major copies of the data (each coordinate
+//  row is contiguous) so that the residual evaluation is vectorized.
+//
+// An optional NonMinimalSolver (a solver that accepts any number of samples
+//  above its own MINIMUM_SAMPLES) can be provided to enable FitNonMinimal,
+//  used by the local optimization of ACRANSAC.
+//
 
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "openMVG/multiview/conditioning.hpp"
@@ -35,6 +46,31 @@
 namespace openMVG {
 namespace robust{
 
+namespace internal
+{
+
+/// Tell if the ErrorT provides a batch residual evaluation function:
+///  ErrorT::Errors(model, data1, data2, std::vector<double> & errors)
+template <typename ErrorT, typename ModelT, typename Data1T, typename Data2T>
+class HasBatchErrors
+{
+  template <typename T>
+  static auto Test(int) -> decltype(
+    T::Errors(std::declval<const ModelT &>(),
+              std::declval<const Data1T &>(),
+              std::declval<const Data2T &>(),
+              std::declval<std::vector<double> &>()),
+    std::true_type());
+
+  template <typename T>
+  static std::false_type Test(...);
+
+public:
+  static constexpr bool value = decltype(Test<ErrorT>(0))::value;
+};
+
+} // namespace internal
+
 enum AContrarioParametrizationType
 {
   POINT_TO_LINE = 0,
@@ -107,13 +143,15 @@ constexpr double ACParametrizationHelper<AContrarioParametrizationType::RADIAN_A
 template <typename SolverArg,
           typename ErrorArg,
           typename UnnormalizerArg,
-          typename ModelArg = Mat3>
+          typename ModelArg = Mat3,
+          typename NonMinimalSolverArg = void>
 class ACKernelAdaptor
 {
 public:
   using Solver = SolverArg;
   using Model = ModelArg;
   using ErrorT = ErrorArg;
+  using NonMinimalSolver = NonMinimalSolverArg;
 
   ACKernelAdaptor(
     const Mat &x1, int w1, int h1,
@@ -127,6 +165,11 @@ public:
 
     NormalizePoints(x1, &x1_, &N1_, w1, h1);
     NormalizePoints(x2, &x2_, &N2_, w2, h2);
+    if (BATCH_ERRORS)
+    {
+      x1_soa_ = x1_;
+      x2_soa_ = x2_;
+    }
 
     // LogAlpha0 is used to make error data scale invariant
     logalpha0_ =
@@ -149,6 +192,20 @@ public:
     Solver::Solve(x1, x2, models);
   }
 
+  template <typename S = NonMinimalSolver>
+  typename std::enable_if<!std::is_void<S>::value>::type FitNonMinimal
+  (
+    const std::vector<uint32_t> &samples,
+    std::vector<Model> *models
+  ) const
+  {
+    if (samples.size() < S::MINIMUM_SAMPLES)
+      return;
+    const auto x1 = ExtractColumns(x1_, samples);
+    const auto x2 = ExtractColumns(x2_, samples);
+    S::Solve(x1, x2, models);
+  }
+
   double Error
   (
     uint32_t sample,
@@ -164,9 +221,7 @@ public:
     std::vector<double> & vec_errors
   ) const
   {
-    vec_errors.resize(x1_.cols());
-    for (uint32_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x1_.col(sample), x2_.col(sample));
+    Errors(model, vec_errors, std::integral_constant<bool, BATCH_ERRORS>());
   }
 
   size_t NumSamples() const
@@ -194,7 +249,33 @@ public:
   double unormalizeError(double val) const {return sqrt(val) / N2_(0,0);}
 
 private:
+  static constexpr bool BATCH_ERRORS =
+    internal::HasBatchErrors<ErrorT, Model, RMat2X, RMat2X>::value;
+
+  void Errors
+  (
+    const Model & model,
+    std::vector<double> & vec_errors,
+    std::true_type // batch residual evaluation
+  ) const
+  {
+    ErrorT::Errors(model, x1_soa_, x2_soa_, vec_errors);
+  }
+
+  void Errors
+  (
+    const Model & model,
+    std::vector<double> & vec_errors,
+    std::false_type // point by point residual evaluation
+  ) const
+  {
+    vec_errors.resize(x1_.cols());
+    for (uint32_t sample = 0; sample < x1_.cols(); ++sample)
+      vec_errors[sample] = ErrorT::Error(model, x1_.col(sample), x2_.col(sample));
+  }
+
   Mat x1_, x2_;       // Normalized input data
+  RMat2X x1_soa_, x2_soa_; // Normalized input data (row major copy used by the batch errors)
   Mat3 N1_, N2_;      // Matrix used to normalize data
   double logalpha0_;  // Alpha0 is used to make the error adaptive to the image size
   bool bPointToLine_; // Store if error model is pointToLine or point to point
@@ -210,13 +291,15 @@ struct UnnormalizerResection {
 template <typename SolverArg,
   typename ErrorArg,
   typename UnnormalizerArg,
-  typename ModelArg = Mat34>
+  typename ModelArg = Mat34,
+  typename NonMinimalSolverArg = void>
 class ACKernelAdaptorResection
 {
 public:
   using Solver = SolverArg;
   using Model = ModelArg;
   using ErrorT = ErrorArg;
+  using NonMinimalSolver = NonMinimalSolverArg;
 
   ACKernelAdaptorResection
   (
@@ -235,6 +318,11 @@ public:
     assert(x2d_.cols() == x3D_.cols());
 
     NormalizePoints(x2d, &x2d_, &N1_, w, h);
+    if (BATCH_ERRORS)
+    {
+      x2d_soa_ = x2d_;
+      x3D_soa_ = x3D_;
+    }
   }
 
   enum { MINIMUM_SAMPLES = Solver::MINIMUM_SAMPLES };
@@ -251,6 +339,20 @@ public:
     Solver::Solve(x1, x2, models);
   }
 
+  template <typename S = NonMinimalSolver>
+  typename std::enable_if<!std::is_void<S>::value>::type FitNonMinimal
+  (
+    const std::vector<uint32_t> &samples,
+    std::vector<Model> *models
+  ) const
+  {
+    if (samples.size() < S::MINIMUM_SAMPLES)
+      return;
+    const auto x1 = ExtractColumns(x2d_, samples);
+    const auto x2 = ExtractColumns(x3D_, samples);
+    S::Solve(x1, x2, models);
+  }
+
   double Error(uint32_t sample, const Model &model) const
   {
     return ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
@@ -262,9 +364,7 @@ public:
     std::vector<double> & vec_errors
   ) const
   {
-    vec_errors.resize(x2d_.cols());
-    for (uint32_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    Errors(model, vec_errors, std::integral_constant<bool, BATCH_ERRORS>());
   }
 
   size_t NumSamples() const { return x2d_.cols(); }
@@ -281,8 +381,35 @@ public:
   double unormalizeError(double val) const {return sqrt(val) / N1_(0,0);}
 
 private:
+  static constexpr bool BATCH_ERRORS =
+    internal::HasBatchErrors<ErrorT, Model, RMat2X, RMat3X>::value;
+
+  void Errors
+  (
+    const Model & model,
+    std::vector<double> & vec_errors,
+    std::true_type // batch residual evaluation
+  ) const
+  {
+    ErrorT::Errors(model, x2d_soa_, x3D_soa_, vec_errors);
+  }
+
+  void Errors
+  (
+    const Model & model,
+    std::vector<double> & vec_errors,
+    std::false_type // point by point residual evaluation
+  ) const
+  {
+    vec_errors.resize(x2d_.cols());
+    for (uint32_t sample = 0; sample < x2d_.cols(); ++sample)
+      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+  }
+
   Mat x2d_;
   const Mat & x3D_;
+  RMat2X x2d_soa_;   // Row major copies of the data used by the batch errors
+  RMat3X x3D_soa_;
   Mat3 N1_;          // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
 };
@@ -290,13 +417,15 @@ private:
 /// Essential matrix Kernel adaptor for the A contrario model estimator
 template <typename SolverArg,
   typename ErrorArg,
-  typename ModelArg = Mat3>
+  typename ModelArg = Mat3,
+  typename NonMinimalSolverArg = void>
 class ACKernelAdaptorEssential
 {
 public:
   using Solver = SolverArg;
   using Model = ModelArg;
   using ErrorT = ErrorArg;
+  using NonMinimalSolver = NonMinimalSolverArg;
 
   ACKernelAdaptorEssential
   (
@@ -320,6 +449,11 @@ public:
     assert(bearing1_.cols() == bearing2_.cols());
 
     logalpha0_ = ACParametrizationHelper<AContrarioParametrizationType::POINT_TO_LINE>::LogAlpha0(w2, h2, 0.5);
+    if (BATCH_ERRORS)
+    {
+      x1_soa_ = x1_;
+      x2_soa_ = x2_;
+    }
   }
 
   enum { MINIMUM_SAMPLES = Solver::MINIMUM_SAMPLES };
@@ -336,6 +470,20 @@ public:
     Solver::Solve(x1, x2, models);
   }
 
+  template <typename S = NonMinimalSolver>
+  typename std::enable_if<!std::is_void<S>::value>::type FitNonMinimal
+  (
+    const std::vector<uint32_t> &samples,
+    std::vector<Model> *models
+  ) const
+  {
+    if (samples.size() < S::MINIMUM_SAMPLES)
+      return;
+    const auto x1 = ExtractColumns(bearing1_, samples);
+    const auto x2 = ExtractColumns(bearing2_, samples);
+    S::Solve(x1, x2, models);
+  }
+
   double Error
   (
     uint32_t sample,
@@ -355,9 +503,7 @@ public:
   {
     Mat3 F;
     FundamentalFromEssential(model, K1_, K2_, &F);
-    vec_errors.resize(x1_.cols());
-    for (uint32_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(F, this->x1_.col(sample), this->x2_.col(sample));
+    Errors(F, vec_errors, std::integral_constant<bool, BATCH_ERRORS>());
   }
 
   size_t NumSamples() const { return x1_.cols(); }
@@ -369,7 +515,33 @@ public:
   double unormalizeError(double val) const { return val; }
 
 private:
+  static constexpr bool BATCH_ERRORS =
+    internal::HasBatchErrors<ErrorT, Mat3, RMat2X, RMat2X>::value;
+
+  void Errors
+  (
+    const Mat3 & F,
+    std::vector<double> & vec_errors,
+    std::true_type // batch residual evaluation
+  ) const
+  {
+    ErrorT::Errors(F, x1_soa_, x2_soa_, vec_errors);
+  }
+
+  void Errors
+  (
+    const Mat3 & F,
+    std::vector<double> & vec_errors,
+    std::false_type // point by point residual evaluation
+  ) const
+  {
+    vec_errors.resize(x1_.cols());
+    for (uint32_t sample = 0; sample < x1_.cols(); ++sample)
+      vec_errors[sample] = ErrorT::Error(F, this->x1_.col(sample), this->x2_.col(sample));
+  }
+
   Mat2X x1_, x2_;             // image points
+  RMat2X x1_soa_, x2_soa_;    // image points (row major copy used by the batch errors)
   Mat3X bearing1_, bearing2_; // bearing vectors
   Mat3 N1_, N2_;              // Matrix used to normalize data
   double logalpha0_;          // Alpha0 is used to make the error adaptive to the image size
@@ -480,6 +652,11 @@ public:
     assert(3 == x1_.rows());
     assert(x1_.rows() == x2_.rows());
     assert(x1_.cols() == x2_.cols());
+    if (BATCH_ERRORS)
+    {
+      x1_soa_ = x1_;
+      x2_soa_ = x2_;
+    }
   }
 
   enum { MINIMUM_SAMPLES = Solver::MINIMUM_SAMPLES };
@@ -511,9 +688,7 @@ public:
     std::vector<double> & vec_errors
   ) const
   {
-    vec_errors.resize(x1_.cols());
-    for (uint32_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = Square(ErrorT::Error(model, x1_.col(sample), x2_.col(sample)));
+    Errors(model, vec_errors, std::integral_constant<bool, BATCH_ERRORS>());
   }
 
   size_t NumSamples() const
@@ -534,7 +709,35 @@ public:
   double unormalizeError(double val) const {return sqrt(val);}
 
 private:
+  static constexpr bool BATCH_ERRORS =
+    internal::HasBatchErrors<ErrorT, Model, RMat3X, RMat3X>::value;
+
+  void Errors
+  (
+    const Model & model,
+    std::vector<double> & vec_errors,
+    std::true_type // batch residual evaluation
+  ) const
+  {
+    ErrorT::Errors(model, x1_soa_, x2_soa_, vec_errors);
+    for (auto & error : vec_errors)
+      error *= error;
+  }
+
+  void Errors
+  (
+    const Model & model,
+    std::vector<double> & vec_errors,
+    std::false_type // point by point residual evaluation
+  ) const
+  {
+    vec_errors.resize(x1_.cols());
+    for (uint32_t sample = 0; sample < x1_.cols(); ++sample)
+      vec_errors[sample] = Square(ErrorT::Error(model, x1_.col(sample), x2_.col(sample)));
+  }
+
   Mat x1_, x2_;       // Normalized input data
+  RMat3X x1_soa_, x2_soa_; // Row major copy of the data used by the batch errors
   double logalpha0_;  // Alpha0 is used to make the error scale invariant
 };
 
@@ -15,6 +15,7 @@
 #include "third_party/vectorGraphics/svgDrawer.hpp"
 
 #include <iterator>
+#include <numeric>
 #include <random>
 
 
@@ -53,6 +54,11 @@ public:
     Solver::Solve(sampled_xs, models);
   }
 
+  // The line solver is a least squares fit: it accepts any number of points
+  void FitNonMinimal(const std::vector<uint32_t> &samples, std::vector<Model> *models) const {
+    Fit(samples, models);
+  }
+
   double Error(uint32_t sample, const Model &model) const {
     return ErrorArg::Error(model, x1_.col(sample));
   }
@@ -364,6 +370,107 @@ TEST(RansacLineFitter, ACRANSACSimu) {
   }
 }
 
+// Compare ACRANSAC with and without the SPRT hypothesis verification
+//  on large contaminated line datasets: the found models must be similar.
+TEST(RansacLineFitter, ACRANSAC_SPRT) {
+
+  const int W = 1000, H = 1000;
+  for (const size_t nbPoints : {1000, 10000})
+  for (const float outlierRatio : {.3f, .6f})
+  for (const double precision : {std::numeric_limits<double>::infinity(), 16.0})
+  {
+    Mat points;
+    generateLine(points, nbPoints, W, H, 1.0f, outlierRatio);
+    ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, W, H);
+
+    std::vector<uint32_t> vec_inliers, vec_inliers_sprt;
+    Vec2 line, line_sprt;
+    ACRANSAC_Options options_sprt;
+    options_sprt.bSPRT = true;
+
+    const std::pair<double,double> ret =
+      ACRANSAC(lineKernel, vec_inliers, 1024, &line, precision);
+    const std::pair<double,double> ret_sprt =
+      ACRANSAC(lineKernel, vec_inliers_sprt, 1024, &line_sprt, precision, options_sprt);
+
+    // A meaningful model is found.
+    // Since some hypotheses are rejected, the local optimization does not
+    //  follow the same path: the results are close but not identical.
+    EXPECT_TRUE(ret_sprt.second < 0);
+    EXPECT_NEAR(vec_inliers.size(), vec_inliers_sprt.size(), 0.1 * vec_inliers.size());
+    EXPECT_NEAR(line[1], line_sprt[1], 1e-2);
+  }
+}
+
+TEST(RansacLineFitter, ACRANSAC_PROSAC) {
+
+  const int W = 1000, H = 1000;
+  const size_t nbPoints = 1000;
+  const Vec2 GTModel(50, 0.3);
+  Mat points;
+  generateLine(points, nbPoints, W, H, 1.0f, .95f);
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, W, H);
+
+  // Simulate a matching quality score (i.e. a distance ratio):
+  //  the inliers have a better score on average.
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<float> scores(nbPoints);
+  for (size_t i = 0; i < nbPoints; ++i)
+  {
+    const bool is_inlier = pointToLineError::Error(GTModel, points.col(i)) < Square(5.0);
+    scores[i] = is_inlier ? .8f * dist(random_generator) : .2f + .8f * dist(random_generator);
+  }
+  std::vector<uint32_t> ranking(nbPoints);
+  std::iota(ranking.begin(), ranking.end(), 0);
+  std::stable_sort(ranking.begin(), ranking.end(),
+    [&scores](const uint32_t a, const uint32_t b) { return scores[a] < scores[b]; });
+
+  // Only 5% of inliers: with a small number of iterations the progressive
+  //  sampling finds the line.
+  ACRANSAC_Options options;
+  options.sampling_ranking = &ranking;
+  std::vector<uint32_t> vec_inliers;
+  Vec2 line;
+  const std::pair<double,double> ret =
+    ACRANSAC(lineKernel, vec_inliers, 64, &line,
+      std::numeric_limits<double>::infinity(), options);
+  EXPECT_TRUE(ret.second < 0);
+  EXPECT_NEAR(GTModel(1), line[1], 1e-2);
+  EXPECT_TRUE(vec_inliers.size() >= 0.04 * nbPoints);
+}
+
+// With a small number of iterations on a noisy line, the local optimization
+//  refines the minimal sample models: a better NFA and a more accurate line are found.
+TEST(RansacLineFitter, ACRANSAC_LocalOptimization) {
+
+  const int W = 1000, H = 1000;
+  const size_t nbPoints = 1000;
+  const Vec2 GTModel(50, 0.3);
+  for (const float outlierRatio : {.3f, .6f})
+  {
+    Mat points;
+    generateLine(points, nbPoints, W, H, 3.0f, outlierRatio);
+    ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, W, H);
+
+    ACRANSAC_Options options_lo;
+    options_lo.bLocalOptimization = true;
+
+    std::vector<uint32_t> vec_inliers, vec_inliers_lo;
+    Vec2 line, line_lo;
+    const std::pair<double,double> ret =
+      ACRANSAC(lineKernel, vec_inliers, 16, &line);
+    const std::pair<double,double> ret_lo =
+      ACRANSAC(lineKernel, vec_inliers_lo, 16, &line_lo,
+        std::numeric_limits<double>::infinity(), options_lo);
+
+    EXPECT_TRUE(ret_lo.second < 0);
+    EXPECT_TRUE(ret_lo.second <= ret.second);
+    EXPECT_NEAR(GTModel(0), line_lo[0], 2.0);
+    EXPECT_NEAR(GTModel(1), line_lo[1], 5e-3);
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -11,6 +11,9 @@
 #include "openMVG/cameras/Camera_Common.hpp"
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/cameras/Camera_Pinhole_Brown.hpp"
+#include "openMVG/cameras/Camera_Pinhole_Fisheye.hpp"
+#include "openMVG/cameras/Camera_Pinhole_Radial.hpp"
 #include "openMVG/multiview/solver_resection_kernel.hpp"
 #include "openMVG/multiview/solver_resection_p3p.hpp"
 #include "openMVG/multiview/solver_resection_up2p_kukelova.hpp"
@@ -143,18 +146,22 @@ namespace sfm {
             SolverType,
             resection::SquaredPixelReprojectionError,
             openMVG::robust::UnnormalizerResection,
-            Mat34>;
+            Mat34,
+            SolverType>; // The DLT is also used for the local optimization
 
         KernelType kernel(resection_data.pt2D, image_size.first, image_size.second,
           resection_data.pt3D);
         // Robust estimation of the pose and its precision
+        openMVG::robust::ACRANSAC_Options acransac_options;
+        acransac_options.bVerbose = true;
+        acransac_options.bLocalOptimization = resection_data.b_local_optimization;
         const std::pair<double,double> ACRansacOut =
           openMVG::robust::ACRANSAC(kernel,
                                     resection_data.vec_inliers,
                                     resection_data.max_iteration,
                                     &P,
                                     dPrecision,
-                                    true);
+                                    acransac_options);
         // Update the upper bound precision of the model found by AC-RANSAC
         resection_data.error_max = ACRansacOut.first;
       }
@@ -367,5 +374,37 @@ namespace sfm {
     return b_BA_Status;
   }
 
+  std::shared_ptr<cameras::IntrinsicBase> SfM_Localizer::CreateIntrinsic
+  (
+    const cameras::EINTRINSIC camera_model,
+    const Pair & image_size,
+    const Mat34 & projection_matrix
+  )
+  {
+    Mat3 K, R;
+    Vec3 t;
+    KRt_From_P(projection_matrix, &K, &R, &t);
+
+    const int width = image_size.first, height = image_size.second;
+    const double focal = (K(0,0) + K(1,1))/2.0;
+    const Vec2 principal_point(K(0,2), K(1,2));
+
+    switch (camera_model)
+    {
+      case cameras::PINHOLE_CAMERA:
+        return std::make_shared<cameras::Pinhole_Intrinsic>(width, height, focal, principal_point(0), principal_point(1));
+      case cameras::PINHOLE_CAMERA_RADIAL1:
+        return std::make_shared<cameras::Pinhole_Intrinsic_Radial_K1>(width, height, focal, principal_point(0), principal_point(1));
+      case cameras::PINHOLE_CAMERA_RADIAL3:
+        return std::make_shared<cameras::Pinhole_Intrinsic_Radial_K3>(width, height, focal, principal_point(0), principal_point(1));
+      case cameras::PINHOLE_CAMERA_BROWN:
+        return std::make_shared<cameras::Pinhole_Intrinsic_Brown_T2>(width, height, focal, principal_point(0), principal_point(1));
+      case cameras::PINHOLE_CAMERA_FISHEYE:
+        return std::make_shared<cameras::Pinhole_Intrinsic_Fisheye>(width, height, focal, principal_point(0), principal_point(1));
+      default:
+        return {};
+    }
+  }
+
 } // namespace sfm
 } // namespace openMVG
@@ -10,8 +10,10 @@
 #define OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_HPP
 
 #include <limits>
+#include <memory>
 #include <vector>
 
+#include "openMVG/cameras/Camera_Common.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 #include "openMVG/multiview/solver_resection.hpp"
 #include "openMVG/types.hpp"
@@ -34,6 +36,9 @@ struct Image_Localizer_Match_Data
   // Upper bound pixel(s) tolerance for residual errors
   double error_max = std::numeric_limits<double>::infinity();
   uint32_t max_iteration = 4096;
+  // Refine the poses with the LO-RANSAC local optimization
+  //  (used only by the DLT resection)
+  bool b_local_optimization = false;
 };
 
 class SfM_Localizer
@@ -113,6 +118,22 @@ public:
     bool b_refine_pose,
     bool b_refine_intrinsic
   );
+
+  /**
+  * @brief Create a camera model from a found projection matrix
+  *  (focal and principal point from its KRt decomposition, no distortion)
+  *
+  * @param[in] camera_model the type of the camera model to create
+  * @param[in] image_size the w,h image size
+  * @param[in] projection_matrix the found projection matrix
+  * @return The camera model (nullptr if the type cannot be created from a projection matrix)
+  */
+  static std::shared_ptr<cameras::IntrinsicBase> CreateIntrinsic
+  (
+    const cameras::EINTRINSIC camera_model,
+    const Pair & image_size,
+    const Mat34 & projection_matrix
+  );
 };
 
 } // namespace sfm
@@ -6,22 +6,112 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/portable_binary.hpp>
+
 #include "openMVG/sfm/pipelines/localization/SfM_Localizer_Single_3DTrackObservation_Database.hpp"
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/features/regions_factory_io.hpp"
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/system/logger.hpp"
 
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+
+#include <cereal/types/memory.hpp>
+#include <cereal/types/vector.hpp>
+
 using namespace openMVG::matching;
 
 namespace openMVG {
 namespace sfm {
 
+namespace {
+
+// A landmark observation descriptor: (view regions, feature index)
+using ObservationDescriptor = std::pair<std::shared_ptr<features::Regions>, IndexT>;
+
+const uint32_t LOCALIZATION_DATABASE_VERSION = 1;
+
+// Select at most max_count representative observation descriptors
+// (greedy k-medoids): iteratively keep the descriptor that reduces the most
+// the sum of the distances of the observations to their closest representative.
+// The first selected descriptor is the medoid of the observations.
+std::vector<size_t> SelectRepresentativeDescriptors
+(
+  const std::vector<ObservationDescriptor> & observations,
+  size_t max_count
+)
+{
+  const size_t count = observations.size();
+  std::vector<size_t> selected;
+  if (count <= max_count)
+  {
+    selected.resize(count);
+    for (size_t i = 0; i < count; ++i)
+      selected[i] = i;
+    return selected;
+  }
+
+  Mat distances(count, count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    distances(i, i) = 0.0;
+    for (size_t j = i + 1; j < count; ++j)
+    {
+      distances(i, j) = distances(j, i) =
+        observations[i].first->SquaredDescriptorDistance(
+          observations[i].second,
+          observations[j].first.get(),
+          observations[j].second);
+    }
+  }
+
+  std::vector<double> closest_distance(count, std::numeric_limits<double>::max());
+  std::vector<bool> is_selected(count, false);
+  while (selected.size() < max_count)
+  {
+    size_t best_candidate = 0;
+    double best_cost = std::numeric_limits<double>::max();
+    for (size_t candidate = 0; candidate < count; ++candidate)
+    {
+      if (is_selected[candidate])
+        continue;
+      double cost = 0.0;
+      for (size_t j = 0; j < count; ++j)
+        cost += std::min(closest_distance[j], distances(candidate, j));
+      if (cost < best_cost)
+      {
+        best_cost = cost;
+        best_candidate = candidate;
+      }
+    }
+    is_selected[best_candidate] = true;
+    selected.push_back(best_candidate);
+    for (size_t j = 0; j < count; ++j)
+      closest_distance[j] = std::min(closest_distance[j], distances(best_candidate, j));
+  }
+  return selected;
+}
+
+} // namespace
+
   SfM_Localization_Single_3DTrackObservation_Database::
-  SfM_Localization_Single_3DTrackObservation_Database()
-  :SfM_Localizer()
+  SfM_Localization_Single_3DTrackObservation_Database
+  (
+    IndexT max_descriptors_per_landmark
+  )
+  :SfM_Localizer(),
+  max_descriptors_per_landmark_(max_descriptors_per_landmark),
+  sfm_data_(nullptr)
   {}
 
   bool
@@ -43,19 +133,31 @@ namespace sfm {
     // - link each observation region to a track id to ease 2D-3D correspondences search
 
     landmark_observations_descriptors_.reset(regions_provider.getRegionsType()->EmptyClone());
+    index_to_landmark_id_.clear();
+    std::vector<ObservationDescriptor> observations;
     for (const auto & landmark : sfm_data.GetLandmarks())
     {
+      observations.clear();
       for (const auto & observation : landmark.second.obs)
       {
         if (observation.second.id_feat != UndefinedIndexT)
         {
-          // copy the feature/descriptor to landmark_observations_descriptors
-          const std::shared_ptr<features::Regions> view_regions = regions_provider.get(observation.first);
-          view_regions->CopyRegion(observation.second.id_feat, landmark_observations_descriptors_.get());
-          // link this descriptor to the track Id
-          index_to_landmark_id_.push_back(landmark.first);
+          observations.emplace_back(regions_provider.get(observation.first),
+                                    observation.second.id_feat);
         }
       }
+      const size_t max_count = (max_descriptors_per_landmark_ > 0) ?
+        max_descriptors_per_landmark_ : observations.size();
+      const std::vector<size_t> kept_observations =
+        SelectRepresentativeDescriptors(observations, max_count);
+      for (const size_t observation_index : kept_observations)
+      {
+        // copy the feature/descriptor to landmark_observations_descriptors
+        const ObservationDescriptor & observation = observations[observation_index];
+        observation.first->CopyRegion(observation.second, landmark_observations_descriptors_.get());
+        // link this descriptor to the track Id
+        index_to_landmark_id_.push_back(landmark.first);
+      }
     }
     OPENMVG_LOG_INFO << "Init retrieval database ... ";
     // Initialize the matching interface
@@ -69,19 +171,171 @@ namespace sfm {
       << "#descriptors: " << landmark_observations_descriptors_->RegionCount();
 
     sfm_data_ = &sfm_data;
+    InitCovisibility();
 
     return true;
   }
 
   bool
-  SfM_Localization_Single_3DTrackObservation_Database::Localize
+  SfM_Localization_Single_3DTrackObservation_Database::Save
+  (
+    const std::string & database_filename
+  ) const
+  {
+    if (!landmark_observations_descriptors_ || !matching_interface_)
+    {
+      OPENMVG_LOG_ERROR << "The retrieval database is not initialized.";
+      return false;
+    }
+
+    std::ofstream stream(database_filename.c_str(), std::ios::out | std::ios::binary);
+    if (!stream)
+    {
+      OPENMVG_LOG_ERROR << "Cannot open the localization database file: " << database_filename;
+      return false;
+    }
+    try
+    {
+      cereal::PortableBinaryOutputArchive archive(stream);
+      archive(LOCALIZATION_DATABASE_VERSION,
+              landmark_observations_descriptors_,
+              index_to_landmark_id_);
+    }
+    catch (const cereal::Exception & e)
+    {
+      OPENMVG_LOG_ERROR << e.what();
+      return false;
+    }
+    if (!stream.good())
+      return false;
+    stream.close();
+
+    // The search structure is optional (not all the matchers support it)
+    if (!matching_interface_->SaveIndex(database_filename + ".index"))
+    {
+      OPENMVG_LOG_INFO << "The matcher search structure cannot be saved,"
+        << " it will be rebuilt at loading.";
+    }
+    return true;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::Load
+  (
+    const SfM_Data & sfm_data,
+    const features::Regions & regions_type,
+    const std::string & database_filename
+  )
+  {
+    std::ifstream stream(database_filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream)
+    {
+      OPENMVG_LOG_ERROR << "Cannot open the localization database file: " << database_filename;
+      return false;
+    }
+
+    uint32_t version = 0;
+    std::unique_ptr<features::Regions> regions;
+    std::vector<IndexT> index_to_landmark_id;
+    try
+    {
+      cereal::PortableBinaryInputArchive archive(stream);
+      archive(version);
+      if (version != LOCALIZATION_DATABASE_VERSION)
+      {
+        OPENMVG_LOG_ERROR << "Unsupported localization database version: " << version;
+        return false;
+      }
+      archive(regions, index_to_landmark_id);
+    }
+    catch (const cereal::Exception & e)
+    {
+      OPENMVG_LOG_ERROR << e.what();
+      return false;
+    }
+
+    if (!regions
+        || regions->Type_id() != regions_type.Type_id()
+        || regions->DescriptorLength() != regions_type.DescriptorLength())
+    {
+      OPENMVG_LOG_ERROR << "The localization database regions type is invalid.";
+      return false;
+    }
+    if (regions->RegionCount() != index_to_landmark_id.size())
+    {
+      OPENMVG_LOG_ERROR << "The localization database is corrupted.";
+      return false;
+    }
+    // Check that the database is related to the given scene
+    for (const IndexT landmark_id : index_to_landmark_id)
+    {
+      if (sfm_data.GetLandmarks().count(landmark_id) == 0)
+      {
+        OPENMVG_LOG_ERROR << "The localization database does not match the scene landmarks.";
+        return false;
+      }
+    }
+
+    // Apply the requested descriptor limit if the database keeps more descriptors per landmark
+    bool b_compacted = false;
+    if (max_descriptors_per_landmark_ > 0)
+    {
+      std::map<IndexT, std::vector<IndexT>> landmark_descriptors;
+      for (IndexT i = 0; i < index_to_landmark_id.size(); ++i)
+        landmark_descriptors[index_to_landmark_id[i]].push_back(i);
+      for (const auto & landmark : landmark_descriptors)
+        b_compacted |= (landmark.second.size() > max_descriptors_per_landmark_);
+
+      if (b_compacted)
+      {
+        const std::shared_ptr<features::Regions> loaded_regions(std::move(regions));
+        regions.reset(loaded_regions->EmptyClone());
+        index_to_landmark_id.clear();
+        std::vector<ObservationDescriptor> observations;
+        for (const auto & landmark : landmark_descriptors)
+        {
+          observations.clear();
+          for (const IndexT descriptor_id : landmark.second)
+            observations.emplace_back(loaded_regions, descriptor_id);
+          for (const size_t observation_index :
+               SelectRepresentativeDescriptors(observations, max_descriptors_per_landmark_))
+          {
+            loaded_regions->CopyRegion(observations[observation_index].second, regions.get());
+            index_to_landmark_id.push_back(landmark.first);
+          }
+        }
+        OPENMVG_LOG_INFO << "The localization database is compacted to "
+          << max_descriptors_per_landmark_ << " descriptors per landmark: "
+          << loaded_regions->RegionCount() << " -> " << regions->RegionCount() << " descriptors.";
+      }
+    }
+
+    landmark_observations_descriptors_ = std::move(regions);
+    index_to_landmark_id_ = std::move(index_to_landmark_id);
+
+    // Initialize the matching interface
+    // (reuse the saved search structure if any and if the descriptors are unchanged)
+    matching_interface_ =
+      RegionMatcherFactory(matching::ANN_L2, *landmark_observations_descriptors_,
+                           b_compacted ? std::string() : database_filename + ".index");
+    if (!matching_interface_)
+      return false;
+
+    OPENMVG_LOG_INFO << "Retrieval database loaded with:\n"
+      << "#landmarks: " << sfm_data.GetLandmarks().size() << "\n"
+      << "#descriptors: " << landmark_observations_descriptors_->RegionCount();
+
+    sfm_data_ = &sfm_data;
+    InitCovisibility();
+
+    return true;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::MatchLandmarks
   (
-    const resection::SolverType & solver_type,
-    const Pair & image_size,
-    const cameras::IntrinsicBase * optional_intrinsics,
     const features::Regions & query_regions,
-    geometry::Pose3 & pose,
-    Image_Localizer_Match_Data * resection_data_ptr
+    Image_Localizer_Match_Data & resection_data
   ) const
   {
     if (!sfm_data_ || !matching_interface_)
@@ -98,26 +352,194 @@ namespace sfm {
 
     OPENMVG_LOG_INFO << "#3D2d putative correspondences: " << vec_putative_matches.size();
     // Init the 3D-2d correspondences array
-    Image_Localizer_Match_Data resection_data;
-    if (resection_data_ptr)
-    {
-      resection_data.error_max = resection_data_ptr->error_max;
-    }
     resection_data.pt3D.resize(3, vec_putative_matches.size());
     resection_data.pt2D.resize(2, vec_putative_matches.size());
-    Mat2X pt2D_original(2, vec_putative_matches.size());
     for (size_t i = 0; i < vec_putative_matches.size(); ++i)
     {
       resection_data.pt3D.col(i) = sfm_data_->GetLandmarks().at(index_to_landmark_id_[vec_putative_matches[i].i_]).X;
       resection_data.pt2D.col(i) = query_regions.GetRegionPosition(vec_putative_matches[i].j_);
-      pt2D_original.col(i) = resection_data.pt2D.col(i);
-      // Handle image distortion if intrinsic is known (to ease the resection)
-      if (optional_intrinsics && optional_intrinsics->have_disto())
+    }
+    return true;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::MatchCovisibleLandmarks
+  (
+    const features::Regions & query_regions,
+    const std::vector<IndexT> & prior_view_ids,
+    size_t covisible_view_count,
+    Image_Localizer_Match_Data & resection_data
+  ) const
+  {
+    if (!sfm_data_ || !landmark_observations_descriptors_)
+    {
+      OPENMVG_LOG_ERROR << "Invalid sfm_data or invalid database.";
+      return false;
+    }
+
+    // Select the prior views known by the database
+    std::set<IndexT> selected_views;
+    for (const IndexT view_id : prior_view_ids)
+    {
+      if (view_to_landmark_ids_.count(view_id))
+        selected_views.insert(view_id);
+    }
+    if (selected_views.empty())
+      return false;
+
+    // Expand the prior views with their most covisible views:
+    //  rank the other views by the number of landmarks shared with the prior views
+    if (covisible_view_count > 0)
+    {
+      Hash_Map<IndexT, uint32_t> covisibility;
+      for (const IndexT view_id : selected_views)
+      {
+        for (const IndexT landmark_id : view_to_landmark_ids_.at(view_id))
+        {
+          for (const auto & observation : sfm_data_->GetLandmarks().at(landmark_id).obs)
+          {
+            if (selected_views.count(observation.first) == 0)
+              ++covisibility[observation.first];
+          }
+        }
+      }
+      std::vector<std::pair<uint32_t, IndexT>> covisible_views;
+      covisible_views.reserve(covisibility.size());
+      for (const auto & covisible_view : covisibility)
+        covisible_views.emplace_back(covisible_view.second, covisible_view.first);
+      const size_t count = std::min(covisible_view_count, covisible_views.size());
+      std::partial_sort(covisible_views.begin(), covisible_views.begin() + count,
+                        covisible_views.end(),
+                        std::greater<std::pair<uint32_t, IndexT>>());
+      for (size_t i = 0; i < count; ++i)
       {
-        resection_data.pt2D.col(i) = optional_intrinsics->get_ud_pixel(resection_data.pt2D.col(i));
+        if (view_to_landmark_ids_.count(covisible_views[i].second))
+          selected_views.insert(covisible_views[i].second);
       }
     }
 
+    // Select the descriptors of the landmarks seen by the selected views
+    std::set<IndexT> candidate_landmarks;
+    for (const IndexT view_id : selected_views)
+    {
+      const auto & landmark_ids = view_to_landmark_ids_.at(view_id);
+      candidate_landmarks.insert(landmark_ids.cbegin(), landmark_ids.cend());
+    }
+    std::vector<bool> candidate_descriptors(landmark_observations_descriptors_->RegionCount(), false);
+    size_t candidate_descriptor_count = 0;
+    for (const IndexT landmark_id : candidate_landmarks)
+    {
+      const auto it = landmark_to_descriptor_indices_.find(landmark_id);
+      if (it == landmark_to_descriptor_indices_.cend())
+        continue;
+      for (const uint32_t descriptor_index : it->second)
+      {
+        candidate_descriptors[descriptor_index] = true;
+        ++candidate_descriptor_count;
+      }
+    }
+    OPENMVG_LOG_INFO << "Covisibility search: #views: " << selected_views.size()
+      << " #landmarks: " << candidate_landmarks.size()
+      << " #descriptors: " << candidate_descriptor_count
+      << " (database: " << landmark_observations_descriptors_->RegionCount() << ")";
+
+    // Match the query with the candidate descriptors
+    //  (search the neighbours in the database index and keep the candidate ones)
+    const size_t kNeighborCount = 16;
+    matching::IndMatches vec_putative_matches;
+    if (!matching_interface_ ||
+        !matching_interface_->MatchDistanceRatio(0.8, query_regions, candidate_descriptors,
+                                                 kNeighborCount, vec_putative_matches))
+    {
+      return false;
+    }
+
+    OPENMVG_LOG_INFO << "#3D2d putative correspondences: " << vec_putative_matches.size();
+    // Init the 3D-2d correspondences array
+    resection_data.pt3D.resize(3, vec_putative_matches.size());
+    resection_data.pt2D.resize(2, vec_putative_matches.size());
+    for (size_t i = 0; i < vec_putative_matches.size(); ++i)
+    {
+      resection_data.pt3D.col(i) = sfm_data_->GetLandmarks().at(index_to_landmark_id_[vec_putative_matches[i].i_]).X;
+      resection_data.pt2D.col(i) = query_regions.GetRegionPosition(vec_putative_matches[i].j_);
+    }
+    return true;
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::Localize
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    const features::Regions & query_regions,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr
+  ) const
+  {
+    Image_Localizer_Match_Data resection_data;
+    if (resection_data_ptr)
+    {
+      resection_data.error_max = resection_data_ptr->error_max;
+    }
+    if (!MatchLandmarks(query_regions, resection_data))
+    {
+      return false;
+    }
+    return LocalizeFromMatches(solver_type, image_size, optional_intrinsics,
+                               resection_data, pose, resection_data_ptr);
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::Localize
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    const features::Regions & query_regions,
+    const std::vector<IndexT> & prior_view_ids,
+    size_t covisible_view_count,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr
+  ) const
+  {
+    Image_Localizer_Match_Data resection_data;
+    const double error_max =
+      resection_data_ptr ? resection_data_ptr->error_max : resection_data.error_max;
+    resection_data.error_max = error_max;
+    if (MatchCovisibleLandmarks(query_regions, prior_view_ids, covisible_view_count, resection_data)
+        && LocalizeFromMatches(solver_type, image_size, optional_intrinsics,
+                               resection_data, pose, resection_data_ptr))
+    {
+      return true;
+    }
+    OPENMVG_LOG_INFO << "Covisibility search failed, use the whole database.";
+    if (resection_data_ptr)
+    {
+      resection_data_ptr->error_max = error_max; // restore the requested upper bound
+    }
+    return Localize(solver_type, image_size, optional_intrinsics,
+                    query_regions, pose, resection_data_ptr);
+  }
+
+  bool
+  SfM_Localization_Single_3DTrackObservation_Database::LocalizeFromMatches
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    Image_Localizer_Match_Data & resection_data,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr
+  ) const
+  {
+    Mat2X pt2D_original = resection_data.pt2D;
+    // Handle image distortion if intrinsic is known (to ease the resection)
+    if (optional_intrinsics && optional_intrinsics->have_disto())
+    {
+      resection_data.pt2D = optional_intrinsics->get_ud_pixels(resection_data.pt2D);
+    }
+
     const bool bResection =  SfM_Localizer::Localize(
       solver_type, image_size, optional_intrinsics, resection_data, pose);
 
@@ -129,5 +551,23 @@ namespace sfm {
     return bResection;
   }
 
+  void
+  SfM_Localization_Single_3DTrackObservation_Database::InitCovisibility()
+  {
+    view_to_landmark_ids_.clear();
+    for (const auto & landmark : sfm_data_->GetLandmarks())
+    {
+      for (const auto & observation : landmark.second.obs)
+      {
+        view_to_landmark_ids_[observation.first].push_back(landmark.first);
+      }
+    }
+    landmark_to_descriptor_indices_.clear();
+    for (uint32_t i = 0; i < index_to_landmark_id_.size(); ++i)
+    {
+      landmark_to_descriptor_indices_[index_to_landmark_id_[i]].push_back(i);
+    }
+  }
+
 } // namespace sfm
 } // namespace openMVG
@@ -9,6 +9,8 @@
 #ifndef OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_STO_DB_HPP
 #define OPENMVG_SFM_PIPELINES_LOCALIZATION_SFM_LOCALIZER_STO_DB_HPP
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "openMVG/matching/regions_matcher.hpp"
@@ -29,12 +31,28 @@ namespace sfm {
 // - create a large array with all the used descriptors and init a Matcher with it
 // - to localize an input image compare its regions to the database and robust estimate
 //   the pose from found 2d-3D correspondences
+//
+// The database (descriptors, landmark association and matcher search structure)
+// can be saved once and reloaded later on without accessing the scene regions.
+// Optionally the database can be compacted by keeping only a few representative
+// descriptors per landmark (greedy k-medoids on the observation descriptors).
+//
+// Covisibility mode (active search): if some similar views are known for the
+// query (i.e. image retrieval), the matching is restricted to the landmarks
+// seen by those views and by their most covisible views.
 
 class SfM_Localization_Single_3DTrackObservation_Database : public SfM_Localizer
 {
 public:
 
-  SfM_Localization_Single_3DTrackObservation_Database();
+  /**
+  * @param[in] max_descriptors_per_landmark if > 0, the maximal number of
+  *  representative descriptors kept per landmark (0: keep all the observations)
+  */
+  explicit SfM_Localization_Single_3DTrackObservation_Database
+  (
+    IndexT max_descriptors_per_landmark = 0
+  );
 
   /**
   * @brief Build the retrieval database (3D points descriptors)
@@ -70,7 +88,112 @@ public:
     Image_Localizer_Match_Data * resection_data_ptr = nullptr
   ) const override;
 
+  /**
+  * @brief Try to localize an image in the database by matching it only with
+  *  the landmarks seen by some prior views and their covisible views.
+  *  If the restricted matching or the resection fails, the whole database is used.
+  *
+  * @param[in] solver_type the type of absolute pose solver to use
+  * @param[in] image_size the w,h image size
+  * @param[in] optional_intrinsics camera intrinsic if known (else nullptr)
+  * @param[in] query_regions the image regions (type must be the same as the database)
+  * @param[in] prior_view_ids the scene views similar to the query (i.e. retrieved by VLAD)
+  * @param[in] covisible_view_count the number of covisible views used to
+  *  expand the prior views
+  * @param[out] pose found pose
+  * @param[out] resection_data matching data (2D-3D and inliers; optional)
+  * @return True if a putative pose has been estimated
+  */
+  bool Localize
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    const features::Regions & query_regions,
+    const std::vector<IndexT> & prior_view_ids,
+    size_t covisible_view_count,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr = nullptr
+  ) const;
+
+  /**
+  * @brief Find the putative 2D-3D correspondences of an image (first step of Localize)
+  *
+  * @param[in] query_regions the image regions (type must be the same as the database)
+  * @param[out] resection_data the putative correspondences (pt2D/pt3D)
+  * @return True if some putative correspondences have been found
+  */
+  bool MatchLandmarks
+  (
+    const features::Regions & query_regions,
+    Image_Localizer_Match_Data & resection_data
+  ) const;
+
+  /**
+  * @brief Find the putative 2D-3D correspondences of an image among the
+  *  landmarks seen by some prior views and their most covisible views.
+  *
+  * @param[in] query_regions the image regions (type must be the same as the database)
+  * @param[in] prior_view_ids the scene views similar to the query
+  * @param[in] covisible_view_count the number of covisible views used to
+  *  expand the prior views
+  * @param[out] resection_data the putative correspondences (pt2D/pt3D)
+  * @return True if some putative correspondences have been found
+  */
+  bool MatchCovisibleLandmarks
+  (
+    const features::Regions & query_regions,
+    const std::vector<IndexT> & prior_view_ids,
+    size_t covisible_view_count,
+    Image_Localizer_Match_Data & resection_data
+  ) const;
+
+  /**
+  * @brief Save the retrieval database to a file.
+  * The matcher search structure is saved alongside (database_filename + ".index").
+  *
+  * @param[in] database_filename the file where the database will be saved
+  * @return True if the database has been correctly saved
+  */
+  bool Save
+  (
+    const std::string & database_filename
+  ) const;
+
+  /**
+  * @brief Load a retrieval database saved with Save (replace Init).
+  * If a landmark has more descriptors than max_descriptors_per_landmark,
+  * the loaded database is compacted again (its matcher search structure is rebuilt).
+  *
+  * @param[in] sfm_data the SfM scene that was used to build the database
+  * @param[in] regions_type the expected regions type of the database
+  * @param[in] database_filename the file where the database was saved
+  * @return True if the database has been correctly loaded
+  */
+  bool Load
+  (
+    const SfM_Data & sfm_data,
+    const features::Regions & regions_type,
+    const std::string & database_filename
+  );
+
 private:
+  /// Robust pose estimation from some putative 2D-3D correspondences
+  bool LocalizeFromMatches
+  (
+    const resection::SolverType & solver_type,
+    const Pair & image_size,
+    const cameras::IntrinsicBase * optional_intrinsics,
+    Image_Localizer_Match_Data & resection_data,
+    geometry::Pose3 & pose,
+    Image_Localizer_Match_Data * resection_data_ptr
+  ) const;
+
+  /// Build the view/landmark/descriptor associations used by the covisibility mode
+  void InitCovisibility();
+
+  /// Maximal number of descriptors kept per landmark (0: no limit)
+  IndexT max_descriptors_per_landmark_;
   // Reference to the scene
   const SfM_Data * sfm_data_;
   /// Association of a regions to a landmark observation
@@ -80,6 +203,10 @@ private:
   /// A matching interface to find matches between 2D descriptor matches
   ///  and 3D points observation descriptors
   std::unique_ptr<matching::RegionsMatcher> matching_interface_;
+  /// Landmarks observed by each view
+  Hash_Map<IndexT, std::vector<IndexT>> view_to_landmark_ids_;
+  /// Database descriptors of each landmark
+  Hash_Map<IndexT, std::vector<uint32_t>> landmark_to_descriptor_indices_;
 };
 
 } // namespace sfm
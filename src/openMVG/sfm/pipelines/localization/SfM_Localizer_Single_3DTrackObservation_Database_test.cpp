@@ -0,0 +1,265 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2026 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+//-----------------
+// Test summary:
+//-----------------
+// - Describe the landmarks of a synthetic scene with some SIFT like
+//   descriptors (one descriptor per landmark, perturbed in each view)
+// - Assert that:
+//   - a saved then loaded database localizes a view as the initial one,
+//   - a compacted database keeps valid descriptor to landmark lookups.
+//-----------------
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer_Single_3DTrackObservation_Database.hpp"
+#include "openMVG/sfm/pipelines/pipelines_test.hpp"
+#include "openMVG/sfm/sfm.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::sfm;
+
+// Create from a synthetic scene (NViewDataSet) a regions provider:
+//  - the feature i of a view is the observation of the landmark i,
+//  - its descriptor is the landmark descriptor with some noise.
+struct Synthetic_Regions_Provider : public Regions_Provider
+{
+  void load
+  (
+    const NViewDataSet & synthetic_data,
+    const SIFT_Regions::DescsT & landmark_descriptors
+  )
+  {
+    region_type_.reset(new SIFT_Regions);
+    for (IndexT j = 0; j < synthetic_data._n; ++j)
+    {
+      cache_[j] = MakeRegions(synthetic_data._x[j], landmark_descriptors, j);
+    }
+  }
+
+  static std::shared_ptr<SIFT_Regions> MakeRegions
+  (
+    const Mat2X & observations,
+    const SIFT_Regions::DescsT & landmark_descriptors,
+    const unsigned int seed
+  )
+  {
+    std::mt19937 random_generator(seed);
+    std::uniform_int_distribution<int> noise(-4, 4);
+    auto regions = std::make_shared<SIFT_Regions>();
+    for (Mat2X::Index i = 0; i < observations.cols(); ++i)
+    {
+      regions->Features().emplace_back(observations(0, i), observations(1, i), 1.f, 0.f);
+      SIFT_Regions::DescriptorT descriptor = landmark_descriptors[i];
+      for (int k = 0; k < descriptor.size(); ++k)
+      {
+        descriptor[k] = static_cast<unsigned char>(
+          std::min(255, std::max(0, descriptor[k] + noise(random_generator))));
+      }
+      regions->Descriptors().push_back(descriptor);
+    }
+    return regions;
+  }
+};
+
+static SIFT_Regions::DescsT RandomDescriptors(const int count)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  SIFT_Regions::DescsT descriptors(count);
+  for (auto & descriptor : descriptors)
+    for (int k = 0; k < descriptor.size(); ++k)
+      descriptor[k] = static_cast<unsigned char>(distribution(random_generator));
+  return descriptors;
+}
+
+// Count the putative 2D-3D correspondences that link a query feature to
+//  its own landmark
+static Mat::Index CountValidLandmarkLookups
+(
+  const NViewDataSet & d,
+  const IndexT query_view,
+  const Image_Localizer_Match_Data & resection_data
+)
+{
+  Mat::Index valid_count = 0;
+  for (Mat::Index i = 0; i < resection_data.pt2D.cols(); ++i)
+  {
+    Mat2X::Index feature_id = 0;
+    (d._x[query_view].colwise() - resection_data.pt2D.col(i))
+      .colwise().squaredNorm().minCoeff(&feature_id);
+    if ((d._X.col(feature_id) - resection_data.pt3D.col(i)).norm() < 1e-8)
+      ++valid_count;
+  }
+  return valid_count;
+}
+
+TEST(SfM_Localization_Single_3DTrackObservation_Database, SaveLoadLocalize)
+{
+  const int nviews = 6;
+  const int npoints = 128;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const SfM_Data sfm_data = getInputScene(d, config, cameras::PINHOLE_CAMERA);
+
+  const SIFT_Regions::DescsT landmark_descriptors =
+    RandomDescriptors(npoints);
+  Synthetic_Regions_Provider regions_provider;
+  regions_provider.load(d, landmark_descriptors);
+
+  // Query with the regions of a scene view: its descriptors are in the
+  //  database, so they pass the distance ratio test despite the other
+  //  observations of the same landmarks
+  const IndexT query_view = 0;
+  const std::shared_ptr<features::Regions> query_regions =
+    regions_provider.get(query_view);
+  const cameras::IntrinsicBase * intrinsic = sfm_data.GetIntrinsics().at(0).get();
+  const Pair image_size(config._cx * 2, config._cy * 2);
+
+  const std::string database_filename = "localization_database.bin";
+
+  SfM_Localization_Single_3DTrackObservation_Database database;
+  EXPECT_TRUE(database.Init(sfm_data, regions_provider));
+  EXPECT_TRUE(database.Save(database_filename));
+
+  SfM_Localization_Single_3DTrackObservation_Database loaded_database;
+  EXPECT_TRUE(loaded_database.Load(sfm_data, SIFT_Regions(), database_filename));
+
+  // The initial and the loaded databases give the same pose
+  geometry::Pose3 pose, loaded_pose;
+  Image_Localizer_Match_Data resection_data, loaded_resection_data;
+  EXPECT_TRUE(database.Localize(resection::SolverType::DEFAULT,
+    image_size, intrinsic, *query_regions,
+    pose, &resection_data));
+  EXPECT_TRUE(loaded_database.Localize(resection::SolverType::DEFAULT,
+    image_size, intrinsic, *query_regions,
+    loaded_pose, &loaded_resection_data));
+
+  EXPECT_EQ(resection_data.pt2D.cols(), loaded_resection_data.pt2D.cols());
+  EXPECT_EQ(resection_data.vec_inliers.size(), loaded_resection_data.vec_inliers.size());
+  EXPECT_MATRIX_NEAR(pose.rotation(), loaded_pose.rotation(), 1e-8);
+  EXPECT_MATRIX_NEAR(pose.center(), loaded_pose.center(), 1e-8);
+
+  // The found pose is the one of the query view
+  const geometry::Pose3 & gt_pose = sfm_data.GetPoses().at(query_view);
+  EXPECT_MATRIX_NEAR(gt_pose.rotation(), loaded_pose.rotation(), 1e-4);
+  EXPECT_MATRIX_NEAR(gt_pose.center(), loaded_pose.center(), 1e-4);
+
+  std::remove(database_filename.c_str());
+  std::remove((database_filename + ".index").c_str());
+}
+
+TEST(SfM_Localization_Single_3DTrackObservation_Database, Compaction)
+{
+  const int nviews = 6;
+  const int npoints = 128;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const SfM_Data sfm_data = getInputScene(d, config, cameras::PINHOLE_CAMERA);
+
+  const SIFT_Regions::DescsT landmark_descriptors =
+    RandomDescriptors(npoints);
+  Synthetic_Regions_Provider regions_provider;
+  regions_provider.load(d, landmark_descriptors);
+
+  // Query with some new noisy descriptors of the landmarks
+  const IndexT query_view = 0;
+  const std::shared_ptr<SIFT_Regions> query_regions =
+    Synthetic_Regions_Provider::MakeRegions(d._x[query_view], landmark_descriptors, nviews);
+
+  const Pair image_size(config._cx * 2, config._cy * 2);
+
+  const std::string database_filename = "localization_database_compacted.bin";
+
+  // Keep 1 of the 6 observation descriptors of each landmark
+  SfM_Localization_Single_3DTrackObservation_Database database(1);
+  EXPECT_TRUE(database.Init(sfm_data, regions_provider));
+  EXPECT_TRUE(database.Save(database_filename));
+
+  SfM_Localization_Single_3DTrackObservation_Database loaded_database;
+  EXPECT_TRUE(loaded_database.Load(sfm_data, SIFT_Regions(), database_filename));
+
+  for (const auto * db : {&database, &loaded_database})
+  {
+    // Whole database search
+    Image_Localizer_Match_Data resection_data;
+    EXPECT_TRUE(db->MatchLandmarks(*query_regions, resection_data));
+    EXPECT_TRUE(resection_data.pt2D.cols() > 0.9 * npoints);
+    EXPECT_EQ(resection_data.pt2D.cols(),
+              CountValidLandmarkLookups(d, query_view, resection_data));
+
+    // Covisibility search (uses the landmark to descriptors lookup)
+    Image_Localizer_Match_Data covisible_resection_data;
+    EXPECT_TRUE(db->MatchCovisibleLandmarks(*query_regions, {1}, 0, covisible_resection_data));
+    EXPECT_TRUE(covisible_resection_data.pt2D.cols() > 0.9 * npoints);
+    EXPECT_EQ(covisible_resection_data.pt2D.cols(),
+              CountValidLandmarkLookups(d, query_view, covisible_resection_data));
+
+    geometry::Pose3 pose;
+    EXPECT_TRUE(db->Localize(resection::SolverType::DEFAULT,
+      image_size, sfm_data.GetIntrinsics().at(0).get(),
+      *query_regions, pose));
+    const geometry::Pose3 & gt_pose = sfm_data.GetPoses().at(query_view);
+    EXPECT_MATRIX_NEAR(gt_pose.rotation(), pose.rotation(), 1e-4);
+    EXPECT_MATRIX_NEAR(gt_pose.center(), pose.center(), 1e-4);
+  }
+
+  std::remove(database_filename.c_str());
+  std::remove((database_filename + ".index").c_str());
+}
+
+TEST(SfM_Localization_Single_3DTrackObservation_Database, LoadCompaction)
+{
+  const int nviews = 6;
+  const int npoints = 128;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const SfM_Data sfm_data = getInputScene(d, config, cameras::PINHOLE_CAMERA);
+
+  const SIFT_Regions::DescsT landmark_descriptors =
+    RandomDescriptors(npoints);
+  Synthetic_Regions_Provider regions_provider;
+  regions_provider.load(d, landmark_descriptors);
+
+  const IndexT query_view = 0;
+  const std::shared_ptr<SIFT_Regions> query_regions =
+    Synthetic_Regions_Provider::MakeRegions(d._x[query_view], landmark_descriptors, nviews);
+
+  const std::string database_filename = "localization_database_full.bin";
+
+  // Save a database with all the observation descriptors
+  SfM_Localization_Single_3DTrackObservation_Database database;
+  EXPECT_TRUE(database.Init(sfm_data, regions_provider));
+  EXPECT_TRUE(database.Save(database_filename));
+
+  // Load it with a limit of 1 descriptor per landmark
+  SfM_Localization_Single_3DTrackObservation_Database loaded_database(1);
+  EXPECT_TRUE(loaded_database.Load(sfm_data, SIFT_Regions(), database_filename));
+
+  // The noisy descriptors pass the distance ratio test
+  //  only if a single descriptor per landmark is kept
+  Image_Localizer_Match_Data resection_data;
+  EXPECT_TRUE(loaded_database.MatchLandmarks(*query_regions, resection_data));
+  EXPECT_TRUE(resection_data.pt2D.cols() > 0.9 * npoints);
+  EXPECT_EQ(resection_data.pt2D.cols(),
+            CountValidLandmarkLookups(d, query_view, resection_data));
+
+  std::remove(database_filename.c_str());
+  std::remove((database_filename + ".index").c_str());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
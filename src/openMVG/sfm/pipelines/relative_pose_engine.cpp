@@ -133,11 +133,13 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
       number_matches = 0;
       for (const auto & match : matches)
       {
-        x1.col(number_matches) = cam_I->get_ud_pixel(
-          features_provider_->feats_per_view.at(I)[match.i_].coords().cast<double>());
-        x2.col(number_matches++) = cam_J->get_ud_pixel(
-          features_provider_->feats_per_view.at(J)[match.j_].coords().cast<double>());
+        x1.col(number_matches) =
+          features_provider_->feats_per_view.at(I)[match.i_].coords().cast<double>();
+        x2.col(number_matches++) =
+          features_provider_->feats_per_view.at(J)[match.j_].coords().cast<double>();
       }
+      x1 = cam_I->get_ud_pixels(x1);
+      x2 = cam_J->get_ud_pixels(x2);
 
       RelativePose_Info relativePose_info;
       relativePose_info.initial_residual_tolerance = Square(2.5);
@@ -376,7 +376,7 @@ bool SequentialSfMReconstructionEngine::AutomaticInitialPairChoice(Pair & initia
 
           // Copy points correspondences to arrays for relative pose estimation
           const size_t n = map_tracksCommon.size();
-          Mat xI(2,n), xJ(2,n);
+          Mat2X xI(2,n), xJ(2,n);
           size_t cptIndex = 0;
           for (const auto & track_iter : map_tracksCommon)
           {
@@ -384,12 +384,12 @@ bool SequentialSfMReconstructionEngine::AutomaticInitialPairChoice(Pair & initia
             const uint32_t i = iter->second;
             const uint32_t j = (++iter)->second;
 
-            Vec2 feat = features_provider_->feats_per_view[I][i].coords().cast<double>();
-            xI.col(cptIndex) = cam_I->get_ud_pixel(feat);
-            feat = features_provider_->feats_per_view[J][j].coords().cast<double>();
-            xJ.col(cptIndex) = cam_J->get_ud_pixel(feat);
+            xI.col(cptIndex) = features_provider_->feats_per_view[I][i].coords().cast<double>();
+            xJ.col(cptIndex) = features_provider_->feats_per_view[J][j].coords().cast<double>();
             ++cptIndex;
           }
+          xI = cam_I->get_ud_pixels(xI);
+          xJ = cam_J->get_ud_pixels(xJ);
 
           // Robust estimation of the relative pose
           RelativePose_Info relativePose_info;
@@ -505,7 +505,7 @@ bool SequentialSfMReconstructionEngine::MakeInitialPair3D(const Pair & current_p
 
   //-- Copy point to arrays
   const size_t n = map_tracksCommon.size();
-  Mat xI(2,n), xJ(2,n);
+  Mat2X xI(2,n), xJ(2,n);
   uint32_t cptIndex = 0;
   for (const auto & track_iter : map_tracksCommon)
   {
@@ -514,12 +514,12 @@ bool SequentialSfMReconstructionEngine::MakeInitialPair3D(const Pair & current_p
       i = iter->second,
       j = (++iter)->second;
 
-    Vec2 feat = features_provider_->feats_per_view[I][i].coords().cast<double>();
-    xI.col(cptIndex) = cam_I->get_ud_pixel(feat);
-    feat = features_provider_->feats_per_view[J][j].coords().cast<double>();
-    xJ.col(cptIndex) = cam_J->get_ud_pixel(feat);
+    xI.col(cptIndex) = features_provider_->feats_per_view[I][i].coords().cast<double>();
+    xJ.col(cptIndex) = features_provider_->feats_per_view[J][j].coords().cast<double>();
     ++cptIndex;
   }
+  xI = cam_I->get_ud_pixels(xI);
+  xJ = cam_J->get_ud_pixels(xJ);
 
   // c. Robust estimation of the relative pose
   RelativePose_Info relativePose_info;
@@ -921,11 +921,11 @@ bool SequentialSfMReconstructionEngine::Resection(const uint32_t viewIndex)
     resection_data.pt3D.col(cpt) = sfm_data_.GetLandmarks().at(*iterTrackId).X;
     resection_data.pt2D.col(cpt) = pt2D_original.col(cpt) =
       features_provider_->feats_per_view.at(viewIndex)[*iterfeatId].coords().cast<double>();
-    // Handle image distortion if intrinsic is known (to ease the resection)
-    if (optional_intrinsic && optional_intrinsic->have_disto())
-    {
-      resection_data.pt2D.col(cpt) = optional_intrinsic->get_ud_pixel(resection_data.pt2D.col(cpt));
-    }
+  }
+  // Handle image distortion if intrinsic is known (to ease the resection)
+  if (optional_intrinsic && optional_intrinsic->have_disto())
+  {
+    resection_data.pt2D = optional_intrinsic->get_ud_pixels(resection_data.pt2D);
   }
 
   // C. Do the resectioning: compute the camera pose
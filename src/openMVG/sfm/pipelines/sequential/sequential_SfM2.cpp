@@ -387,11 +387,11 @@ bool SequentialSfMReconstructionEngine2::AddingMissingView
           resection_data.pt3D.col(cpt) = sfm_data_.GetLandmarks().at(*track_it).X;
           resection_data.pt2D.col(cpt) = pt2D_original.col(cpt) =
             features_provider_->feats_per_view.at(view_id)[*feat_it].coords().cast<double>();
-          // Handle image distortion if intrinsic is known (to ease the resection)
-          if (intrinsic && intrinsic->have_disto())
-          {
-            resection_data.pt2D.col(cpt) = intrinsic->get_ud_pixel(resection_data.pt2D.col(cpt));
-          }
+        }
+        // Handle image distortion if intrinsic is known (to ease the resection)
+        if (intrinsic && intrinsic->have_disto())
+        {
+          resection_data.pt2D = intrinsic->get_ud_pixels(resection_data.pt2D);
         }
 
         geometry::Pose3 pose;
@@ -50,11 +50,10 @@ void PointsToMat(
   for (PointFeatures::const_iterator iter = vec_feats.begin();
     iter != vec_feats.end(); ++iter, ++i)
   {
-    if (cam)
-      m.col(i) = cam->get_ud_pixel({iter->x(), iter->y()});
-    else
-      m.col(i) << iter->x(), iter->y();
+    m.col(i) << iter->x(), iter->y();
   }
+  if (cam)
+    m = cam->get_ud_pixels(m);
 }
 
 SfM_Data_Structure_Estimation_From_Known_Poses::SfM_Data_Structure_Estimation_From_Known_Poses
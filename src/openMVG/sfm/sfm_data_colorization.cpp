@@ -12,12 +12,17 @@
 #include "openMVG/image/image_container.hpp"
 #include "openMVG/image/image_io.hpp"
 #include "openMVG/image/pixel_types.hpp"
+#include "openMVG/numeric/numeric.h"
 #include "openMVG/sfm/sfm_data.hpp"
-#include "openMVG/stl/stl.hpp"
 #include "openMVG/system/loggerprogress.hpp"
 
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <atomic>
+#include <map>
+#include <numeric>
+#include <queue>
+
 namespace openMVG {
 namespace sfm {
 
@@ -25,117 +30,165 @@ namespace sfm {
 bool ColorizeTracks(
   const SfM_Data & sfm_data,
   std::vector<Vec3> & vec_3dPoints,
-  std::vector<Vec3> & vec_tracksColor)
+  std::vector<Vec3> & vec_tracksColor,
+  const int max_image_downscale)
 {
   // Colorize each track
   // Start with the most representative image
   //   and iterate to provide a color to each 3D point
-
+  // The image selection (a greedy set cover) only depends on the observations:
+  //  - the view coverages (number of uncolored tracks per view) are kept in a
+  //    priority queue and updated incrementally when tracks get colored,
+  //  - the selected images are then decoded and sampled in parallel.
+
+  const Landmarks & landmarks = sfm_data.GetLandmarks();
+  vec_tracksColor.resize(landmarks.size());
+  vec_3dPoints.resize(landmarks.size());
+
+  //Build a list of contiguous index for the tracks and the views
+  std::vector<const Landmark *> tracks(landmarks.size());
+  std::map<IndexT, IndexT> viewIds_to_contiguousIndexes;
   {
-    system::LoggerProgress my_progress_bar(sfm_data.GetLandmarks().size(),"- Compute scene structure color -" );
-
-    vec_tracksColor.resize(sfm_data.GetLandmarks().size());
-    vec_3dPoints.resize(sfm_data.GetLandmarks().size());
-
-    //Build a list of contiguous index for the trackIds
-    std::map<IndexT, IndexT> trackIds_to_contiguousIndexes;
     IndexT cpt = 0;
-    for (Landmarks::const_iterator it = sfm_data.GetLandmarks().begin();
-      it != sfm_data.GetLandmarks().end(); ++it, ++cpt)
+    for (Landmarks::const_iterator it = landmarks.begin();
+      it != landmarks.end(); ++it, ++cpt)
     {
-      trackIds_to_contiguousIndexes[it->first] = cpt;
+      tracks[cpt] = &it->second;
       vec_3dPoints[cpt] = it->second.X;
+      for (const auto & obs_it : it->second.obs)
+        viewIds_to_contiguousIndexes[obs_it.first] = 0;
     }
+  }
+  std::vector<IndexT> view_ids;
+  view_ids.reserve(viewIds_to_contiguousIndexes.size());
+  for (auto & view_it : viewIds_to_contiguousIndexes)
+  {
+    view_it.second = view_ids.size();
+    view_ids.push_back(view_it.first);
+  }
 
-    // The track list that will be colored (point removed during the process)
-    std::set<IndexT> remainingTrackToColor;
-    std::transform(sfm_data.GetLandmarks().begin(), sfm_data.GetLandmarks().end(),
-      std::inserter(remainingTrackToColor, remainingTrackToColor.begin()),
-      stl::RetrieveKey());
+  // List the views observing each track (compressed rows of contiguous view indexes),
+  //  so that the view id lookups are done once per observation
+  std::vector<IndexT> track_views_offsets(tracks.size() + 1, 0);
+  std::vector<IndexT> track_views;
+  for (IndexT track_index = 0; track_index < tracks.size(); ++track_index)
+  {
+    for (const auto & obs_it : tracks[track_index]->obs)
+      track_views.push_back(viewIds_to_contiguousIndexes.at(obs_it.first));
+    track_views_offsets[track_index + 1] = track_views.size();
+  }
 
-    while ( !remainingTrackToColor.empty() )
+  // List the tracks (and their observation) seen by each view (compressed rows)
+  std::vector<IndexT> view_tracks_offsets(view_ids.size() + 1, 0);
+  for (const IndexT view_index : track_views)
+    ++view_tracks_offsets[view_index + 1];
+  std::partial_sum(view_tracks_offsets.begin(), view_tracks_offsets.end(),
+    view_tracks_offsets.begin());
+  std::vector<IndexT> view_tracks(view_tracks_offsets.back());
+  std::vector<const Observation *> view_observations(view_tracks_offsets.back());
+  {
+    std::vector<IndexT> view_tracks_fill(view_tracks_offsets.begin(), view_tracks_offsets.end() - 1);
+    for (IndexT track_index = 0; track_index < tracks.size(); ++track_index)
     {
-      // Find the most representative image (for the remaining 3D points)
-      //  a. Count the number of observation per view for each 3Dpoint Index
-      //  b. Sort to find the most representative view index
-
-      std::map<IndexT, IndexT> map_IndexCardinal; // ViewId, Cardinal
-      for (const auto & track_to_color_it : remainingTrackToColor)
+      IndexT k = track_views_offsets[track_index];
+      for (const auto & obs_it : tracks[track_index]->obs)
       {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        for (const auto & obs_it : obs)
-        {
-          const auto viewId = obs_it.first;
-          if (map_IndexCardinal.find(viewId) == map_IndexCardinal.end())
-            map_IndexCardinal[viewId] = 1;
-          else
-            ++map_IndexCardinal[viewId];
-        }
+        const IndexT position = view_tracks_fill[track_views[k++]]++;
+        view_tracks[position] = track_index;
+        view_observations[position] = &obs_it.second;
       }
+    }
+  }
 
-      // Find the View index that is the most represented
-      std::vector<IndexT> vec_cardinal;
-      std::transform(map_IndexCardinal.begin(),
-        map_IndexCardinal.end(),
-        std::back_inserter(vec_cardinal),
-        stl::RetrieveValue());
-      using namespace stl::indexed_sort;
-      std::vector<sort_index_packet_descend<IndexT, IndexT>> packet_vec(vec_cardinal.size());
-      sort_index_helper(packet_vec, &vec_cardinal[0], 1);
-
-      // First image index with the most of occurrence
-      std::map<IndexT, IndexT>::const_iterator iterTT = map_IndexCardinal.begin();
-      std::advance(iterTT, packet_vec[0].index);
-      const size_t view_index = iterTT->first;
-      const View * view = sfm_data.GetViews().at(view_index).get();
-      const std::string sView_filename = stlplus::create_filespec(sfm_data.s_root_path,
-        view->s_Img_path);
-      image::Image<image::RGBColor> image_rgb;
-      image::Image<unsigned char> image_gray;
-      const bool b_rgb_image = ReadImage(sView_filename.c_str(), &image_rgb);
-      if (!b_rgb_image) //try Gray level
-      {
-        const bool b_gray_image = ReadImage(sView_filename.c_str(), &image_gray);
-        if (!b_gray_image)
-        {
-          OPENMVG_LOG_ERROR << "Cannot open provided the image.";
-          return false;
-        }
-      }
+  // Number of uncolored tracks observed by each view
+  std::vector<IndexT> view_coverage(view_ids.size());
+  for (IndexT i = 0; i < view_ids.size(); ++i)
+    view_coverage[i] = view_tracks_offsets[i + 1] - view_tracks_offsets[i];
 
-      // Iterate through the remaining track to color
-      // - look if the current view is present to color the track
-      std::set<IndexT> set_toRemove;
-      for (const auto & track_to_color_it : remainingTrackToColor)
-      {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        Observations::const_iterator it = obs.find(view_index);
-
-        if (it != obs.end())
-        {
-          // Color the track
-          const Vec2 & pt = it->second.x;
-          const image::RGBColor color =
-            b_rgb_image
-            ? image_rgb(pt.y(), pt.x())
-            : image::RGBColor(image_gray(pt.y(), pt.x()));
-
-          vec_tracksColor[trackIds_to_contiguousIndexes.at(trackId)] =
-            Vec3(color.r(), color.g(), color.b());
-          set_toRemove.insert(trackId);
-          ++my_progress_bar;
-        }
-      }
-      // Remove colored track
-      for (const auto & to_remove_it : set_toRemove)
-      {
-        remainingTrackToColor.erase(to_remove_it);
-      }
+  // Most representative view first (the smallest view id in case of equality)
+  using CoverageEntry = std::pair<IndexT, IndexT>; // Cardinal, view index
+  const auto coverage_order = [](const CoverageEntry & lhs, const CoverageEntry & rhs)
+  {
+    return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+  };
+  std::priority_queue<CoverageEntry, std::vector<CoverageEntry>, decltype(coverage_order)>
+    coverage_queue(coverage_order);
+  for (IndexT i = 0; i < view_ids.size(); ++i)
+    if (view_coverage[i] > 0)
+      coverage_queue.emplace(view_coverage[i], i);
+
+  // Greedy selection of the views, and of the view used to color each track
+  std::vector<IndexT> track_coloring_view(tracks.size(), UndefinedIndexT);
+  std::vector<IndexT> selected_views;
+  while (!coverage_queue.empty())
+  {
+    const CoverageEntry entry = coverage_queue.top();
+    coverage_queue.pop();
+    const IndexT current_view = entry.second;
+    if (entry.first != view_coverage[current_view])
+    {
+      // Outdated coverage (some tracks got colored since the entry was pushed)
+      if (view_coverage[current_view] > 0)
+        coverage_queue.emplace(view_coverage[current_view], current_view);
+      continue;
+    }
+
+    selected_views.push_back(current_view);
+    for (IndexT i = view_tracks_offsets[current_view]; i < view_tracks_offsets[current_view + 1]; ++i)
+    {
+      const IndexT track_index = view_tracks[i];
+      if (track_coloring_view[track_index] != UndefinedIndexT)
+        continue;
+      track_coloring_view[track_index] = current_view;
+      // The track is no longer to color for its views
+      for (IndexT k = track_views_offsets[track_index]; k < track_views_offsets[track_index + 1]; ++k)
+        --view_coverage[track_views[k]];
+    }
+  }
+
+  // Decode the selected images and color their tracks
+  system::LoggerProgress my_progress_bar(landmarks.size(),"- Compute scene structure color -" );
+  std::atomic<bool> b_read_error(false);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(selected_views.size()); ++i)
+  {
+    if (b_read_error)
+      continue;
+
+    const IndexT current_view = selected_views[i];
+    const IndexT view_id = view_ids[current_view];
+    const View * view = sfm_data.GetViews().at(view_id).get();
+    const std::string sView_filename = stlplus::create_filespec(sfm_data.s_root_path,
+      view->s_Img_path);
+    image::Image<image::RGBColor> image_rgb;
+    int downscale = 1;
+    if (!image::ReadImageDownscaled(sView_filename.c_str(), max_image_downscale, &image_rgb, &downscale))
+    {
+      OPENMVG_LOG_ERROR << "Cannot open provided the image: " << sView_filename;
+      b_read_error = true;
+      continue;
+    }
+
+    // Color the tracks for which this view has been selected
+    IndexT colored_track_count = 0;
+    for (IndexT j = view_tracks_offsets[current_view]; j < view_tracks_offsets[current_view + 1]; ++j)
+    {
+      const IndexT track_index = view_tracks[j];
+      if (track_coloring_view[track_index] != current_view)
+        continue;
+
+      const Vec2 & pt = view_observations[j]->x;
+      const int x = clamp(static_cast<int>(pt.x() / downscale), 0, static_cast<int>(image_rgb.Width()) - 1);
+      const int y = clamp(static_cast<int>(pt.y() / downscale), 0, static_cast<int>(image_rgb.Height()) - 1);
+      const image::RGBColor & color = image_rgb(y, x);
+      vec_tracksColor[track_index] = Vec3(color.r(), color.g(), color.b());
+      ++colored_track_count;
     }
+    my_progress_bar += colored_track_count;
   }
-  return true;
+  return !b_read_error;
 }
 
 } // namespace sfm
@@ -17,10 +17,22 @@ namespace sfm {
 
 struct SfM_Data;
 
+/**
+* @brief Find the color of the SfM_Data Landmarks/structure
+* Each track is colored by a view of a greedy selection of the most
+*  representative views (the views observing most of the uncolored tracks).
+* @param[in] sfm_data The scene
+* @param[out] vec_3dPoints The Landmarks positions
+* @param[out] vec_tracksColor The Landmarks colors
+* @param[in] max_image_downscale Maximal downscaling factor allowed when
+*  decoding the images (1: full resolution, exact observation color)
+* @return false if an image cannot be read
+*/
 bool ColorizeTracks(
   const SfM_Data & sfm_data,
   std::vector<Vec3> & vec_3dPoints,
-  std::vector<Vec3> & vec_tracksColor);
+  std::vector<Vec3> & vec_tracksColor,
+  const int max_image_downscale = 1);
 
 } // namespace sfm
 } // namespace openMVG
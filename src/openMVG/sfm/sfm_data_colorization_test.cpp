@@ -0,0 +1,96 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_colorization.hpp"
+
+#include "testing/testing.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <map>
+
+using namespace openMVG;
+using namespace openMVG::image;
+using namespace openMVG::sfm;
+
+// Build a scene with 3 views (a red, a green and a blue image)
+SfM_Data ColorizationScene()
+{
+  SfM_Data sfm_data;
+  sfm_data.s_root_path = stlplus::folder_current_full();
+
+  const std::vector<RGBColor> colors = {RGBColor(255, 0, 0), RGBColor(0, 255, 0), RGBColor(0, 0, 255)};
+  for (IndexT view_id = 0; view_id < colors.size(); ++view_id)
+  {
+    const std::string filename = "colorization_" + std::to_string(view_id) + ".png";
+    Image<RGBColor> image(20, 10, true, colors[view_id]);
+    WriteImage(filename.c_str(), image);
+    sfm_data.views[view_id] = std::make_shared<View>(filename, view_id, 0, view_id, 20, 10);
+  }
+
+  // Observations: track id -> observing views
+  const std::map<IndexT, std::vector<IndexT>> track_views = {
+    {0, {0, 1}}, {1, {0, 1}}, {2, {1, 2}}, {3, {1}}, {4, {1}}, {5, {0, 2}}};
+  for (const auto & track_it : track_views)
+  {
+    Landmark & landmark = sfm_data.structure[track_it.first];
+    landmark.X = Vec3(track_it.first, 0, 0);
+    for (const IndexT view_id : track_it.second)
+      landmark.obs[view_id] = Observation(Vec2(5.5, 2.5), track_it.first);
+  }
+  return sfm_data;
+}
+
+void RemoveColorizationSceneImages(const SfM_Data & sfm_data)
+{
+  for (const auto & view_it : sfm_data.GetViews())
+    stlplus::file_delete(view_it.second->s_Img_path);
+}
+
+TEST(SfM_Data_Colorization, GreedyViewSelection)
+{
+  const SfM_Data sfm_data = ColorizationScene();
+
+  std::vector<Vec3> vec_3dPoints, vec_tracksColor;
+  EXPECT_TRUE(ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor));
+  EXPECT_EQ(6, vec_3dPoints.size());
+  EXPECT_EQ(6, vec_tracksColor.size());
+
+  // The green view observes the most tracks, it colors all its tracks.
+  // The remaining track is seen by the red and the blue view with
+  //  the same coverage: the smallest view id is used.
+  IndexT i = 0;
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+  {
+    EXPECT_EQ(landmark_it.second.X, vec_3dPoints[i]);
+    const Vec3 expected_color = (landmark_it.first == 5) ? Vec3(255, 0, 0) : Vec3(0, 255, 0);
+    EXPECT_EQ(expected_color, vec_tracksColor[i]);
+    ++i;
+  }
+
+  // Same result with a reduced resolution decoding (PNG images are read at full resolution)
+  std::vector<Vec3> vec_tracksColor_downscaled;
+  EXPECT_TRUE(ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor_downscaled, 4));
+  EXPECT_TRUE(vec_tracksColor == vec_tracksColor_downscaled);
+  RemoveColorizationSceneImages(sfm_data);
+}
+
+TEST(SfM_Data_Colorization, MissingImage)
+{
+  const SfM_Data sfm_data = ColorizationScene();
+  stlplus::file_delete(sfm_data.GetViews().at(1)->s_Img_path);
+
+  std::vector<Vec3> vec_3dPoints, vec_tracksColor;
+  EXPECT_FALSE(ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor));
+  RemoveColorizationSceneImages(sfm_data);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -0,0 +1,108 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (C) 2020 Pierre Moulon
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SYSTEM_BOUNDED_QUEUE_HPP
+#define OPENMVG_SYSTEM_BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace openMVG {
+namespace system {
+
+// A thread safe FIFO queue with a bounded capacity.
+// It is used to connect the stages of a processing pipeline:
+// - Push blocks while the queue is full (back pressure on the producer),
+// - Pop blocks while the queue is empty,
+// - Close wakes up everybody: no more items can be pushed and Pop returns
+//   false once the remaining items have been consumed.
+//
+// Typical usage
+// BoundedQueue<int> queue(8);
+// std::thread consumer([&]{ int value; while (queue.Pop(value)) { ... } });
+// for (int i = 0; i < 100; ++i) queue.Push(i);
+// queue.Close();
+// consumer.join();
+
+template <typename T>
+class BoundedQueue
+{
+ public:
+  explicit BoundedQueue(const std::size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1), closed_(false)
+  {
+  }
+
+  /**
+   * @brief Add an item at the end of the queue (block while the queue is full)
+   * @return false if the queue has been closed (the item is discarded)
+   **/
+  bool Push(T value)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]{ return closed_ || queue_.size() < capacity_; });
+    if (closed_)
+      return false;
+    queue_.push_back(std::move(value));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the first item of the queue (block while the queue is empty)
+   * @return false if the queue is closed and empty
+   **/
+  bool Pop(T & value)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]{ return closed_ || !queue_.empty(); });
+    if (queue_.empty())
+      return false;
+    value = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  /// Close the queue: reject new items, let the consumers drain the queue.
+  void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  std::size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+  std::size_t Capacity() const { return capacity_; }
+
+ private:
+  const std::size_t capacity_;
+  bool closed_;
+  std::deque<T> queue_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+} // namespace system
+} // namespace openMVG
+
+#endif // OPENMVG_SYSTEM_BOUNDED_QUEUE_HPP
@@ -0,0 +1,108 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (C) 2020 Pierre Moulon
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/system/bounded_queue.hpp"
+#include "openMVG/system/latency_statistics.hpp"
+
+#include "testing/testing.h"
+
+#include <thread>
+#include <vector>
+
+using namespace openMVG::system;
+
+TEST(BoundedQueue, FIFO)
+{
+  BoundedQueue<int> queue(4);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  EXPECT_EQ(2, queue.Size());
+
+  int value = 0;
+  EXPECT_TRUE(queue.Pop(value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(queue.Pop(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(0, queue.Size());
+}
+
+TEST(BoundedQueue, Close)
+{
+  BoundedQueue<int> queue(4);
+  EXPECT_TRUE(queue.Push(1));
+  queue.Close();
+  // No more item can be added
+  EXPECT_FALSE(queue.Push(2));
+  // Remaining items can still be consumed
+  int value = 0;
+  EXPECT_TRUE(queue.Pop(value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(queue.Pop(value));
+}
+
+TEST(BoundedQueue, ProducerConsumer)
+{
+  const int count = 10000;
+  BoundedQueue<int> queue(3);
+
+  std::vector<int> consumed;
+  std::thread consumer([&]{
+    int value;
+    while (queue.Pop(value))
+    {
+      EXPECT_TRUE(queue.Size() <= queue.Capacity());
+      consumed.push_back(value);
+    }
+  });
+  for (int i = 0; i < count; ++i)
+    queue.Push(i);
+  queue.Close();
+  consumer.join();
+
+  // All the items have been received in order
+  EXPECT_EQ(count, consumed.size());
+  for (int i = 0; i < count; ++i)
+    EXPECT_EQ(i, consumed[i]);
+}
+
+TEST(LatencyStatistics, Percentiles)
+{
+  LatencyStatistics stats("test");
+  EXPECT_EQ(0.0, stats.Percentile(50));
+  EXPECT_EQ(0.0, stats.Mean());
+
+  for (int i = 100; i > 0; --i)
+    stats.Add(i);
+  EXPECT_EQ(100, stats.Count());
+  EXPECT_NEAR(50.5, stats.Mean(), 1e-8);
+  // The min and max are exact, the other percentiles are known up to 1%
+  EXPECT_EQ(1.0, stats.Percentile(0));
+  EXPECT_NEAR(50.0, stats.Percentile(50), 0.5);
+  EXPECT_NEAR(90.0, stats.Percentile(90), 0.9);
+  EXPECT_NEAR(99.0, stats.Percentile(99), 0.99);
+  EXPECT_EQ(100.0, stats.Percentile(100));
+}
+
+TEST(LatencyStatistics, BoundedMemory)
+{
+  LatencyStatistics stats("test");
+  // Out of range durations are clamped to the first and last buckets
+  stats.Add(0.0);
+  stats.Add(1e9);
+  for (int i = 0; i < 1000000; ++i)
+    stats.Add(1.0 + (i % 1000) * 0.01);
+  EXPECT_EQ(1000002, stats.Count());
+  EXPECT_EQ(0.0, stats.Percentile(0));
+  EXPECT_EQ(1e9, stats.Percentile(100));
+  EXPECT_NEAR(5.995, stats.Percentile(50), 0.06);
+  EXPECT_NEAR(10.9, stats.Percentile(99), 0.11);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -0,0 +1,155 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (C) 2020 Pierre Moulon
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SYSTEM_LATENCY_STATISTICS_HPP
+#define OPENMVG_SYSTEM_LATENCY_STATISTICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace openMVG {
+namespace system {
+
+// Thread safe statistics of the durations (in milliseconds) of a processing
+// stage, used to report latency percentiles.
+//
+// The durations are accumulated in a fixed size histogram of logarithmic
+// buckets: the memory is bounded and Add is O(1) whatever the number of
+// recorded durations. The count, mean, min and max are exact, the other
+// percentiles are known up to the bucket width (1% relative precision).
+//
+// Typical usage
+// LatencyStatistics decode_stats("decode");
+// system::Timer timer; ... decode_stats.Add(timer.elapsedMs());
+// OPENMVG_LOG_INFO << decode_stats.ToString(); // "[decode] #10 mean: ... p50: ..."
+
+class LatencyStatistics
+{
+ public:
+  explicit LatencyStatistics(const std::string & name = {}) : name_(name)
+  {
+    buckets_.fill(0);
+  }
+
+  /// Record a duration (in milliseconds)
+  void Add(const double duration_ms)
+  {
+    const std::size_t bucket = Bucket(duration_ms);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++buckets_[bucket];
+    ++count_;
+    sum_ += duration_ms;
+    min_ = std::min(min_, duration_ms);
+    max_ = std::max(max_, duration_ms);
+  }
+
+  std::size_t Count() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+  /// Mean duration (0 if no duration has been recorded)
+  double Mean() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return MeanUnlocked();
+  }
+
+  /**
+   * @brief Return the percentile of the recorded durations (nearest rank method)
+   * @param[in] percentile the asked percentile. Value must be in [0;100]
+   * @return the percentile duration (0 if no duration has been recorded)
+   **/
+  double Percentile(const double percentile) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return PercentileUnlocked(percentile);
+  }
+
+  /// Return a "[name] #count mean: X p50: X p90: X p99: X max: X (ms)" string
+  std::string ToString() const
+  {
+    std::ostringstream os;
+    std::lock_guard<std::mutex> lock(mutex_);
+    os << "[" << name_ << "] #" << count_
+      << " mean: " << MeanUnlocked()
+      << " p50: " << PercentileUnlocked(50)
+      << " p90: " << PercentileUnlocked(90)
+      << " p99: " << PercentileUnlocked(99)
+      << " max: " << PercentileUnlocked(100) << " (ms)";
+    return os.str();
+  }
+
+  const std::string & Name() const { return name_; }
+
+ private:
+  // Bucket i covers [kMinDuration * kGrowth^i; kMinDuration * kGrowth^(i+1)),
+  //  the first and last buckets also collect the smaller and larger durations.
+  // 1200 buckets cover [1 micro second; ~6 hours].
+  static constexpr std::size_t kBucketCount = 1200;
+  static double MinDuration() { return 1e-3; }
+  static double Growth() { return 1.02; }
+
+  static std::size_t Bucket(const double duration_ms)
+  {
+    if (!(duration_ms > MinDuration()))
+      return 0;
+    const double bucket = std::log(duration_ms / MinDuration()) / std::log(Growth());
+    return static_cast<std::size_t>(
+      std::min(bucket, static_cast<double>(kBucketCount - 1)));
+  }
+
+  double MeanUnlocked() const
+  {
+    return (count_ == 0) ? 0.0 : sum_ / count_;
+  }
+
+  double PercentileUnlocked(const double percentile) const
+  {
+    if (count_ == 0)
+      return 0.0;
+    const double clamped_percentile = std::min(100.0, std::max(0.0, percentile));
+    const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(
+      std::ceil(clamped_percentile / 100.0 * count_)));
+    if (rank == 1)
+      return min_;
+    if (rank == count_)
+      return max_;
+    // Find the bucket of the asked rank and return its (geometric) center
+    std::uint64_t cumulated_count = 0;
+    std::size_t bucket = 0;
+    for (; bucket < kBucketCount - 1; ++bucket)
+    {
+      cumulated_count += buckets_[bucket];
+      if (cumulated_count >= rank)
+        break;
+    }
+    const double center = MinDuration() * std::pow(Growth(), bucket + 0.5);
+    return std::min(max_, std::max(min_, center));
+  }
+
+  std::string name_;
+  std::array<std::uint64_t, kBucketCount> buckets_;
+  std::uint64_t count_ = 0;
+  double sum_ = 0.0;
+  double min_ = std::numeric_limits<double>::max();
+  double max_ = std::numeric_limits<double>::lowest();
+  mutable std::mutex mutex_;
+};
+
+} // namespace system
+} // namespace openMVG
+
+#endif // OPENMVG_SYSTEM_LATENCY_STATISTICS_HPP
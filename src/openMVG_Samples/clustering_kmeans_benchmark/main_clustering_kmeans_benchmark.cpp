@@ -0,0 +1,67 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2026 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/clustering/kmeans.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::clustering;
+
+// Time the kmeans solvers on a SIFT like dataset and compare their inertia
+int main()
+{
+  const int dimension = 128;
+  const int nb_point = 50000;
+  const uint32_t nb_cluster = 128;
+  const uint32_t max_nb_iteration = 25;
+
+  // Points are sampled around some random modes
+  std::mt19937_64 rng(std::mt19937_64::default_seed);
+  std::uniform_real_distribution<float> distrib(0.f, 255.f);
+  std::normal_distribution<float> noise(0.f, 50.f);
+  std::vector<Vecf> modes(2 * nb_cluster, Vecf(dimension));
+  for (auto & mode : modes)
+    for (int i = 0; i < dimension; ++i)
+      mode(i) = distrib(rng);
+  std::vector<Vecf> pts(nb_point, Vecf(dimension));
+  for (int id_pt = 0; id_pt < nb_point; ++id_pt)
+    for (int i = 0; i < dimension; ++i)
+      pts[id_pt](i) = modes[id_pt % modes.size()](i) + noise(rng);
+
+  const std::vector<std::pair<KMeansSolverType, std::string>> solvers =
+  {
+    {KMeansSolverType::KMEANS_LLOYD, "Lloyd"},
+    {KMeansSolverType::KMEANS_HAMERLY, "Hamerly"},
+    {KMeansSolverType::KMEANS_MINI_BATCH, "Mini-batch"}
+  };
+  for (const auto & solver : solvers)
+  {
+    std::vector<uint32_t> ids;
+    std::vector<Vecf> centers;
+    system::Timer timer;
+    KMeans(pts, ids, centers, nb_cluster, max_nb_iteration,
+           KMeansInitType::KMEANS_INIT_RANDOM, nullptr, solver.first);
+    const double time_ms = timer.elapsedMs();
+
+    double inertia = 0.0;
+    for (int i = 0; i < nb_point; ++i)
+      inertia += (pts[i] - centers[ids[i]]).squaredNorm();
+    std::cout
+      << "KMeans solver: " << solver.second
+      << " time: " << time_ms << " ms"
+      << " inertia: " << inertia / nb_point << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2026 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_filtering.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <utility>
+
+using namespace openMVG;
+using namespace openMVG::image;
+
+// Time the separable Gaussian blur (and the fused blur + decimation)
+// for every convolution instruction set supported by this CPU
+int main()
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+  for (const auto & size : {std::make_pair(640, 480), std::make_pair(1920, 1080)})
+  {
+    Image<float> in(size.first, size.second);
+    for (int i = 0; i < in.size(); ++i)
+      in.data()[i] = distribution(random_generator);
+
+    for (const double sigma : {1.0, 1.6, 3.2})
+    {
+      const Eigen::Matrix<float, 1, Eigen::Dynamic> kernel =
+        ComputeGaussianKernel(2 * static_cast<int>(3 * sigma) + 1, sigma).cast<float>();
+      for (const auto instruction_set :
+        {EConvolutionInstructionSet::SCALAR,
+         EConvolutionInstructionSet::SSE2,
+         EConvolutionInstructionSet::AVX2})
+      {
+        if (!IsSupported(instruction_set))
+          continue;
+        RowMatrixXf out;
+        const int nb_run = 5;
+        system::Timer timer;
+        for (int i = 0; i < nb_run; ++i)
+          SeparableConvolution2d(in.GetMat(), kernel, kernel, &out, 1, instruction_set);
+        const double blur_ms = timer.elapsedMs() / nb_run;
+        timer.reset();
+        for (int i = 0; i < nb_run; ++i)
+          SeparableConvolution2d(in.GetMat(), kernel, kernel, &out, 2, instruction_set);
+        const double blur_decimate_ms = timer.elapsedMs() / nb_run;
+        std::cout
+          << size.first << "x" << size.second << " sigma: " << sigma
+          << " (kernel: " << kernel.size() << ")"
+          << " instruction set: " << static_cast<int>(instruction_set)
+          << " blur: " << blur_ms << " ms"
+          << " blur+decimate: " << blur_decimate_ms << " ms" << std::endl;
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2026 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/multiview/solver_fundamental_kernel.hpp"
+#include "openMVG/multiview/test_data_sets.hpp"
+#include "openMVG/numeric/numeric.h"
+#include "openMVG/robust_estimation/rand_sampling.hpp"
+#include "openMVG/robust_estimation/robust_estimator_ACRansac.hpp"
+#include "openMVG/robust_estimation/robust_estimator_ACRansacKernelAdaptator.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::robust;
+
+// Time ACRANSAC with and without the SPRT hypothesis verification
+// on some large contaminated two-view (fundamental matrix) datasets
+int main()
+{
+  const nViewDatasetConfigurator config;
+  const int W = 2 * config._cx, H = 2 * config._cy;
+
+  using KernelType =
+    ACKernelAdaptor<
+      fundamental::kernel::SevenPointSolver,
+      fundamental::kernel::EpipolarDistanceError,
+      UnnormalizerT,
+      Mat3,
+      fundamental::kernel::EightPointSolver>;
+
+  for (const size_t nb_points : {1000, 10000, 100000})
+  for (const float outlier_ratio : {.3f, .6f})
+  for (const double precision : {std::numeric_limits<double>::infinity(), 4.0})
+  {
+    // Noisy correspondences, some of them are replaced by random points
+    const NViewDataSet d = NRealisticCamerasRing(2, nb_points, config);
+    std::mt19937 random_generator(std::mt19937::default_seed);
+    std::normal_distribution<double> noise(0, 0.5);
+    std::uniform_real_distribution<double> dW(0, W), dH(0, H);
+    Mat x1 = d._x[0], x2 = d._x[1];
+    for (Mat::Index i = 0; i < x2.cols(); ++i)
+    {
+      x1.col(i) += Vec2(noise(random_generator), noise(random_generator));
+      x2.col(i) += Vec2(noise(random_generator), noise(random_generator));
+    }
+    const auto nb_outliers = static_cast<uint32_t>(outlier_ratio * nb_points);
+    std::vector<uint32_t> outlier_ids(nb_outliers);
+    UniformSample(nb_outliers, nb_points, random_generator, &outlier_ids);
+    for (const auto & id : outlier_ids)
+    {
+      x2.col(id) << dW(random_generator), dH(random_generator);
+    }
+
+    const KernelType kernel(x1, W, H, x2, W, H, true);
+
+    std::cout
+      << "#points: " << nb_points << " outlier ratio: " << outlier_ratio
+      << " precision: " << precision << std::endl;
+    for (const bool sprt : {false, true})
+    {
+      ACRANSAC_Options options;
+      options.bSPRT = sprt;
+      std::vector<uint32_t> inliers;
+      Mat3 F;
+      system::Timer timer;
+      const std::pair<double, double> ret =
+        ACRANSAC(kernel, inliers, 1024, &F, Square(precision), options);
+      const double time_ms = timer.elapsedMs();
+      std::cout
+        << (sprt ? " ACRANSAC+SPRT: " : " ACRANSAC:      ")
+        << time_ms << " ms #inliers: " << inliers.size()
+        << " threshold: " << std::sqrt(ret.first) << std::endl;
+    }
+  }
+  return EXIT_SUCCESS;
+}
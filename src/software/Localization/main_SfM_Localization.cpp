@@ -12,6 +12,8 @@
 #include <openMVG/features/feature.hpp>
 #include <openMVG/features/image_describer.hpp>
 #include <openMVG/image/image_io.hpp>
+#include <openMVG/matching_image_collection/Vlad.hpp>
+#include <openMVG/matching_image_collection/Vlad_Database.hpp>
 #include <openMVG/sfm/sfm.hpp>
 #include <openMVG/system/loggerprogress.hpp>
 #include <openMVG/system/timer.hpp>
@@ -68,6 +70,11 @@ int main(int argc, char **argv)
   bool bUseSingleIntrinsics = false;
   bool bExportStructure = false;
   int resection_method  = static_cast<int>(resection::SolverType::DEFAULT);
+  std::string sLocalizationDatabase;
+  int iMaxDescriptorsPerLandmark = 0;
+  std::string sVladDatabase;
+  int iRetrievalViews = 10;
+  int iCovisibleViews = 10;
 
 #ifdef OPENMVG_USE_OPENMP
   int iNumThreads = 0;
@@ -82,7 +89,13 @@ int main(int argc, char **argv)
   cmd.add( make_option('c', i_User_camera_model, "camera_model") );
   cmd.add( make_switch('s', "single_intrinsics"));
   cmd.add( make_switch('e', "export_structure"));
+  cmd.add( make_switch('L', "local_optimization"));
   cmd.add( make_option('R', resection_method, "resection_method"));
+  cmd.add( make_option('b', sLocalizationDatabase, "localization_database"));
+  cmd.add( make_option('k', iMaxDescriptorsPerLandmark, "max_landmark_descriptors"));
+  cmd.add( make_option('V', sVladDatabase, "vlad_database"));
+  cmd.add( make_option('T', iRetrievalViews, "retrieval_views"));
+  cmd.add( make_option('C', iCovisibleViews, "covisible_views"));
 
 #ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
@@ -110,6 +123,8 @@ int main(int argc, char **argv)
     << "  (OFF by default)\n"
     << "[-e|--export_structure] (switch) when switched on, the program will also export structure to output sfm_data.\n"
     << "  if OFF only VIEWS, INTRINSICS and EXTRINSICS are exported (OFF by default)\n"
+    << "[-L|--local_optimization] (switch) when switched on, the DLT resection poses are refined\n"
+    << "  with the LO-RANSAC local optimization (OFF by default)\n"
     << "[-c|--camera_model] Camera model type for view with unknown intrinsic:\n"
       << "\t 1: Pinhole\n"
       << "\t 2: Pinhole radial 1\n"
@@ -123,6 +138,17 @@ int main(int argc, char **argv)
       << "\t" << static_cast<int>(resection::SolverType::P3P_KNEIP_CVPR11) << ": P3P_KNEIP_CVPR11\n"
       << "\t" << static_cast<int>(resection::SolverType::P3P_NORDBERG_ECCV18) << ": P3P_NORDBERG_ECCV18\n"
       << "\t" << static_cast<int>(resection::SolverType::UP2P_KUKELOVA_ACCV10)  << ": UP2P_KUKELOVA_ACCV10 | 2Points | upright camera\n"
+    << "[-b|--localization_database] path to a localization database file:\n"
+      << "\t if the file exists, the database is loaded (the scene regions are not loaded),\n"
+      << "\t else the database is built from the scene regions and saved to this file.\n"
+    << "[-k|--max_landmark_descriptors] maximal number of representative descriptors\n"
+      << "\t kept per landmark (0: keep all (default)).\n"
+      << "\t A loaded database is compacted again if it keeps more descriptors per landmark.\n"
+    << "[-V|--vlad_database] VLAD database of the scene views (see openMVG_main_ComputeVLAD):\n"
+      << "\t if provided, the query is matched only with the landmarks seen by its most\n"
+      << "\t similar scene views and their covisible views (covisibility search).\n"
+    << "[-T|--retrieval_views] number of similar views retrieved with VLAD (default=" << iRetrievalViews << ")\n"
+    << "[-C|--covisible_views] number of covisible views added to the retrieved views (default=" << iCovisibleViews << ")\n"
 #ifdef OPENMVG_USE_OPENMP
     << "[-n|--numThreads] number of thread(s)\n"
 #endif
@@ -137,6 +163,16 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if (iMaxDescriptorsPerLandmark < 0)  {
+    std::cerr << "\n Invalid max_landmark_descriptors value" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (iRetrievalViews < 1 || iCovisibleViews < 0)  {
+    std::cerr << "\n Invalid retrieval_views or covisible_views value" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   // Load input SfM_Data scene
   SfM_Data sfm_data;
   if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(ALL))) {
@@ -158,6 +194,7 @@ int main(int argc, char **argv)
   }
 
   bUseSingleIntrinsics = cmd.used('s');
+  const bool bLocalOptimization = cmd.used('L');
   bExportStructure = cmd.used('e');
   // ---------------
   // Initialization
@@ -201,16 +238,6 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  // Show the progress on the command line:
-  system::LoggerProgress progress;
-
-  // Load the SfM_Data region's views
-  std::shared_ptr<Regions_Provider> regions_provider = std::make_shared<Regions_Provider>();
-  if (!regions_provider->load(sfm_data, sMatchesDir, regions_type, &progress)) {
-    std::cerr << std::endl << "Invalid regions." << std::endl;
-    return EXIT_FAILURE;
-  }
-
   if ( !stlplus::folder_exists( sQueryDir ) && !stlplus::file_exists( sQueryDir ) )
   {
     std::cerr << "\nThe query directory/file does not exist : " << std::endl;
@@ -241,13 +268,75 @@ int main(int argc, char **argv)
 
   std::vector<Vec3> vec_found_poses;
 
-  sfm::SfM_Localization_Single_3DTrackObservation_Database localizer;
-  if (!localizer.Init(sfm_data, *regions_provider.get()))
+  sfm::SfM_Localization_Single_3DTrackObservation_Database localizer(
+    static_cast<IndexT>(iMaxDescriptorsPerLandmark));
+  if (!sLocalizationDatabase.empty() && stlplus::is_file(sLocalizationDatabase))
+  {
+    // Reuse a previously built database (no need to load the scene regions)
+    system::Timer database_timer;
+    if (!localizer.Load(sfm_data, *regions_type, sLocalizationDatabase))
+    {
+      std::cerr << "Cannot load the localization database: "
+        << sLocalizationDatabase << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "Localization database loaded in (s): "
+      << database_timer.elapsed() << std::endl;
+  }
+  else
+  {
+    // Show the progress on the command line:
+    system::LoggerProgress progress;
+
+    // Load the SfM_Data region's views
+    std::shared_ptr<Regions_Provider> regions_provider = std::make_shared<Regions_Provider>();
+    if (!regions_provider->load(sfm_data, sMatchesDir, regions_type, &progress)) {
+      std::cerr << std::endl << "Invalid regions." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (!localizer.Init(sfm_data, *regions_provider.get()))
+    {
+      std::cerr << "Cannot initialize the SfM localizer" << std::endl;
+    }
+    // Since we have copied interesting data, release some memory
+    regions_provider.reset();
+
+    if (!sLocalizationDatabase.empty() && !localizer.Save(sLocalizationDatabase))
+    {
+      std::cerr << "Cannot save the localization database: "
+        << sLocalizationDatabase << std::endl;
+    }
+  }
+
+  // Optional image retrieval (covisibility search)
+  VLAD_Database vlad_database;
+  std::unique_ptr<VLADBase> vlad_builder;
+  std::unique_ptr<Regions> vlad_codebook_regions;
+  if (!sVladDatabase.empty())
   {
-    std::cerr << "Cannot initialize the SfM localizer" << std::endl;
+    if (!Load(vlad_database, sVladDatabase)
+        || vlad_database.codebook.empty()
+        || vlad_database.view_ids.empty()
+        || vlad_database.codebook[0].size() != regions_type->DescriptorLength())
+    {
+      std::cerr << "Invalid VLAD database: " << sVladDatabase << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (dynamic_cast<const SIFT_Regions*>(regions_type.get()))
+      vlad_builder.reset(new VLAD<SIFT_Regions>);
+    else if (dynamic_cast<const AKAZE_Float_Regions*>(regions_type.get()))
+      vlad_builder.reset(new VLAD<AKAZE_Float_Regions>);
+    else
+    {
+      std::cerr << "VLAD does not support this Regions type." << std::endl;
+      return EXIT_FAILURE;
+    }
+    vlad_codebook_regions.reset(regions_type->EmptyClone());
+    vlad_builder->CodebookToRegions(vlad_codebook_regions, vlad_database.codebook);
+    std::cout << "Covisibility search enabled (#indexed views: "
+      << vlad_database.view_ids.size() << ")" << std::endl;
   }
-  // Since we have copied interesting data, release some memory
-  regions_provider.reset();
 
   // list images from sfm_data in a vector
   std::vector<std::string> vec_image_original (sfm_data.GetViews().size());
@@ -385,17 +474,50 @@ int main(int argc, char **argv)
     geometry::Pose3 pose;
     sfm::Image_Localizer_Match_Data matching_data;
     matching_data.error_max = dMaxResidualError;
+    matching_data.b_local_optimization = bLocalOptimization;
 
     bool bSuccessfulLocalization = false;
 
+    // Retrieve the most similar scene views (VLAD embedding inner product)
+    std::vector<IndexT> retrieved_view_ids;
+    if (vlad_builder)
+    {
+      const VLADBase::VladMatrixType query_embedding =
+        vlad_builder->ComputeVLADEmbedding(*query_regions, *vlad_codebook_regions,
+                                           vlad_database.normalization);
+      const Eigen::Matrix<VLADBase::VladInternalType, Eigen::Dynamic, 1> similarities =
+        vlad_database.embeddings.transpose() * query_embedding.col(0);
+      std::vector<std::pair<VLADBase::VladInternalType, IndexT>> ranked_views(similarities.size());
+      for (Eigen::Index j = 0; j < similarities.size(); ++j)
+        ranked_views[j] = {similarities(j), vlad_database.view_ids[j]};
+      const size_t count = std::min(static_cast<size_t>(iRetrievalViews), ranked_views.size());
+      std::partial_sort(ranked_views.begin(), ranked_views.begin() + count, ranked_views.end(),
+        std::greater<std::pair<VLADBase::VladInternalType, IndexT>>());
+      for (size_t j = 0; j < count; ++j)
+        retrieved_view_ids.push_back(ranked_views[j].second);
+    }
+
     // Try to localize the image in the database thanks to its regions
-    if (!localizer.Localize(
-      optional_intrinsic ? static_cast<resection::SolverType>(resection_method) : resection::SolverType::DLT_6POINTS,
-      {imageGray.Width(), imageGray.Height()},
-      optional_intrinsic.get(),
-      *(query_regions.get()),
-      pose,
-      &matching_data))
+    const resection::SolverType solver_type = optional_intrinsic ?
+      static_cast<resection::SolverType>(resection_method) : resection::SolverType::DLT_6POINTS;
+    const bool bLocalized = vlad_builder ?
+      localizer.Localize(
+        solver_type,
+        {imageGray.Width(), imageGray.Height()},
+        optional_intrinsic.get(),
+        *(query_regions.get()),
+        retrieved_view_ids,
+        static_cast<size_t>(iCovisibleViews),
+        pose,
+        &matching_data)
+      : localizer.Localize(
+        solver_type,
+        {imageGray.Width(), imageGray.Height()},
+        optional_intrinsic.get(),
+        *(query_regions.get()),
+        pose,
+        &matching_data);
+    if (!bLocalized)
     {
       std::cerr << "Cannot locate the image " << *iter_image << std::endl;
       bSuccessfulLocalization = false;
@@ -410,34 +532,16 @@ int main(int argc, char **argv)
       if (b_new_intrinsic)
       {
         // setup a default camera model from the found projection matrix
-        Mat3 K, R;
-        Vec3 t;
-        KRt_From_P(matching_data.projection_matrix, &K, &R, &t);
-
-        const double focal = (K(0,0) + K(1,1))/2.0;
-        const Vec2 principal_point(K(0,2), K(1,2));
-
-        switch (openMVG::cameras::EINTRINSIC(i_User_camera_model))
+        const cameras::EINTRINSIC camera_model = openMVG::cameras::EINTRINSIC(i_User_camera_model);
+        optional_intrinsic = sfm::SfM_Localizer::CreateIntrinsic(
+          camera_model,
+          {imageGray.Width(), imageGray.Height()},
+          matching_data.projection_matrix);
+        if (!optional_intrinsic)
         {
-          case cameras::PINHOLE_CAMERA:
-            optional_intrinsic = std::make_shared<cameras::Pinhole_Intrinsic>(imageGray.Width(), imageGray.Height(),focal, principal_point(0), principal_point(1));
-          break;
-          case cameras::PINHOLE_CAMERA_RADIAL1:
-            optional_intrinsic = std::make_shared<cameras::Pinhole_Intrinsic_Radial_K1>(imageGray.Width(), imageGray.Height(),focal, principal_point(0), principal_point(1));
-          break;
-          case cameras::PINHOLE_CAMERA_RADIAL3:
-            optional_intrinsic = std::make_shared<cameras::Pinhole_Intrinsic_Radial_K3>(imageGray.Width(), imageGray.Height(),focal, principal_point(0), principal_point(1));
-          break;
-          case cameras::PINHOLE_CAMERA_BROWN:
-            optional_intrinsic = std::make_shared<cameras::Pinhole_Intrinsic_Brown_T2>(imageGray.Width(), imageGray.Height(),focal, principal_point(0), principal_point(1));
-          break;
-          case cameras::PINHOLE_CAMERA_FISHEYE:
-            optional_intrinsic = std::make_shared<cameras::Pinhole_Intrinsic_Fisheye>(imageGray.Width(), imageGray.Height(),focal, principal_point(0), principal_point(1));
-          break;
-          case cameras::CAMERA_SPHERICAL:
+          if (camera_model == cameras::CAMERA_SPHERICAL)
             std::cerr << "The spherical camera cannot be created there. Resection of a spherical camera must be done with an existing camera model." << std::endl;
-          break;
-          default:
+          else
             std::cerr << "Error: unknown camera model: " << static_cast<int>(i_User_camera_model) << std::endl;
         }
       }
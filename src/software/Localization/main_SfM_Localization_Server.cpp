@@ -0,0 +1,536 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/json.hpp>
+
+#include <openMVG/features/feature.hpp>
+#include <openMVG/features/image_describer.hpp>
+#include <openMVG/image/image_io.hpp>
+#include <openMVG/sfm/sfm.hpp>
+#include <openMVG/system/bounded_queue.hpp>
+#include <openMVG/system/latency_statistics.hpp>
+#include <openMVG/system/loggerprogress.hpp>
+#include <openMVG/system/timer.hpp>
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+#include "nonFree/sift/SIFT_describer_io.hpp"
+#include "openMVG/features/akaze/image_describer_akaze_io.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A query image and the data computed along the localization pipeline
+struct LocalizationQuery
+{
+  std::string image_path;
+  system::Timer latency_timer; // Started when the query is received
+  image::Image<unsigned char> image;
+  int width = 0, height = 0;
+  std::unique_ptr<features::Regions> regions;
+  std::shared_ptr<cameras::IntrinsicBase> intrinsic;
+  Image_Localizer_Match_Data matching_data;
+  geometry::Pose3 pose;
+};
+using LocalizationQueryPtr = std::unique_ptr<LocalizationQuery>;
+using LocalizationQueue = system::BoundedQueue<LocalizationQueryPtr>;
+
+// Serialize the responses written on the standard output
+class ResponseWriter
+{
+public:
+  void Success(const LocalizationQuery & query)
+  {
+    const Vec3 center = query.pose.center();
+    const Mat3 & R = query.pose.rotation();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "OK " << query.image_path
+      << ' ' << query.matching_data.vec_inliers.size()
+      << ' ' << center(0) << ' ' << center(1) << ' ' << center(2);
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        std::cout << ' ' << R(i, j);
+    std::cout << std::endl;
+  }
+
+  void Failure(const LocalizationQuery & query, const std::string & reason)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "FAIL " << query.image_path << ' ' << reason << std::endl;
+  }
+
+  void Statistics(const std::vector<const system::LatencyStatistics *> & stats)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto & stat : stats)
+      std::cout << "STATS " << stat->ToString() << '\n';
+    std::cout << std::flush;
+  }
+
+private:
+  std::mutex mutex_;
+};
+
+// A pipeline stage: some worker threads consume the queries of an input queue,
+// apply the stage function (timed) and forward the successful queries to the
+// next stage queue. A stage function returns an empty string on success or
+// the failure reason (the query is then answered and dropped).
+class LocalizationStage
+{
+public:
+  using StageFunction = std::function<std::string(LocalizationQuery &)>;
+
+  LocalizationStage
+  (
+    const std::string & name,
+    size_t queue_size,
+    StageFunction function
+  ):
+    input_(queue_size),
+    stats_(name),
+    function_(std::move(function))
+  {}
+
+  void Start
+  (
+    int nb_workers,
+    LocalizationStage * next_stage, // nullptr for the last stage
+    ResponseWriter & writer,
+    system::LatencyStatistics & total_stats
+  )
+  {
+    for (int i = 0; i < nb_workers; ++i)
+    {
+      workers_.emplace_back([this, next_stage, &writer, &total_stats]
+      {
+        LocalizationQueryPtr query;
+        while (input_.Pop(query))
+        {
+          system::Timer stage_timer;
+          const std::string failure = function_(*query);
+          stats_.Add(stage_timer.elapsedMs());
+          if (!failure.empty())
+          {
+            writer.Failure(*query, failure);
+            total_stats.Add(query->latency_timer.elapsedMs());
+          }
+          else if (next_stage)
+          {
+            next_stage->input_.Push(std::move(query));
+          }
+          else
+          {
+            writer.Success(*query);
+            total_stats.Add(query->latency_timer.elapsedMs());
+          }
+        }
+      });
+    }
+  }
+
+  bool Push(LocalizationQueryPtr query) { return input_.Push(std::move(query)); }
+
+  // Wait that all the queries of the stage have been processed
+  void Stop()
+  {
+    input_.Close();
+    for (auto & worker : workers_)
+      worker.join();
+    workers_.clear();
+  }
+
+  const system::LatencyStatistics & Statistics() const { return stats_; }
+
+private:
+  LocalizationQueue input_;
+  system::LatencyStatistics stats_;
+  StageFunction function_;
+  std::vector<std::thread> workers_;
+};
+
+// ----------------------------------------------------
+// Resident localization service:
+// - load once the scene, the localization database and the image describer,
+// - read query image paths on the standard input (one per line),
+// - localize them through a pipeline:
+//   decode -> describe -> match -> resection (robust) -> refine
+// - answer on the standard output (one line per query, in completion order):
+//   OK <image> <#inliers> <center x y z> <rotation (row major)>
+//   FAIL <image> <reason>
+// The "stats" command outputs the per-stage latency percentiles,
+// "quit" (or the end of the input stream) stops the service once the pending
+// queries have been answered.
+// ----------------------------------------------------
+int main(int argc, char **argv)
+{
+  using namespace std;
+  std::cerr << std::endl
+    << "-----------------------------------------------------------\n"
+    << "  Images localization service in an existing SfM reconstruction:\n"
+    << "-----------------------------------------------------------\n"
+    << std::endl;
+
+  CmdLine cmd;
+
+  std::string sSfM_Data_Filename;
+  std::string sMatchesDir;
+  std::string sLocalizationDatabase;
+  int iMaxDescriptorsPerLandmark = 0;
+  double dMaxResidualError = std::numeric_limits<double>::infinity();
+  int i_User_camera_model = cameras::PINHOLE_CAMERA_RADIAL3;
+  bool bUseSingleIntrinsics = false;
+  int resection_method  = static_cast<int>(resection::SolverType::DEFAULT);
+  int iNumThreads = std::max(1u, std::thread::hardware_concurrency());
+  int iQueueSize = 4;
+
+  cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
+  cmd.add( make_option('m', sMatchesDir, "match_dir") );
+  cmd.add( make_option('b', sLocalizationDatabase, "localization_database"));
+  cmd.add( make_option('k', iMaxDescriptorsPerLandmark, "max_landmark_descriptors"));
+  cmd.add( make_option('r', dMaxResidualError, "residual_error"));
+  cmd.add( make_option('c', i_User_camera_model, "camera_model") );
+  cmd.add( make_switch('s', "single_intrinsics"));
+  cmd.add( make_option('R', resection_method, "resection_method"));
+  cmd.add( make_option('n', iNumThreads, "numThreads") );
+  cmd.add( make_option('Q', iQueueSize, "queue_size") );
+
+  try {
+    if (argc == 1) throw std::string("Invalid parameter.");
+    cmd.process(argc, argv);
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+    << "[-i|--input_file] path to a SfM_Data scene\n"
+    << "[-m|--match_dir] path to the directory containing the matches\n"
+    << "  corresponding to the provided SfM_Data scene\n"
+    << "\n"
+    << "(optional)\n"
+    << "[-b|--localization_database] path to a localization database file:\n"
+      << "\t if the file exists, the database is loaded (the scene regions are not loaded),\n"
+      << "\t else the database is built from the scene regions and saved to this file.\n"
+    << "[-k|--max_landmark_descriptors] maximal number of representative descriptors\n"
+      << "\t kept per landmark (0: keep all (default)).\n"
+      << "\t A loaded database is compacted again if it keeps more descriptors per landmark.\n"
+    << "[-r|--residual_error] upper bound of the residual error tolerance\n"
+    << "[-s|--single_intrinsics] (switch) when switched on, the program will check if the input sfm_data\n"
+    << "  contains a single intrinsics and, if so, take this value as intrinsics for the query images.\n"
+    << "  (OFF by default)\n"
+    << "[-c|--camera_model] Camera model type for view with unknown intrinsic:\n"
+      << "\t 1: Pinhole\n"
+      << "\t 2: Pinhole radial 1\n"
+      << "\t 3: Pinhole radial 3 (default)\n"
+      << "\t 4: Pinhole radial 3 + tangential 2\n"
+      << "\t 5: Pinhole fisheye\n"
+      << "\t 7: Spherical camera\n"
+    << "[-R|--resection_method] resection/pose estimation method (default=" << resection_method << "):\n"
+      << "\t" << static_cast<int>(resection::SolverType::DLT_6POINTS) << ": DIRECT_LINEAR_TRANSFORM 6Points | does not use intrinsic data\n"
+      << "\t" << static_cast<int>(resection::SolverType::P3P_KE_CVPR17) << ": P3P_KE_CVPR17\n"
+      << "\t" << static_cast<int>(resection::SolverType::P3P_KNEIP_CVPR11) << ": P3P_KNEIP_CVPR11\n"
+      << "\t" << static_cast<int>(resection::SolverType::P3P_NORDBERG_ECCV18) << ": P3P_NORDBERG_ECCV18\n"
+      << "\t" << static_cast<int>(resection::SolverType::UP2P_KUKELOVA_ACCV10)  << ": UP2P_KUKELOVA_ACCV10 | 2Points | upright camera\n"
+    << "[-n|--numThreads] number of worker thread(s) split between the pipeline stages,\n"
+      << "\t at least one per stage (default=" << iNumThreads << ")\n"
+    << "[-Q|--queue_size] maximal number of pending queries between two stages (default=" << iQueueSize << ")\n"
+    << "\n"
+    << "Protocol (standard input, one command per line):\n"
+    << "  <image path>: localize the image\n"
+    << "  stats: output the per stage latency percentiles\n"
+    << "  quit: stop the service (once the pending queries are answered)\n"
+    << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if ( !isValid(openMVG::cameras::EINTRINSIC(i_User_camera_model)) )  {
+    std::cerr << "\n Invalid camera type" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (iMaxDescriptorsPerLandmark < 0 || iNumThreads < 1 || iQueueSize < 1)  {
+    std::cerr << "\n Invalid max_landmark_descriptors, numThreads or queue_size value" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Load input SfM_Data scene
+  SfM_Data sfm_data;
+  if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(ALL))) {
+    std::cerr << std::endl
+      << "The input SfM_Data file \""<< sSfM_Data_Filename << "\" cannot be read." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (sfm_data.GetPoses().empty() || sfm_data.GetLandmarks().empty())
+  {
+    std::cerr << std::endl
+      << "The input SfM_Data file have not 3D content to match with." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  bUseSingleIntrinsics = cmd.used('s');
+  if (bUseSingleIntrinsics && sfm_data.GetIntrinsics().size() != 1)
+  {
+    std::cerr << "You choose the single intrinsic mode but the sfm_data scene,"
+      << " have too few or too much intrinsics." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // ---------------
+  // Initialization
+  // ---------------
+
+  // Init the regions_type from the image describer file (used for image regions extraction)
+  using namespace openMVG::features;
+  const std::string sImage_describer = stlplus::create_filespec(sMatchesDir, "image_describer", "json");
+  std::unique_ptr<Regions> regions_type = Init_region_type_from_file(sImage_describer);
+  if (!regions_type)
+  {
+    std::cerr << "Invalid: "
+      << sImage_describer << " regions type file." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Init the feature extractor that have been used for the reconstruction
+  std::unique_ptr<Image_describer> image_describer;
+  if (stlplus::is_file(sImage_describer))
+  {
+    // Dynamically load the image_describer from the file (will restore old used settings)
+    std::ifstream stream(sImage_describer.c_str());
+    if (!stream)
+      return EXIT_FAILURE;
+
+    try
+    {
+      cereal::JSONInputArchive archive(stream);
+      archive(cereal::make_nvp("image_describer", image_describer));
+    }
+    catch (const cereal::Exception & e)
+    {
+      std::cerr << e.what() << std::endl
+        << "Cannot dynamically allocate the Image_describer interface." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  else
+  {
+    std::cerr << "Expected file image_describer.json cannot be opened." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Init the localization database
+  sfm::SfM_Localization_Single_3DTrackObservation_Database localizer(
+    static_cast<IndexT>(iMaxDescriptorsPerLandmark));
+  if (!sLocalizationDatabase.empty() && stlplus::is_file(sLocalizationDatabase))
+  {
+    if (!localizer.Load(sfm_data, *regions_type, sLocalizationDatabase))
+    {
+      std::cerr << "Cannot load the localization database: "
+        << sLocalizationDatabase << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  else
+  {
+    // Show the progress on the command line:
+    system::LoggerProgress progress;
+
+    // Load the SfM_Data region's views
+    std::shared_ptr<Regions_Provider> regions_provider = std::make_shared<Regions_Provider>();
+    if (!regions_provider->load(sfm_data, sMatchesDir, regions_type, &progress)) {
+      std::cerr << std::endl << "Invalid regions." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (!localizer.Init(sfm_data, *regions_provider.get()))
+    {
+      std::cerr << "Cannot initialize the SfM localizer" << std::endl;
+      return EXIT_FAILURE;
+    }
+    // Since we have copied interesting data, release some memory
+    regions_provider.reset();
+
+    if (!sLocalizationDatabase.empty() && !localizer.Save(sLocalizationDatabase))
+    {
+      std::cerr << "Cannot save the localization database: "
+        << sLocalizationDatabase << std::endl;
+    }
+  }
+
+  const std::shared_ptr<cameras::IntrinsicBase> single_intrinsic =
+    bUseSingleIntrinsics ? sfm_data.GetIntrinsics().begin()->second : nullptr;
+  const cameras::EINTRINSIC camera_model = cameras::EINTRINSIC(i_User_camera_model);
+
+  // ---------------
+  // Localization pipeline
+  // ---------------
+
+  LocalizationStage decode_stage("decode", iQueueSize,
+    [&](LocalizationQuery & query) -> std::string
+    {
+      if (image::GetFormat(query.image_path.c_str()) == image::Unknown)
+        return "unknown image file format";
+      if (!image::ReadImage(query.image_path.c_str(), &query.image))
+        return "cannot open the image";
+      query.width = query.image.Width();
+      query.height = query.image.Height();
+
+      if (single_intrinsic)
+      {
+        if (query.width != single_intrinsic->w() || query.height != single_intrinsic->h())
+          return "the image size does not match the single intrinsic";
+        query.intrinsic = single_intrinsic;
+      }
+      else if (camera_model == cameras::CAMERA_SPHERICAL)
+      {
+        // Since the spherical image is only defined by its image size we can initialize its camera model.
+        // This way the resection will be performed with valid bearing vector
+        query.intrinsic = std::make_shared<cameras::Intrinsic_Spherical>(query.width, query.height);
+      }
+      return {};
+    });
+
+  LocalizationStage describe_stage("describe", iQueueSize,
+    [&](LocalizationQuery & query) -> std::string
+    {
+      image_describer->Describe(query.image, query.regions);
+      query.image = image::Image<unsigned char>(); // release the image memory
+      if (!query.regions || query.regions->RegionCount() == 0)
+        return "no region detected";
+      return {};
+    });
+
+  LocalizationStage match_stage("match", iQueueSize,
+    [&](LocalizationQuery & query) -> std::string
+    {
+      query.matching_data.error_max = dMaxResidualError;
+      const bool bMatch = localizer.MatchLandmarks(*query.regions, query.matching_data);
+      query.regions.reset();
+      if (!bMatch)
+        return "no 2D-3D putative correspondences";
+      return {};
+    });
+
+  LocalizationStage resection_stage("resection", iQueueSize,
+    [&](LocalizationQuery & query) -> std::string
+    {
+      Image_Localizer_Match_Data & matching_data = query.matching_data;
+      const cameras::IntrinsicBase * intrinsic = query.intrinsic.get();
+      Mat2X pt2D_original = matching_data.pt2D;
+      // Handle image distortion if intrinsic is known (to ease the resection)
+      if (intrinsic && intrinsic->have_disto())
+      {
+        matching_data.pt2D = intrinsic->get_ud_pixels(matching_data.pt2D);
+      }
+      const bool bResection = SfM_Localizer::Localize(
+        intrinsic ? static_cast<resection::SolverType>(resection_method) : resection::SolverType::DLT_6POINTS,
+        {query.width, query.height},
+        intrinsic,
+        matching_data,
+        query.pose);
+      matching_data.pt2D = std::move(pt2D_original); // restore original image domain points
+      if (!bResection)
+        return "resection failure";
+      return {};
+    });
+
+  LocalizationStage refine_stage("refine", iQueueSize,
+    [&](LocalizationQuery & query) -> std::string
+    {
+      // If no intrinsic as input: init a new one from the projection matrix decomposition
+      // Else use the existing one and consider it as static.
+      const bool b_new_intrinsic = (query.intrinsic == nullptr);
+      if (b_new_intrinsic)
+      {
+        query.intrinsic = SfM_Localizer::CreateIntrinsic(camera_model, {query.width, query.height},
+                                                         query.matching_data.projection_matrix);
+        if (!query.intrinsic)
+          return "cannot create the camera model";
+      }
+      else if (query.intrinsic == single_intrinsic)
+      {
+        // Do not share the scene intrinsic between concurrent refinements
+        query.intrinsic.reset(single_intrinsic->clone());
+      }
+      if (!SfM_Localizer::RefinePose(query.intrinsic.get(), query.pose,
+                                     query.matching_data, true, b_new_intrinsic))
+        return "pose refinement failure";
+      return {};
+    });
+
+  ResponseWriter writer;
+  system::LatencyStatistics total_stats("total");
+
+  std::vector<LocalizationStage*> stages =
+    {&decode_stage, &describe_stage, &match_stage, &resection_stage, &refine_stage};
+  // Split the worker thread budget between the stages (at least one worker per stage),
+  // the remaining threads go first to the most expensive stages.
+  std::vector<int> num_workers(stages.size(), std::max(1, iNumThreads / static_cast<int>(stages.size())));
+  const std::vector<size_t> stages_by_cost = {1, 2, 3, 4, 0}; // describe, match, resection, refine, decode
+  for (int i = 0; i < iNumThreads % static_cast<int>(stages.size()); ++i)
+    ++num_workers[stages_by_cost[i]];
+  std::cerr << "Worker threads per stage:";
+  for (size_t i = 0; i < stages.size(); ++i)
+    std::cerr << ' ' << stages[i]->Statistics().Name() << '=' << num_workers[i];
+  std::cerr << std::endl;
+
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    stages[i]->Start(num_workers[i],
+                     (i + 1 < stages.size()) ? stages[i + 1] : nullptr,
+                     writer, total_stats);
+  }
+
+  const auto output_statistics = [&]
+  {
+    std::vector<const system::LatencyStatistics *> stats;
+    for (const auto & stage : stages)
+      stats.push_back(&stage->Statistics());
+    stats.push_back(&total_stats);
+    writer.Statistics(stats);
+  };
+
+  OPENMVG_LOG_INFO << "Localization service ready.";
+
+  std::string line;
+  while (std::getline(std::cin, line))
+  {
+    // Trim the line
+    const size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+      continue;
+    line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+
+    if (line == "quit")
+      break;
+    if (line == "stats")
+    {
+      output_statistics();
+      continue;
+    }
+
+    LocalizationQueryPtr query(new LocalizationQuery);
+    query->image_path = line;
+    decode_stage.Push(std::move(query));
+  }
+
+  // Drain the pipeline (stage by stage)
+  for (auto & stage : stages)
+    stage->Stop();
+
+  output_statistics();
+  return EXIT_SUCCESS;
+}
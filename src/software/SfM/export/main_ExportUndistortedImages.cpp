@@ -18,6 +18,8 @@
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
 #include <cstdlib>
+#include <map>
+#include <memory>
 #include <string>
 
 #ifdef OPENMVG_USE_OPENMP
@@ -39,6 +41,7 @@ int main(int argc, char *argv[]) {
   CmdLine cmd;
   std::string sSfM_Data_Filename;
   std::string sOutDir = "";
+  std::string sMapCacheDir = "";
   bool bExportOnlyReconstructedViews = false;
 #ifdef OPENMVG_USE_OPENMP
   int iNumThreads = 0;
@@ -47,6 +50,7 @@ int main(int argc, char *argv[]) {
   cmd.add( make_option('i', sSfM_Data_Filename, "sfmdata") );
   cmd.add( make_option('o', sOutDir, "outdir") );
   cmd.add( make_option('r', bExportOnlyReconstructedViews, "exportOnlyReconstructed") );
+  cmd.add( make_option('c', sMapCacheDir, "mapCacheDir") );
 
 #ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
@@ -62,6 +66,8 @@ int main(int argc, char *argv[]) {
       << "[-i|--sfmdata] filename, the SfM_Data file to convert\n"
       << "[-o|--outdir] path\n"
       << "[-r|--exportOnlyReconstructed] boolean 1/0 (default = 0)\n"
+      << "[-c|--mapCacheDir] path, directory used to persist the undistortion maps\n"
+      << "  (reused by the next exports of the same intrinsics)\n"
 #ifdef OPENMVG_USE_OPENMP
       << "[-n|--numThreads] number of thread(s)\n"
 #endif
@@ -81,9 +87,41 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (!sMapCacheDir.empty() && !stlplus::folder_exists(sMapCacheDir))
+    stlplus::folder_create( sMapCacheDir );
+
   bool bOk = true;
   {
     system::Timer timer;
+
+    // Compute the undistortion maps once per distinct intrinsic
+    // (intrinsics sharing the same parameters share the same map)
+    std::map<std::size_t, std::shared_ptr<UndistortionMap>> maps_per_hash;
+    std::map<IndexT, std::shared_ptr<UndistortionMap>> maps;
+    for (const auto & intrinsic_it : sfm_data.GetIntrinsics())
+    {
+      const IntrinsicBase * cam = intrinsic_it.second.get();
+      if (!cam->have_disto())
+        continue;
+      const std::size_t hash = cam->hashValue();
+      std::shared_ptr<UndistortionMap> & map = maps_per_hash[hash];
+      if (!map)
+      {
+        map = std::make_shared<UndistortionMap>();
+        const std::string sMapFile = sMapCacheDir.empty() ? "" :
+          stlplus::create_filespec(sMapCacheDir, "undistortion_map_" + std::to_string(hash), "bin");
+        if (sMapFile.empty() || !map->Load(sMapFile, hash))
+        {
+          map->Build(cam);
+          if (!sMapFile.empty() && !map->Save(sMapFile))
+            OPENMVG_LOG_ERROR << "Cannot save the undistortion map: " << sMapFile;
+        }
+      }
+      maps[intrinsic_it.first] = map;
+    }
+    OPENMVG_LOG_INFO
+      << maps_per_hash.size() << " undistortion map(s) ready in (s): " << timer.elapsed();
+
     // Export views as undistorted images (those with valid Intrinsics)
     Image<RGBColor> image, image_ud;
     Image<uint8_t> image_gray, image_gray_ud;
@@ -127,7 +165,7 @@ int main(int argc, char *argv[]) {
         // undistort the image and save it
         if (ReadImage( srcImage.c_str(), &image))
         {
-          UndistortImage(image, cam, image_ud, BLACK);
+          UndistortImage(image, cam, *maps.at(view->id_intrinsic), image_ud, BLACK);
           const bool bRes = WriteImage(dstImage.c_str(), image_ud);
 #ifdef OPENMVG_USE_OPENMP
           #pragma omp critical
@@ -137,7 +175,7 @@ int main(int argc, char *argv[]) {
         else // If RGBColor reading fails, we try to read a gray image
         if (ReadImage( srcImage.c_str(), &image_gray))
         {
-          UndistortImage(image_gray, cam, image_gray_ud, BLACK);
+          UndistortImage(image_gray, cam, *maps.at(view->id_intrinsic), image_gray_ud, BLACK);
           const bool bRes = WriteImage(dstImage.c_str(), image_gray_ud);
 #ifdef OPENMVG_USE_OPENMP
           #pragma omp critical
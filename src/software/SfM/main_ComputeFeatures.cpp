@@ -16,6 +16,8 @@
 #include "openMVG/features/regions_factory_io.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/system/bounded_queue.hpp"
+#include "openMVG/system/latency_statistics.hpp"
 #include "openMVG/system/logger.hpp"
 #include "openMVG/system/loggerprogress.hpp"
 #include "openMVG/system/timer.hpp"
@@ -27,10 +29,15 @@
 
 #include <cereal/details/helpers.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #ifdef OPENMVG_USE_OPENMP
 #include <omp.h>
@@ -40,6 +47,7 @@ using namespace openMVG;
 using namespace openMVG::image;
 using namespace openMVG::features;
 using namespace openMVG::sfm;
+using namespace openMVG::system;
 using namespace std;
 
 features::EDESCRIBER_PRESET stringToEnum(const std::string & sPreset)
@@ -58,6 +66,18 @@ features::EDESCRIBER_PRESET stringToEnum(const std::string & sPreset)
   return preset;
 }
 
+/// A view going through the feature extraction pipeline
+struct FeatureExtractionItem
+{
+  std::string view_filename, feat_filename, desc_filename;
+  Image<unsigned char> image;
+  int image_downscale = 1;
+  Image<unsigned char> mask;
+  bool has_mask = false;
+  std::unique_ptr<Regions> regions;
+};
+using FeatureExtractionItemPtr = std::unique_ptr<FeatureExtractionItem>;
+
 /// - Compute view image description (feature & descriptor extraction)
 /// - Export computed data
 int main(int argc, char **argv)
@@ -70,9 +90,10 @@ int main(int argc, char **argv)
   std::string sImage_Describer_Method = "SIFT";
   bool bForce = false;
   std::string sFeaturePreset = "";
-#ifdef OPENMVG_USE_OPENMP
   int iNumThreads = 0;
-#endif
+  int iNumDecodeThreads = 2;
+  int iNumWriteThreads = 1;
+  int iQueueSize = 0;
 
   // required
   cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
@@ -82,10 +103,10 @@ int main(int argc, char **argv)
   cmd.add( make_option('u', bUpRight, "upright") );
   cmd.add( make_option('f', bForce, "force") );
   cmd.add( make_option('p', sFeaturePreset, "describerPreset") );
-
-#ifdef OPENMVG_USE_OPENMP
   cmd.add( make_option('n', iNumThreads, "numThreads") );
-#endif
+  cmd.add( make_option('d', iNumDecodeThreads, "numDecodeThreads") );
+  cmd.add( make_option('w', iNumWriteThreads, "numWriteThreads") );
+  cmd.add( make_option('q', iQueueSize, "queueSize") );
 
   try {
       if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -102,6 +123,7 @@ int main(int argc, char **argv)
         << "   SIFT (default),\n"
         << "   SIFT_ANATOMY,\n"
         << "   AKAZE_FLOAT: AKAZE with floating point descriptors,\n"
+        << "   AKAZE_FLOAT_QUANTIZED: AKAZE with floating point descriptors stored as uchar,\n"
         << "   AKAZE_MLDB:  AKAZE with binary descriptors\n"
         << "[-u|--upright] Use Upright feature 0 or 1\n"
         << "[-p|--describerPreset]\n"
@@ -109,9 +131,12 @@ int main(int argc, char **argv)
         << "   NORMAL (default),\n"
         << "   HIGH,\n"
         << "   ULTRA: !!Can take long time!!\n"
-#ifdef OPENMVG_USE_OPENMP
-        << "[-n|--numThreads] number of parallel computations\n"
-#endif
+        << "[-n|--numThreads] number of parallel descriptions\n"
+        << "  (default 0: a single description thread)\n"
+        << "[-d|--numDecodeThreads] number of threads reading the images (default 2)\n"
+        << "[-w|--numWriteThreads] number of threads saving the regions (default 1)\n"
+        << "[-q|--queueSize] max number of images waiting between two stages\n"
+        << "  (default 0: twice the number of description threads)\n"
       ;
 
       OPENMVG_LOG_ERROR << s;
@@ -127,11 +152,18 @@ int main(int argc, char **argv)
     << "--upright " << bUpRight << "\n"
     << "--describerPreset " << (sFeaturePreset.empty() ? "NORMAL" : sFeaturePreset) << "\n"
     << "--force " << bForce << "\n"
-#ifdef OPENMVG_USE_OPENMP
     << "--numThreads " << iNumThreads << "\n"
-#endif
+    << "--numDecodeThreads " << iNumDecodeThreads << "\n"
+    << "--numWriteThreads " << iNumWriteThreads << "\n"
+    << "--queueSize " << iQueueSize << "\n"
     ;
 
+  iNumThreads = std::max(1, iNumThreads);
+  iNumDecodeThreads = std::max(1, iNumDecodeThreads);
+  iNumWriteThreads = std::max(1, iNumWriteThreads);
+  if (iQueueSize <= 0)
+    iQueueSize = 2 * iNumThreads;
+
 
   if (sOutDir.empty())
   {
@@ -208,6 +240,12 @@ int main(int argc, char **argv)
         (AKAZE_Image_describer::Params(AKAZE::Params(), AKAZE_MSURF), !bUpRight);
     }
     else
+    if (sImage_Describer_Method == "AKAZE_FLOAT_QUANTIZED")
+    {
+      image_describer = AKAZE_Image_describer::create
+        (AKAZE_Image_describer::Params(AKAZE::Params(), AKAZE_MSURF_QUANTIZED), !bUpRight);
+    }
+    else
     if (sImage_Describer_Method == "AKAZE_MLDB")
     {
       image_describer = AKAZE_Image_describer::create
@@ -247,101 +285,182 @@ int main(int argc, char **argv)
   // For each View of the SfM_Data container:
   // - if regions file exists continue,
   // - if no file, compute features
+  //
+  // The computation is a pipeline of three stages connected by bounded queues
+  // (a full queue blocks the previous stage):
+  // - decode: read the image (at the describer resolution) and its mask,
+  // - describe: compute the regions,
+  // - write: save the regions to disk.
   {
     system::Timer timer;
-    Image<unsigned char> imageGray;
+
+    // Let the image decoder perform the downscaling the describer will apply
+    const int max_image_downscale = image_describer->Max_image_downscale();
+    if (max_image_downscale > 1)
+      OPENMVG_LOG_INFO << "Images are decoded at a reduced resolution (up to 1/"
+        << max_image_downscale << ")";
 
     system::LoggerProgress my_progress_bar(sfm_data.GetViews().size(), "- EXTRACT FEATURES -" );
 
     // Use a boolean to track if we must stop feature extraction
     std::atomic<bool> preemptive_exit(false);
-#ifdef OPENMVG_USE_OPENMP
-    const unsigned int nb_max_thread = omp_get_max_threads();
-
-    if (iNumThreads > 0) {
-        omp_set_num_threads(iNumThreads);
-    } else {
-        omp_set_num_threads(nb_max_thread);
-    }
 
-    #pragma omp parallel for schedule(dynamic) if (iNumThreads > 0) private(imageGray)
-#endif
-    for (int i = 0; i < static_cast<int>(sfm_data.views.size()); ++i)
+    BoundedQueue<FeatureExtractionItemPtr>
+      describe_queue(iQueueSize),
+      write_queue(iQueueSize);
+    system::LatencyStatistics
+      decode_stats("decode"),
+      describe_stats("describe"),
+      write_stats("write");
+
+    // Decode stage: the views are dispatched to the decoding threads
+    std::atomic<int> next_view(0);
+    const int nb_views = static_cast<int>(sfm_data.views.size());
+    auto decode_worker = [&]
     {
-      Views::const_iterator iterViews = sfm_data.views.begin();
-      std::advance(iterViews, i);
-      const View * view = iterViews->second.get();
-      const std::string
-        sView_filename = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path),
-        sFeat = stlplus::create_filespec(sOutDir, stlplus::basename_part(sView_filename), "feat"),
-        sDesc = stlplus::create_filespec(sOutDir, stlplus::basename_part(sView_filename), "desc");
-
-      // If features or descriptors file are missing, compute them
-      if (!preemptive_exit && (bForce || !stlplus::file_exists(sFeat) || !stlplus::file_exists(sDesc)))
+      for (int i = next_view++; i < nb_views && !preemptive_exit; i = next_view++)
       {
-        if (!ReadImage(sView_filename.c_str(), &imageGray))
+        Views::const_iterator iterViews = sfm_data.views.begin();
+        std::advance(iterViews, i);
+        const View * view = iterViews->second.get();
+
+        FeatureExtractionItemPtr item(new FeatureExtractionItem);
+        item->view_filename = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
+        item->feat_filename = stlplus::create_filespec(sOutDir, stlplus::basename_part(item->view_filename), "feat");
+        item->desc_filename = stlplus::create_filespec(sOutDir, stlplus::basename_part(item->view_filename), "desc");
+
+        // If features or descriptors file are missing, compute them
+        if (!bForce && stlplus::file_exists(item->feat_filename) && stlplus::file_exists(item->desc_filename))
+        {
+          ++my_progress_bar;
           continue;
+        }
+
+        system::Timer stage_timer;
+        ImageHeader full_resolution;
+        if (!ReadImageDownscaled(item->view_filename.c_str(), max_image_downscale,
+                                 &item->image, &item->image_downscale, &full_resolution))
+        {
+          ++my_progress_bar;
+          continue;
+        }
 
         //
         // Look if there is an occlusion feature mask
         //
-        Image<unsigned char> * mask = nullptr; // The mask is null by default
-
         const std::string
           mask_filename_local =
             stlplus::create_filespec(sfm_data.s_root_path,
-              stlplus::basename_part(sView_filename) + "_mask", "png"),
+              stlplus::basename_part(item->view_filename) + "_mask", "png"),
           mask_filename_global =
             stlplus::create_filespec(sfm_data.s_root_path, "mask", "png");
 
-        Image<unsigned char> imageMask;
-        // Try to read the local mask
-        if (stlplus::file_exists(mask_filename_local))
+        // Try to read the local mask, else the global one
+        const std::string & mask_filename =
+          stlplus::file_exists(mask_filename_local) ? mask_filename_local : mask_filename_global;
+        if (stlplus::file_exists(mask_filename))
         {
-          if (!ReadImage(mask_filename_local.c_str(), &imageMask))
+          if (!ReadImage(mask_filename.c_str(), &item->mask))
           {
             OPENMVG_LOG_ERROR
-              << "Invalid mask: " << mask_filename_local << ';'
+              << "Invalid mask: " << mask_filename << ';'
               << "Stopping feature extraction.";
             preemptive_exit = true;
-            continue;
-          }
-          // Use the local mask only if it fits the current image size
-          if (imageMask.Width() == imageGray.Width() && imageMask.Height() == imageGray.Height())
-            mask = &imageMask;
-        }
-        else
-        {
-          // Try to read the global mask
-          if (stlplus::file_exists(mask_filename_global))
-          {
-            if (!ReadImage(mask_filename_global.c_str(), &imageMask))
-            {
-              OPENMVG_LOG_ERROR
-                << "Invalid mask: " << mask_filename_global << ';'
-                << "Stopping feature extraction.";
-              preemptive_exit = true;
-              continue;
-            }
-            // Use the global mask only if it fits the current image size
-            if (imageMask.Width() == imageGray.Width() && imageMask.Height() == imageGray.Height())
-              mask = &imageMask;
+            break;
           }
+          // Use the mask only if it fits the current image size
+          item->has_mask =
+            item->mask.Width() == full_resolution.width && item->mask.Height() == full_resolution.height;
         }
+        decode_stats.Add(stage_timer.elapsedMs());
+        describe_queue.Push(std::move(item));
+      }
+    };
+
+    // Describe stage
+    // The describers can use some inner OpenMP regions: the OpenMP threads
+    // are shared between the description threads to not oversubscribe the CPU
+#ifdef OPENMVG_USE_OPENMP
+    const int nb_omp_threads_per_describer = std::max(1, omp_get_max_threads() / iNumThreads);
+#endif
+    auto describe_worker = [&]
+    {
+#ifdef OPENMVG_USE_OPENMP
+      omp_set_num_threads(nb_omp_threads_per_describer);
+#endif
+      FeatureExtractionItemPtr item;
+      while (describe_queue.Pop(item))
+      {
+        system::Timer stage_timer;
+        // Compute features and descriptors
+        item->regions = image_describer->Describe_downscaled(
+          item->image, item->image_downscale, item->has_mask ? &item->mask : nullptr);
+        // Release the image memory as soon as possible
+        item->image = Image<unsigned char>();
+        item->mask = Image<unsigned char>();
+        describe_stats.Add(stage_timer.elapsedMs());
+        write_queue.Push(std::move(item));
+      }
+    };
 
-        // Compute features and descriptors and export them to files
-        auto regions = image_describer->Describe(imageGray, mask);
-        if (regions && !image_describer->Save(regions.get(), sFeat, sDesc)) {
+    // Write stage
+    auto write_worker = [&]
+    {
+      FeatureExtractionItemPtr item;
+      while (write_queue.Pop(item))
+      {
+        system::Timer stage_timer;
+        // Export computed data to files
+        if (item->regions && !preemptive_exit &&
+            !image_describer->Save(item->regions.get(), item->feat_filename, item->desc_filename))
+        {
           OPENMVG_LOG_ERROR
-            << "Cannot save regions for image: " << sView_filename << ';'
+            << "Cannot save regions for image: " << item->view_filename << ';'
             << "Stopping feature extraction.";
           preemptive_exit = true;
-          continue;
         }
+        write_stats.Add(stage_timer.elapsedMs());
+        ++my_progress_bar;
       }
-      ++my_progress_bar;
+    };
+
+    // Start the stages, then close each queue once its producers are done
+    system::Timer pipeline_timer;
+    std::vector<std::thread> decode_threads, describe_threads, write_threads;
+    for (int i = 0; i < iNumDecodeThreads; ++i)
+      decode_threads.emplace_back(decode_worker);
+    for (int i = 0; i < iNumThreads; ++i)
+      describe_threads.emplace_back(describe_worker);
+    for (int i = 0; i < iNumWriteThreads; ++i)
+      write_threads.emplace_back(write_worker);
+
+    for (auto & thread : decode_threads)
+      thread.join();
+    describe_queue.Close();
+    for (auto & thread : describe_threads)
+      thread.join();
+    write_queue.Close();
+    for (auto & thread : write_threads)
+      thread.join();
+    const double pipeline_duration = pipeline_timer.elapsed();
+
+    // Per stage report: the throughput is the number of images processed
+    // by the stage over the pipeline wall time
+    const std::pair<const system::LatencyStatistics *, int> stages[] = {
+      {&decode_stats, iNumDecodeThreads},
+      {&describe_stats, iNumThreads},
+      {&write_stats, iNumWriteThreads}};
+    for (const auto & stage : stages)
+    {
+      OPENMVG_LOG_INFO << stage.first->ToString()
+        << " #threads: " << stage.second
+        << " throughput: "
+        << (pipeline_duration > 0 ? stage.first->Count() / pipeline_duration : 0.0)
+        << " images/s";
     }
     OPENMVG_LOG_INFO << "Task done in (s): " << timer.elapsed();
+    if (preemptive_exit)
+      return EXIT_FAILURE;
   }
   return EXIT_SUCCESS;
 }
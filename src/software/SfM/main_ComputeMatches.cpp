@@ -50,6 +50,7 @@ int main( int argc, char** argv )
   std::string  sPredefinedPairList    = "";
   std::string  sNearestMatchingMethod = "AUTO";
   bool         bForce                 = false;
+  bool         bSaveScores            = false;
   unsigned int ui_max_cache_size      = 0;
 
   // Pre-emptive matching parameters
@@ -65,6 +66,7 @@ int main( int argc, char** argv )
   cmd.add( make_option( 'n', sNearestMatchingMethod, "nearest_matching_method" ) );
   cmd.add( make_option( 'f', bForce, "force" ) );
   cmd.add( make_option( 'c', ui_max_cache_size, "cache_size" ) );
+  cmd.add( make_option( 's', bSaveScores, "save_scores" ) );
   // Pre-emptive matching
   cmd.add( make_option( 'P', ui_preemptive_feature_count, "preemptive_feature_count") );
 
@@ -101,9 +103,12 @@ int main( int argc, char** argv )
       << "  For Binary based descriptor:\n"
       << "    BRUTEFORCEHAMMING: BruteForce Hamming matching,\n"
       << "    HNSWHAMMING: Hamming Approximate Matching with Hierarchical Navigable Small World graphs\n"
+      << "    MULTIINDEXHASHINGHAMMING: Hamming exact matching with Multi-Index Hashing\n"
       << "[-c|--cache_size]\n"
       << "  Use a regions cache (only cache_size regions will be stored in memory)\n"
-      << "  If not used, all regions will be load in memory."
+      << "  If not used, all regions will be load in memory.\n"
+      << "[-s|--save_scores] Save the distance ratio of each match with the matches\n"
+      << "  (used by the GeometricFilter --prosac sampling, OFF by default)."
       << "\n[Pre-emptive matching:]\n"
       << "[-P|--preemptive_feature_count] <NUMBER> Number of feature used for pre-emptive matching";
 
@@ -123,6 +128,7 @@ int main( int argc, char** argv )
             << "--ratio " << fDistRatio << "\n"
             << "--nearest_matching_method " << sNearestMatchingMethod << "\n"
             << "--cache_size " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size)) << "\n"
+            << "--save_scores " << bSaveScores << "\n"
             << "--preemptive_feature_used/count " << cmd.used('P') << " / " << ui_preemptive_feature_count;
   if (cmd.used('P'))
   {
@@ -275,6 +281,12 @@ int main( int argc, char** argv )
       collectionMatcher.reset(new Matcher_Regions(fDistRatio, HNSW_HAMMING));
     }
     else
+    if (sNearestMatchingMethod == "MULTIINDEXHASHINGHAMMING")
+    {
+      OPENMVG_LOG_INFO << "Using MULTI_INDEX_HASHING_HAMMING matcher";
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, MULTI_INDEX_HASHING_HAMMING));
+    }
+    else
     if (sNearestMatchingMethod == "ANNL2")
     {
       OPENMVG_LOG_INFO << "Using ANN_L2 matcher";
@@ -340,7 +352,7 @@ int main( int argc, char** argv )
       //---------------------------------------
       //-- Export putative matches & pairs
       //---------------------------------------
-      if ( !Save( map_PutativeMatches, std::string( sOutputMatchesFilename ) ) )
+      if ( !Save( map_PutativeMatches, std::string( sOutputMatchesFilename ), bSaveScores ) )
       {
         OPENMVG_LOG_ERROR
           << "Cannot save computed matches in: "
@@ -43,6 +43,8 @@ int main(int argc, char **argv)
 
   cmd.add(make_option('i', sSfM_Data_Filename_In, "input_file"));
   cmd.add(make_option('o', sOutputPLY_Out, "output_file"));
+  int max_image_downscale = 1;
+  cmd.add(make_option('d', max_image_downscale, "max_image_downscale"));
 
   try {
       if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -50,7 +52,10 @@ int main(int argc, char **argv)
   } catch (const std::string& s) {
       OPENMVG_LOG_INFO << "Usage: " << argv[0] << '\n'
         << "[-i|--input_file] path to the input SfM_Data scene\n"
-        << "[-o|--output_file] path to the output PLY file";
+        << "[-o|--output_file] path to the output PLY file\n"
+        << "[-d|--max_image_downscale] maximal downscaling factor used to decode the images\n"
+        << "   1: (default) full resolution, exact observation colors\n"
+        << "   2, 4, 8: faster JPEG decoding, colors of the downscaled images";
 
       OPENMVG_LOG_ERROR << s;
       return EXIT_FAILURE;
@@ -72,7 +77,7 @@ int main(int argc, char **argv)
 
   // Compute the scene structure color
   std::vector<Vec3> vec_3dPoints, vec_tracksColor, vec_camPosition;
-  if (ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor))
+  if (ColorizeTracks(sfm_data, vec_3dPoints, vec_tracksColor, max_image_downscale))
   {
     GetCameraPositions(sfm_data, vec_camPosition);
 
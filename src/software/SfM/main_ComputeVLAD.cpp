@@ -14,6 +14,7 @@
 #include "openMVG/matching_image_collection/Pair_Builder.hpp"
 #include "openMVG/matching_image_collection/Retrieval_Helpers.hpp"
 #include "openMVG/matching_image_collection/Vlad.hpp"
+#include "openMVG/matching_image_collection/Vlad_Database.hpp"
 #include "openMVG/sfm/pipelines/sfm_preemptive_regions_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider_cache.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
@@ -48,6 +49,7 @@ template <typename Order>
 void saveRetrievalMatrix(
     const string &filename, const SfM_Data &sfm_data,
     const IndexedPairwiseSimilarity<Order> &result_ordered_by_similarity) {
+  if (result_ordered_by_similarity.empty()) return;
   const size_t num_neighbors =
       result_ordered_by_similarity.begin()->second.size();
 
@@ -59,9 +61,10 @@ void saveRetrievalMatrix(
 
   for (const auto result_it : result_ordered_by_similarity) {
     const auto ref_view_id = result_it.first;
-    const auto ref_view = sfm_data.GetViews().at(ref_view_id);
-    const std::string ref_view_filename =
-        stlplus::create_filespec(sfm_data.s_root_path, ref_view->s_Img_path);
+    const auto ref_view_it = sfm_data.GetViews().find(ref_view_id);
+    if (ref_view_it == sfm_data.GetViews().end()) continue;
+    const std::string ref_view_filename = stlplus::create_filespec(
+        sfm_data.s_root_path, ref_view_it->second->s_Img_path);
 
     svg_stream.drawImage(ref_view_filename, size, size, x_offset * size,
                          y_offset * size);
@@ -71,9 +74,10 @@ void saveRetrievalMatrix(
       ++x_offset;
       const auto found_view_id = retrieval_list_it.second;
 
-      const auto found_view = sfm_data.GetViews().at(found_view_id);
+      const auto found_view_it = sfm_data.GetViews().find(found_view_id);
+      if (found_view_it == sfm_data.GetViews().end()) continue;
       const std::string found_view_filename = stlplus::create_filespec(
-          sfm_data.s_root_path, found_view->s_Img_path);
+          sfm_data.s_root_path, found_view_it->second->s_Img_path);
 
       svg_stream.drawImage(found_view_filename, size, size, x_offset * size,
                            y_offset * size);
@@ -151,11 +155,14 @@ int main(int argc, char **argv) {
   std::string sSfM_Data_Filename;
   std::string sMatchesDirectory = "";
   std::string sPairFile = "vlad_pairs.txt";
+  std::string sVladDatabase = "";
   int32_t num_neighbors = 0;
   int32_t codebook_size = 128;
   int32_t vlad_flavor =
       static_cast<int>(VLAD_NORMALIZATION::RESIDUAL_NORMALIZATION_PWR_LAW);
   int32_t max_feats = -1;
+  int32_t kmeans_solver =
+      static_cast<int>(clustering::KMeansSolverType::KMEANS_HAMERLY);
   uint32_t ui_max_cache_size = 0;
 
   // required
@@ -169,6 +176,9 @@ int main(int argc, char **argv) {
   cmd.add(make_option('v', vlad_flavor, "vlad_flavor"));
   cmd.add(make_option('c', ui_max_cache_size, "cache_size"));
   cmd.add(make_option('m', max_feats, "max_feats"));
+  cmd.add(make_option('k', kmeans_solver, "kmeans_solver"));
+  cmd.add(make_option('b', sVladDatabase, "vlad_database"));
+  cmd.add(make_switch('a', "add_views"));
 
   try {
     if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -196,12 +206,32 @@ int main(int argc, char **argv) {
         << ": \"Revisiting the VLAD image representation\". J. Delhumeau et "
            "al. ACM Multimedia 2013. \n"
         << "[-m|--max_feats] Max number of features to perform the learning "
-           "step (<= 0: whole feature set is used, default="
+           "step, not available with --add_views (<= 0: whole feature set is "
+           "used, default="
         << max_feats << ")\n"
+        << "[-k|--kmeans_solver] kmeans solver used to learn the codebook "
+           "(default=" << kmeans_solver << "):\n"
+        << "\t"
+        << static_cast<int>(clustering::KMeansSolverType::KMEANS_LLOYD)
+        << ": Llyod iterations\n"
+        << "\t"
+        << static_cast<int>(clustering::KMeansSolverType::KMEANS_HAMERLY)
+        << ": Llyod iterations accelerated with Hamerly bounds (exact)\n"
+        << "\t"
+        << static_cast<int>(clustering::KMeansSolverType::KMEANS_MINI_BATCH)
+        << ": mini-batch kmeans (approximate)\n"
         << "[-c|--cache_size] Use a regions cache (only cache_size regions "
            "will be stored in memory)\n"
         << "\t"
-        << "If not used, all regions will be loaded in memory." << std::endl;
+        << "If not used, all regions will be loaded in memory.\n"
+        << "[-b|--vlad_database] file used to store the codebook and the VLAD "
+           "embeddings of the indexed views\n"
+        << "[-a|--add_views] incremental mode: load the --vlad_database, "
+           "embed only the views that are not yet indexed, query them against "
+           "the database and export only the new pairs\n"
+        << "\t"
+        << "The codebook is not relearned and the database is updated."
+        << std::endl;
 
     std::cerr << s << std::endl;
     return EXIT_FAILURE;
@@ -217,8 +247,31 @@ int main(int argc, char **argv) {
             << "--codebook_size " << codebook_size << "\n"
             << "--vlad_flavor " << vlad_flavor << "\n"
             << "--max_feats " << max_feats << "\n"
+            << "--kmeans_solver " << kmeans_solver << "\n"
+            << "--vlad_database " << sVladDatabase << "\n"
+            << "--add_views " << cmd.used('a') << "\n"
             << std::endl;
 
+  if (kmeans_solver < 0 ||
+      kmeans_solver >
+        static_cast<int>(clustering::KMeansSolverType::KMEANS_MINI_BATCH)) {
+    std::cerr << "\nInvalid kmeans solver" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const bool b_add_views = cmd.used('a');
+  if (b_add_views && sVladDatabase.empty()) {
+    std::cerr << "\nThe --add_views mode requires a --vlad_database file"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (b_add_views && max_feats > 0) {
+    std::cerr << "\nThe --max_feats option limits the codebook learning, "
+                 "it cannot be used with --add_views (the codebook of the "
+                 "database is reused)" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   if (sMatchesDirectory.empty() || !stlplus::is_folder(sMatchesDirectory)) {
     std::cerr << "\nIt is an invalid output directory" << std::endl;
     return EXIT_FAILURE;
@@ -235,6 +288,56 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
+  //---------------------------------------
+  // Load the VLAD database (codebook & already indexed views)
+  //---------------------------------------
+  VLAD_Database vlad_database;
+  VLAD_NORMALIZATION vlad_normalization =
+      static_cast<VLAD_NORMALIZATION>(vlad_flavor);
+  if (b_add_views) {
+    if (!Load(vlad_database, sVladDatabase)) {
+      std::cerr << std::endl
+                << "The VLAD database \"" << sVladDatabase
+                << "\" cannot be read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (vlad_database.codebook.empty()) {
+      std::cerr << "\nThe VLAD database does not contain any codebook."
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    // The codebook and the normalization are fixed by the database
+    codebook_size = vlad_database.codebook.size();
+    vlad_normalization = vlad_database.normalization;
+    OPENMVG_LOG_INFO << "Loaded VLAD database: "
+                     << vlad_database.view_ids.size() << " indexed views, "
+                     << codebook_size << " centroids.";
+  }
+
+  // Views to embed and to use as retrieval queries
+  // (all the views, or only the non indexed ones in add_views mode)
+  std::vector<IndexT> query_view_ids;
+  {
+    const std::set<IndexT> indexed_view_ids(vlad_database.view_ids.cbegin(),
+                                            vlad_database.view_ids.cend());
+    for (const auto &view : sfm_data.GetViews()) {
+      if (indexed_view_ids.count(view.first) == 0)
+        query_view_ids.push_back(view.first);
+    }
+  }
+  if (query_view_ids.empty()) {
+    OPENMVG_LOG_INFO << "No new view to add to the VLAD database.";
+    savePairs(sPairFile, Pair_Set());
+    return EXIT_SUCCESS;
+  }
+
+  // Scene restricted to the views to embed
+  SfM_Data query_sfm_data;
+  query_sfm_data.s_root_path = sfm_data.s_root_path;
+  for (const auto &view_id : query_view_ids) {
+    query_sfm_data.views[view_id] = sfm_data.views.at(view_id);
+  }
+
   //---------------------------------------
   // Load SfM Scene regions
   //---------------------------------------
@@ -265,29 +368,29 @@ int main(int argc, char **argv) {
     }
   } else {
     learning_regions_provider = std::make_shared<Preemptive_Regions_Provider>(
-        max_feats / sfm_data.GetViews().size());
+        max_feats / query_sfm_data.GetViews().size());
   }
 
   system::LoggerProgress progress;
-  if (!learning_regions_provider->load(sfm_data, sMatchesDirectory, regions_type, &progress))
+  if (!learning_regions_provider->load(query_sfm_data, sMatchesDirectory, regions_type, &progress))
   {
     std::cerr << std::endl
               << "Invalid regions." << std::endl;
     return EXIT_FAILURE;
   }
 
+  const size_t database_size =
+      vlad_database.view_ids.size() + query_view_ids.size();
+
   // Default parameters for num_neighbors
   if (num_neighbors <= 0) {
-    num_neighbors = static_cast<int>(std::ceil(sfm_data.views.size() * 0.3));
+    num_neighbors = static_cast<int>(std::ceil(database_size * 0.3));
   }
 
-  if (num_neighbors > sfm_data.views.size()) {
-    num_neighbors = sfm_data.views.size() - 1;
+  if (num_neighbors >= database_size) {
+    num_neighbors = database_size - 1;
   }
 
-  const VLAD_NORMALIZATION vlad_normalization =
-      static_cast<VLAD_NORMALIZATION>(vlad_flavor);
-
   const size_t base_descriptor_length =
       learning_regions_provider->getRegionsType()->DescriptorLength();
   const size_t vlad_descriptor_length = base_descriptor_length * codebook_size;
@@ -312,35 +415,46 @@ int main(int argc, char **argv) {
     OPENMVG_LOG_INFO << "AKAZE";
     vlad_builder.reset(new VLAD<AKAZE_Float_Regions>);
   }
+  else
+  if (dynamic_cast<const AKAZE_Quantized_Float_Regions*>(regions_type.get())) {
+    OPENMVG_LOG_INFO << "AKAZE (quantized)";
+    vlad_builder.reset(new VLAD<AKAZE_Quantized_Float_Regions>);
+  }
   else {
     OPENMVG_LOG_ERROR << "VLAD does not support this Regions type.";
     OPENMVG_LOG_ERROR << "Please consider add the specialization here.";
     return EXIT_FAILURE;
   }
 
-  std::vector<IndexT> view_ids;
-  for (const auto &view : sfm_data.GetViews()) {
-    const auto &view_id = view.first;
-    view_ids.push_back(view_id);
-  }
-
-  // Convert input regions to array
-  VLADBase::DescriptorVector descriptor_array = vlad_builder->RegionsToCodebook(
-    view_ids,
-    learning_regions_provider);
+  if (!b_add_views) {
+    // Convert input regions to array
+    VLADBase::DescriptorVector descriptor_array = vlad_builder->RegionsToCodebook(
+      query_view_ids,
+      learning_regions_provider);
 
-  std::cout << "Using # features for learning: " << descriptor_array.size()
-          << std::endl;
-
-  VLADBase::DescriptorVector codebook;
-  codebook = vlad_builder->BuildCodebook(descriptor_array, codebook_size);
+    std::cout << "Using # features for learning: " << descriptor_array.size()
+            << std::endl;
 
-  // Freeing some memory
-  descriptor_array.clear();
-  descriptor_array.shrink_to_fit();
+    system::Timer codebook_timer;
+    vlad_database.codebook = vlad_builder->BuildCodebook(
+      descriptor_array, codebook_size, 25,
+      static_cast<clustering::KMeansSolverType>(kmeans_solver));
+    OPENMVG_LOG_INFO << "Codebook learning done in (s): "
+                     << codebook_timer.elapsed();
+    vlad_database.normalization = vlad_normalization;
+
+    // Freeing some memory
+    descriptor_array.clear();
+    descriptor_array.shrink_to_fit();
+  }
+  else if (vlad_database.codebook[0].size() != base_descriptor_length) {
+    OPENMVG_LOG_ERROR << "The VLAD database codebook does not match the "
+                         "regions descriptor length.";
+    return EXIT_FAILURE;
+  }
 
   std::unique_ptr<features::Regions> codebook_regions(regions_type->EmptyClone());
-  vlad_builder->CodebookToRegions(codebook_regions, codebook);
+  vlad_builder->CodebookToRegions(codebook_regions, vlad_database.codebook);
 
   std::shared_ptr<Regions_Provider> embedding_regions_provider;
   if (max_feats <= 0) {
@@ -353,18 +467,22 @@ int main(int argc, char **argv) {
       embedding_regions_provider =
           std::make_shared<Regions_Provider_Cache>(ui_max_cache_size);
     }
-    if (!embedding_regions_provider->load(sfm_data, sMatchesDirectory,
+    if (!embedding_regions_provider->load(query_sfm_data, sMatchesDirectory,
                                           regions_type, &progress)) {
       std::cerr << std::endl << "Invalid regions." << std::endl;
       return EXIT_FAILURE;
     }
   }
 
-  VLADBase::VladMatrixType vlad_image_descriptors =
+  // Only the views that are not yet indexed are embedded
+  // and appended to the database
+  vlad_database.Append(
+    query_view_ids,
     vlad_builder->ComputeVLADEmbedding(
-      view_ids,
+      query_view_ids,
       codebook_regions,
-      embedding_regions_provider);
+      embedding_regions_provider,
+      vlad_normalization));
 
   // release the region provider
   embedding_regions_provider.reset();
@@ -377,51 +495,49 @@ int main(int argc, char **argv) {
 
   //
   // Retrieval
+  // The query views are the last columns of the database embeddings
   //
-  progress.Restart(
-      sfm_data.GetViews().size(), "- VLAD Retrieval... -");
-  #ifdef OPENMVG_USE_OPENMP
-  #pragma omp parallel
-  #endif
-  for (int i = 0; i < sfm_data.GetViews().size(); i++) {
-    const auto &view_id = sfm_data.GetViews().at(i)->id_view;
-    const VLADBase::VladInternalType *query =
-        vlad_image_descriptors.col(view_id).data();
-
+  {
     matching::ArrayMatcherBruteForce<VLADBase::VladInternalType,
                                     matching::LInner<VLADBase::VladInternalType>>
         matcher;
 
-    if (!matcher.Build(vlad_image_descriptors.data(), sfm_data.views.size(),
+    if (!matcher.Build(vlad_database.embeddings.data(), database_size,
                       vlad_descriptor_length)) {
       std::cout << "Error::Build" << std::endl;
     }
 
+    const VLADBase::VladInternalType *query =
+        vlad_database.embeddings.rightCols(query_view_ids.size()).data();
+
     const size_t NN = num_neighbors + 1;  // num_neighbors + 1 (the query vector
                                           // itself is part of the database)
     IndMatches nearest_neighbor_ids;
     std::vector<VLADBase::VladInternalType> nearest_neighbor_similarities;
-    if (!matcher.SearchNeighbours(query, 1, &nearest_neighbor_ids,
+    if (!matcher.SearchNeighbours(query, query_view_ids.size(),
+                                  &nearest_neighbor_ids,
                                   &nearest_neighbor_similarities, NN))
       std::cout << "Error::SearchNeighbours" << std::endl;
-    #ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-    #endif
-    {
-    #ifdef OPENMVG_USE_OPENMP
-    #pragma omp critical
-    #endif
-    {
-      for (int id = 0; id < nearest_neighbor_ids.size(); ++id) {
-        const auto pair = nearest_neighbor_ids[id];
-        if (view_id == pair.j_) continue;  // Ignore if we find the same image
-        const auto similarity = -1. * nearest_neighbor_similarities[id];
-        resulting_pairs.insert(
-            {std::min(view_id, pair.j_), std::max(view_id, pair.j_)});
-        result_ordered_by_similarity[view_id].insert({similarity, pair.j_});
+
+    size_t unknown_view_count = 0;
+    for (int id = 0; id < nearest_neighbor_ids.size(); ++id) {
+      const auto view_id = query_view_ids[nearest_neighbor_ids[id].i_];
+      const auto found_view_id =
+          vlad_database.view_ids[nearest_neighbor_ids[id].j_];
+      if (view_id == found_view_id) continue;  // Ignore if we find the same image
+      // Ignore the database views that are not part of the scene
+      if (sfm_data.GetViews().count(found_view_id) == 0) {
+        ++unknown_view_count;
+        continue;
       }
-      ++progress;
+      const auto similarity = -1. * nearest_neighbor_similarities[id];
+      resulting_pairs.insert(
+          {std::min(view_id, found_view_id), std::max(view_id, found_view_id)});
+      result_ordered_by_similarity[view_id].insert({similarity, found_view_id});
     }
+    if (unknown_view_count > 0) {
+      OPENMVG_LOG_WARNING << unknown_view_count << " retrieved database views "
+                          "are not part of the input scene and are ignored.";
     }
   }
 
@@ -448,5 +564,17 @@ int main(int argc, char **argv) {
 
   savePairwiseSimilarityScores(sSimFile, result_ordered_by_similarity);
 
+  // Export the updated VLAD database
+  if (!sVladDatabase.empty()) {
+    if (!Save(vlad_database, sVladDatabase)) {
+      std::cerr << std::endl
+                << "Cannot save the VLAD database \"" << sVladDatabase
+                << "\"." << std::endl;
+      return EXIT_FAILURE;
+    }
+    OPENMVG_LOG_INFO << "VLAD database saved: " << vlad_database.view_ids.size()
+                     << " indexed views.";
+  }
+
   return EXIT_SUCCESS;
 }
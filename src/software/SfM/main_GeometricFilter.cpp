@@ -23,6 +23,7 @@
 #include "openMVG/matching_image_collection/H_ACRobust.hpp"
 #include "openMVG/matching_image_collection/Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/Pair_Builder.hpp"
+#include "openMVG/robust_estimation/gms_filter.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_regions_provider_cache.hpp"
@@ -37,8 +38,10 @@
 #include <cstdlib>
 #include <iostream>
 #include <locale>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace openMVG;
 using namespace openMVG::matching;
@@ -57,6 +60,77 @@ enum EGeometricModel
   ESSENTIAL_MATRIX_UPRIGHT = 5
 };
 
+/// Prune the putative matches with the GMS filter (Grid-based Motion Statistics):
+/// - the feature positions of each view are converted once and shared by the pairs,
+/// - the pairs are filtered in parallel (scale & rotation invariant GMS),
+/// - the pairs without any consistent correspondence are removed.
+PairWiseMatches GMSFilterPutativeMatches
+(
+  const SfM_Data & sfm_data,
+  const std::shared_ptr<Regions_Provider> & regions_provider,
+  const PairWiseMatches & putative_matches,
+  system::ProgressInterface * my_progress_bar
+)
+{
+  // Collect the feature positions of the views used by the pairs
+  std::map<IndexT, std::vector<Eigen::Vector2f>> view_positions;
+  for (const auto & pair_it : putative_matches)
+  {
+    view_positions[pair_it.first.first];
+    view_positions[pair_it.first.second];
+  }
+  my_progress_bar->Restart( view_positions.size() + putative_matches.size(), "- GMS filtering -" );
+  for (auto & view_it : view_positions)
+  {
+    const std::shared_ptr<features::Regions> regions = regions_provider->get(view_it.first);
+    view_it.second.resize(regions->RegionCount());
+    for (size_t i = 0; i < regions->RegionCount(); ++i)
+      view_it.second[i] = regions->GetRegionPosition(i).cast<float>();
+    ++(*my_progress_bar);
+  }
+
+  const int kGmsThreshold = 6;
+  const bool with_scale_invariance = true;
+  const bool with_rotation_invariance = true;
+
+  PairWiseMatches gms_matches;
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(putative_matches.size()); ++i)
+  {
+    auto iter = putative_matches.cbegin();
+    std::advance(iter, i);
+    const View
+      * view_I = sfm_data.GetViews().at(iter->first.first).get(),
+      * view_J = sfm_data.GetViews().at(iter->first.second).get();
+
+    const robust::GMSFilter gms(
+      view_positions.at(view_I->id_view), {view_I->ui_width, view_I->ui_height},
+      view_positions.at(view_J->id_view), {view_J->ui_width, view_J->ui_height},
+      iter->second,
+      kGmsThreshold);
+    std::vector<bool> inlier_flags;
+    if (gms.GetInlierMask(inlier_flags, with_scale_invariance, with_rotation_invariance) > 0)
+    {
+      IndMatches pair_matches;
+      for (size_t k = 0; k < inlier_flags.size(); ++k)
+      {
+        if (inlier_flags[k])
+          pair_matches.push_back(iter->second[k]);
+      }
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp critical
+#endif
+      {
+        gms_matches.insert({iter->first, std::move(pair_matches)});
+      }
+    }
+    ++(*my_progress_bar);
+  }
+  return gms_matches;
+}
+
 /// Compute corresponding features between a series of views:
 /// - Load view images description (regions: features & descriptors)
 /// - Compute putative local feature matches (descriptors matching)
@@ -80,6 +154,10 @@ int main( int argc, char** argv )
   std::string  sGeometricModel   = "f";
   bool         bForce            = false;
   bool         bGuided_matching  = false;
+  bool         bGMS_filter       = false;
+  bool         bLocal_optimization = false;
+  bool         bSPRT             = false;
+  bool         bPROSAC           = false;
   int          imax_iteration    = 2048;
   unsigned int ui_max_cache_size = 0;
 
@@ -93,6 +171,10 @@ int main( int argc, char** argv )
   cmd.add( make_option( 'g', sGeometricModel, "geometric_model" ) );
   cmd.add( make_option( 'f', bForce, "force" ) );
   cmd.add( make_option( 'r', bGuided_matching, "guided_matching" ) );
+  cmd.add( make_option( 'G', bGMS_filter, "gms_filter" ) );
+  cmd.add( make_option( 'L', bLocal_optimization, "local_optimization" ) );
+  cmd.add( make_option( 'S', bSPRT, "sprt" ) );
+  cmd.add( make_option( 'P', bPROSAC, "prosac" ) );
   cmd.add( make_option( 'I', imax_iteration, "max_iteration" ) );
   cmd.add( make_option( 'c', ui_max_cache_size, "cache_size" ) );
 
@@ -121,6 +203,15 @@ int main( int argc, char** argv )
                      << "   u: upright essential matrix with an angular parametrization,\n"
                      << "   o: orthographic essential matrix.\n"
                      << "[-r|--guided_matching]  Use the found model to improve the pairwise correspondences.\n"
+                     << "[-G|--gms_filter]       Prune the putative matches with the GMS filter\n"
+                     << "  (Grid-based Motion Statistics) before the robust model estimation.\n"
+                     << "[-L|--local_optimization] Refine the robust model estimation with LO-RANSAC\n"
+                     << "  (local optimization of the meaningful models, OFF by default).\n"
+                     << "[-S|--sprt]             Speed up the robust model estimation by rejecting early\n"
+                     << "  the bad model hypotheses with the SPRT test (OFF by default).\n"
+                     << "[-P|--prosac]           Sample first the putative matches with the best distance ratio\n"
+                     << "  (PROSAC, used only if the matches have a score, OFF by default).\n"
+                     << "  The scores are saved by ComputeMatches --save_scores.\n"
                      << "[-c|--cache_size]\n"
                      << "  Use a regions cache (only cache_size regions will be stored in memory)\n"
                      << "  If not used, all regions will be load in memory.";
@@ -142,6 +233,10 @@ int main( int argc, char** argv )
                    << "--force              " << (bForce ? "true" : "false") << "\n"
                    << "--geometric_model    " << sGeometricModel << "\n"
                    << "--guided_matching    " << bGuided_matching << "\n"
+                   << "--gms_filter         " << bGMS_filter << "\n"
+                   << "--local_optimization " << bLocal_optimization << "\n"
+                   << "--sprt               " << bSPRT << "\n"
+                   << "--prosac             " << bPROSAC << "\n"
                    << "--cache_size         " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size));
 
   if ( sFilteredMatchesFilename.empty() )
@@ -270,6 +365,14 @@ int main( int argc, char** argv )
     map_PutativeMatches = getPairs( map_PutativeMatches, input_pairs );
   }
 
+  if ( bGMS_filter )
+  {
+    // Prune the putative matches that do not have a consistent local motion
+    system::Timer gms_timer;
+    map_PutativeMatches = GMSFilterPutativeMatches( sfm_data, regions_provider, map_PutativeMatches, &progress );
+    OPENMVG_LOG_INFO << "GMS filtering done in (s): " << gms_timer.elapsed();
+  }
+
   //---------------------------------------
   // b. Geometric filtering of putative matches
   //    - AContrario Estimation of the desired geometric model
@@ -284,6 +387,11 @@ int main( int argc, char** argv )
     system::Timer timer;
     const double  d_distance_ratio = 0.6;
 
+    GeometricFilter_RobustOptions robust_options;
+    robust_options.b_local_optimization = bLocal_optimization;
+    robust_options.b_sprt = bSPRT;
+    robust_options.b_prosac = bPROSAC;
+
     PairWiseMatches map_GeometricMatches;
     switch ( eGeometricModelToCompute )
     {
@@ -291,7 +399,7 @@ int main( int argc, char** argv )
       {
         const bool bGeometric_only_guided_matching = true;
         filter_ptr->Robust_model_estimation(
-            GeometricFilter_HMatrix_AC( 4.0, imax_iteration ),
+            GeometricFilter_HMatrix_AC( 4.0, imax_iteration, robust_options ),
             map_PutativeMatches,
             bGuided_matching,
             bGeometric_only_guided_matching ? -1.0 : d_distance_ratio,
@@ -302,7 +410,7 @@ int main( int argc, char** argv )
       case FUNDAMENTAL_MATRIX:
       {
         filter_ptr->Robust_model_estimation(
-            GeometricFilter_FMatrix_AC( 4.0, imax_iteration ),
+            GeometricFilter_FMatrix_AC( 4.0, imax_iteration, robust_options ),
             map_PutativeMatches,
             bGuided_matching,
             d_distance_ratio,
@@ -313,7 +421,7 @@ int main( int argc, char** argv )
       case ESSENTIAL_MATRIX:
       {
         filter_ptr->Robust_model_estimation(
-            GeometricFilter_EMatrix_AC( 4.0, imax_iteration ),
+            GeometricFilter_EMatrix_AC( 4.0, imax_iteration, robust_options ),
             map_PutativeMatches,
             bGuided_matching,
             d_distance_ratio,
@@ -343,7 +451,7 @@ int main( int argc, char** argv )
       case ESSENTIAL_MATRIX_ANGULAR:
       {
         filter_ptr->Robust_model_estimation(
-          GeometricFilter_ESphericalMatrix_AC_Angular<false>(4.0, imax_iteration),
+          GeometricFilter_ESphericalMatrix_AC_Angular<false>(4.0, imax_iteration, robust_options),
           map_PutativeMatches, bGuided_matching, d_distance_ratio, &progress);
         map_GeometricMatches = filter_ptr->Get_geometric_matches();
       }
@@ -351,7 +459,7 @@ int main( int argc, char** argv )
       case ESSENTIAL_MATRIX_UPRIGHT:
       {
         filter_ptr->Robust_model_estimation(
-          GeometricFilter_ESphericalMatrix_AC_Angular<true>(4.0, imax_iteration),
+          GeometricFilter_ESphericalMatrix_AC_Angular<true>(4.0, imax_iteration, robust_options),
           map_PutativeMatches, bGuided_matching, d_distance_ratio, &progress);
         map_GeometricMatches = filter_ptr->Get_geometric_matches();
       }
@@ -359,7 +467,7 @@ int main( int argc, char** argv )
       case ESSENTIAL_MATRIX_ORTHO:
       {
         filter_ptr->Robust_model_estimation(
-            GeometricFilter_EOMatrix_RA( 2.0, imax_iteration ),
+            GeometricFilter_EOMatrix_RA( 2.0, imax_iteration, robust_options ),
             map_PutativeMatches,
             bGuided_matching,
             d_distance_ratio,
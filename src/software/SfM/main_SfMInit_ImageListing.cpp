@@ -27,6 +27,11 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
 
 using namespace openMVG;
 using namespace openMVG::cameras;
@@ -63,41 +68,46 @@ bool checkIntrinsicStringValidity(const std::string & Kmatrix, double & focal, d
 
 bool getGPS
 (
-  const std::string & filename,
+  const Exif_IO & exifReader,
   const int & GPS_to_XYZ_method,
   Vec3 & pose_center
 )
 {
-  std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
-  if (exifReader)
+  // Check existence of EXIF data
+  if ( exifReader.doesHaveExifInfo() )
   {
-    // Try to parse EXIF metada & check existence of EXIF data
-    if ( exifReader->open( filename ) && exifReader->doesHaveExifInfo() )
+    // Check existence of GPS coordinates
+    double latitude, longitude, altitude;
+    if ( exifReader.GPSLatitude( &latitude ) &&
+         exifReader.GPSLongitude( &longitude ) &&
+         exifReader.GPSAltitude( &altitude ) )
     {
-      // Check existence of GPS coordinates
-      double latitude, longitude, altitude;
-      if ( exifReader->GPSLatitude( &latitude ) &&
-           exifReader->GPSLongitude( &longitude ) &&
-           exifReader->GPSAltitude( &altitude ) )
+      // Add ECEF or UTM XYZ position to the GPS position array
+      switch (GPS_to_XYZ_method)
       {
-        // Add ECEF or UTM XYZ position to the GPS position array
-        switch (GPS_to_XYZ_method)
-        {
-          case 1:
-            pose_center = lla_to_utm( latitude, longitude, altitude );
-            break;
-          case 0:
-          default:
-            pose_center = lla_to_ecef( latitude, longitude, altitude );
-            break;
-        }
-        return true;
+        case 1:
+          pose_center = lla_to_utm( latitude, longitude, altitude );
+          break;
+        case 0:
+        default:
+          pose_center = lla_to_ecef( latitude, longitude, altitude );
+          break;
       }
+      return true;
     }
   }
   return false;
 }
 
+/// Camera properties and pose prior read from an image file
+struct ImageMetaData
+{
+  bool b_listed = false; // false if the image cannot be used
+  double width = -1, height = -1, focal = -1, ppx = -1, ppy = -1;
+  bool b_has_gps = false;
+  Vec3 pose_center = Vec3::Zero();
+  std::string error_report; // warning & error messages related to the image
+};
 
 /// Check string of prior weights
 std::pair<bool, Vec3> checkPriorWeightsString
@@ -151,6 +161,8 @@ int main(int argc, char **argv)
 
   double focal_pixels = -1.0;
 
+  int iNumThreads = 0;
+
   cmd.add( make_option('i', sImageDir, "imageDirectory") );
   cmd.add( make_option('d', sfileDatabase, "sensorWidthDatabase") );
   cmd.add( make_option('o', sOutputDir, "outputDirectory") );
@@ -161,6 +173,9 @@ int main(int argc, char **argv)
   cmd.add( make_switch('P', "use_pose_prior") );
   cmd.add( make_option('W', sPriorWeights, "prior_weights"));
   cmd.add( make_option('m', i_GPS_XYZ_method, "gps_to_xyz_method") );
+#ifdef OPENMVG_USE_OPENMP
+  cmd.add( make_option('n', iNumThreads, "numThreads") );
+#endif
 
   try {
     if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -187,7 +202,11 @@ int main(int argc, char **argv)
       << "[-W|--prior_weights] \"x;y;z;\" of weights for each dimension of the prior (default: 1.0)\n"
       << "[-m|--gps_to_xyz_method] XZY Coordinate system:\n"
       << "\t 0: ECEF (default)\n"
-      << "\t 1: UTM";
+      << "\t 1: UTM\n"
+#ifdef OPENMVG_USE_OPENMP
+      << "[-n|--numThreads] number of images read in parallel (default: number of cores)\n"
+#endif
+      ;
 
       OPENMVG_LOG_ERROR << s;
       return EXIT_FAILURE;
@@ -206,8 +225,8 @@ int main(int argc, char **argv)
     << "\n--prior_weights " << sPriorWeights
     << "\n--gps_to_xyz_method " << i_GPS_XYZ_method;
 
-  // Expected properties for each image
-  double width = -1, height = -1, focal = -1, ppx = -1,  ppy = -1;
+  // User provided intrinsic values (-k option)
+  double user_focal = -1, user_ppx = -1,  user_ppy = -1;
 
   const EINTRINSIC e_User_camera_model = EINTRINSIC(i_User_camera_model);
 
@@ -233,7 +252,7 @@ int main(int argc, char **argv)
   }
 
   if (sKmatrix.size() > 0 &&
-    !checkIntrinsicStringValidity(sKmatrix, focal, ppx, ppy) )
+    !checkIntrinsicStringValidity(sKmatrix, user_focal, user_ppx, user_ppy) )
   {
     OPENMVG_LOG_ERROR << "Invalid K matrix input";
     return EXIT_FAILURE;
@@ -246,6 +265,7 @@ int main(int argc, char **argv)
   }
 
   std::vector<Datasheet> vec_database;
+  DatasheetIndex database_index;
   if (!sfileDatabase.empty())
   {
     if ( !parseDatabase( sfileDatabase, vec_database ) )
@@ -255,6 +275,7 @@ int main(int argc, char **argv)
        << ", please specify a valid file.";
       return EXIT_FAILURE;
     }
+    buildDatabaseIndex( vec_database, database_index );
   }
 
   // Check if prior weights are given
@@ -272,24 +293,29 @@ int main(int argc, char **argv)
   Views & views = sfm_data.views;
   Intrinsics & intrinsics = sfm_data.intrinsics;
 
-  system::LoggerProgress my_progress_bar(vec_image.size(), "- Listing images -" );
-  std::ostringstream error_report_stream;
-  for ( std::vector<std::string>::const_iterator iter_image = vec_image.begin();
-    iter_image != vec_image.end();
-    ++iter_image, ++my_progress_bar )
+  // Read the image meta data
+  // - Image files are read in parallel (header and EXIF data only),
+  // - The views are then created in the sorted image name order.
+  std::vector<ImageMetaData> vec_image_meta_data(vec_image.size());
+
+  // Read meta data to fill camera parameter (w,h,focal,ppx,ppy) fields.
+  const auto read_image_meta_data = [&]
+  (
+    const std::string & sImageName,
+    ImageMetaData & meta_data
+  )
   {
-    // Read meta data to fill camera parameter (w,h,focal,ppx,ppy) fields.
-    width = height = ppx = ppy = focal = -1.0;
-
-    const std::string sImageFilename = stlplus::create_filespec( sImageDir, *iter_image );
+    const std::string sImageFilename = stlplus::create_filespec( sImageDir, sImageName );
     const std::string sImFilenamePart = stlplus::filename_part(sImageFilename);
+    std::ostringstream error_report_stream;
 
     // Test if the image format is supported:
     if (openMVG::image::GetFormat(sImageFilename.c_str()) == openMVG::image::Unknown)
     {
       error_report_stream
           << sImFilenamePart << ": Unkown image file format." << "\n";
-      continue; // image cannot be opened
+      meta_data.error_report = error_report_stream.str();
+      return; // image cannot be opened
     }
 
     if (sImFilenamePart.find("mask.png") != std::string::npos
@@ -297,35 +323,41 @@ int main(int argc, char **argv)
     {
       error_report_stream
           << sImFilenamePart << " is a mask image" << "\n";
-      continue;
+      meta_data.error_report = error_report_stream.str();
+      return;
     }
 
     ImageHeader imgHeader;
     if (!openMVG::image::ReadImageHeader(sImageFilename.c_str(), &imgHeader))
-      continue; // image cannot be read
-
-    width = imgHeader.width;
-    height = imgHeader.height;
-    ppx = width / 2.0;
-    ppy = height / 2.0;
+      return; // image cannot be read
 
+    meta_data.b_listed = true;
+    meta_data.width = imgHeader.width;
+    meta_data.height = imgHeader.height;
+    meta_data.ppx = meta_data.width / 2.0;
+    meta_data.ppy = meta_data.height / 2.0;
 
     // Consider the case where the focal is provided manually
     if (sKmatrix.size() > 0) // Known user calibration K matrix
     {
-      if (!checkIntrinsicStringValidity(sKmatrix, focal, ppx, ppy))
-        focal = -1.0;
+      meta_data.focal = user_focal;
+      meta_data.ppx = user_ppx;
+      meta_data.ppy = user_ppy;
     }
     else // User provided focal length value
       if (focal_pixels != -1 )
-        focal = focal_pixels;
+        meta_data.focal = focal_pixels;
+
+    // EXIF data are read only if they are required
+    if (meta_data.focal != -1 && !b_Use_pose_prior)
+      return;
+
+    std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
+    exifReader->open( sImageFilename );
 
     // If not manually provided or wrongly provided
-    if (focal == -1)
+    if (meta_data.focal == -1)
     {
-      std::unique_ptr<Exif_IO> exifReader(new Exif_IO_EasyExif);
-      exifReader->open( sImageFilename );
-
       const bool bHaveValidExifMetadata =
         exifReader->doesHaveExifInfo()
         && !exifReader->getModel().empty()
@@ -338,7 +370,7 @@ int main(int argc, char **argv)
         {
           error_report_stream
             << stlplus::basename_part(sImageFilename) << ": Focal length is missing." << "\n";
-          focal = -1.0;
+          meta_data.focal = -1.0;
         }
         else
         // Create the image entry in the list file
@@ -346,11 +378,11 @@ int main(int argc, char **argv)
           const std::string sCamModel = exifReader->getBrand() + " " + exifReader->getModel();
 
           Datasheet datasheet;
-          if ( getInfo( sCamModel, vec_database, datasheet ))
+          if ( getInfo( sCamModel, vec_database, database_index, datasheet ))
           {
             // The camera model was found in the database so we can compute it's approximated focal length
             const double ccdw = datasheet.sensorSize_;
-            focal = std::max ( width, height ) * exifReader->getFocal() / ccdw;
+            meta_data.focal = std::max ( meta_data.width, meta_data.height ) * exifReader->getFocal() / ccdw;
           }
           else
           {
@@ -362,6 +394,43 @@ int main(int argc, char **argv)
         }
       }
     }
+
+    if (b_Use_pose_prior)
+    {
+      meta_data.b_has_gps = getGPS(*exifReader, i_GPS_XYZ_method, meta_data.pose_center);
+    }
+    meta_data.error_report = error_report_stream.str();
+  };
+
+  {
+    system::LoggerProgress my_progress_bar(vec_image.size(), "- Listing images -" );
+#ifdef OPENMVG_USE_OPENMP
+    const int nb_threads = (iNumThreads > 0) ? iNumThreads : omp_get_max_threads();
+    #pragma omp parallel for schedule(dynamic) num_threads(nb_threads)
+#endif
+    for (int i = 0; i < static_cast<int>(vec_image.size()); ++i)
+    {
+      read_image_meta_data(vec_image[i], vec_image_meta_data[i]);
+      ++my_progress_bar;
+    }
+  }
+
+  std::ostringstream error_report_stream;
+  for (size_t i = 0; i < vec_image.size(); ++i)
+  {
+    const std::string & sImageName = vec_image[i];
+    const ImageMetaData & meta_data = vec_image_meta_data[i];
+    error_report_stream << meta_data.error_report;
+    if (!meta_data.b_listed)
+      continue;
+
+    const double
+      width = meta_data.width,
+      height = meta_data.height,
+      focal = meta_data.focal,
+      ppx = meta_data.ppx,
+      ppy = meta_data.ppy;
+
     // Build intrinsic parameter related to the view
     std::shared_ptr<IntrinsicBase> intrinsic;
 
@@ -401,10 +470,9 @@ int main(int argc, char **argv)
     }
 
     // Build the view corresponding to the image
-    Vec3 pose_center;
-    if (getGPS(sImageFilename, i_GPS_XYZ_method, pose_center) && b_Use_pose_prior)
+    if (b_Use_pose_prior && meta_data.b_has_gps)
     {
-      ViewPriors v(*iter_image, views.size(), views.size(), views.size(), width, height);
+      ViewPriors v(sImageName, views.size(), views.size(), views.size(), width, height);
 
       // Add intrinsic related to the image (if any)
       if (!intrinsic)
@@ -420,7 +488,7 @@ int main(int argc, char **argv)
       }
 
       v.b_use_pose_center_ = true;
-      v.pose_center_ = pose_center;
+      v.pose_center_ = meta_data.pose_center;
       // prior weights
       if (prior_w_info.first == true)
       {
@@ -432,7 +500,7 @@ int main(int argc, char **argv)
     }
     else
     {
-      View v(*iter_image, views.size(), views.size(), views.size(), width, height);
+      View v(sImageName, views.size(), views.size(), views.size(), width, height);
 
       // Add intrinsic related to the image (if any)
       if (!intrinsic)
@@ -16,6 +16,7 @@
 
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/stl/split.hpp"
 #include "openMVG/stl/stl.hpp"
 #include "openMVG/system/loggerprogress.hpp"
 #include "openMVG/system/timer.hpp"
@@ -56,12 +57,14 @@ int main(int argc, char **argv)
   std::string sSfM_Data_Filename;
   std::string sFeatDirectory = "";
   int max_feature_count_per_image = -1;
+  std::string sMatcherList = "hnsw_l1;hnsw_l2;ann_l2;cascade_l2;fast_cascade_l2";
 
   //required
   cmd.add(make_option('i', sSfM_Data_Filename, "input_file"));
   cmd.add(make_option('f', sFeatDirectory, "feat_dir"));
   // optional
   cmd.add(make_option('c', max_feature_count_per_image, "max_feature_count"));
+  cmd.add(make_option('m', sMatcherList, "matcher_list"));
 
 
   try
@@ -76,7 +79,9 @@ int main(int argc, char **argv)
               << "[-i|--input_file] a SfM_Data file\n"
               << "[-f|--feat_dir path] output path where features are stored\n"
               << "--- Optional ---\n"
-              << "[-c|--max_feature_count number] max_feature count per image (i.e 1000).";
+              << "[-c|--max_feature_count number] max_feature count per image (i.e 1000).\n"
+              << "[-m|--matcher_list] ';' separated list of the matchers to compare to brute_force_l2:\n"
+              << "  hnsw_l1, hnsw_l2, ann_l2, cascade_l2, fast_cascade_l2 (default: all).";
     OPENMVG_LOG_ERROR << s;
     return EXIT_FAILURE;
   }
@@ -85,7 +90,8 @@ int main(int argc, char **argv)
             << "\n"
             << argv[0] << "\n"
             << "--input_file " << sSfM_Data_Filename << "\n"
-            << "--feat_dir " << sFeatDirectory << "\n";
+            << "--feat_dir " << sFeatDirectory << "\n"
+            << "--matcher_list " << sMatcherList << "\n";
 
   if (sFeatDirectory.empty() || !stlplus::is_folder(sFeatDirectory))
   {
@@ -138,14 +144,16 @@ int main(int argc, char **argv)
   // Compute matches for a reference implementation (Brute Force L2)
   // - and compare the accuracy and timing of some other method
   // - accuracy is defined as the median percentage of similar index retrieved
-  const std::vector<std::string> matcher_to_evaluate = {
-    "brute_force_l2",
-    "hnsw_l1",
-    "hnsw_l2",
-    "ann_l2",
-    "cascade_l2",
-    "fast_cascade_l2"
-  };
+  std::vector<std::string> matcher_to_evaluate = {"brute_force_l2"};
+  {
+    std::vector<std::string> vec_str;
+    stl::split(sMatcherList, ';', vec_str);
+    for (const auto & method : vec_str)
+    {
+      if (!method.empty() && method != "brute_force_l2")
+        matcher_to_evaluate.push_back(method);
+    }
+  }
 
   OPENMVG_LOG_INFO << "Going to bench: ";
   for (const auto & method : matcher_to_evaluate)
@@ -157,6 +165,7 @@ int main(int argc, char **argv)
   {
     double time = 0.0;
     double accuracy = 0.0;
+    size_t match_count = 0;
   };
 
   std::map<std::string, collected_data> collected_stats;
@@ -177,7 +186,10 @@ int main(int argc, char **argv)
     else if (method == "fast_cascade_l2")
       collectionMatcher.reset(new Cascade_Hashing_Matcher_Regions(fDistRatio));
     else
+    {
       OPENMVG_LOG_ERROR << "Invalid Regions Matcher: " << method;
+      return EXIT_FAILURE;
+    }
 
     collected_data data;
     if (method == "brute_force_l2") // Populate the reference matches
@@ -185,6 +197,8 @@ int main(int argc, char **argv)
       system::Timer timer;
       collectionMatcher->Match(regions_provider, pairs, reference_matches, &progress);
       data.time = timer.elapsed();
+      for (const auto & matches_it : reference_matches)
+        data.match_count += matches_it.second.size();
       collected_stats[method] = data;
     }
     else // Compute corresponding indexes and compare them against the "GT"
@@ -193,11 +207,13 @@ int main(int argc, char **argv)
       PairWiseMatches matches;
       collectionMatcher->Match(regions_provider, pairs, matches, &progress);
       data.time = timer.elapsed();
+      for (const auto & matches_it : matches)
+        data.match_count += matches_it.second.size();
 
       // Compute accuracy
       // - percentage of correct retrieved index to the "GT"
       std::vector<double> accuracy_per_pair;
-      for (const auto ref_matches_it : reference_matches)
+      for (const auto & ref_matches_it : reference_matches)
       {
         const Pair pair = ref_matches_it.first;
         const auto & matches_ref = ref_matches_it.second;
@@ -224,7 +240,9 @@ int main(int argc, char **argv)
   for (const auto & method : matcher_to_evaluate)
   {
     OPENMVG_LOG_INFO << "Method: " << method << "\n"
-      << "time(seconds): " << collected_stats[method].time;
+      << "time(seconds): " << collected_stats[method].time << "\n"
+      << "pairs per second: " << pairs.size() / collected_stats[method].time << "\n"
+      << "#putative matches: " << collected_stats[method].match_count;
      if (method != "brute_force_l2")
       OPENMVG_LOG_INFO << "accuracy(percent): " << collected_stats[method].accuracy;
   }